@@ -9,6 +9,7 @@
 #define RT_NAME_MAX 8
 #define RT_USING_SMP
 #define RT_CPUS_NR 2
+#define RT_CPU_CACHE_LINE_SZ 32
 #define RT_ALIGN_SIZE 4
 /* RT_THREAD_PRIORITY_8 is not set */
 #define RT_THREAD_PRIORITY_32
@@ -274,6 +275,7 @@
 
 /* PKG_USING_HELLO is not set */
 #define SOC_VEXPRESS_A9
+#define RT_USING_CPU_FFS
 #define RT_USING_UART0
 #define RT_USING_UART1
 /* BSP_DRV_AUDIO is not set */
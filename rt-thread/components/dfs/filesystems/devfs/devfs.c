@@ -323,7 +323,7 @@ static const struct dfs_file_ops _device_fops =
 static const struct dfs_filesystem_ops _device_fs = 
 {
     "devfs",
-    DFS_FS_FLAG_DEFAULT,
+    DFS_FS_FLAG_STREAM,
     &_device_fops,
 
     dfs_device_fs_mount,
@@ -45,6 +45,25 @@
 
 static rt_device_t disk[_VOLUMES] = {0};
 
+/* the alignment of buffer for DMA transfer of device, 0 for no requirement */
+#ifndef RT_DFS_ELM_DMA_ALIGN
+#define RT_DFS_ELM_DMA_ALIGN        0
+#endif
+
+/* the minimal size of read-only file to build cluster link map on open */
+#ifndef RT_DFS_ELM_FASTSEEK_SIZE
+#define RT_DFS_ELM_FASTSEEK_SIZE    (1024 * 1024)
+#endif
+
+/* the sectors transferred through bounce buffer at a time */
+#define ELM_BOUNCE_SECTORS          8
+/* the maximal items of cluster link map, 2 items for each fragment */
+#define ELM_LINKMAP_MAX             256
+
+#if RT_DFS_ELM_DMA_ALIGN > 1
+static BYTE *disk_bounce[_VOLUMES] = {0};
+#endif
+
 static int elm_result_to_dfs(FRESULT result)
 {
     int status = RT_EOK;
@@ -201,6 +220,10 @@ int dfs_elm_unmount(struct dfs_filesystem *fs)
     fs->data = RT_NULL;
     disk[index] = RT_NULL;
     rt_free(fat);
+#if RT_DFS_ELM_DMA_ALIGN > 1
+    rt_free_align(disk_bounce[index]);
+    disk_bounce[index] = RT_NULL;
+#endif
 
     return RT_EOK;
 }
@@ -333,6 +356,47 @@ int dfs_elm_statfs(struct dfs_filesystem *fs, struct statfs *buf)
     return 0;
 }
 
+#if _USE_FASTSEEK
+/* build the cluster link map of file, then the file is seeked and read
+ * without following the FAT chain */
+static void elm_create_linkmap(FIL *fd)
+{
+    DWORD *tbl;
+    DWORD size = 32;
+    FRESULT result;
+
+    tbl = (DWORD *)rt_malloc(size * sizeof(DWORD));
+    if (tbl == RT_NULL)
+        return;
+
+    tbl[0] = size;
+    fd->cltbl = tbl;
+    result = f_lseek(fd, CREATE_LINKMAP);
+    if (result == FR_NOT_ENOUGH_CORE && tbl[0] <= ELM_LINKMAP_MAX)
+    {
+        /* the required size is returned */
+        size = tbl[0];
+        rt_free(tbl);
+        fd->cltbl = RT_NULL;
+
+        tbl = (DWORD *)rt_malloc(size * sizeof(DWORD));
+        if (tbl == RT_NULL)
+            return;
+
+        tbl[0] = size;
+        fd->cltbl = tbl;
+        result = f_lseek(fd, CREATE_LINKMAP);
+    }
+
+    /* too fragmented, access the file by FAT chain */
+    if (result != FR_OK)
+    {
+        fd->cltbl = RT_NULL;
+        rt_free(tbl);
+    }
+}
+#endif
+
 int dfs_elm_open(struct dfs_fd *file)
 {
     FIL *fd;
@@ -438,6 +502,15 @@ int dfs_elm_open(struct dfs_fd *file)
             file->size = f_size(fd);
             file->data = fd;
 
+#if _USE_FASTSEEK
+            /* the link map is only for the file not expanded */
+            if (RT_DFS_ELM_FASTSEEK_SIZE > 0 && !(mode & FA_WRITE) &&
+                f_size(fd) >= RT_DFS_ELM_FASTSEEK_SIZE)
+            {
+                elm_create_linkmap(fd);
+            }
+#endif
+
             if (file->flags & O_APPEND)
             {
                 /* seek to the end of file */
@@ -481,6 +554,9 @@ int dfs_elm_close(struct dfs_fd *file)
         if (result == FR_OK)
         {
             /* release memory */
+#if _USE_FASTSEEK
+            rt_free(fd->cltbl);
+#endif
             rt_free(fd);
         }
     }
@@ -808,7 +884,11 @@ static const struct dfs_file_ops dfs_elm_fops =
 static const struct dfs_filesystem_ops dfs_elm =
 {
     "elm",
+#ifdef RT_DFS_ELM_REENTRANT
     DFS_FS_FLAG_DEFAULT,
+#else
+    DFS_FS_FLAG_LOCKED,     /* FatFs is not reentrant */
+#endif
     &dfs_elm_fops,
 
     dfs_elm_mount,
@@ -847,12 +927,67 @@ DSTATUS disk_status(BYTE drv)
     return 0;
 }
 
+#if RT_DFS_ELM_DMA_ALIGN > 1
+/* transfer the sectors of unaligned buffer through the aligned bounce buffer */
+static DRESULT disk_bounce_transfer(BYTE drv, BYTE *buff, DWORD sector, UINT count, int write)
+{
+    UINT n;
+    rt_size_t result, bytes;
+    rt_device_t device = disk[drv];
+    struct rt_device_blk_geometry geometry;
+
+    rt_memset(&geometry, 0, sizeof(geometry));
+    rt_device_control(device, RT_DEVICE_CTRL_BLK_GETGEOME, &geometry);
+    if (geometry.bytes_per_sector == 0 || geometry.bytes_per_sector > _MAX_SS)
+        return RES_ERROR;
+
+    if (disk_bounce[drv] == RT_NULL)
+    {
+        disk_bounce[drv] = (BYTE *)rt_malloc_align(ELM_BOUNCE_SECTORS * _MAX_SS,
+                                                   RT_DFS_ELM_DMA_ALIGN);
+        if (disk_bounce[drv] == RT_NULL)
+            return RES_ERROR;
+    }
+
+    while (count > 0)
+    {
+        n = count > ELM_BOUNCE_SECTORS ? ELM_BOUNCE_SECTORS : count;
+        bytes = n * geometry.bytes_per_sector;
+
+        if (write)
+        {
+            rt_memcpy(disk_bounce[drv], buff, bytes);
+            result = rt_device_write(device, sector, disk_bounce[drv], n);
+        }
+        else
+        {
+            result = rt_device_read(device, sector, disk_bounce[drv], n);
+            rt_memcpy(buff, disk_bounce[drv], bytes);
+        }
+        if (result != n)
+            return RES_ERROR;
+
+        buff += bytes;
+        sector += n;
+        count -= n;
+    }
+
+    return RES_OK;
+}
+#endif
+
 /* Read Sector(s) */
 DRESULT disk_read (BYTE drv, BYTE* buff, DWORD sector, UINT count)
 {
     rt_size_t result;
     rt_device_t device = disk[drv];
 
+#if RT_DFS_ELM_DMA_ALIGN > 1
+    /* the buffer of user is transferred directly if it's aligned */
+    if ((rt_ubase_t)buff & (RT_DFS_ELM_DMA_ALIGN - 1))
+        return disk_bounce_transfer(drv, buff, sector, count, 0);
+#endif
+
     result = rt_device_read(device, sector, buff, count);
     if (result == count)
     {
@@ -868,6 +1003,11 @@ DRESULT disk_write (BYTE drv, const BYTE* buff, DWORD sector, UINT count)
     rt_size_t result;
     rt_device_t device = disk[drv];
 
+#if RT_DFS_ELM_DMA_ALIGN > 1
+    if ((rt_ubase_t)buff & (RT_DFS_ELM_DMA_ALIGN - 1))
+        return disk_bounce_transfer(drv, (BYTE *)buff, sector, count, 1);
+#endif
+
     result = rt_device_write(device, sector, buff, count);
     if (result == count)
     {
@@ -999,7 +1139,7 @@ void ff_rel_grant(_SYNC_t m)
 #endif
 
 /* Memory functions */
-#if _USE_LFN == 3
+#if _USE_LFN == 3 || _USE_FREEMAP
 /* Allocate memory block */
 void *ff_memalloc(UINT size)
 {
@@ -1011,5 +1151,5 @@ void ff_memfree(void *mem)
 {
     rt_free(mem);
 }
-#endif /* _USE_LFN == 3 */
+#endif /* _USE_LFN == 3 || _USE_FREEMAP */
 
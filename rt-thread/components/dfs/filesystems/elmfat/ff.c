@@ -919,6 +919,73 @@ FRESULT move_window (	/* Returns FR_OK or FR_DISK_ERROR */
 
 
 
+#if _USE_FATWIN
+/*-----------------------------------------------------------------------*/
+/* Move/Flush FAT access window in the file system object                */
+/*-----------------------------------------------------------------------*/
+#if !_FS_READONLY
+static
+FRESULT sync_fatwin (	/* Returns FR_OK or FR_DISK_ERROR */
+	FATFS* fs			/* File system object */
+)
+{
+	DWORD wsect;
+	UINT nf;
+	FRESULT res = FR_OK;
+
+
+	if (fs->fwflag) {	/* Write back the FAT sector if it is dirty */
+		wsect = fs->fatsect;
+		if (disk_write(fs->drv, fs->fatwin, wsect, 1) != RES_OK) {
+			res = FR_DISK_ERR;
+		} else {
+			fs->fwflag = 0;
+			for (nf = fs->n_fats; nf >= 2; nf--) {	/* Reflect the change to all FAT copies */
+				wsect += fs->fsize;
+				disk_write(fs->drv, fs->fatwin, wsect, 1);
+			}
+		}
+	}
+	return res;
+}
+#endif
+
+
+static
+FRESULT move_fatwin (	/* Returns FR_OK or FR_DISK_ERROR */
+	FATFS* fs,			/* File system object */
+	DWORD sector		/* FAT sector number to make appearance in the fs->fatwin[] */
+)
+{
+	FRESULT res = FR_OK;
+
+
+	if (sector != fs->fatsect) {	/* Window offset changed? */
+#if !_FS_READONLY
+		res = sync_fatwin(fs);		/* Write-back changes */
+#endif
+		if (res == FR_OK) {			/* Fill FAT window with new data */
+			if (disk_read(fs->drv, fs->fatwin, sector, 1) != RES_OK) {
+				sector = 0xFFFFFFFF;	/* Invalidate window if data is not reliable */
+				res = FR_DISK_ERR;
+			}
+			fs->fatsect = sector;
+		}
+	}
+	return res;
+}
+
+#define FAT_WIN(fs)			((fs)->fatwin)
+#define FAT_MOVE(fs, sect)	move_fatwin(fs, sect)
+#define FAT_DIRTY(fs)		((fs)->fwflag = 1)
+#else
+#define FAT_WIN(fs)			((fs)->win)
+#define FAT_MOVE(fs, sect)	move_window(fs, sect)
+#define FAT_DIRTY(fs)		((fs)->wflag = 1)
+#endif
+
+
+
 
 #if !_FS_READONLY
 /*-----------------------------------------------------------------------*/
@@ -933,7 +1000,12 @@ FRESULT sync_fs (	/* FR_OK:succeeded, !=0:error */
 	FRESULT res;
 
 
+#if _USE_FATWIN
+	res = sync_fatwin(fs);
+	if (res == FR_OK) res = sync_window(fs);
+#else
 	res = sync_window(fs);
+#endif
 	if (res == FR_OK) {
 		/* Update FSInfo sector if needed */
 		if (fs->fs_type == FS_FAT32 && fs->fsi_flag == 1) {
@@ -1002,21 +1074,21 @@ DWORD get_fat (	/* 0xFFFFFFFF:Disk error, 1:Internal error, 2..0x7FFFFFFF:Cluste
 		switch (fs->fs_type) {
 		case FS_FAT12 :
 			bc = (UINT)clst; bc += bc / 2;
-			if (move_window(fs, fs->fatbase + (bc / SS(fs))) != FR_OK) break;
-			wc = fs->win[bc++ % SS(fs)];
-			if (move_window(fs, fs->fatbase + (bc / SS(fs))) != FR_OK) break;
-			wc |= fs->win[bc % SS(fs)] << 8;
+			if (FAT_MOVE(fs, fs->fatbase + (bc / SS(fs))) != FR_OK) break;
+			wc = FAT_WIN(fs)[bc++ % SS(fs)];
+			if (FAT_MOVE(fs, fs->fatbase + (bc / SS(fs))) != FR_OK) break;
+			wc |= FAT_WIN(fs)[bc % SS(fs)] << 8;
 			val = (clst & 1) ? (wc >> 4) : (wc & 0xFFF);
 			break;
 
 		case FS_FAT16 :
-			if (move_window(fs, fs->fatbase + (clst / (SS(fs) / 2))) != FR_OK) break;
-			val = ld_word(fs->win + clst * 2 % SS(fs));
+			if (FAT_MOVE(fs, fs->fatbase + (clst / (SS(fs) / 2))) != FR_OK) break;
+			val = ld_word(FAT_WIN(fs) + clst * 2 % SS(fs));
 			break;
 
 		case FS_FAT32 :
-			if (move_window(fs, fs->fatbase + (clst / (SS(fs) / 4))) != FR_OK) break;
-			val = ld_dword(fs->win + clst * 4 % SS(fs)) & 0x0FFFFFFF;
+			if (FAT_MOVE(fs, fs->fatbase + (clst / (SS(fs) / 4))) != FR_OK) break;
+			val = ld_dword(FAT_WIN(fs) + clst * 4 % SS(fs)) & 0x0FFFFFFF;
 			break;
 #if _FS_EXFAT
 		case FS_EXFAT :
@@ -1035,8 +1107,8 @@ DWORD get_fat (	/* 0xFFFFFFFF:Disk error, 1:Internal error, 2..0x7FFFFFFF:Cluste
 					break;
 				}
 				if (obj->stat != 2) {	/* Get value from FAT if FAT chain is valid */
-					if (move_window(fs, fs->fatbase + (clst / (SS(fs) / 4))) != FR_OK) break;
-					val = ld_dword(fs->win + clst * 4 % SS(fs)) & 0x7FFFFFFF;
+					if (FAT_MOVE(fs, fs->fatbase + (clst / (SS(fs) / 4))) != FR_OK) break;
+					val = ld_dword(FAT_WIN(fs) + clst * 4 % SS(fs)) & 0x7FFFFFFF;
 					break;
 				}
 			}
@@ -1074,42 +1146,167 @@ FRESULT put_fat (	/* FR_OK(0):succeeded, !=0:error */
 		switch (fs->fs_type) {
 		case FS_FAT12 :	/* Bitfield items */
 			bc = (UINT)clst; bc += bc / 2;
-			res = move_window(fs, fs->fatbase + (bc / SS(fs)));
+			res = FAT_MOVE(fs, fs->fatbase + (bc / SS(fs)));
 			if (res != FR_OK) break;
-			p = fs->win + bc++ % SS(fs);
+			p = FAT_WIN(fs) + bc++ % SS(fs);
 			*p = (clst & 1) ? ((*p & 0x0F) | ((BYTE)val << 4)) : (BYTE)val;
-			fs->wflag = 1;
-			res = move_window(fs, fs->fatbase + (bc / SS(fs)));
+			FAT_DIRTY(fs);
+			res = FAT_MOVE(fs, fs->fatbase + (bc / SS(fs)));
 			if (res != FR_OK) break;
-			p = fs->win + bc % SS(fs);
+			p = FAT_WIN(fs) + bc % SS(fs);
 			*p = (clst & 1) ? (BYTE)(val >> 4) : ((*p & 0xF0) | ((BYTE)(val >> 8) & 0x0F));
-			fs->wflag = 1;
+			FAT_DIRTY(fs);
 			break;
 
 		case FS_FAT16 :	/* WORD aligned items */
-			res = move_window(fs, fs->fatbase + (clst / (SS(fs) / 2)));
+			res = FAT_MOVE(fs, fs->fatbase + (clst / (SS(fs) / 2)));
 			if (res != FR_OK) break;
-			st_word(fs->win + clst * 2 % SS(fs), (WORD)val);
-			fs->wflag = 1;
+			st_word(FAT_WIN(fs) + clst * 2 % SS(fs), (WORD)val);
+			FAT_DIRTY(fs);
 			break;
 
 		case FS_FAT32 :	/* DWORD aligned items */
 #if _FS_EXFAT
 		case FS_EXFAT :
 #endif
-			res = move_window(fs, fs->fatbase + (clst / (SS(fs) / 4)));
+			res = FAT_MOVE(fs, fs->fatbase + (clst / (SS(fs) / 4)));
 			if (res != FR_OK) break;
 			if (!_FS_EXFAT || fs->fs_type != FS_EXFAT) {
-				val = (val & 0x0FFFFFFF) | (ld_dword(fs->win + clst * 4 % SS(fs)) & 0xF0000000);
+				val = (val & 0x0FFFFFFF) | (ld_dword(FAT_WIN(fs) + clst * 4 % SS(fs)) & 0xF0000000);
 			}
-			st_dword(fs->win + clst * 4 % SS(fs), val);
-			fs->wflag = 1;
+			st_dword(FAT_WIN(fs) + clst * 4 % SS(fs), val);
+			FAT_DIRTY(fs);
 			break;
 		}
 	}
+#if _USE_FREEMAP
+	if (res == FR_OK && fs->fmap) {	/* Reflect the change to the free cluster map */
+		if (val & 0x0FFFFFFF) {
+			fs->fmap[clst / 32] |= (DWORD)1 << (clst % 32);
+		} else {
+			fs->fmap[clst / 32] &= ~((DWORD)1 << (clst % 32));
+		}
+	}
+#endif
 	return res;
 }
 
+
+
+
+#if _USE_FREEMAP
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Free cluster map of FAT12/16/32 volume                 */
+/*-----------------------------------------------------------------------*/
+
+#define FMAP_USED(fs, clst)	((fs)->fmap[(clst) / 32] & ((DWORD)1 << ((clst) % 32)))
+
+static
+void free_fmap (
+	FATFS* fs	/* File system object */
+)
+{
+	if (fs->fmap) ff_memfree(fs->fmap);
+	fs->fmap = 0;
+	fs->fmap_flag = 0;
+}
+
+
+static
+FRESULT make_fmap (	/* FR_OK:The map is available, FR_NOT_ENOUGH_CORE:Not available, others:Error */
+	FATFS* fs		/* File system object */
+)
+{
+	FRESULT res = FR_OK;
+	DWORD *map, nfree, clst, sect, stat;
+	UINT i, sz;
+	BYTE *p;
+	_FDID obj;
+
+
+	if (fs->fmap_flag == 1) return FR_OK;
+	if (fs->fmap_flag == 2 || fs->fs_type == FS_EXFAT) return FR_NOT_ENOUGH_CORE;
+
+	sz = (UINT)((fs->n_fatent + 31) / 32) * sizeof (DWORD);
+	map = (sz <= _USE_FREEMAP) ? ff_memalloc(sz) : 0;
+	if (!map) {
+		fs->fmap_flag = 2;		/* Do not try it again until remount */
+		return FR_NOT_ENOUGH_CORE;
+	}
+	mem_set(map, 0xFF, sz);		/* Reserved clusters and the tail of map are always 'in use' */
+
+	nfree = 0;
+	if (fs->fs_type == FS_FAT12) {	/* FAT12: Sector unaligned FAT entries */
+		obj.fs = fs;
+		for (clst = 2; clst < fs->n_fatent; clst++) {
+			stat = get_fat(&obj, clst);
+			if (stat == 0xFFFFFFFF) { res = FR_DISK_ERR; break; }
+			if (stat == 1) { res = FR_INT_ERR; break; }
+			if (stat == 0) {
+				map[clst / 32] &= ~((DWORD)1 << (clst % 32));
+				nfree++;
+			}
+		}
+	} else {						/* FAT16/32: Sector aligned FAT entries */
+		sect = fs->fatbase;
+		i = 0; p = 0;
+		for (clst = 0; clst < fs->n_fatent; clst++) {
+			if (i == 0) {
+				res = FAT_MOVE(fs, sect++);
+				if (res != FR_OK) break;
+				p = FAT_WIN(fs);
+				i = SS(fs);
+			}
+			if (fs->fs_type == FS_FAT16) {
+				stat = ld_word(p);
+				p += 2; i -= 2;
+			} else {
+				stat = ld_dword(p) & 0x0FFFFFFF;
+				p += 4; i -= 4;
+			}
+			if (stat == 0 && clst >= 2) {
+				map[clst / 32] &= ~((DWORD)1 << (clst % 32));
+				nfree++;
+			}
+		}
+	}
+	if (res != FR_OK) {
+		ff_memfree(map);
+		return res;
+	}
+
+	fs->fmap = map;
+	fs->fmap_flag = 1;
+	fs->free_clst = nfree;	/* Now free_clst is valid */
+	fs->fsi_flag |= 1;
+	return FR_OK;
+}
+
+
+static
+DWORD find_fmap (	/* 0:No free cluster, 2..:Free cluster found */
+	FATFS* fs,		/* File system object */
+	DWORD clst		/* Cluster number to scan from */
+)
+{
+	DWORD n = fs->n_fatent;
+
+
+	while (n) {
+		if (++clst >= fs->n_fatent) clst = 2;	/* Wrap-around */
+		if (fs->fmap[clst / 32] == 0xFFFFFFFF) {	/* Skip the rest of a word in use at once */
+			n -= (n > 32 - clst % 32) ? 32 - clst % 32 : n;
+			clst |= 31;
+			continue;
+		}
+		if (!FMAP_USED(fs, clst)) return clst;
+		n--;
+	}
+	return 0;
+}
+
+#endif /* _USE_FREEMAP */
+
 #endif /* !_FS_READONLY */
 
 
@@ -1349,17 +1546,28 @@ DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk err
 	} else
 #endif
 	{	/* On the FAT12/16/32 volume */
-		ncl = scl;	/* Start cluster */
-		for (;;) {
-			ncl++;							/* Next cluster */
-			if (ncl >= fs->n_fatent) {		/* Check wrap-around */
-				ncl = 2;
-				if (ncl > scl) return 0;	/* No free cluster */
+#if _USE_FREEMAP
+		res = make_fmap(fs);				/* Build the free cluster map at first */
+		if (res == FR_DISK_ERR) return 0xFFFFFFFF;
+		if (res == FR_INT_ERR) return 1;
+		if (fs->fmap) {
+			ncl = find_fmap(fs, scl);		/* Find a free cluster on the map */
+			if (ncl == 0) return 0;			/* No free cluster */
+		} else
+#endif
+		{
+			ncl = scl;	/* Start cluster */
+			for (;;) {
+				ncl++;							/* Next cluster */
+				if (ncl >= fs->n_fatent) {		/* Check wrap-around */
+					ncl = 2;
+					if (ncl > scl) return 0;	/* No free cluster */
+				}
+				cs = get_fat(obj, ncl);			/* Get the cluster status */
+				if (cs == 0) break;				/* Found a free cluster */
+				if (cs == 1 || cs == 0xFFFFFFFF) return cs;	/* An error occurred */
+				if (ncl == scl) return 0;		/* No free cluster */
 			}
-			cs = get_fat(obj, ncl);			/* Get the cluster status */
-			if (cs == 0) break;				/* Found a free cluster */
-			if (cs == 1 || cs == 0xFFFFFFFF) return cs;	/* An error occurred */
-			if (ncl == scl) return 0;		/* No free cluster */
 		}
 	}
 
@@ -1374,7 +1582,7 @@ DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk err
 
 	if (res == FR_OK) {			/* Update FSINFO if function succeeded. */
 		fs->last_clst = ncl;
-		if (fs->free_clst < fs->n_fatent - 2) fs->free_clst--;
+		if (fs->free_clst <= fs->n_fatent - 2) fs->free_clst--;
 		fs->fsi_flag |= 1;
 	} else {
 		ncl = (res == FR_DISK_ERR) ? 0xFFFFFFFF : 1;	/* Failed. Create error status */
@@ -1383,6 +1591,103 @@ DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk err
 	return ncl;		/* Return new cluster number or error status */
 }
 
+
+
+
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Stretch the chain of a file being written              */
+/*-----------------------------------------------------------------------*/
+static
+DWORD stretch_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk error, >=2:Next cluster# */
+	FIL* fp,			/* Pointer to the file object */
+	DWORD clst			/* Cluster# to stretch, 0:Create a new chain */
+)
+{
+	DWORD ncl;
+#if _USE_PREALLOC
+	DWORD pcl, cs;
+	UINT n;
+	FATFS *fs = fp->obj.fs;
+#endif
+
+
+	ncl = create_chain(&fp->obj, clst);	/* Follow or stretch cluster chain on the FAT */
+#if _USE_PREALLOC
+	/* Preallocate the following clusters when the end of chain is reached, it keeps
+	   the files written at the same time from interleaving cluster by cluster */
+	if (ncl >= 2 && ncl == fs->last_clst && (!_FS_EXFAT || fs->fs_type != FS_EXFAT)) {
+		cs = get_fat(&fp->obj, ncl);
+		if (cs == 0xFFFFFFFF) return cs;
+		if (cs < fs->n_fatent) return ncl;	/* It is not the last cluster */
+		for (pcl = ncl, n = _USE_PREALLOC; n && pcl + 1 < fs->n_fatent; n--, pcl++) {
+#if _USE_FREEMAP
+			if (fs->fmap) {
+				if (FMAP_USED(fs, pcl + 1)) break;
+			} else
+#endif
+			{
+				cs = get_fat(&fp->obj, pcl + 1);
+				if (cs != 0) break;			/* Not free or an error (left to the next allocation) */
+			}
+			if (put_fat(fs, pcl + 1, 0xFFFFFFFF) != FR_OK || put_fat(fs, pcl, pcl + 1) != FR_OK) {
+				return 0xFFFFFFFF;
+			}
+			fs->last_clst = pcl + 1;
+			if (fs->free_clst <= fs->n_fatent - 2) fs->free_clst--;
+			fs->fsi_flag |= 1;
+			fp->prealloc = 1;
+		}
+	}
+#endif
+	return ncl;
+}
+
+
+
+
+#if _USE_PREALLOC
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Remove the preallocated clusters beyond the file size  */
+/*-----------------------------------------------------------------------*/
+static
+FRESULT trim_chain (	/* FR_OK(0):succeeded, !=0:error */
+	FIL* fp				/* Pointer to the file object */
+)
+{
+	FRESULT res = FR_OK;
+	FATFS *fs = fp->obj.fs;
+	DWORD clst, nxt, bcs = (DWORD)fs->csize * SS(fs);
+	FSIZE_t ofs;
+
+
+	if (!fp->prealloc || !fp->obj.sclust) return FR_OK;
+
+	if (fp->obj.objsize == 0) {	/* Remove the entire chain */
+		res = remove_chain(&fp->obj, fp->obj.sclust, 0);
+		fp->obj.sclust = 0;
+		fp->flag |= FA_MODIFIED;
+	} else {
+		/* Get the last cluster in the file size */
+		if (fp->fptr && (fp->fptr - 1) / bcs == (fp->obj.objsize - 1) / bcs) {
+			clst = fp->clust;
+		} else {
+			clst = fp->obj.sclust;
+			for (ofs = bcs; ofs < fp->obj.objsize; ofs += bcs) {
+				clst = get_fat(&fp->obj, clst);
+				if (clst == 0xFFFFFFFF) return FR_DISK_ERR;
+				if (clst < 2 || clst >= fs->n_fatent) return FR_INT_ERR;
+			}
+		}
+		nxt = get_fat(&fp->obj, clst);
+		if (nxt == 0xFFFFFFFF) return FR_DISK_ERR;
+		if (nxt == 1) return FR_INT_ERR;
+		if (nxt < fs->n_fatent) res = remove_chain(&fp->obj, nxt, clst);	/* Remove the clusters beyond the file size */
+	}
+	if (res == FR_OK) fp->prealloc = 0;
+	return res;
+}
+#endif
+
 #endif /* !_FS_READONLY */
 
 
@@ -1419,6 +1724,50 @@ DWORD clmt_clust (	/* <2:Error, >=2:Cluster number */
 
 
 
+/*-----------------------------------------------------------------------*/
+/* File access - Get sectors in contiguous clusters following the current */
+/*-----------------------------------------------------------------------*/
+
+static
+UINT contig_sect (	/* Number of sectors in the contiguous clusters (fp->clust is moved to the last one) */
+	FIL* fp,		/* Pointer to the file object */
+	UINT nsect,		/* Maximum number of sectors */
+	int stretch		/* 0:Follow the chain, 1:Stretch the chain if needed */
+)
+{
+	FATFS *fs = fp->obj.fs;
+	DWORD nxt, bcs = (DWORD)fs->csize * SS(fs);
+	FSIZE_t ofs = (fp->fptr / bcs + 1) * bcs;	/* Offset of the next cluster */
+	UINT n = 0;
+
+
+	while (n < nsect) {
+#if _USE_FASTSEEK
+		if (fp->cltbl) {
+			nxt = clmt_clust(fp, ofs);		/* Get cluster# from the CLMT */
+		} else
+#endif
+		{
+#if !_FS_READONLY
+			if (stretch) {
+				nxt = stretch_chain(fp, fp->clust);	/* Follow or stretch cluster chain on the FAT */
+			} else
+#endif
+			{
+				nxt = get_fat(&fp->obj, fp->clust);	/* Follow cluster chain on the FAT */
+			}
+		}
+		if (nxt != fp->clust + 1) break;	/* Not contiguous, end of chain or error (left to the caller) */
+		fp->clust = nxt;
+		n += fs->csize;
+		ofs += bcs;
+	}
+	return (n > nsect) ? nsect : n;
+}
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Set directory index                              */
 /*-----------------------------------------------------------------------*/
@@ -2981,6 +3330,12 @@ FRESULT find_volume (	/* FR_OK(0): successful, !=0: any error occurred */
 	/* Following code attempts to mount the volume. (analyze BPB and initialize the fs object) */
 
 	fs->fs_type = 0;					/* Clear the file system object */
+#if _USE_FREEMAP && !_FS_READONLY
+	free_fmap(fs);						/* Discard free cluster map of the previous mount */
+#endif
+#if _USE_FATWIN
+	fs->fwflag = 0; fs->fatsect = 0xFFFFFFFF;	/* Invalidate FAT window */
+#endif
 	fs->drv = LD2PD(vol);				/* Bind the logical drive and a physical drive */
 	stat = disk_initialize(fs->drv);	/* Initialize the physical drive */
 	if (stat & STA_NOINIT) { 			/* Check if the initialization succeeded */
@@ -3217,12 +3572,19 @@ FRESULT f_mount (
 #endif
 #if _FS_REENTRANT						/* Discard sync object of the current volume */
 		if (!ff_del_syncobj(cfs->sobj)) return FR_INT_ERR;
+#endif
+#if _USE_FREEMAP && !_FS_READONLY
+		free_fmap(cfs);					/* Discard free cluster map of the current volume */
 #endif
 		cfs->fs_type = 0;				/* Clear old fs object */
 	}
 
 	if (fs) {
 		fs->fs_type = 0;				/* Clear new fs object */
+#if _USE_FREEMAP && !_FS_READONLY
+		fs->fmap = 0;
+		fs->fmap_flag = 0;
+#endif
 #if _FS_REENTRANT						/* Create sync object for the new volume */
 		if (!ff_cre_syncobj((BYTE)vol, &fs->sobj)) return FR_INT_ERR;
 #endif
@@ -3398,6 +3760,9 @@ FRESULT f_open (
 			fp->obj.id = fs->id;
 			fp->flag = mode;		/* Set file access mode */
 			fp->err = 0;			/* Clear error flag */
+#if _USE_PREALLOC && !_FS_READONLY
+			fp->prealloc = 0;		/* No cluster is preallocated */
+#endif
 			fp->sect = 0;			/* Invalidate current data sector */
 			fp->fptr = 0;			/* Set file pointer top of the file */
 #if !_FS_READONLY
@@ -3493,6 +3858,7 @@ FRESULT f_read (
 			if (cc) {							/* Read maximum contiguous sectors directly */
 				if (csect + cc > fs->csize) {	/* Clip at cluster boundary */
 					cc = fs->csize - csect;
+					cc += contig_sect(fp, btr / SS(fs) - cc, 0);	/* Extend over the contiguous clusters */
 				}
 				if (disk_read(fs->drv, rbuff, sect, cc) != RES_OK) ABORT(fs, FR_DISK_ERR);
 #if !_FS_READONLY && _FS_MINIMIZE <= 2			/* Replace one of the read sectors with cached data if it contains a dirty sector */
@@ -3575,7 +3941,7 @@ FRESULT f_write (
 				if (fp->fptr == 0) {		/* On the top of the file? */
 					clst = fp->obj.sclust;	/* Follow from the origin */
 					if (clst == 0) {		/* If no cluster is allocated, */
-						clst = create_chain(&fp->obj, 0);	/* create a new cluster chain */
+						clst = stretch_chain(fp, 0);	/* create a new cluster chain */
 					}
 				} else {					/* On the middle or end of the file */
 #if _USE_FASTSEEK
@@ -3584,7 +3950,7 @@ FRESULT f_write (
 					} else
 #endif
 					{
-						clst = create_chain(&fp->obj, fp->clust);	/* Follow or stretch cluster chain on the FAT */
+						clst = stretch_chain(fp, fp->clust);	/* Follow or stretch cluster chain on the FAT */
 					}
 				}
 				if (clst == 0) break;		/* Could not allocate a new cluster (disk full) */
@@ -3608,6 +3974,7 @@ FRESULT f_write (
 			if (cc) {						/* Write maximum contiguous sectors directly */
 				if (csect + cc > fs->csize) {	/* Clip at cluster boundary */
 					cc = fs->csize - csect;
+					cc += contig_sect(fp, btw / SS(fs) - cc, 1);	/* Extend over the contiguous clusters */
 				}
 				if (disk_write(fs->drv, wbuff, sect, cc) != RES_OK) ABORT(fs, FR_DISK_ERR);
 #if _FS_MINIMIZE <= 2
@@ -3751,6 +4118,16 @@ FRESULT f_close (
 	FATFS *fs;
 
 #if !_FS_READONLY
+#if _USE_PREALLOC
+	res = validate(&fp->obj, &fs);		/* Check validity of the file object */
+	if (res == FR_OK) {
+		if (!fp->err) res = trim_chain(fp);	/* Remove the preallocated clusters */
+#if _FS_REENTRANT
+		unlock_fs(fs, res);
+#endif
+	}
+	if (res == FR_OK)
+#endif
 	res = f_sync(fp);					/* Flush cached data */
 	if (res == FR_OK)
 #endif
@@ -4349,7 +4726,16 @@ FRESULT f_getfree (
 		/* If free_clst is valid, return it without full cluster scan */
 		if (fs->free_clst <= fs->n_fatent - 2) {
 			*nclst = fs->free_clst;
-		} else {
+		} else
+#if _USE_FREEMAP
+		if ((res = make_fmap(fs)) != FR_NOT_ENOUGH_CORE) {	/* Count free clusters on building the free cluster map */
+			if (res == FR_OK) *nclst = fs->free_clst;
+		} else
+#endif
+		{
+#if _USE_FREEMAP
+			res = FR_OK;
+#endif
 			/* Get number of free clusters */
 			nfree = 0;
 			if (fs->fs_type == FS_FAT12) {	/* FAT12: Sector unalighed FAT entries */
@@ -4384,9 +4770,9 @@ FRESULT f_getfree (
 					i = 0; p = 0;
 					do {
 						if (i == 0) {
-							res = move_window(fs, sect++);
+							res = FAT_MOVE(fs, sect++);
 							if (res != FR_OK) break;
-							p = fs->win;
+							p = FAT_WIN(fs);
 							i = SS(fs);
 						}
 						if (fs->fs_type == FS_FAT16) {
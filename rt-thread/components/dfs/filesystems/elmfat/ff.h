@@ -115,6 +115,10 @@ typedef struct {
 	DWORD	last_clst;		/* Last allocated cluster */
 	DWORD	free_clst;		/* Number of free clusters */
 #endif
+#if _USE_FREEMAP && !_FS_READONLY
+	BYTE	fmap_flag;		/* Free cluster map status (0:not built, 1:built, 2:not available) */
+	DWORD*	fmap;			/* Free cluster map (1 bit per cluster, 1:in use) */
+#endif
 #if _FS_RPATH != 0
 	DWORD	cdir;			/* Current directory start cluster (0:root) */
 #if _FS_EXFAT
@@ -131,6 +135,11 @@ typedef struct {
 	DWORD	database;		/* Data base sector */
 	DWORD	winsect;		/* Current sector appearing in the win[] */
 	BYTE	win[_MAX_SS];	/* Disk access window for Directory, FAT (and file data at tiny cfg) */
+#if _USE_FATWIN
+	BYTE	fwflag;			/* fatwin[] flag (b0:dirty) */
+	DWORD	fatsect;		/* Current sector appearing in the fatwin[] */
+	BYTE	fatwin[_MAX_SS];	/* Disk access window for FAT */
+#endif
 } FATFS;
 
 
@@ -170,6 +179,9 @@ typedef struct {
 	DWORD	dir_sect;		/* Sector number containing the directory entry */
 	BYTE*	dir_ptr;		/* Pointer to the directory entry in the win[] */
 #endif
+#if _USE_PREALLOC && !_FS_READONLY
+	BYTE	prealloc;		/* Clusters are preallocated beyond the file size (trimmed on close) */
+#endif
 #if _USE_FASTSEEK
 	DWORD*	cltbl;			/* Pointer to the cluster link map table (nulled on open, set by application) */
 #endif
@@ -307,11 +319,12 @@ DWORD get_fattime (void);
 #if _USE_LFN != 0						/* Unicode - OEM code conversion */
 WCHAR ff_convert (WCHAR chr, UINT dir);	/* OEM-Unicode bidirectional conversion */
 WCHAR ff_wtoupper (WCHAR chr);			/* Unicode upper-case conversion */
-#if _USE_LFN == 3						/* Memory functions */
+#endif
+
+#if _USE_LFN == 3 || _USE_FREEMAP		/* Memory functions */
 void* ff_memalloc (UINT msize);			/* Allocate memory block */
 void ff_memfree (void* mblock);			/* Free memory block */
 #endif
-#endif
 
 /* Sync functions */
 #if _FS_REENTRANT
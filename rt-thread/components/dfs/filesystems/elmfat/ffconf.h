@@ -51,6 +51,37 @@
 /* This option switches f_expand function. (0:Disable or 1:Enable) */
 
 
+#ifdef RT_DFS_ELM_FAT_WINDOW
+#define _USE_FATWIN		1
+#else
+#define _USE_FATWIN		0
+#endif
+/* This option switches the dedicated sector window for FAT. (0:Disable or 1:Enable)
+/  When enabled, FAT sectors are cached apart from the directory sectors, so that
+/  allocating clusters and updating directory entries do not evict each other. */
+
+
+#ifdef RT_DFS_ELM_FREE_MAP_SIZE
+#define _USE_FREEMAP	RT_DFS_ELM_FREE_MAP_SIZE
+#else
+#define _USE_FREEMAP	0
+#endif
+/* This option defines the maximum size in bytes of the free cluster map of a
+/  FAT12/16/32 volume, 0 to disable. The map holds a bit per cluster, it is built
+/  on the first allocation or f_getfree() and cluster allocation searches it
+/  instead of scanning the FAT. */
+
+
+#ifdef RT_DFS_ELM_PREALLOC_CLUSTERS
+#define _USE_PREALLOC	RT_DFS_ELM_PREALLOC_CLUSTERS
+#else
+#define _USE_PREALLOC	0
+#endif
+/* This option defines how many contiguous clusters are preallocated when f_write()
+/  stretches the cluster chain of a file on FAT12/16/32 volume, 0 to disable. The
+/  clusters beyond the file size are removed on f_close(). */
+
+
 #define _USE_CHMOD		0
 /* This option switches attribute manipulation functions, f_chmod() and f_utime().
 /  (0:Disable or 1:Enable) Also _FS_READONLY needs to be 0 to enable this option. */
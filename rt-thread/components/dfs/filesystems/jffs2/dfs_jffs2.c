@@ -104,6 +104,18 @@ static int jffs2_result_to_dfs(int result)
 /*
  * RT-Thread DFS Interface for jffs2
  */
+/* the GC thread and the compressor benchmark work under the lock of file
+ * system operations */
+rt_err_t jffs2_fs_lock(rt_int32_t timeout)
+{
+    return rt_mutex_take(&jffs2_lock, timeout);
+}
+
+void jffs2_fs_unlock(void)
+{
+    rt_mutex_release(&jffs2_lock);
+}
+
 static int dfs_jffs2_mount(struct dfs_filesystem* fs,
                     unsigned long rwflag,
                     const void* data)
@@ -177,7 +189,10 @@ static int dfs_jffs2_unmount(struct dfs_filesystem* fs)
     {
         if (device_partition[index].dev == RT_MTD_NOR_DEVICE(fs->dev_id))
         {
+            /* the GC thread of jffs2 takes the lock too */
+            rt_mutex_take(&jffs2_lock, RT_WAITING_FOREVER);
             result = jffs2_umount(device_partition[index].mte);
+            rt_mutex_release(&jffs2_lock);
             if (result) return jffs2_result_to_dfs(result);
 
             rt_free(device_partition[index].mte);
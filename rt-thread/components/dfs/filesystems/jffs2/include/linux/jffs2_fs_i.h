@@ -40,6 +40,8 @@ struct jffs2_inode_info {
 
 	uint16_t flags;
 	uint8_t usercompr;
+	uint8_t compr_fails;	/* blocks failed to compress in a row */
+	uint8_t compr_skip;	/* blocks to write without compression */
 #if !defined (__ECOS) && !defined(RT_THREAD)
 #if LINUX_VERSION_CODE > KERNEL_VERSION(2,5,2)
 	struct inode vfs_inode;
@@ -1,6 +1,8 @@
 #ifndef JFFS2_CONFIG_H
 #define JFFS2_CONFIG_H
 
+#include <rtconfig.h>
+
 #define __ECOS  /* must be defined */
 
 #define FILE_PATH_MAX                128  /* the longest file path */
@@ -35,19 +37,44 @@
 /* jffs2 debug output opion */
 #define CONFIG_JFFS2_FS_DEBUG 		0  /* 1 or 2 */
 
-/* jffs2 gc thread section */
-//#define CYGOPT_FS_JFFS2_GCTHREAD
+/* jffs2 gc thread section, the garbage collection and erasing of blocks
+ * run in background instead of the writing */
+#ifdef RT_JFFS2_USING_GCTHREAD
+#define CYGOPT_FS_JFFS2_GCTHREAD
+#endif
 #define CYGNUM_JFFS2_GC_THREAD_PRIORITY  (RT_THREAD_PRIORITY_MAX-2) /* GC thread's priority */
 #define CYGNUM_JFFS2_GS_THREAD_TICKS  20  /* event timeout ticks */
 #define CYGNUM_JFFS2_GC_THREAD_TICKS  20  /* GC thread's running ticks */
+#define CYGNUM_JFFS2_GC_THREAD_STACK_SIZE  (1024*4) /* GC thread's stack size */
+
+/* erase block summary, a block filled is mounted by reading its summary
+ * node instead of scanning all the nodes in it */
+#ifdef RT_JFFS2_USING_SUMMARY
+#define CONFIG_JFFS2_SUMMARY
+#endif
 
 //#define CONFIG_JFFS2_FS_WRITEBUFFER /* should not be enabled */
 
-/* zlib section*/
-//#define CONFIG_JFFS2_ZLIB
-//#define CONFIG_JFFS2_RTIME
+/* compression section, lz4 is fast and zlib compresses better */
+#ifdef RT_JFFS2_USING_ZLIB
+#define CONFIG_JFFS2_ZLIB
+#endif
+#ifdef RT_JFFS2_USING_RTIME
+#define CONFIG_JFFS2_RTIME
+#endif
+#ifdef RT_JFFS2_USING_LZ4
+#define CONFIG_JFFS2_LZ4
+#endif
 //#define CONFIG_JFFS2_RUBIN
-//#define CONFIG_JFFS2_CMODE_NONE
-//#define CONFIG_JFFS2_CMODE_SIZE
+
+/* compression mode: priority (default), the first one succeeded by priority;
+ * size, the smallest; favourlz4, the smallest but lz4 is preferred */
+#if defined(RT_JFFS2_COMPR_MODE_NONE)
+#define CONFIG_JFFS2_CMODE_NONE
+#elif defined(RT_JFFS2_COMPR_MODE_SIZE)
+#define CONFIG_JFFS2_CMODE_SIZE
+#elif defined(RT_JFFS2_COMPR_MODE_FAVOURLZ4)
+#define CONFIG_JFFS2_CMODE_FAVOURLZ4
+#endif
 
 #endif
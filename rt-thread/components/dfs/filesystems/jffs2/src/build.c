@@ -325,6 +325,17 @@ int jffs2_do_mount_fs(struct jffs2_sb_info *c)
 		c->blocks = kmalloc(sizeof(struct jffs2_eraseblock) * c->nr_blocks, GFP_KERNEL);
 	if (!c->blocks)
 		return -ENOMEM;
+
+	if (jffs2_sum_init(c)) {
+#ifndef __ECOS
+		if (c->mtd->flags & MTD_NO_VIRTBLOCKS)
+			vfree(c->blocks);
+		else
+#endif
+			kfree(c->blocks);
+		return -ENOMEM;
+	}
+
 	for (i=0; i<c->nr_blocks; i++) {
 		INIT_LIST_HEAD(&c->blocks[i].list);
 		c->blocks[i].offset = i * c->sector_size;
@@ -353,6 +364,7 @@ int jffs2_do_mount_fs(struct jffs2_sb_info *c)
 
 	if (jffs2_build_filesystem(c)) {
 		D1(printk(KERN_DEBUG "build_fs failed\n"));
+		jffs2_sum_exit(c);
 		jffs2_free_ino_caches(c);
 		jffs2_free_raw_node_refs(c);
 #ifndef __ECOS
@@ -13,7 +13,11 @@
  *
  */
 
+#ifdef RT_USING_FINSH
+#include <finsh.h> /* before printf is redefined by os-ecos.h */
+#endif
 #include "compr.h"
+#include <linux/pagemap.h>
 
 static DEFINE_SPINLOCK(jffs2_compressor_list_lock);
 
@@ -26,6 +30,29 @@ static int jffs2_compression_mode = JFFS2_COMPR_MODE_PRIORITY;
 /* Statistics for blocks stored without compression */
 static uint32_t none_stat_compr_blocks=0,none_stat_decompr_blocks=0,none_stat_compr_size=0;
 
+static int jffs2_is_best_compression(struct jffs2_compressor *this,
+		struct jffs2_compressor *best, uint32_t size, uint32_t bestsize)
+{
+	switch (jffs2_compression_mode) {
+	case JFFS2_COMPR_MODE_SIZE:
+		if (bestsize > size)
+			return 1;
+		return 0;
+	case JFFS2_COMPR_MODE_FAVOURLZ4:
+		if ((this->compr == JFFS2_COMPR_LZ4) && (bestsize > size))
+			return 1;
+		if ((best->compr != JFFS2_COMPR_LZ4) && (bestsize > size))
+			return 1;
+		if ((this->compr == JFFS2_COMPR_LZ4) && (bestsize > (size * FAVOUR_LZ4_PERCENT / 100)))
+			return 1;
+		if ((bestsize * FAVOUR_LZ4_PERCENT / 100) > size)
+			return 1;
+		return 0;
+	}
+	/* Shouldn't happen */
+	return 0;
+}
+
 /* jffs2_compress:
  * @data: Pointer to uncompressed data
  * @cdata: Pointer to returned pointer to buffer for compressed data
@@ -55,6 +82,12 @@ uint16_t jffs2_compress(struct jffs2_sb_info *c, struct jffs2_inode_info *f,
         uint32_t orig_slen, orig_dlen;
         uint32_t best_slen=0, best_dlen=0;
 
+        /* The data of this file didn't compress recently */
+        if (f && f->compr_skip) {
+                f->compr_skip--;
+                goto out;
+        }
+
         switch (jffs2_compression_mode) {
         case JFFS2_COMPR_MODE_NONE:
                 break;
@@ -91,6 +124,7 @@ uint16_t jffs2_compress(struct jffs2_sb_info *c, struct jffs2_inode_info *f,
                 if (ret == JFFS2_COMPR_NONE) kfree(output_buf);
                 break;
         case JFFS2_COMPR_MODE_SIZE:
+        case JFFS2_COMPR_MODE_FAVOURLZ4:
                 orig_slen = *datalen;
                 orig_dlen = *cdatalen;
                 spin_lock(&jffs2_compressor_list_lock);
@@ -127,7 +161,7 @@ uint16_t jffs2_compress(struct jffs2_sb_info *c, struct jffs2_inode_info *f,
                         spin_lock(&jffs2_compressor_list_lock);
                         this->usecount--;
                         if (!compr_ret) {
-                                if ((!best_dlen)||(best_dlen>*cdatalen)) {
+                                if ((!best_dlen)||jffs2_is_best_compression(this, best, *cdatalen, best_dlen)) {
                                         best_dlen = *cdatalen;
                                         best_slen = *datalen;
                                         best = this;
@@ -150,6 +184,16 @@ uint16_t jffs2_compress(struct jffs2_sb_info *c, struct jffs2_inode_info *f,
         default:
                 printk(KERN_ERR "JFFS2: unknow compression mode.\n");
         }
+
+        /* Stop trying for a while if the blocks of file don't compress */
+        if (f && jffs2_compression_mode != JFFS2_COMPR_MODE_NONE) {
+                if (ret != JFFS2_COMPR_NONE) {
+                        f->compr_fails = 0;
+                } else if (++f->compr_fails >= JFFS2_COMPR_FAIL_LIMIT) {
+                        f->compr_fails = 0;
+                        f->compr_skip = JFFS2_COMPR_SKIP_BLOCKS;
+                }
+        }
  out:
         if (ret == JFFS2_COMPR_NONE) {
 	        *cpage_out = data_in;
@@ -268,6 +312,42 @@ int jffs2_unregister_compressor(struct jffs2_compressor *comp)
         return 0;
 }
 
+char *jffs2_get_compression_mode_name(void) 
+{
+        switch (jffs2_compression_mode) {
+        case JFFS2_COMPR_MODE_NONE:
+                return "none";
+        case JFFS2_COMPR_MODE_PRIORITY:
+                return "priority";
+        case JFFS2_COMPR_MODE_SIZE:
+                return "size";
+        case JFFS2_COMPR_MODE_FAVOURLZ4:
+                return "favourlz4";
+        }
+        return "unkown";
+}
+
+int jffs2_set_compression_mode_name(const char *name) 
+{
+        if (!strcmp("none",name)) {
+                jffs2_compression_mode = JFFS2_COMPR_MODE_NONE;
+                return 0;
+        }
+        if (!strcmp("priority",name)) {
+                jffs2_compression_mode = JFFS2_COMPR_MODE_PRIORITY;
+                return 0;
+        }
+        if (!strcmp("size",name)) {
+                jffs2_compression_mode = JFFS2_COMPR_MODE_SIZE;
+                return 0;
+        }
+        if (!strcmp("favourlz4",name)) {
+                jffs2_compression_mode = JFFS2_COMPR_MODE_FAVOURLZ4;
+                return 0;
+        }
+        return 1;
+}
+
 #ifdef CONFIG_JFFS2_PROC
 
 #define JFFS2_STAT_BUF_SIZE 16000
@@ -317,36 +397,6 @@ char *jffs2_stats(void)
         return buf;
 }
 
-char *jffs2_get_compression_mode_name(void) 
-{
-        switch (jffs2_compression_mode) {
-        case JFFS2_COMPR_MODE_NONE:
-                return "none";
-        case JFFS2_COMPR_MODE_PRIORITY:
-                return "priority";
-        case JFFS2_COMPR_MODE_SIZE:
-                return "size";
-        }
-        return "unkown";
-}
-
-int jffs2_set_compression_mode_name(const char *name) 
-{
-        if (!strcmp("none",name)) {
-                jffs2_compression_mode = JFFS2_COMPR_MODE_NONE;
-                return 0;
-        }
-        if (!strcmp("priority",name)) {
-                jffs2_compression_mode = JFFS2_COMPR_MODE_PRIORITY;
-                return 0;
-        }
-        if (!strcmp("size",name)) {
-                jffs2_compression_mode = JFFS2_COMPR_MODE_SIZE;
-                return 0;
-        }
-        return 1;
-}
-
 static int jffs2_compressor_Xable(const char *name, int disabled)
 {
         struct jffs2_compressor *this;
@@ -421,6 +471,9 @@ int jffs2_compressors_init(void)
 #ifdef CONFIG_JFFS2_RTIME
         jffs2_rtime_init();
 #endif
+#ifdef CONFIG_JFFS2_LZ4
+        jffs2_lz4_init();
+#endif
 #ifdef CONFIG_JFFS2_RUBIN
         jffs2_rubinmips_init();
         jffs2_dynrubin_init();
@@ -433,9 +486,14 @@ int jffs2_compressors_init(void)
 #ifdef CONFIG_JFFS2_CMODE_SIZE
         jffs2_compression_mode = JFFS2_COMPR_MODE_SIZE;
         D1(printk(KERN_INFO "JFFS2: default compression mode: size\n");)
+#else
+#ifdef CONFIG_JFFS2_CMODE_FAVOURLZ4
+        jffs2_compression_mode = JFFS2_COMPR_MODE_FAVOURLZ4;
+        D1(printk(KERN_INFO "JFFS2: default compression mode: favourlz4\n");)
 #else
         D1(printk(KERN_INFO "JFFS2: default compression mode: priority\n");)
 #endif
+#endif
 #endif
         return 0;
 }
@@ -447,6 +505,9 @@ int jffs2_compressors_exit(void)
         jffs2_dynrubin_exit();
         jffs2_rubinmips_exit();
 #endif
+#ifdef CONFIG_JFFS2_LZ4
+        jffs2_lz4_exit();
+#endif
 #ifdef CONFIG_JFFS2_RTIME
         jffs2_rtime_exit();
 #endif
@@ -455,3 +516,147 @@ int jffs2_compressors_exit(void)
 #endif
         return 0;
 }
+
+#ifdef RT_USING_FINSH
+
+/* jffs2_compr [none|priority|size|favourlz4] */
+static int jffs2_compr(int argc, char **argv)
+{
+        struct jffs2_compressor *this;
+
+        if (argc > 1 && jffs2_set_compression_mode_name(argv[1])) {
+                rt_kprintf("unknown compression mode %s\n", argv[1]);
+                return -1;
+        }
+
+        rt_kprintf("compression mode: %s\n", jffs2_get_compression_mode_name());
+        rt_kprintf("%10s   compr: %d blocks (%d)  decompr: %d blocks\n", "none",
+                   none_stat_compr_blocks, none_stat_compr_size, none_stat_decompr_blocks);
+        spin_lock(&jffs2_compressor_list_lock);
+        list_for_each_entry(this, &jffs2_compressor_list, list) {
+                rt_kprintf("%10s %c priority %d  compr: %d blocks (%d/%d)  decompr: %d blocks\n",
+                           this->name, ((this->disabled)||(!this->compress)) ? '-' : '+',
+                           this->priority, this->stat_compr_blocks, this->stat_compr_new_size,
+                           this->stat_compr_orig_size, this->stat_decompr_blocks);
+        }
+        spin_unlock(&jffs2_compressor_list_lock);
+
+        return 0;
+}
+MSH_CMD_EXPORT(jffs2_compr, show jffs2 compressors or set mode: jffs2_compr [none|priority|size|favourlz4]);
+
+#define COMPR_BENCH_SIZE   (32 * 1024)
+#define COMPR_BENCH_ROUNDS 16
+
+/* The data of benchmark: text-like data of a few words, or mixed with
+   random bytes, or random bytes only */
+static uint32_t jffs2_compr_bench_fill(unsigned char *buf, uint32_t size, const char *type)
+{
+        static const char *words[] = {"jffs2 ", "flash ", "node ", "block ", "erase ",
+                                      "inode ", "data ", "0x1000 ", "\n", "rt-thread "};
+        uint32_t len = 0, seed = 1, wlen;
+        int random;
+
+        while (len < size) {
+                seed = seed * 1103515245 + 12345;
+                if (!strcmp(type, "random"))
+                        random = 1;
+                else if (!strcmp(type, "mixed"))
+                        random = (len / 256) & 1;
+                else
+                        random = 0;
+
+                if (random) {
+                        buf[len++] = seed >> 16;
+                        continue;
+                }
+                wlen = strlen(words[(seed >> 16) % 10]);
+                if (wlen > size - len)
+                        wlen = size - len;
+                memcpy(buf + len, words[(seed >> 16) % 10], wlen);
+                len += wlen;
+        }
+        return len;
+}
+
+/* Compress and decompress the data by pages with every compressor. The
+   workspace of compressors is shared with jffs2, so it runs under the lock
+   of file system operations. */
+static int jffs2_compr_bench(int argc, char **argv)
+{
+        struct jffs2_compressor *this;
+        unsigned char *data, *cdata, *ddata;
+        uint32_t size, pages, i, round, ofs, len, clen, csize;
+        uint32_t clens[COMPR_BENCH_SIZE / PAGE_CACHE_SIZE];
+        rt_tick_t ctick, dtick;
+        int ret;
+
+        if (list_empty(&jffs2_compressor_list)) {
+                rt_kprintf("no compressor, jffs2 shall be mounted\n");
+                return -1;
+        }
+
+        data = kmalloc(COMPR_BENCH_SIZE * 3, GFP_KERNEL);
+        if (!data)
+                return -ENOMEM;
+        cdata = data + COMPR_BENCH_SIZE;
+        ddata = cdata + COMPR_BENCH_SIZE;
+
+        size = jffs2_compr_bench_fill(data, COMPR_BENCH_SIZE, argc > 1 ? argv[1] : "text");
+        pages = size / PAGE_CACHE_SIZE;
+
+        jffs2_fs_lock(RT_WAITING_FOREVER);
+        spin_lock(&jffs2_compressor_list_lock);
+        list_for_each_entry(this, &jffs2_compressor_list, list) {
+                if (!this->compress)
+                        continue;
+
+                /* A page not compressed is stored as it is */
+                csize = 0;
+                ctick = rt_tick_get();
+                for (round = 0; round < COMPR_BENCH_ROUNDS; round++) {
+                        csize = 0;
+                        for (i = 0; i < pages; i++) {
+                                ofs = i * PAGE_CACHE_SIZE;
+                                len = clen = PAGE_CACHE_SIZE;
+                                if (this->compress(data + ofs, cdata + ofs, &len, &clen, NULL) ||
+                                    len != PAGE_CACHE_SIZE)
+                                        clen = 0;
+                                clens[i] = clen;
+                                csize += clen ? clen : PAGE_CACHE_SIZE;
+                        }
+                }
+                ctick = rt_tick_get() - ctick;
+
+                ret = 0;
+                dtick = rt_tick_get();
+                for (round = 0; round < COMPR_BENCH_ROUNDS && !ret; round++) {
+                        for (i = 0; i < pages && !ret; i++) {
+                                ofs = i * PAGE_CACHE_SIZE;
+                                if (clens[i])
+                                        ret = this->decompress(cdata + ofs, ddata + ofs, clens[i],
+                                                               PAGE_CACHE_SIZE, NULL);
+                                else
+                                        memcpy(ddata + ofs, data + ofs, PAGE_CACHE_SIZE);
+                        }
+                }
+                dtick = rt_tick_get() - dtick;
+                if (!ret && memcmp(data, ddata, size))
+                        ret = -1;
+
+                if (ctick == 0) ctick = 1;
+                if (dtick == 0) dtick = 1;
+                rt_kprintf("%10s ratio %3d%%  compress %6d KB/s  decompress %6d KB/s%s\n",
+                           this->name, csize * 100 / size,
+                           (uint32_t)((rt_uint64_t)size * COMPR_BENCH_ROUNDS * RT_TICK_PER_SECOND / ctick / 1024),
+                           (uint32_t)((rt_uint64_t)size * COMPR_BENCH_ROUNDS * RT_TICK_PER_SECOND / dtick / 1024),
+                           ret ? "  verify failed" : "");
+        }
+        spin_unlock(&jffs2_compressor_list_lock);
+        jffs2_fs_unlock();
+
+        kfree(data);
+        return 0;
+}
+MSH_CMD_EXPORT(jffs2_compr_bench, jffs2 compressors benchmark: jffs2_compr_bench [text|mixed|random]);
+#endif
@@ -33,6 +33,7 @@
 #define JFFS2_LZO_PRIORITY       40
 #define JFFS2_RTIME_PRIORITY     50
 #define JFFS2_ZLIB_PRIORITY      60
+#define JFFS2_LZ4_PRIORITY       70
 
 #define JFFS2_RUBINMIPS_DISABLED /* RUBINs will be used only */
 #define JFFS2_DYNRUBIN_DISABLED  /*        for decompression */
@@ -40,6 +41,16 @@
 #define JFFS2_COMPR_MODE_NONE       0
 #define JFFS2_COMPR_MODE_PRIORITY   1
 #define JFFS2_COMPR_MODE_SIZE       2
+#define JFFS2_COMPR_MODE_FAVOURLZ4  3
+
+/* In favourlz4 mode, lz4 is used unless the best one is smaller than this
+   percent of lz4 output, the decompression of lz4 is much faster */
+#define FAVOUR_LZ4_PERCENT 80
+
+/* The compression of a file is skipped for some blocks after the blocks
+   of it failed to compress in a row, e.g. the file is compressed already */
+#define JFFS2_COMPR_FAIL_LIMIT  4
+#define JFFS2_COMPR_SKIP_BLOCKS 16
 
 struct jffs2_compressor {
         struct list_head list;
@@ -76,11 +87,12 @@ int jffs2_decompress(struct jffs2_sb_info *c, struct jffs2_inode_info *f,
 
 void jffs2_free_comprbuf(unsigned char *comprbuf, unsigned char *orig);
 
+int jffs2_set_compression_mode_name(const char *mode_name);
+char *jffs2_get_compression_mode_name(void);
+
 #ifdef CONFIG_JFFS2_PROC
 int jffs2_enable_compressor_name(const char *name);
 int jffs2_disable_compressor_name(const char *name);
-int jffs2_set_compression_mode_name(const char *mode_name);
-char *jffs2_get_compression_mode_name(void);
 int jffs2_set_compressor_priority(const char *mode_name, int priority);
 char *jffs2_list_compressors(void);
 char *jffs2_stats(void);
@@ -103,5 +115,9 @@ void jffs2_rtime_exit(void);
 int jffs2_zlib_init(void);
 void jffs2_zlib_exit(void);
 #endif
+#ifdef CONFIG_JFFS2_LZ4
+int jffs2_lz4_init(void);
+void jffs2_lz4_exit(void);
+#endif
 
 #endif /* __JFFS2_COMPR_H__ */
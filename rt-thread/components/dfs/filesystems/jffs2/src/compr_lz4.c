@@ -0,0 +1,252 @@
+/*
+ * JFFS2 -- Journalling Flash File System, Version 2.
+ *
+ * LZ4 compressor. The data is stored in the LZ4 block format: sequences
+ * of a token, the literals and the match, the matches are found by a hash
+ * table of the positions of 4-byte strings. It compresses less than zlib,
+ * but both compression and decompression are many times faster.
+ *
+ * For licensing information, see the file 'LICENCE' in this directory.
+ *
+ */
+
+#include <linux/kernel.h>
+#include <linux/types.h>
+#include <linux/errno.h>
+#include <linux/string.h>
+#include <linux/slab.h>
+#include <linux/jffs2.h>
+#include "compr.h"
+
+#define LZ4_MINMATCH		4
+#define LZ4_LASTLITERALS	5	/* the last bytes are always literals */
+#define LZ4_MFLIMIT		12	/* the last match starts before it */
+#define LZ4_HASH_LOG		11
+#define LZ4_SKIP_TRIGGER	6	/* search faster in data without matches */
+#define LZ4_MAX_INPUT		0xffff	/* the positions in hash table are 16 bits */
+
+/* The hash table, like the zlib streams, is protected by the lock of file system */
+static uint16_t *lz4_hash_table;
+
+static inline uint32_t lz4_read32(const unsigned char *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint32_t lz4_hash(uint32_t v)
+{
+	return (v * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+/* The length over 15 in the token is written as bytes of 255 and the rest */
+static unsigned char *lz4_put_length(unsigned char *op, uint32_t len)
+{
+	while (len >= 255) {
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = len;
+
+	return op;
+}
+
+static int lz4_get_length(const unsigned char **ip, const unsigned char *iend, uint32_t *len)
+{
+	unsigned char b;
+
+	do {
+		if (*ip >= iend)
+			return -1;
+		b = *(*ip)++;
+		*len += b;
+	} while (b == 255);
+
+	return 0;
+}
+
+static unsigned char *lz4_put_literals(unsigned char *op, const unsigned char *anchor,
+				       uint32_t litlen)
+{
+	unsigned char *token = op++;
+
+	if (litlen >= 15) {
+		*token = 15 << 4;
+		op = lz4_put_length(op, litlen - 15);
+	} else {
+		*token = litlen << 4;
+	}
+	memcpy(op, anchor, litlen);
+
+	return op + litlen;
+}
+
+static int jffs2_lz4_compress(unsigned char *data_in, unsigned char *cpage_out,
+			      uint32_t *sourcelen, uint32_t *dstlen, void *model)
+{
+	const unsigned char *ip = data_in, *anchor = data_in, *ref, *p;
+	const unsigned char *iend = data_in + *sourcelen;
+	const unsigned char *mflimit = iend - LZ4_MFLIMIT;
+	const unsigned char *matchlimit = iend - LZ4_LASTLITERALS;
+	unsigned char *op = cpage_out, *oend = cpage_out + *dstlen;
+	unsigned char *token;
+	uint32_t h, litlen, matchlen, offset, searches;
+
+	if (*sourcelen > LZ4_MAX_INPUT || *sourcelen <= LZ4_MFLIMIT)
+		return -1;
+
+	memset(lz4_hash_table, 0, sizeof(uint16_t) << LZ4_HASH_LOG);
+	lz4_hash_table[lz4_hash(lz4_read32(ip))] = 0;
+	ip++;
+	searches = 1 << LZ4_SKIP_TRIGGER;
+
+	while (ip <= mflimit) {
+		h = lz4_hash(lz4_read32(ip));
+		ref = data_in + lz4_hash_table[h];
+		lz4_hash_table[h] = ip - data_in;
+
+		if (lz4_read32(ref) != lz4_read32(ip)) {
+			ip += searches++ >> LZ4_SKIP_TRIGGER;
+			continue;
+		}
+		searches = 1 << LZ4_SKIP_TRIGGER;
+
+		/* Catch up the bytes before the match */
+		while (ip > anchor && ref > data_in && ip[-1] == ref[-1]) {
+			ip--;
+			ref--;
+		}
+
+		for (p = ip + LZ4_MINMATCH; p < matchlimit && *p == ref[p - ip]; p++)
+			;
+		matchlen = p - ip - LZ4_MINMATCH;
+		litlen = ip - anchor;
+
+		if (op + 1 + litlen / 255 + 1 + litlen + 2 + matchlen / 255 + 1 > oend)
+			return -1;
+
+		token = op;
+		op = lz4_put_literals(op, anchor, litlen);
+		offset = ip - ref;
+		*op++ = offset & 0xff;
+		*op++ = offset >> 8;
+		if (matchlen >= 15) {
+			*token |= 15;
+			op = lz4_put_length(op, matchlen - 15);
+		} else {
+			*token |= matchlen;
+		}
+
+		ip += matchlen + LZ4_MINMATCH;
+		anchor = ip;
+
+		/* The position in the match is likely to match again */
+		if (ip <= mflimit)
+			lz4_hash_table[lz4_hash(lz4_read32(ip - 2))] = ip - 2 - data_in;
+	}
+
+	litlen = iend - anchor;
+	if (op + 1 + litlen / 255 + 1 + litlen > oend)
+		return -1;
+	op = lz4_put_literals(op, anchor, litlen);
+
+	if (op - cpage_out >= *sourcelen)
+		return -1;
+
+	*dstlen = op - cpage_out;
+	return 0;
+}
+
+static int jffs2_lz4_decompress(unsigned char *data_in, unsigned char *cpage_out,
+				uint32_t srclen, uint32_t destlen, void *model)
+{
+	const unsigned char *ip = data_in, *iend = data_in + srclen;
+	unsigned char *op = cpage_out, *oend = cpage_out + destlen;
+	const unsigned char *ref;
+	uint32_t token, len, offset;
+
+	while (ip < iend) {
+		token = *ip++;
+
+		len = token >> 4;
+		if (len == 15 && lz4_get_length(&ip, iend, &len))
+			return -1;
+		if (len > iend - ip || len > oend - op)
+			return -1;
+		memcpy(op, ip, len);
+		op += len;
+		ip += len;
+
+		/* The last sequence has literals only */
+		if (ip == iend)
+			break;
+
+		if (iend - ip < 2)
+			return -1;
+		offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > op - cpage_out)
+			return -1;
+		ref = op - offset;
+
+		len = token & 15;
+		if (len == 15 && lz4_get_length(&ip, iend, &len))
+			return -1;
+		len += LZ4_MINMATCH;
+		if (len > oend - op)
+			return -1;
+
+		if (offset >= len) {
+			memcpy(op, ref, len);
+			op += len;
+		} else {
+			/* The match overlaps the bytes being copied */
+			while (len--)
+				*op++ = *ref++;
+		}
+	}
+
+	if (op != oend)
+		return -1;
+
+	return 0;
+}
+
+static struct jffs2_compressor jffs2_lz4_comp = {
+    .priority = JFFS2_LZ4_PRIORITY,
+    .name = "lz4",
+    .compr = JFFS2_COMPR_LZ4,
+    .compress = &jffs2_lz4_compress,
+    .decompress = &jffs2_lz4_decompress,
+#ifdef JFFS2_LZ4_DISABLED
+    .disabled = 1,
+#else
+    .disabled = 0,
+#endif
+};
+
+int jffs2_lz4_init(void)
+{
+	int ret;
+
+	lz4_hash_table = kmalloc(sizeof(uint16_t) << LZ4_HASH_LOG, GFP_KERNEL);
+	if (!lz4_hash_table)
+		return -ENOMEM;
+
+	ret = jffs2_register_compressor(&jffs2_lz4_comp);
+	if (ret) {
+		kfree(lz4_hash_table);
+		lz4_hash_table = NULL;
+	}
+
+	return ret;
+}
+
+void jffs2_lz4_exit(void)
+{
+	jffs2_unregister_compressor(&jffs2_lz4_comp);
+	kfree(lz4_hash_table);
+	lz4_hash_table = NULL;
+}
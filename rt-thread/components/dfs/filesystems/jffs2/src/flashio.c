@@ -149,3 +149,26 @@ writev_out:
 
 	return ret;
 }
+
+#ifdef CONFIG_JFFS2_SUMMARY
+int jffs2_flash_writev(struct jffs2_sb_info *c,
+		const struct iovec *vecs, unsigned long count, loff_t to,
+		size_t * retlen, uint32_t ino)
+{
+	unsigned long i;
+	size_t totlen = 0, thislen = 0;
+	int ret;
+
+	ret = jffs2_flash_direct_writev(c, vecs, count, to, &thislen);
+	if (retlen) *retlen = thislen;
+
+	for (i = 0; i < count; i++)
+		totlen += vecs[i].iov_len;
+
+	// record the node in the summary of the block once it's on flash
+	if (!ret && thislen == totlen)
+		jffs2_sum_add_kvec(c, vecs, count, (uint32_t) to);
+
+	return ret;
+}
+#endif
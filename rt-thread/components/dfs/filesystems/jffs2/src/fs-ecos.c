@@ -477,6 +477,7 @@ static int jffs2_read_super(struct super_block *sb)
 	return 0;
 
 out_nodes:
+	jffs2_sum_exit(c);
 	jffs2_free_ino_caches(c);
 	jffs2_free_raw_node_refs(c);
 	rt_free(c->blocks);
@@ -556,12 +557,12 @@ int jffs2_mount(cyg_fstab_entry * fste, cyg_mtab_entry * mte)
 		jffs2_sb->s_root->i_count = 1;	// Ensures the root inode is always in ram until umount
 
 		D2(printf("jffs2_mount erasing pending blocks\n"));
-#ifdef CYGOPT_FS_JFFS2_WRITE
-		if (!jffs2_is_readonly(c))
-		    jffs2_erase_pending_blocks(c,0);
-#endif
 #ifdef CYGOPT_FS_JFFS2_GCTHREAD
+		// The pending blocks are erased by the GC thread
 		jffs2_start_garbage_collect_thread(c);
+#elif defined(CYGOPT_FS_JFFS2_WRITE)
+		if (!jffs2_is_readonly(c))
+		    jffs2_erase_pending_blocks(c,0);
 #endif
 	}
 	mte->data = (CYG_ADDRWORD) jffs2_sb;
@@ -641,6 +642,7 @@ static int jffs2_umount(cyg_mtab_entry * mte)
 		//root_i = NULL;
 
 		// Clean up the super block and root inode
+		jffs2_sum_exit(c);
 		jffs2_free_ino_caches(c);
 		jffs2_free_raw_node_refs(c);
 		rt_free(c->blocks);
@@ -641,6 +641,14 @@ static int jffs2_garbage_collect_pristine(struct jffs2_sb_info *c,
 			ret = -EIO;
 		goto out_node;
 	}
+	if (jffs2_sum_active()) {
+		struct iovec vec;
+
+		vec.iov_base = node;
+		vec.iov_len = rawlen;
+		jffs2_sum_add_kvec(c, &vec, 1, phys_ofs);
+	}
+
 	nraw->flash_offset |= REF_PRISTINE;
 	jffs2_add_physical_node_ref(c, nraw);
 
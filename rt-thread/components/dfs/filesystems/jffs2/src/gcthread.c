@@ -127,126 +127,131 @@ jffs2_garbage_collect_thread(unsigned long data)
 }
 #endif 
 
-rt_uint32_t cyg_current_time(void)
-{
-	return 0;
-}
-
-static void
-jffs2_garbage_collect_thread(unsigned long data);
+static void jffs2_garbage_collect_thread(void *parameter);
 
 void jffs2_garbage_collect_trigger(struct jffs2_sb_info *c)
 {
      struct super_block *sb=OFNI_BS_2SFFJ(c);
 
-     /* Wake up the thread */
+     /* Wake up the thread only if there is something to do, it's called
+      * after every write */
+     if (!jffs2_thread_should_wake(c))
+          return;
+
      D1(printk("jffs2_garbage_collect_trigger\n"));
 
-     rt_event_send(&sb->s_gc_thread_flags,GC_THREAD_FLAG_TRIG);
+     rt_event_send(&sb->s_gc_thread_flags, GC_THREAD_FLAG_TRIG);
 }
 
-static struct rt_thread gc_thread;
 void
 jffs2_start_garbage_collect_thread(struct jffs2_sb_info *c)
 {
      struct super_block *sb=OFNI_BS_2SFFJ(c);
-     cyg_mtab_entry *mte;
-     int result;
-	
+     rt_err_t result;
+
      RT_ASSERT(c);
-     //RT_ASSERT(!sb->s_gc_thread_handle);
-	 
-     mte=(cyg_dir *) sb->s_root;
-     RT_ASSERT(mte);
-	 
-     rt_event_init(&sb->s_gc_thread_flags, "gc_event", RT_IPC_FLAG_FIFO);	 
-     rt_mutex_init(&sb->s_lock, "gc_mutex", RT_IPC_FLAG_FIFO);
-//     rt_mutex_init(&mte->fs->syncmode, "fs_lock", RT_IPC_FLAG_FIFO);
-	 
+
+     rt_event_init(&sb->s_gc_thread_flags, "jffs2gc", RT_IPC_FLAG_FIFO);
+
      D1(printk("jffs2_start_garbage_collect_thread\n"));
      /* Start the thread. Doesn't matter if it fails -- it's only an
       * optimisation anyway */
-     result =  rt_thread_init(&sb->s_gc_thread, 
-	                   "jffs2_gc_thread",
-                       jffs2_garbage_collect_thread,
-                       (void *)c,
-                       (void*)sb->s_gc_thread_stack,
-                       sizeof(sb->s_gc_thread_stack),
-					   CYGNUM_JFFS2_GC_THREAD_PRIORITY,
-					   CYGNUM_JFFS2_GC_THREAD_TICKS
-					   );
-	 if (result != RT_EOK) {
-		 rt_thread_startup(&sb->s_gc_thread);
-		 /* how to deal with the following filed? */
-		 /* sb->s_gc_thread_handle; */
-	 }
+     result = rt_thread_init(&sb->s_gc_thread,
+                             "jffs2gc",
+                             jffs2_garbage_collect_thread,
+                             (void *)c,
+                             (void *)sb->s_gc_thread_stack,
+                             sizeof(sb->s_gc_thread_stack),
+                             CYGNUM_JFFS2_GC_THREAD_PRIORITY,
+                             CYGNUM_JFFS2_GC_THREAD_TICKS);
+     if (result == RT_EOK)
+          rt_thread_startup(&sb->s_gc_thread);
+     else
+          /* the thread-less stop still works by the exit flag */
+          rt_event_send(&sb->s_gc_thread_flags, GC_THREAD_FLAG_HAS_EXIT);
+
+     /* The blocks left to erase at mount are erased in background */
+     rt_event_send(&sb->s_gc_thread_flags, GC_THREAD_FLAG_TRIG);
 }
 
+/* Called with the file system lock held */
 void
 jffs2_stop_garbage_collect_thread(struct jffs2_sb_info *c)
 {
      struct super_block *sb=OFNI_BS_2SFFJ(c);
-     cyg_mtab_entry *mte;
-	 rt_uint32_t  e;
-	 
-     //RT_ASSERT(sb->s_gc_thread_handle);
+     rt_base_t level;
+     rt_uint32_t e;
 
      D1(printk("jffs2_stop_garbage_collect_thread\n"));
      /* Stop the thread and wait for it if necessary */
 
-     rt_event_send(&sb->s_gc_thread_flags,GC_THREAD_FLAG_STOP);
+     rt_event_send(&sb->s_gc_thread_flags, GC_THREAD_FLAG_STOP);
 
      D1(printk("jffs2_stop_garbage_collect_thread wait\n"));
-	 
+
      rt_event_recv(&sb->s_gc_thread_flags,
                    GC_THREAD_FLAG_HAS_EXIT,
                    RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR,
-				   RT_WAITING_FOREVER,  &e);
+                   RT_WAITING_FOREVER, &e);
 
      // Kill and free the resources ...  this is safe due to the flag
-     // from the thread.
-     rt_thread_detach(&sb->s_gc_thread);
-     rt_sem_detach(&sb->s_lock);
+     // from the thread, which may not have returned yet.
+     level = rt_hw_interrupt_disable();
+     if (rt_object_get_type((rt_object_t)&sb->s_gc_thread) == RT_Object_Class_Thread)
+          rt_thread_detach(&sb->s_gc_thread);
+     rt_hw_interrupt_enable(level);
      rt_event_detach(&sb->s_gc_thread_flags);
 }
 
 
 static void
-jffs2_garbage_collect_thread(unsigned long data)
+jffs2_garbage_collect_thread(void *parameter)
 {
-     struct jffs2_sb_info *c=(struct jffs2_sb_info *)data;
+     struct jffs2_sb_info *c=(struct jffs2_sb_info *)parameter;
      struct super_block *sb=OFNI_BS_2SFFJ(c);
-     cyg_mtab_entry *mte;
-     rt_uint32_t flag = 0;
-	 
+     rt_uint32_t flag;
+     int ret;
+
      D1(printk("jffs2_garbage_collect_thread START\n"));
 
      while(1) {
+          flag = 0;
           rt_event_recv(&sb->s_gc_thread_flags,
                         GC_THREAD_FLAG_TRIG | GC_THREAD_FLAG_STOP,
                         RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR,
-				        cyg_current_time() + CYGNUM_JFFS2_GS_THREAD_TICKS,  
-						&flag);
+                        CYGNUM_JFFS2_GS_THREAD_TICKS, &flag);
 
           if (flag & GC_THREAD_FLAG_STOP)
                break;
 
-          D1(printk("jffs2: GC THREAD GC BEGIN\n"));
+          /* The unmount holds the lock while waiting for this thread to
+           * exit, so never wait forever for it */
+          if (jffs2_fs_lock(CYGNUM_JFFS2_GS_THREAD_TICKS) != RT_EOK)
+               continue;
+
+          ret = 0;
+          if (!list_empty(&c->erase_pending_list)) {
+               D1(printk("jffs2: GC THREAD ERASE\n"));
+               jffs2_erase_pending_blocks(c, 1);
+          } else if (jffs2_thread_should_wake(c)) {
+               D1(printk("jffs2: GC THREAD GC BEGIN\n"));
+               ret = jffs2_garbage_collect_pass(c);
+               D1(printk("jffs2: GC THREAD GC END\n"));
+          }
 
-          mte=(cyg_dir *) sb->s_root;
-          RT_ASSERT(mte != NULL);
-//          rt_mutex_take(&mte->fs->syncmode, RT_WAITING_FOREVER);
+          /* Go on without waiting while there is still work to do */
+          if (!ret && (!list_empty(&c->erase_pending_list) || jffs2_thread_should_wake(c)))
+               rt_event_send(&sb->s_gc_thread_flags, GC_THREAD_FLAG_TRIG);
+          jffs2_fs_unlock();
 
-          if (jffs2_garbage_collect_pass(c) == -ENOSPC) {
+          if (ret == -ENOSPC) {
                printf("No space for garbage collection. "
                       "Aborting JFFS2 GC thread\n");
                break;
           }
-//          rt_mutex_release(&mte->fs->syncmode);
-          D1(printk("jffs2: GC THREAD GC END\n"));
      }
 
      D1(printk("jffs2_garbage_collect_thread EXIT\n"));
-     rt_event_send(&sb->s_gc_thread_flags,GC_THREAD_FLAG_HAS_EXIT);	 
+     rt_event_send(&sb->s_gc_thread_flags, GC_THREAD_FLAG_HAS_EXIT);
 }
 #endif
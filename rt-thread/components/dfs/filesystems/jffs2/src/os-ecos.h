@@ -164,21 +164,10 @@ struct super_block {
 //#endif
 
 #ifdef CYGOPT_FS_JFFS2_GCTHREAD
-	struct rt_mutex s_lock;             // Lock the inode cache
 	struct rt_event s_gc_thread_flags;  // Communication with the gcthread
-	//void (*s_gc_thread_handle)(void *parameter);
 	struct rt_thread s_gc_thread;
-//#if (CYGNUM_JFFS2_GC_THREAD_STACK_SIZE >= CYGNUM_HAL_STACK_SIZE_MINIMUM)
-//    char s_gc_thread_stack[CYGNUM_JFFS2_GC_THREAD_STACK_SIZE];
-//#else
-//    char s_gc_thread_stack[CYGNUM_HAL_STACK_SIZE_MINIMUM];
-//#endif
-	#define CYGNUM_JFFS2_GC_THREAD_STACK_SIZE  (1024*4)
-    char s_gc_thread_stack[CYGNUM_JFFS2_GC_THREAD_STACK_SIZE];
-
-    cyg_mtab_entry *mte;
+	char s_gc_thread_stack[CYGNUM_JFFS2_GC_THREAD_STACK_SIZE];
 #endif
-
 };
 
 #define sleep_on_spinunlock(wq, sl) spin_unlock(sl)
@@ -196,6 +185,11 @@ static inline void jffs2_garbage_collect_trigger(struct jffs2_sb_info *c)
 }
 #endif
 
+/* dfs_jffs2.c, the lock of file system taken by the GC thread and the
+   compressor benchmark */
+rt_err_t jffs2_fs_lock(rt_int32_t timeout);
+void jffs2_fs_unlock(void);
+
 /* fs-ecos.c */
 struct _inode *jffs2_new_inode (struct _inode *dir_i, int mode, struct jffs2_raw_inode *ri);
 struct _inode *jffs2_iget(struct super_block *sb, cyg_uint32 ino);
@@ -248,7 +242,12 @@ static inline void jffs2_erase_pending_trigger(struct jffs2_sb_info *c)
 #define jffs2_flash_setup(c) (0)
 #define jffs2_nand_flash_cleanup(c) do {} while(0)
 #define jffs2_wbuf_dirty(c) (0)
+#ifdef CONFIG_JFFS2_SUMMARY
+int jffs2_flash_writev(struct jffs2_sb_info *c, const struct iovec *vecs,
+		       unsigned long count, loff_t to, size_t *retlen, uint32_t ino);
+#else
 #define jffs2_flash_writev(a,b,c,d,e,f) jffs2_flash_direct_writev(a,b,c,d,e)
+#endif
 #define jffs2_wbuf_timeout NULL
 #define jffs2_wbuf_process NULL
 #define jffs2_nor_ecc(c) (0)
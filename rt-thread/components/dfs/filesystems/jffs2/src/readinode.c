@@ -465,7 +465,15 @@ static int jffs2_get_inode_nodes(struct jffs2_sb_info *c, struct jffs2_inode_inf
 			JFFS2_ERROR("error %d reading node at 0x%08x in get_inode_nodes()\n", err, ref_offset(ref));
 			goto free_out;
 		}
-			
+
+		/* The node mounted from a summary may have been obsoleted on
+		   flash after the summary was written */
+		if (!(je16_to_cpu(node.u.nodetype) & JFFS2_NODE_ACCURATE)) {
+			jffs2_mark_node_obsolete(c, ref);
+			spin_lock(&c->erase_completion_lock);
+			continue;
+		}
+
 		switch (je16_to_cpu(node.u.nodetype)) {
 			
 		case JFFS2_NODETYPE_DIRENT:
@@ -66,16 +66,16 @@
 static uint32_t pseudo_random;
 
 static int jffs2_scan_eraseblock (struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
-				  unsigned char *buf, uint32_t buf_size);
+				  unsigned char *buf, uint32_t buf_size, struct jffs2_summary *s);
 
 /* These helper functions _must_ increase ofs and also do the dirty/used space accounting. 
  * Returning an error will abort the mount - bad checksums etc. should just mark the space
  * as dirty.
  */
 static int jffs2_scan_inode_node(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb, 
-				 struct jffs2_raw_inode *ri, uint32_t ofs);
+				 struct jffs2_raw_inode *ri, uint32_t ofs, struct jffs2_summary *s);
 static int jffs2_scan_dirent_node(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
-				 struct jffs2_raw_dirent *rd, uint32_t ofs);
+				 struct jffs2_raw_dirent *rd, uint32_t ofs, struct jffs2_summary *s);
 
 #define BLK_STATE_ALLFF		0
 #define BLK_STATE_CLEAN		1
@@ -108,6 +108,7 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 	uint32_t empty_blocks = 0, bad_blocks = 0;
 	unsigned char *flashbuf = NULL;
 	uint32_t buf_size = 0;
+	struct jffs2_summary *s = NULL;
 #ifndef __ECOS
 	size_t pointlen;
 
@@ -141,10 +142,23 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 			return -ENOMEM;
 	}
 
+	if (jffs2_sum_active()) {
+		/* The summary entries of the nodes found in the block being scanned */
+		s = kmalloc(sizeof(struct jffs2_summary), GFP_KERNEL);
+		if (!s) {
+			ret = -ENOMEM;
+			goto out;
+		}
+		memset(s, 0, sizeof(struct jffs2_summary));
+	}
+
 	for (i=0; i<c->nr_blocks; i++) {
 		struct jffs2_eraseblock *jeb = &c->blocks[i];
 
-		ret = jffs2_scan_eraseblock(c, jeb, buf_size?flashbuf:(flashbuf+jeb->offset), buf_size);
+		if (jffs2_sum_active())
+			jffs2_sum_reset_collected(s);
+
+		ret = jffs2_scan_eraseblock(c, jeb, buf_size?flashbuf:(flashbuf+jeb->offset), buf_size, s);
 
 		if (ret < 0)
 			goto out;
@@ -204,6 +218,9 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 						list_add(&c->nextblock->list, &c->dirty_list);
 					}
 				}
+				/* The summary of the new nextblock describes the nodes in it already */
+				if (jffs2_sum_active())
+					jffs2_sum_move_collected(c, s);
                                 c->nextblock = jeb;
                         } else {
 				jeb->dirty_size += jeb->free_size + jeb->wasted_size;
@@ -275,6 +292,10 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 	}
 	ret = 0;
  out:
+	if (s) {
+		jffs2_sum_free_collected(s);
+		kfree(s);
+	}
 	if (buf_size)
 		kfree(flashbuf);
 #ifndef __ECOS
@@ -305,8 +326,40 @@ static int jffs2_fill_scan_buf (struct jffs2_sb_info *c, unsigned char *buf,
 	return 0;
 }
 
+static int jffs2_scan_classify_jeb(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb)
+{
+	/* mark_node_obsolete can add to wasted !! */
+	if (jeb->wasted_size) {
+		jeb->dirty_size += jeb->wasted_size;
+		c->dirty_size += jeb->wasted_size;
+		c->wasted_size -= jeb->wasted_size;
+		jeb->wasted_size = 0;
+	}
+
+	if ((jeb->used_size + jeb->unchecked_size) == PAD(c->cleanmarker_size) && !jeb->dirty_size 
+		&& (!jeb->first_node || !jeb->first_node->next_phys) )
+		return BLK_STATE_CLEANMARKER;
+		
+	/* move blocks with max 4 byte dirty space to cleanlist */	
+	else if (!ISDIRTY(c->sector_size - (jeb->used_size + jeb->unchecked_size))) {
+		c->dirty_size -= jeb->dirty_size;
+		c->wasted_size += jeb->dirty_size; 
+		jeb->wasted_size += jeb->dirty_size;
+		jeb->dirty_size = 0;
+		return BLK_STATE_CLEAN;
+	} else if (jeb->used_size || jeb->unchecked_size)
+		return BLK_STATE_PARTDIRTY;
+	else
+		return BLK_STATE_ALLDIRTY;
+}
+
+#ifdef CONFIG_JFFS2_SUMMARY
+static int jffs2_scan_summary(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+			      uint32_t sum_ofs);
+#endif
+
 static int jffs2_scan_eraseblock (struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
-				  unsigned char *buf, uint32_t buf_size) {
+				  unsigned char *buf, uint32_t buf_size, struct jffs2_summary *s) {
 	struct jffs2_unknown_node *node;
 	struct jffs2_unknown_node crcnode;
 	uint32_t ofs, prevofs;
@@ -337,6 +390,24 @@ static int jffs2_scan_eraseblock (struct jffs2_sb_info *c, struct jffs2_eraseblo
 		default: 	return ret;
 		}
 	}
+#endif
+#ifdef CONFIG_JFFS2_SUMMARY
+	{
+		struct jffs2_sum_marker sm;
+
+		/* A block with valid summary is mounted from it, without reading the nodes */
+		err = jffs2_fill_scan_buf(c, (unsigned char *)&sm,
+					  jeb->offset + c->sector_size - sizeof(sm), sizeof(sm));
+		if (err)
+			return err;
+
+		if (je32_to_cpu(sm.magic) == JFFS2_SUM_MAGIC) {
+			err = jffs2_scan_summary(c, jeb, je32_to_cpu(sm.offset));
+			if (err)
+				return err;
+			/* Otherwise fall back to the full scan */
+		}
+	}
 #endif
 	buf_ofs = jeb->offset;
 
@@ -551,7 +622,7 @@ scan_more:
 				buf_ofs = ofs;
 				node = (void *)buf;
 			}
-			err = jffs2_scan_inode_node(c, jeb, (void *)node, ofs);
+			err = jffs2_scan_inode_node(c, jeb, (void *)node, ofs, s);
 			if (err) return err;
 			ofs += PAD(je32_to_cpu(node->totlen));
 			break;
@@ -567,7 +638,7 @@ scan_more:
 				buf_ofs = ofs;
 				node = (void *)buf;
 			}
-			err = jffs2_scan_dirent_node(c, jeb, (void *)node, ofs);
+			err = jffs2_scan_dirent_node(c, jeb, (void *)node, ofs, s);
 			if (err) return err;
 			ofs += PAD(je32_to_cpu(node->totlen));
 			break;
@@ -628,6 +699,9 @@ scan_more:
 
 			case JFFS2_FEATURE_RWCOMPAT_COPY:
 				D1(printk(KERN_NOTICE "Unknown but compatible feature node (0x%04x) found at offset 0x%08x\n", je16_to_cpu(node->nodetype), ofs));
+				/* The summary can't describe it, so the block must be scanned */
+				if (jffs2_sum_active())
+					jffs2_sum_disable_collecting(s);
 				USED_SPACE(PAD(je32_to_cpu(node->totlen)));
 				ofs += PAD(je32_to_cpu(node->totlen));
 				break;
@@ -639,29 +713,7 @@ scan_more:
 	D1(printk(KERN_DEBUG "Block at 0x%08x: free 0x%08x, dirty 0x%08x, unchecked 0x%08x, used 0x%08x\n", jeb->offset, 
 		  jeb->free_size, jeb->dirty_size, jeb->unchecked_size, jeb->used_size));
 
-	/* mark_node_obsolete can add to wasted !! */
-	if (jeb->wasted_size) {
-		jeb->dirty_size += jeb->wasted_size;
-		c->dirty_size += jeb->wasted_size;
-		c->wasted_size -= jeb->wasted_size;
-		jeb->wasted_size = 0;
-	}
-
-	if ((jeb->used_size + jeb->unchecked_size) == PAD(c->cleanmarker_size) && !jeb->dirty_size 
-		&& (!jeb->first_node || !jeb->first_node->next_phys) )
-		return BLK_STATE_CLEANMARKER;
-		
-	/* move blocks with max 4 byte dirty space to cleanlist */	
-	else if (!ISDIRTY(c->sector_size - (jeb->used_size + jeb->unchecked_size))) {
-		c->dirty_size -= jeb->dirty_size;
-		c->wasted_size += jeb->dirty_size; 
-		jeb->wasted_size += jeb->dirty_size;
-		jeb->dirty_size = 0;
-		return BLK_STATE_CLEAN;
-	} else if (jeb->used_size || jeb->unchecked_size)
-		return BLK_STATE_PARTDIRTY;
-	else
-		return BLK_STATE_ALLDIRTY;
+	return jffs2_scan_classify_jeb(c, jeb);
 }
 
 static struct jffs2_inode_cache *jffs2_scan_make_ino_cache(struct jffs2_sb_info *c, uint32_t ino)
@@ -691,7 +743,7 @@ static struct jffs2_inode_cache *jffs2_scan_make_ino_cache(struct jffs2_sb_info
 }
 
 static int jffs2_scan_inode_node(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb, 
-				 struct jffs2_raw_inode *ri, uint32_t ofs)
+				 struct jffs2_raw_inode *ri, uint32_t ofs, struct jffs2_summary *s)
 {
 	struct jffs2_raw_node_ref *raw;
 	struct jffs2_inode_cache *ic;
@@ -758,11 +810,14 @@ static int jffs2_scan_inode_node(struct jffs2_sb_info *c, struct jffs2_erasebloc
 	pseudo_random += je32_to_cpu(ri->version);
 
 	UNCHECKED_SPACE(PAD(je32_to_cpu(ri->totlen)));
+
+	if (jffs2_sum_active())
+		jffs2_sum_add_inode_mem(s, ri, ofs - jeb->offset);
 	return 0;
 }
 
 static int jffs2_scan_dirent_node(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb, 
-				  struct jffs2_raw_dirent *rd, uint32_t ofs)
+				  struct jffs2_raw_dirent *rd, uint32_t ofs, struct jffs2_summary *s)
 {
 	struct jffs2_raw_node_ref *raw;
 	struct jffs2_full_dirent *fd;
@@ -836,9 +891,283 @@ static int jffs2_scan_dirent_node(struct jffs2_sb_info *c, struct jffs2_eraseblo
 	USED_SPACE(PAD(je32_to_cpu(rd->totlen)));
 	jffs2_add_fd_to_list(c, fd, &ic->scan_dents);
 
+	if (jffs2_sum_active())
+		jffs2_sum_add_dirent_mem(s, rd, rd->name, ofs - jeb->offset);
+	return 0;
+}
+
+#ifdef CONFIG_JFFS2_SUMMARY
+static void jffs2_scan_add_ref(struct jffs2_eraseblock *jeb, struct jffs2_raw_node_ref *raw)
+{
+	if (!jeb->first_node)
+		jeb->first_node = raw;
+	if (jeb->last_node)
+		jeb->last_node->next_phys = raw;
+	jeb->last_node = raw;
+}
+
+static int jffs2_scan_sum_inode(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+				struct jffs2_sum_inode_flash *spi)
+{
+	struct jffs2_raw_node_ref *raw;
+	struct jffs2_inode_cache *ic;
+	uint32_t ofs = jeb->offset + je32_to_cpu(spi->offset);
+
+	raw = jffs2_alloc_raw_node_ref();
+	if (!raw) {
+		printk(KERN_NOTICE "jffs2_scan_sum_inode(): allocation of node reference failed\n");
+		return -ENOMEM;
+	}
+	ic = jffs2_scan_make_ino_cache(c, je32_to_cpu(spi->inode));
+	if (!ic) {
+		jffs2_free_raw_node_ref(raw);
+		return -ENOMEM;
+	}
+
+	/* Like a node found by scanning, it's checked later. The node obsoleted
+	   after the summary was written is found then. */
+	raw->flash_offset = ofs | REF_UNCHECKED;
+	raw->__totlen = PAD(je32_to_cpu(spi->totlen));
+	raw->next_phys = NULL;
+	raw->next_in_ino = ic->nodes;
+	ic->nodes = raw;
+	jffs2_scan_add_ref(jeb, raw);
+
+	D1(printk(KERN_DEBUG "Node at 0x%08x is ino #%u, version %d from summary\n",
+		  ofs, je32_to_cpu(spi->inode), je32_to_cpu(spi->version)));
+
+	pseudo_random += je32_to_cpu(spi->version);
+
+	UNCHECKED_SPACE(PAD(je32_to_cpu(spi->totlen)));
+	return 0;
+}
+
+static int jffs2_scan_sum_dirent(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+				 struct jffs2_sum_dirent_flash *spd)
+{
+	struct jffs2_unknown_node node;
+	struct jffs2_raw_node_ref *raw;
+	struct jffs2_full_dirent *fd;
+	struct jffs2_inode_cache *ic;
+	uint32_t ofs = jeb->offset + je32_to_cpu(spd->offset);
+	int err;
+
+	/* The dirents are used to build the directory tree at once, so check
+	   that the node hasn't been marked obsolete since the summary was
+	   written. It's left as dirty space if it has. */
+	err = jffs2_fill_scan_buf(c, (unsigned char *)&node, ofs, sizeof(node));
+	if (err)
+		return err;
+	if (je16_to_cpu(node.magic) != JFFS2_MAGIC_BITMASK ||
+	    je16_to_cpu(node.nodetype) != JFFS2_NODETYPE_DIRENT) {
+		D2(printk(KERN_DEBUG "Dirent at 0x%08x is obsolete. Skipping\n", ofs));
+		return 0;
+	}
+
+	pseudo_random += je32_to_cpu(spd->version);
+
+	fd = jffs2_alloc_full_dirent(spd->nsize+1);
+	if (!fd) {
+		return -ENOMEM;
+	}
+	memcpy(&fd->name, spd->name, spd->nsize);
+	fd->name[spd->nsize] = 0;
+
+	raw = jffs2_alloc_raw_node_ref();
+	if (!raw) {
+		jffs2_free_full_dirent(fd);
+		printk(KERN_NOTICE "jffs2_scan_sum_dirent(): allocation of node reference failed\n");
+		return -ENOMEM;
+	}
+	ic = jffs2_scan_make_ino_cache(c, je32_to_cpu(spd->pino));
+	if (!ic) {
+		jffs2_free_full_dirent(fd);
+		jffs2_free_raw_node_ref(raw);
+		return -ENOMEM;
+	}
+
+	raw->__totlen = PAD(je32_to_cpu(spd->totlen));
+	raw->flash_offset = ofs | REF_PRISTINE;
+	raw->next_phys = NULL;
+	raw->next_in_ino = ic->nodes;
+	ic->nodes = raw;
+	jffs2_scan_add_ref(jeb, raw);
+
+	fd->raw = raw;
+	fd->next = NULL;
+	fd->version = je32_to_cpu(spd->version);
+	fd->ino = je32_to_cpu(spd->ino);
+	fd->nhash = full_name_hash(fd->name, spd->nsize);
+	fd->type = spd->type;
+	USED_SPACE(PAD(je32_to_cpu(spd->totlen)));
+	jffs2_add_fd_to_list(c, fd, &ic->scan_dents);
+
 	return 0;
 }
 
+/* Check the summary node and all of its entries before any node ref is
+   built from it, so that the block can still be scanned if it's bad */
+static int jffs2_sum_verify(struct jffs2_sb_info *c, struct jffs2_raw_summary *summary,
+			    uint32_t sum_ofs, uint32_t sumlen)
+{
+	union jffs2_sum_flash *sp;
+	unsigned char *ptr, *end;
+	uint32_t crc, i, ofs, totlen, minlen, len, prev_end;
+
+	if (je16_to_cpu(summary->magic) != JFFS2_MAGIC_BITMASK ||
+	    je16_to_cpu(summary->nodetype) != JFFS2_NODETYPE_SUMMARY ||
+	    je32_to_cpu(summary->totlen) != sumlen)
+		return 0;
+
+	crc = crc32(0, summary, sizeof(struct jffs2_unknown_node)-4);
+	if (crc != je32_to_cpu(summary->hdr_crc))
+		return 0;
+	crc = crc32(0, summary, sizeof(struct jffs2_raw_summary)-8);
+	if (crc != je32_to_cpu(summary->node_crc))
+		return 0;
+	crc = crc32(0, summary->sum, sumlen - sizeof(struct jffs2_raw_summary));
+	if (crc != je32_to_cpu(summary->sum_crc))
+		return 0;
+
+	if (je32_to_cpu(summary->cln_mkr) && je32_to_cpu(summary->cln_mkr) != c->cleanmarker_size)
+		return 0;
+
+	prev_end = PAD(je32_to_cpu(summary->cln_mkr));
+	ptr = (unsigned char *)summary->sum;
+	end = (unsigned char *)summary + sumlen - sizeof(struct jffs2_sum_marker);
+
+	for (i = 0; i < je32_to_cpu(summary->sum_num); i++) {
+		sp = (union jffs2_sum_flash *)ptr;
+		if (ptr + sizeof(struct jffs2_sum_unknown_flash) > end)
+			return 0;
+
+		switch (je16_to_cpu(sp->u.nodetype)) {
+		case JFFS2_NODETYPE_INODE:
+			len = JFFS2_SUMMARY_INODE_SIZE;
+			if (ptr + len > end)
+				return 0;
+			ofs = je32_to_cpu(sp->i.offset);
+			totlen = je32_to_cpu(sp->i.totlen);
+			minlen = sizeof(struct jffs2_raw_inode);
+			break;
+
+		case JFFS2_NODETYPE_DIRENT:
+			if (ptr + JFFS2_SUMMARY_DIRENT_SIZE(0) > end)
+				return 0;
+			len = JFFS2_SUMMARY_DIRENT_SIZE(sp->d.nsize);
+			if (ptr + len > end)
+				return 0;
+			ofs = je32_to_cpu(sp->d.offset);
+			totlen = je32_to_cpu(sp->d.totlen);
+			minlen = sizeof(struct jffs2_raw_dirent) + sp->d.nsize;
+			break;
+
+		default:
+			printk(KERN_NOTICE "Unknown summary entry type 0x%04x\n", je16_to_cpu(sp->u.nodetype));
+			return 0;
+		}
+
+		/* The nodes are in order and before the summary node */
+		if ((ofs & 3) || ofs < prev_end || totlen < minlen ||
+		    totlen > sum_ofs || ofs + PAD(totlen) > sum_ofs)
+			return 0;
+
+		prev_end = ofs + PAD(totlen);
+		ptr += len;
+	}
+
+	return 1;
+}
+
+/* Returns the state of the block mounted from the summary, 0 if the block
+   shall be scanned, or a negative error */
+static int jffs2_scan_summary(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+			      uint32_t sum_ofs)
+{
+	struct jffs2_raw_summary *summary;
+	struct jffs2_raw_node_ref *raw;
+	union jffs2_sum_flash *sp;
+	unsigned char *ptr;
+	uint32_t sumlen, i;
+	int ret;
+
+	if ((sum_ofs & 3) || sum_ofs > c->sector_size - JFFS2_SUMMARY_FRAME_SIZE)
+		return 0;
+
+	sumlen = c->sector_size - sum_ofs;
+	summary = kmalloc(sumlen, GFP_KERNEL);
+	if (!summary)
+		return -ENOMEM;
+
+	ret = jffs2_fill_scan_buf(c, (unsigned char *)summary, jeb->offset + sum_ofs, sumlen);
+	if (ret)
+		goto out;
+
+	if (!jffs2_sum_verify(c, summary, sum_ofs, sumlen)) {
+		printk(KERN_NOTICE "Invalid summary found in block at 0x%08x, scanning it\n", jeb->offset);
+		ret = 0;
+		goto out;
+	}
+
+	D1(printk(KERN_DEBUG "Mounting block at 0x%08x from summary of %d entries\n",
+		  jeb->offset, je32_to_cpu(summary->sum_num)));
+
+	if (je32_to_cpu(summary->cln_mkr)) {
+		raw = jffs2_alloc_raw_node_ref();
+		if (!raw) {
+			printk(KERN_NOTICE "Failed to allocate node ref for clean marker\n");
+			ret = -ENOMEM;
+			goto out;
+		}
+		raw->next_in_ino = NULL;
+		raw->next_phys = NULL;
+		raw->flash_offset = jeb->offset | REF_NORMAL;
+		raw->__totlen = c->cleanmarker_size;
+		jeb->first_node = jeb->last_node = raw;
+
+		USED_SPACE(PAD(c->cleanmarker_size));
+	}
+
+	ptr = (unsigned char *)summary->sum;
+	for (i = 0; i < je32_to_cpu(summary->sum_num); i++) {
+		sp = (union jffs2_sum_flash *)ptr;
+
+		if (je16_to_cpu(sp->u.nodetype) == JFFS2_NODETYPE_INODE) {
+			ret = jffs2_scan_sum_inode(c, jeb, &sp->i);
+			ptr += JFFS2_SUMMARY_INODE_SIZE;
+		} else {
+			ret = jffs2_scan_sum_dirent(c, jeb, &sp->d);
+			ptr += JFFS2_SUMMARY_DIRENT_SIZE(sp->d.nsize);
+		}
+		if (ret)
+			goto out;
+	}
+
+	/* The summary node itself, which doesn't belong to any inode */
+	raw = jffs2_alloc_raw_node_ref();
+	if (!raw) {
+		printk(KERN_NOTICE "Failed to allocate node ref for summary\n");
+		ret = -ENOMEM;
+		goto out;
+	}
+	raw->next_in_ino = NULL;
+	raw->next_phys = NULL;
+	raw->flash_offset = (jeb->offset + sum_ofs) | REF_NORMAL;
+	raw->__totlen = sumlen;
+	jffs2_scan_add_ref(jeb, raw);
+
+	USED_SPACE(sumlen);
+
+	/* The rest of the block is the obsoleted nodes and padding */
+	DIRTY_SPACE(jeb->free_size);
+
+	ret = jffs2_scan_classify_jeb(c, jeb);
+ out:
+	kfree(summary);
+	return ret;
+}
+#endif /* CONFIG_JFFS2_SUMMARY */
+
 static int count_list(struct list_head *l)
 {
 	uint32_t count = 0;
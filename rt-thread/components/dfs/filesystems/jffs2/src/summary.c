@@ -0,0 +1,302 @@
+/*
+ * JFFS2 -- Journalling Flash File System, Version 2.
+ *
+ * Erase block summary.
+ *
+ * The inode and dirent nodes appended to the nextblock are collected in
+ * memory. Before the block is filled, the collected entries are written in
+ * a summary node which takes the rest of the block, and a marker pointing
+ * to it is put at the end of the block. At mount, jffs2_scan_eraseblock()
+ * builds the node refs of such a block from the summary without reading
+ * the nodes.
+ *
+ * For licensing information, see the file 'LICENCE' in this directory.
+ *
+ */
+
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/crc32.h>
+#include <linux/compiler.h>
+#include "nodelist.h"
+
+#ifdef CONFIG_JFFS2_SUMMARY
+
+/* The initial size of the buffer of collected entries */
+#define JFFS2_SUM_BUF_SIZE	256
+
+int jffs2_sum_init(struct jffs2_sb_info *c)
+{
+	c->summary = kmalloc(sizeof(struct jffs2_summary), GFP_KERNEL);
+	if (!c->summary) {
+		printk(KERN_WARNING "Can't allocate memory for summary information!\n");
+		return -ENOMEM;
+	}
+	memset(c->summary, 0, sizeof(struct jffs2_summary));
+
+	return 0;
+}
+
+void jffs2_sum_exit(struct jffs2_sb_info *c)
+{
+	if (c->summary) {
+		jffs2_sum_free_collected(c->summary);
+		kfree(c->summary);
+		c->summary = NULL;
+	}
+}
+
+void jffs2_sum_reset_collected(struct jffs2_summary *s)
+{
+	s->sum_size = 0;
+	s->sum_num = 0;
+	s->disabled = 0;
+}
+
+void jffs2_sum_free_collected(struct jffs2_summary *s)
+{
+	kfree(s->sum_buf);
+	s->sum_buf = NULL;
+	s->buf_size = 0;
+	jffs2_sum_reset_collected(s);
+}
+
+void jffs2_sum_disable_collecting(struct jffs2_summary *s)
+{
+	D1(printk(KERN_DEBUG "jffs2_sum_disable_collecting()\n"));
+	s->sum_size = 0;
+	s->sum_num = 0;
+	s->disabled = 1;
+}
+
+/* The entries collected during scanning the new nextblock replace the old ones */
+void jffs2_sum_move_collected(struct jffs2_sb_info *c, struct jffs2_summary *s)
+{
+	struct jffs2_summary tmp;
+
+	tmp = *c->summary;
+	*c->summary = *s;
+	*s = tmp;
+	jffs2_sum_reset_collected(s);
+}
+
+static void *jffs2_sum_alloc_entry(struct jffs2_summary *s, uint32_t size)
+{
+	unsigned char *buf;
+	uint32_t buf_size;
+
+	if (s->disabled)
+		return NULL;
+
+	if (s->sum_size + size > s->buf_size) {
+		buf_size = s->buf_size ? s->buf_size : JFFS2_SUM_BUF_SIZE;
+		while (buf_size < s->sum_size + size)
+			buf_size *= 2;
+
+		buf = kmalloc(buf_size, GFP_KERNEL);
+		if (!buf) {
+			/* The summary can't describe all nodes of this jeb */
+			printk(KERN_NOTICE "Can't allocate memory for summary entries, disabling summary of this jeb\n");
+			jffs2_sum_disable_collecting(s);
+			return NULL;
+		}
+		if (s->sum_size)
+			memcpy(buf, s->sum_buf, s->sum_size);
+		kfree(s->sum_buf);
+		s->sum_buf = buf;
+		s->buf_size = buf_size;
+	}
+
+	buf = s->sum_buf + s->sum_size;
+	s->sum_size += size;
+	s->sum_num++;
+
+	return buf;
+}
+
+void jffs2_sum_add_inode_mem(struct jffs2_summary *s, struct jffs2_raw_inode *ri, uint32_t ofs)
+{
+	struct jffs2_sum_inode_flash *sp;
+
+	sp = jffs2_sum_alloc_entry(s, JFFS2_SUMMARY_INODE_SIZE);
+	if (!sp)
+		return;
+
+	sp->nodetype = ri->nodetype;
+	sp->inode = ri->ino;
+	sp->version = ri->version;
+	sp->offset = cpu_to_je32(ofs);
+	sp->totlen = ri->totlen;
+}
+
+void jffs2_sum_add_dirent_mem(struct jffs2_summary *s, struct jffs2_raw_dirent *rd,
+			      const unsigned char *name, uint32_t ofs)
+{
+	struct jffs2_sum_dirent_flash *sp;
+
+	sp = jffs2_sum_alloc_entry(s, JFFS2_SUMMARY_DIRENT_SIZE(rd->nsize));
+	if (!sp)
+		return;
+
+	sp->nodetype = rd->nodetype;
+	sp->totlen = rd->totlen;
+	sp->offset = cpu_to_je32(ofs);
+	sp->pino = rd->pino;
+	sp->version = rd->version;
+	sp->ino = rd->ino;
+	sp->nsize = rd->nsize;
+	sp->type = rd->type;
+	memcpy(sp->name, name, rd->nsize);
+}
+
+/* Called after a node has been written successfully. The header of the
+   node is in vecs[0], and the name of a dirent follows it in vecs[1] */
+void jffs2_sum_add_kvec(struct jffs2_sb_info *c, const struct iovec *vecs,
+			unsigned long count, uint32_t to)
+{
+	union jffs2_node_union *node = vecs[0].iov_base;
+	struct jffs2_eraseblock *jeb = c->nextblock;
+	const unsigned char *name;
+
+	/* Only the nodes appended to the nextblock are described by its summary */
+	if (!jeb || to != jeb->offset + c->sector_size - jeb->free_size)
+		return;
+
+	switch (je16_to_cpu(node->u.nodetype)) {
+	case JFFS2_NODETYPE_INODE:
+		jffs2_sum_add_inode_mem(c->summary, &node->i, to - jeb->offset);
+		break;
+
+	case JFFS2_NODETYPE_DIRENT:
+		if (count > 1)
+			name = vecs[1].iov_base;
+		else
+			name = node->d.name;
+		jffs2_sum_add_dirent_mem(c->summary, &node->d, name, to - jeb->offset);
+		break;
+
+	default:
+		jffs2_sum_disable_collecting(c->summary);
+		break;
+	}
+}
+
+/* Space of the nextblock kept for the summary, so that the summary with
+   the entry of the node being written still fits in the block */
+uint32_t jffs2_sum_reserved_size(struct jffs2_sb_info *c)
+{
+	if (c->summary->disabled)
+		return 0;
+
+	return PAD(c->summary->sum_size + JFFS2_SUMMARY_DIRENT_SIZE(JFFS2_NAME_MAX) +
+		   JFFS2_SUMMARY_FRAME_SIZE);
+}
+
+/**
+ *	jffs2_sum_write_sumnode - write the summary node of the nextblock
+ *	@c: superblock info
+ *
+ *	The summary node takes all the free space of the nextblock, so the
+ *	block shall be closed after it. On failure, the summary of the block
+ *	is disabled and the block is scanned at mount as before.
+ *
+ *	Called with alloc_sem held, and without erase_completion_lock.
+ */
+int jffs2_sum_write_sumnode(struct jffs2_sb_info *c)
+{
+	struct jffs2_summary *s = c->summary;
+	struct jffs2_eraseblock *jeb = c->nextblock;
+	struct jffs2_raw_summary isum;
+	struct jffs2_sum_marker *sm;
+	struct jffs2_raw_node_ref *raw;
+	struct iovec vecs[2];
+	unsigned char *buf;
+	uint32_t sum_ofs, datasize, cln_mkr;
+	size_t retlen;
+	int ret;
+
+	if (!jeb || s->disabled)
+		return 0;
+
+	if (jeb->free_size < JFFS2_SUMMARY_FRAME_SIZE + s->sum_size) {
+		printk(KERN_NOTICE "No space for summary at 0x%08x, free 0x%08x, summary 0x%08x\n",
+		       jeb->offset, jeb->free_size, s->sum_size);
+		jffs2_sum_disable_collecting(s);
+		return -ENOSPC;
+	}
+
+	raw = jffs2_alloc_raw_node_ref();
+	datasize = jeb->free_size - sizeof(isum);
+	buf = kmalloc(datasize, GFP_KERNEL);
+	if (!raw || !buf) {
+		if (raw)
+			jffs2_free_raw_node_ref(raw);
+		kfree(buf);
+		jffs2_sum_disable_collecting(s);
+		return -ENOMEM;
+	}
+
+	/* The entries, the padding of empty flash and the marker at the end */
+	sum_ofs = c->sector_size - jeb->free_size;
+	memset(buf, 0xff, datasize);
+	memcpy(buf, s->sum_buf, s->sum_size);
+	sm = (struct jffs2_sum_marker *)(buf + datasize - sizeof(struct jffs2_sum_marker));
+	sm->offset = cpu_to_je32(sum_ofs);
+	sm->magic = cpu_to_je32(JFFS2_SUM_MAGIC);
+
+	/* A clean marker still valid is mounted from the summary too */
+	cln_mkr = 0;
+	if (c->cleanmarker_size && jeb->first_node && !jeb->first_node->next_in_ino &&
+	    ref_offset(jeb->first_node) == jeb->offset && !ref_obsolete(jeb->first_node))
+		cln_mkr = c->cleanmarker_size;
+
+	memset(&isum, 0, sizeof(isum));
+	isum.magic = cpu_to_je16(JFFS2_MAGIC_BITMASK);
+	isum.nodetype = cpu_to_je16(JFFS2_NODETYPE_SUMMARY);
+	isum.totlen = cpu_to_je32(jeb->free_size);
+	isum.hdr_crc = cpu_to_je32(crc32(0, &isum, sizeof(struct jffs2_unknown_node) - 4));
+	isum.sum_num = cpu_to_je32(s->sum_num);
+	isum.cln_mkr = cpu_to_je32(cln_mkr);
+	isum.padded = cpu_to_je32(jeb->dirty_size + jeb->wasted_size);
+	isum.sum_crc = cpu_to_je32(crc32(0, buf, datasize));
+	isum.node_crc = cpu_to_je32(crc32(0, &isum, sizeof(isum) - 8));
+
+	vecs[0].iov_base = &isum;
+	vecs[0].iov_len = sizeof(isum);
+	vecs[1].iov_base = buf;
+	vecs[1].iov_len = datasize;
+
+	D1(printk(KERN_DEBUG "Writing summary of %d entries at 0x%08x\n",
+		  s->sum_num, jeb->offset + sum_ofs));
+
+	raw->flash_offset = jeb->offset + sum_ofs;
+	raw->__totlen = jeb->free_size;
+	raw->next_phys = NULL;
+	/* Doesn't belong to any inode */
+	raw->next_in_ino = NULL;
+
+	ret = jffs2_flash_direct_writev(c, vecs, 2, jeb->offset + sum_ofs, &retlen);
+	kfree(buf);
+
+	if (ret || retlen != sizeof(isum) + datasize) {
+		printk(KERN_NOTICE "Write of summary at 0x%08x failed. returned %d, retlen %zd\n",
+		       jeb->offset + sum_ofs, ret, retlen);
+		jffs2_sum_disable_collecting(s);
+		if (retlen) {
+			/* The space written is dirty */
+			raw->flash_offset |= REF_OBSOLETE;
+			jffs2_add_physical_node_ref(c, raw);
+		} else {
+			jffs2_free_raw_node_ref(raw);
+		}
+		return ret ? ret : -EIO;
+	}
+
+	raw->flash_offset |= REF_NORMAL;
+	jffs2_add_physical_node_ref(c, raw);
+	jffs2_sum_reset_collected(s);
+
+	return 0;
+}
+
+#endif /* CONFIG_JFFS2_SUMMARY */
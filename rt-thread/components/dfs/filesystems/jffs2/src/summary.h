@@ -0,0 +1,124 @@
+/*
+ * JFFS2 -- Journalling Flash File System, Version 2.
+ *
+ * Erase block summary: the nodes written to an erase block are recorded
+ * in a summary node at the end of the block, so the block can be mounted
+ * by reading the summary only.
+ *
+ * For licensing information, see the file 'LICENCE' in this directory.
+ *
+ */
+
+#ifndef JFFS2_SUMMARY_H
+#define JFFS2_SUMMARY_H
+
+#define JFFS2_SUM_MAGIC	0x02851885
+
+/* The marker is at the end of the erase block and points to the summary node */
+struct jffs2_sum_marker
+{
+	jint32_t offset;	/* offset of the summary node in the jeb */
+	jint32_t magic;		/* == JFFS2_SUM_MAGIC */
+} __attribute__((packed));
+
+struct jffs2_raw_summary
+{
+	jint16_t magic;
+	jint16_t nodetype;	/* == JFFS2_NODETYPE_SUMMARY */
+	jint32_t totlen;
+	jint32_t hdr_crc;
+	jint32_t sum_num;	/* number of sum entries */
+	jint32_t cln_mkr;	/* clean marker size, 0 = no cleanmarker */
+	jint32_t padded;	/* space of the jeb not described by entries */
+	jint32_t sum_crc;	/* summary information crc */
+	jint32_t node_crc;	/* node crc */
+	jint32_t sum[0];	/* inode summary info */
+} __attribute__((packed));
+
+struct jffs2_sum_unknown_flash
+{
+	jint16_t nodetype;	/* node type */
+} __attribute__((packed));
+
+struct jffs2_sum_inode_flash
+{
+	jint16_t nodetype;	/* node type */
+	jint32_t inode;		/* inode number */
+	jint32_t version;	/* inode version */
+	jint32_t offset;	/* offset on jeb */
+	jint32_t totlen;	/* record length */
+} __attribute__((packed));
+
+struct jffs2_sum_dirent_flash
+{
+	jint16_t nodetype;	/* == JFFS_NODETYPE_DIRENT */
+	jint32_t totlen;	/* record length */
+	jint32_t offset;	/* offset on jeb */
+	jint32_t pino;		/* parent dir ino */
+	jint32_t version;	/* dirent version */
+	jint32_t ino;		/* == zero for unlink */
+	uint8_t nsize;		/* dirent name size */
+	uint8_t type;		/* dirent type */
+	uint8_t name[0];	/* dirent name */
+} __attribute__((packed));
+
+union jffs2_sum_flash
+{
+	struct jffs2_sum_unknown_flash u;
+	struct jffs2_sum_inode_flash i;
+	struct jffs2_sum_dirent_flash d;
+};
+
+#define JFFS2_SUMMARY_INODE_SIZE	(sizeof(struct jffs2_sum_inode_flash))
+#define JFFS2_SUMMARY_DIRENT_SIZE(x)	(sizeof(struct jffs2_sum_dirent_flash) + (x))
+#define JFFS2_SUMMARY_FRAME_SIZE	(sizeof(struct jffs2_raw_summary) + sizeof(struct jffs2_sum_marker))
+
+/* Entries collected for the nextblock, in the on-flash format */
+struct jffs2_summary
+{
+	uint32_t sum_size;	/* size of the collected entries */
+	uint32_t sum_num;	/* number of the collected entries */
+	uint32_t buf_size;	/* size of sum_buf */
+	int disabled;		/* no summary can be written for this jeb */
+	unsigned char *sum_buf;
+};
+
+#ifdef CONFIG_JFFS2_SUMMARY
+
+#define jffs2_sum_active() (1)
+
+int jffs2_sum_init(struct jffs2_sb_info *c);
+void jffs2_sum_exit(struct jffs2_sb_info *c);
+
+void jffs2_sum_reset_collected(struct jffs2_summary *s);
+void jffs2_sum_free_collected(struct jffs2_summary *s);
+void jffs2_sum_disable_collecting(struct jffs2_summary *s);
+void jffs2_sum_move_collected(struct jffs2_sb_info *c, struct jffs2_summary *s);
+
+void jffs2_sum_add_inode_mem(struct jffs2_summary *s, struct jffs2_raw_inode *ri, uint32_t ofs);
+void jffs2_sum_add_dirent_mem(struct jffs2_summary *s, struct jffs2_raw_dirent *rd,
+			      const unsigned char *name, uint32_t ofs);
+void jffs2_sum_add_kvec(struct jffs2_sb_info *c, const struct iovec *vecs,
+			unsigned long count, uint32_t to);
+
+uint32_t jffs2_sum_reserved_size(struct jffs2_sb_info *c);
+int jffs2_sum_write_sumnode(struct jffs2_sb_info *c);
+
+#else
+
+#define jffs2_sum_active() (0)
+#define jffs2_sum_init(a) (0)
+#define jffs2_sum_exit(a)
+#define jffs2_sum_reset_collected(a)
+#define jffs2_sum_free_collected(a)
+#define jffs2_sum_disable_collecting(a)
+#define jffs2_sum_move_collected(a,b)
+#define jffs2_sum_add_inode_mem(a,b,c)
+#define jffs2_sum_add_dirent_mem(a,b,c,d)
+#define jffs2_sum_add_kvec(a,b,c,d)
+#define jffs2_sum_reserved_size(a) (0)
+#define jffs2_sum_write_sumnode(a) (0)
+
+#endif /* CONFIG_JFFS2_SUMMARY */
+
+#endif /* JFFS2_SUMMARY_H */
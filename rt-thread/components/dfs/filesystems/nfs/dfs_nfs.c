@@ -35,6 +35,42 @@
 #define NAME_MAX    64
 #define DFS_NFS_MAX_MTU  1024
 
+/* the outstanding READ/WRITE calls of a transfer */
+#ifndef DFS_NFS_MAX_INFLIGHT
+#define DFS_NFS_MAX_INFLIGHT    4
+#endif
+
+/* the bytes read ahead on sequential reading, 0 for no read-ahead */
+#ifndef DFS_NFS_READAHEAD
+#define DFS_NFS_READAHEAD       4096
+#endif
+
+/* the bytes of write-behind buffer, 0 for writing through */
+#ifndef DFS_NFS_WRITEBEHIND
+#define DFS_NFS_WRITEBEHIND     4096
+#endif
+
+/* the times of retransmission without any reply */
+#ifndef DFS_NFS_MAX_RETRIES
+#define DFS_NFS_MAX_RETRIES     5
+#endif
+
+/* the cached handles and attributes of paths, 0 for no cache */
+#ifndef DFS_NFS_CACHE_SIZE
+#define DFS_NFS_CACHE_SIZE      32
+#endif
+
+/* the seconds of attributes cached for regular file and directory */
+#ifndef DFS_NFS_ACREGMIN
+#define DFS_NFS_ACREGMIN        3
+#endif
+#ifndef DFS_NFS_ACDIRMIN
+#define DFS_NFS_ACDIRMIN        30
+#endif
+
+/* the maximal bytes of READDIRPLUS reply, less than UDPMSGSIZE */
+#define DFS_NFS_READDIRPLUS_MAX 4096
+
 #ifdef _WIN32
 #define strtok_r strtok_s
 #endif
@@ -45,7 +81,40 @@ struct nfs_file
     size_t offset;      /* current offset */
 
     size_t size;        /* total size */
-    bool_t eof;         /* end of file */
+
+    /* read-ahead, the data of [ra_offset, ra_offset + ra_len) */
+    char *ra_buf;
+    size_t ra_offset;
+    size_t ra_len;
+    bool_t ra_eof;      /* the read-ahead data is end of file */
+    size_t next;        /* the offset after last read */
+
+    /* write-behind, the data of [wb_offset, wb_offset + wb_len) */
+    char *wb_buf;
+    size_t wb_offset;
+    size_t wb_len;
+
+    bool_t uncommitted; /* there are UNSTABLE writes to commit */
+    bool_t verf_valid;
+    writeverf3 verf;    /* write verifier of server */
+};
+
+/* a READ or WRITE call of transfer */
+struct nfs_rpc
+{
+    size_t offset;      /* offset in the transfer */
+    size_t count;
+
+    union
+    {
+        READ3args read;
+        WRITE3args write;
+    } args;
+    union
+    {
+        READ3res read;
+        WRITE3res write;
+    } res;
 };
 
 struct nfs_dir
@@ -56,6 +125,24 @@ struct nfs_dir
     entry3 *entry;
     bool_t eof;
     READDIR3res res;
+
+    char *path;             /* path of directory */
+    bool_t plus;            /* read by READDIRPLUS */
+    entryplus3 *entryplus;
+    READDIRPLUS3res resplus;
+    ftype3 type;            /* type of the last entry */
+};
+
+/* the cached handle and attributes of path */
+struct nfs_node
+{
+    rt_list_t list;         /* the most recently used is at head */
+
+    char *path;             /* NULL for free node */
+    rt_uint32_t hash;
+    nfs_fh3 handle;
+    fattr3 attr;
+    rt_tick_t expire;       /* the tick of attributes expired */
 };
 
 #define HOST_LENGTH         32
@@ -71,6 +158,9 @@ struct nfs_filesystem
     char host[HOST_LENGTH];
     char export[EXPORT_PATH_LENGTH];
     void *data;             /* nfs_file or nfs_dir */
+
+    struct nfs_node *nodes; /* NULL if not cached */
+    rt_list_t lru;
 };
 
 typedef struct nfs_filesystem nfs_filesystem;
@@ -140,98 +230,247 @@ static void copy_handle(nfs_fh3 *dest, const nfs_fh3 *source)
     memcpy(dest->data.data_val, source->data.data_val, dest->data.data_len);
 }
 
-static nfs_fh3 *get_handle(nfs_filesystem *nfs, const char *name)
+static rt_uint32_t nfs_hash_path(const char *path, size_t len)
 {
-    nfs_fh3 *handle = NULL;
-    char *file;
-    char *path;
-    char *init;
+    rt_uint32_t hash = 0;
 
-    init = path = rt_malloc(strlen(name)+1);
-    if (init == NULL)
-        return NULL;
+    while (len --)
+        hash = hash * 31 + (rt_uint8_t)*path ++;
 
-    memcpy(init, name, strlen(name)+1);
+    return hash;
+}
 
-    handle = rt_malloc(sizeof(nfs_fh3));
-    if (handle == NULL)
-    {
-        rt_free(init);
+/* the length of parent directory in path */
+static size_t nfs_parent_len(const char *path)
+{
+    const char *last = strrchr(path, '/');
+
+    return last == NULL ? 0 : last - path;
+}
+
+/* free the node and put it at the tail of LRU for reusing */
+static void nfs_cache_release(nfs_filesystem *nfs, struct nfs_node *node)
+{
+    rt_free(node->path);
+    node->path = NULL;
+    xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&node->handle);
+
+    rt_list_remove(&(node->list));
+    rt_list_insert_before(&(nfs->lru), &(node->list));
+}
+
+/* find the node of path, the node whose attributes expired is released */
+static struct nfs_node *nfs_cache_find(nfs_filesystem *nfs, const char *path, size_t len)
+{
+    int index;
+    rt_uint32_t hash;
+    struct nfs_node *node;
 
+    if (nfs->nodes == NULL || len == 0)
         return NULL;
+
+    hash = nfs_hash_path(path, len);
+    for (index = 0; index < DFS_NFS_CACHE_SIZE; index ++)
+    {
+        node = &nfs->nodes[index];
+        if (node->path == NULL || node->hash != hash ||
+            strncmp(node->path, path, len) != 0 || node->path[len] != '\0')
+            continue;
+
+        if ((rt_int32_t)(rt_tick_get() - node->expire) >= 0)
+        {
+            nfs_cache_release(nfs, node);
+
+            return NULL;
+        }
+
+        rt_list_remove(&(node->list));
+        rt_list_insert_after(&(nfs->lru), &(node->list));
+
+        return node;
     }
 
-    if (path[0] == '/')
+    return NULL;
+}
+
+static void nfs_cache_set_attr(struct nfs_node *node, const fattr3 *attr)
+{
+    node->attr = *attr;
+    node->expire = rt_tick_get() + RT_TICK_PER_SECOND *
+                   (attr->type == NFS3DIR ? DFS_NFS_ACDIRMIN : DFS_NFS_ACREGMIN);
+}
+
+/* cache the handle and attributes of an absolute path */
+static void nfs_cache_insert(nfs_filesystem *nfs, const char *path, size_t len,
+                             const nfs_fh3 *handle, const fattr3 *attr)
+{
+    struct nfs_node *node;
+
+    if (nfs->nodes == NULL || len == 0 || path[0] != '/')
+        return;
+
+    node = nfs_cache_find(nfs, path, len);
+    if (node == NULL)
     {
-        path ++;
-        copy_handle(handle, &nfs->root_handle);
+        /* reuse the least recently used node */
+        node = rt_list_entry(nfs->lru.prev, struct nfs_node, list);
+        if (node->path != NULL)
+            nfs_cache_release(nfs, node);
+
+        node->path = rt_malloc(len + 1);
+        if (node->path == NULL)
+            return;
+        memcpy(node->path, path, len);
+        node->path[len] = '\0';
+        node->hash = nfs_hash_path(path, len);
+
+        rt_list_remove(&(node->list));
+        rt_list_insert_after(&(nfs->lru), &(node->list));
     }
     else
     {
-        copy_handle(handle, &nfs->current_handle);
+        xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&node->handle);
     }
 
-    while ((file = strtok_r(NULL, "/", &path)) != NULL)
+    copy_handle(&node->handle, handle);
+    if (node->handle.data.data_val == NULL)
     {
-        LOOKUP3args args;
-        LOOKUP3res res;
-        memset(&res, 0, sizeof(res));
-        copy_handle(&args.what.dir, handle);
-        xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
-        args.what.name = file;
+        nfs_cache_release(nfs, node);
 
-        if (nfsproc3_lookup_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
-        {
-            rt_kprintf("Lookup failed\n");
-            rt_free(init);
-            rt_free(handle);
-            xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
+        return;
+    }
+    nfs_cache_set_attr(node, attr);
+}
 
-            return NULL;
-        }
-        else if (res.status != NFS3_OK)
-        {
-            rt_kprintf("Lookup failed: %d\n", res.status);
-            rt_free(init);
-            rt_free(handle);
-            xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
-            xdr_free((xdrproc_t)xdr_LOOKUP3res, (char *)&res);
+/* remove the node of path, and the nodes under it if subtree */
+static void nfs_cache_remove(nfs_filesystem *nfs, const char *path, size_t len,
+                             rt_bool_t subtree)
+{
+    int index;
+    struct nfs_node *node;
 
-            return NULL;
+    if (nfs->nodes == NULL)
+        return;
+
+    for (index = 0; index < DFS_NFS_CACHE_SIZE; index ++)
+    {
+        node = &nfs->nodes[index];
+        if (node->path != NULL && strncmp(node->path, path, len) == 0 &&
+            (node->path[len] == '\0' || (subtree && node->path[len] == '/')))
+        {
+            nfs_cache_release(nfs, node);
         }
-        copy_handle(handle, &res.LOOKUP3res_u.resok.object);
-        xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
-        xdr_free((xdrproc_t)xdr_LOOKUP3res, (char *)&res);
     }
+}
 
-    rt_free(init);
+/* update the attributes of directory after it's modified */
+static void nfs_cache_wcc(nfs_filesystem *nfs, const char *path, size_t len,
+                          const wcc_data *wcc)
+{
+    struct nfs_node *node;
 
-    return handle;
+    node = nfs_cache_find(nfs, path, len);
+    if (node == NULL)
+        return;
+
+    if (wcc->after.attributes_follow)
+        nfs_cache_set_attr(node, &wcc->after.post_op_attr_u.attributes);
+    else
+        nfs_cache_release(nfs, node);
 }
 
-static nfs_fh3 *get_dir_handle(nfs_filesystem *nfs, const char *name)
+static int nfs_getattr(nfs_filesystem *nfs, nfs_fh3 *handle, fattr3 *attr)
 {
-    nfs_fh3 *handle = NULL;
-    char *file;
-    char *path;
-    char *init;
+    GETATTR3args args;
+    GETATTR3res res;
+
+    args.object = *handle;
+
+    memset(&res, '\0', sizeof(res));
+
+    if (nfsproc3_getattr_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
+    {
+        rt_kprintf("GetAttr failed\n");
 
-    init = path = rt_malloc(strlen(name)+1);
-    if (init == NULL)
+        return -1;
+    }
+    else if (res.status != NFS3_OK)
+    {
+        rt_kprintf("Getattr failed: %d\n", res.status);
+
+        return -1;
+    }
+
+    *attr = res.GETATTR3res_u.resok.obj_attributes;
+    xdr_free((xdrproc_t)xdr_GETATTR3res, (char *)&res);
+
+    return 0;
+}
+
+/*
+ * Look up the handle of path by LOOKUP component by component from the
+ * longest cached directory of path, the handle and attributes of each
+ * component are cached. The attributes of path are returned if attr isn't
+ * NULL.
+ */
+static nfs_fh3 *nfs_lookup(nfs_filesystem *nfs, const char *name, size_t len,
+                           fattr3 *attr)
+{
+    LOOKUP3args args;
+    LOOKUP3res res;
+    struct nfs_node *node;
+    nfs_fh3 *handle;
+    fattr3 fattr;
+    bool_t attr_valid, retried = FALSE;
+    char *path, *component, save;
+    size_t start, end;
+
+    path = rt_malloc(len + 1);
+    if (path == NULL)
         return NULL;
-    memcpy(init, name, strlen(name)+1);
 
     handle = rt_malloc(sizeof(nfs_fh3));
     if (handle == NULL)
     {
-        rt_free(init);
+        rt_free(path);
 
         return NULL;
     }
 
+    memcpy(path, name, len);
+    path[len] = '\0';
+    /* remove the trailing '/' */
+    while (len > 0 && path[len - 1] == '/')
+        path[-- len] = '\0';
+
+__lookup:
+    /* find the longest cached directory of path */
+    node = NULL;
+    start = 0;
     if (path[0] == '/')
     {
-        path ++;
+        for (start = len; start > 0; start --)
+        {
+            node = nfs_cache_find(nfs, path, start);
+            if (node != NULL)
+                break;
+
+            while (start > 0 && path[start - 1] != '/')
+                start --;
+            if (start == 0)
+                break;
+        }
+    }
+
+    attr_valid = FALSE;
+    if (node != NULL)
+    {
+        copy_handle(handle, &node->handle);
+        fattr = node->attr;
+        attr_valid = TRUE;
+    }
+    else if (path[0] == '/')
+    {
         copy_handle(handle, &nfs->root_handle);
     }
     else
@@ -239,110 +478,103 @@ static nfs_fh3 *get_dir_handle(nfs_filesystem *nfs, const char *name)
         copy_handle(handle, &nfs->current_handle);
     }
 
-    while ((file = strtok_r(NULL, "/", &path)) != NULL && path[0] != 0)
+    for (end = start; end < len; )
     {
-        LOOKUP3args args;
-        LOOKUP3res res;
+        /* skip the separators */
+        while (end < len && path[end] == '/')
+            end ++;
+        if (end == len)
+            break;
+
+        component = &path[end];
+        while (end < len && path[end] != '/')
+            end ++;
+        save = path[end];
+        path[end] = '\0';
+
         memset(&res, 0, sizeof(res));
-        copy_handle(&args.what.dir, handle);
-        xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
-        args.what.name = file;
+        args.what.dir = *handle;
+        args.what.name = component;
 
         if (nfsproc3_lookup_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
         {
             rt_kprintf("Lookup failed\n");
-            rt_free(init);
-            rt_free(handle);
-            xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
-
-            return NULL;
+            goto __failed;
         }
         else if (res.status != NFS3_OK)
         {
-            rt_kprintf("Lookup failed: %d\n", res.status);
-            rt_free(init);
-            rt_free(handle);
-            xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
             xdr_free((xdrproc_t)xdr_LOOKUP3res, (char *)&res);
 
-            return NULL;
+            /* the cached directory is removed by others, look up again */
+            if (res.status == NFS3ERR_STALE && node != NULL && retried == FALSE)
+            {
+                path[end] = save;
+                nfs_cache_remove(nfs, path, 0, RT_TRUE);
+                xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
+                retried = TRUE;
+
+                goto __lookup;
+            }
+
+            rt_kprintf("Lookup failed: %d\n", res.status);
+            goto __failed;
         }
+
+        xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
         copy_handle(handle, &res.LOOKUP3res_u.resok.object);
-        xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
+        attr_valid = res.LOOKUP3res_u.resok.obj_attributes.attributes_follow;
+        if (attr_valid)
+        {
+            fattr = res.LOOKUP3res_u.resok.obj_attributes.post_op_attr_u.attributes;
+            nfs_cache_insert(nfs, path, end, handle, &fattr);
+        }
         xdr_free((xdrproc_t)xdr_LOOKUP3res, (char *)&res);
-    }
 
-    rt_free(init);
+        path[end] = save;
+    }
 
-    return handle;
-}
+    if (attr != NULL)
+    {
+        if (attr_valid == FALSE && nfs_getattr(nfs, handle, &fattr) < 0)
+            goto __failed;
 
-static size_t nfs_get_filesize(nfs_filesystem *nfs, nfs_fh3 *handle)
-{
-    GETATTR3args args;
-    GETATTR3res res;
-    fattr3 *info;
-    size_t size;
+        *attr = fattr;
+    }
+    rt_free(path);
 
-    args.object = *handle;
+    return handle;
 
-    memset(&res, '\0', sizeof(res));
+__failed:
+    xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
+    rt_free(handle);
+    rt_free(path);
 
-    if ((nfsproc3_getattr_3(args, &res, nfs->nfs_client)!=RPC_SUCCESS) ||
-        res.status != NFS3_OK)
-    {
-        rt_kprintf("GetAttr failed: %d\n", res.status);
+    return NULL;
+}
 
-        return 0;
-    }
+static nfs_fh3 *get_handle(nfs_filesystem *nfs, const char *name)
+{
+    return nfs_lookup(nfs, name, strlen(name), NULL);
+}
 
-    info = &res.GETATTR3res_u.resok.obj_attributes;
-    size = info->size;
-    xdr_free((xdrproc_t)xdr_GETATTR3res, (char *)&res);
-    
-    return size;
+static nfs_fh3 *get_dir_handle(nfs_filesystem *nfs, const char *name)
+{
+    return nfs_lookup(nfs, name, nfs_parent_len(name), NULL);
 }
 
 rt_bool_t nfs_is_directory(nfs_filesystem *nfs, const char *name)
 {
-    GETATTR3args args;
-    GETATTR3res res;
-    fattr3 *info;
+    fattr3 attr;
     nfs_fh3 *handle;
-    rt_bool_t result;
 
-    result = RT_FALSE;
-    handle = get_handle(nfs, name);
+    handle = nfs_lookup(nfs, name, strlen(name), &attr);
     if (handle == NULL)
         return RT_FALSE;
 
-    args.object = *handle;
-
-    memset(&res, '\0', sizeof(res));
-
-    if (nfsproc3_getattr_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
-    {
-        rt_kprintf("GetAttr failed\n");
-
-        return RT_FALSE;
-    }
-    else if (res.status != NFS3_OK)
-    {
-        rt_kprintf("Getattr failed: %d\n", res.status);
-
-        return RT_FALSE;
-    }
-
-    info=&res.GETATTR3res_u.resok.obj_attributes;
-
-    if (info->type == NFS3DIR)
-        result = RT_TRUE;
-
-    xdr_free((xdrproc_t)xdr_GETATTR3res, (char *)&res);
     xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
     rt_free(handle);
-    
-    return result;
+
+    return attr.type == NFS3DIR ? RT_TRUE : RT_FALSE;
 }
 
 int nfs_create(nfs_filesystem *nfs, const char *name, mode_t mode)
@@ -390,6 +622,17 @@ int nfs_create(nfs_filesystem *nfs, const char *name, mode_t mode)
         rt_kprintf("Create failed: %d\n", res.status);
         ret = -1;
     }
+    else
+    {
+        CREATE3resok *resok = &res.CREATE3res_u.resok;
+
+        nfs_cache_wcc(nfs, name, nfs_parent_len(name), &resok->dir_wcc);
+        if (resok->obj.handle_follows && resok->obj_attributes.attributes_follow)
+        {
+            nfs_cache_insert(nfs, name, strlen(name), &resok->obj.post_op_fh3_u.handle,
+                             &resok->obj_attributes.post_op_attr_u.attributes);
+        }
+    }
     xdr_free((xdrproc_t)xdr_CREATE3res, (char *)&res);
     xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
     rt_free(handle);
@@ -438,6 +681,17 @@ int nfs_mkdir(nfs_filesystem *nfs, const char *name, mode_t mode)
         rt_kprintf("Mkdir failed: %d\n", res.status);
         ret = -1;
     }
+    else
+    {
+        MKDIR3resok *resok = &res.MKDIR3res_u.resok;
+
+        nfs_cache_wcc(nfs, name, nfs_parent_len(name), &resok->dir_wcc);
+        if (resok->obj.handle_follows && resok->obj_attributes.attributes_follow)
+        {
+            nfs_cache_insert(nfs, name, strlen(name), &resok->obj.post_op_fh3_u.handle,
+                             &resok->obj_attributes.post_op_attr_u.attributes);
+        }
+    }
     xdr_free((xdrproc_t)xdr_MKDIR3res, (char *)&res);
     xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
     rt_free(handle);
@@ -489,6 +743,17 @@ int nfs_mount(struct dfs_filesystem *fs, unsigned long rwflag, const void *data)
     copy_handle(&nfs->current_handle, &nfs->root_handle);
 
     nfs->nfs_client->cl_auth = authnone_create();
+
+    /* no cache if out of memory */
+    rt_list_init(&nfs->lru);
+    if (DFS_NFS_CACHE_SIZE > 0)
+    {
+        int index;
+
+        nfs->nodes = rt_calloc(DFS_NFS_CACHE_SIZE, sizeof(struct nfs_node));
+        for (index = 0; nfs->nodes != NULL && index < DFS_NFS_CACHE_SIZE; index ++)
+            rt_list_insert_before(&nfs->lru, &(nfs->nodes[index].list));
+    }
     fs->data = nfs;
 
     return 0;
@@ -554,6 +819,12 @@ int nfs_unmount(struct dfs_filesystem *fs)
         nfs->mount_client = NULL;
     }
 
+    if (nfs->nodes != NULL)
+    {
+        nfs_cache_remove(nfs, "", 0, RT_TRUE);
+        rt_free(nfs->nodes);
+    }
+
     rt_free(nfs);
     fs->data = NULL;
 
@@ -565,11 +836,241 @@ int nfs_ioctl(struct dfs_fd *file, int cmd, void *args)
     return -ENOSYS;
 }
 
+/* encode the READ or WRITE call of the part of transfer and send it */
+static enum clnt_stat nfs_rpc_send(nfs_filesystem *nfs, unsigned long proc,
+                                   struct nfs_rpc *rpc, uint32_t xid)
+{
+    if (proc == NFSPROC3_READ)
+    {
+        return clntudp_send(nfs->nfs_client, proc, (xdrproc_t)xdr_READ3args,
+                            (char *)&rpc->args.read, xid);
+    }
+
+    return clntudp_send(nfs->nfs_client, proc, (xdrproc_t)xdr_WRITE3args,
+                        (char *)&rpc->args.write, xid);
+}
+
+/*
+ * Transfer the data of file by READ or WRITE calls in parallel.
+ *
+ * The range is split into the calls of MTU, up to DFS_NFS_MAX_INFLIGHT calls
+ * are outstanding and the replies are matched by transaction id. The data of
+ * READ is decoded to the buffer directly. The outstanding calls are
+ * retransmitted if there is no reply in the timeout of client.
+ *
+ * Return the bytes transferred from the offset continuously, or an error code.
+ */
+static int nfs_transfer(nfs_filesystem *nfs, nfs_file *fd, unsigned long proc,
+                        size_t offset, char *buf, size_t count, bool_t *eof)
+{
+    struct nfs_rpc rpcs[DFS_NFS_MAX_INFLIGHT];
+    struct clnt_pending pending[DFS_NFS_MAX_INFLIGHT];
+    struct nfs_rpc *rpc;
+    enum clnt_stat stat;
+    size_t issued = 0, end = count, bytes;
+    int index, inflight = 0, retries = 0, result = 0;
+
+    if (eof != NULL)
+        *eof = FALSE;
+
+    memset(pending, 0, sizeof(pending));
+    while (result == 0 && (issued < end || inflight > 0))
+    {
+        /* send the calls in the window */
+        for (index = 0; index < DFS_NFS_MAX_INFLIGHT && issued < end; index ++)
+        {
+            if (pending[index].xid != 0)
+                continue;
+
+            rpc = &rpcs[index];
+            rpc->offset = issued;
+            rpc->count = end - issued > DFS_NFS_MAX_MTU ? DFS_NFS_MAX_MTU : end - issued;
+            memset(&rpc->res, 0, sizeof(rpc->res));
+
+            if (proc == NFSPROC3_READ)
+            {
+                rpc->args.read.file = fd->handle;
+                rpc->args.read.offset = offset + rpc->offset;
+                rpc->args.read.count = rpc->count;
+
+                /* decode the data to the buffer */
+                rpc->res.read.READ3res_u.resok.data.data_val = buf + rpc->offset;
+                rpc->res.read.READ3res_u.resok.data.data_len = rpc->count;
+                pending[index].xresults = (xdrproc_t)xdr_READ3res;
+            }
+            else
+            {
+                rpc->args.write.file = fd->handle;
+                rpc->args.write.offset = offset + rpc->offset;
+                rpc->args.write.count = rpc->count;
+                rpc->args.write.stable = UNSTABLE;
+                rpc->args.write.data.data_val = buf + rpc->offset;
+                rpc->args.write.data.data_len = rpc->count;
+                pending[index].xresults = (xdrproc_t)xdr_WRITE3res;
+            }
+            pending[index].resultsp = (char *)&rpc->res;
+            pending[index].xid = clntudp_newxid(nfs->nfs_client);
+
+            if (nfs_rpc_send(nfs, proc, rpc, pending[index].xid) != RPC_SUCCESS)
+            {
+                rt_kprintf("Send call failed\n");
+                pending[index].xid = 0;
+                result = -EIO;
+                break;
+            }
+
+            issued += rpc->count;
+            inflight ++;
+        }
+        if (result != 0)
+            break;
+
+        stat = clntudp_recv(nfs->nfs_client, pending, DFS_NFS_MAX_INFLIGHT, &index);
+        if (stat == RPC_TIMEDOUT)
+        {
+            if (++ retries > DFS_NFS_MAX_RETRIES)
+            {
+                rt_kprintf("Server not responding\n");
+                result = -ETIMEDOUT;
+                break;
+            }
+
+            /* retransmit the outstanding calls */
+            for (index = 0; index < DFS_NFS_MAX_INFLIGHT; index ++)
+            {
+                if (pending[index].xid != 0)
+                    nfs_rpc_send(nfs, proc, &rpcs[index], pending[index].xid);
+            }
+            continue;
+        }
+
+        inflight --;
+        retries = 0;
+        rpc = &rpcs[index];
+        if (proc == NFSPROC3_READ)
+        {
+            READ3resok *resok = &rpc->res.read.READ3res_u.resok;
+
+            /* the buffer isn't allocated by xdr, don't free it */
+            if (stat != RPC_SUCCESS || rpc->res.read.status != NFS3_OK)
+            {
+                rt_kprintf("Read failed: %d\n", stat != RPC_SUCCESS ? stat : rpc->res.read.status);
+                result = -EIO;
+                break;
+            }
+
+            bytes = resok->count;
+            if (bytes < rpc->count || resok->eof)
+            {
+                /* the transfer ends at the short read */
+                if (rpc->offset + bytes <= end)
+                {
+                    end = rpc->offset + bytes;
+                    if (eof != NULL)
+                        *eof = resok->eof;
+                }
+            }
+        }
+        else
+        {
+            WRITE3resok *resok = &rpc->res.write.WRITE3res_u.resok;
+
+            if (stat != RPC_SUCCESS || rpc->res.write.status != NFS3_OK)
+            {
+                rt_kprintf("Write failed: %d\n", stat != RPC_SUCCESS ? stat : rpc->res.write.status);
+                result = -EIO;
+                break;
+            }
+
+            if (resok->committed == UNSTABLE)
+                fd->uncommitted = TRUE;
+
+            /* the server has rebooted, the unstable data may be lost */
+            if (fd->verf_valid && memcmp(fd->verf, resok->verf, NFS3_WRITEVERFSIZE) != 0)
+            {
+                rt_kprintf("Write failed: server rebooted\n");
+                result = -EIO;
+            }
+            memcpy(fd->verf, resok->verf, NFS3_WRITEVERFSIZE);
+            fd->verf_valid = TRUE;
+
+            bytes = resok->count;
+            if (bytes < rpc->count && rpc->offset + bytes < end)
+                end = rpc->offset + bytes;
+
+            xdr_free((xdrproc_t)xdr_WRITE3res, (char *)&rpc->res.write);
+        }
+    }
+
+    /* the replies of outstanding calls will be dropped as stale */
+    if (result < 0)
+        return result;
+
+    return end;
+}
+
+/* write the data in write-behind buffer to server */
+static int nfs_file_flush(nfs_filesystem *nfs, nfs_file *fd)
+{
+    int result;
+
+    if (fd->wb_len == 0)
+        return 0;
+
+    result = nfs_transfer(nfs, fd, NFSPROC3_WRITE, fd->wb_offset,
+                          fd->wb_buf, fd->wb_len, NULL);
+    if (result >= 0 && (size_t)result < fd->wb_len)
+        result = -EIO;
+    fd->wb_len = 0;
+
+    return result < 0 ? result : 0;
+}
+
+/* commit the data of UNSTABLE writes to stable storage of server */
+static int nfs_file_commit(nfs_filesystem *nfs, nfs_file *fd)
+{
+    COMMIT3args args;
+    COMMIT3res res;
+    int result = 0;
+
+    if (fd->uncommitted == FALSE)
+        return 0;
+
+    /* commit the whole file */
+    args.file = fd->handle;
+    args.offset = 0;
+    args.count = 0;
+
+    memset(&res, 0, sizeof(res));
+    if (nfsproc3_commit_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
+    {
+        rt_kprintf("Commit failed\n");
+
+        return -EIO;
+    }
+    else if (res.status != NFS3_OK)
+    {
+        rt_kprintf("Commit failed: %d\n", res.status);
+        result = -EIO;
+    }
+    else if (memcmp(fd->verf, res.COMMIT3res_u.resok.verf, NFS3_WRITEVERFSIZE) != 0)
+    {
+        /* the server has rebooted after the writes */
+        rt_kprintf("Commit failed: server rebooted\n");
+        result = -EIO;
+    }
+    fd->uncommitted = FALSE;
+    fd->verf_valid = FALSE;
+    xdr_free((xdrproc_t)xdr_COMMIT3res, (char *)&res);
+
+    return result;
+}
+
 int nfs_read(struct dfs_fd *file, void *buf, size_t count)
 {
-    READ3args args;
-    READ3res res;
-    ssize_t bytes, total=0;
+    int result = 0;
+    bool_t eof, sequential;
+    size_t bytes, total = 0;
     nfs_file *fd;
     nfs_filesystem *nfs;
 
@@ -586,58 +1087,77 @@ int nfs_read(struct dfs_fd *file, void *buf, size_t count)
     if (nfs->nfs_client == NULL)
         return -1;
 
-    /* end of file */
-    if (fd->eof == TRUE)
-        return 0;
+    /* the data written behind shall be read */
+    result = nfs_file_flush(nfs, fd);
+    if (result < 0)
+        return result;
 
-    args.file = fd->handle;
-    do {
-        args.offset = fd->offset;
-        args.count = count > DFS_NFS_MAX_MTU ? DFS_NFS_MAX_MTU : count;
-        count -= args.count;
-
-        memset(&res, 0, sizeof(res));
-        if (nfsproc3_read_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
+    sequential = (fd->offset == fd->next);
+    while (count > 0)
+    {
+        /* copy the data of read-ahead */
+        if (fd->ra_len > 0 && fd->offset >= fd->ra_offset &&
+            fd->offset < fd->ra_offset + fd->ra_len)
         {
-            rt_kprintf("Read failed\n");
-            total = 0;
-            break;
+            bytes = fd->ra_offset + fd->ra_len - fd->offset;
+            if (bytes > count)
+                bytes = count;
+            memcpy(buf, fd->ra_buf + (fd->offset - fd->ra_offset), bytes);
         }
-        else if (res.status != NFS3_OK)
+        else if (fd->ra_eof && fd->offset == fd->ra_offset + fd->ra_len)
         {
-            rt_kprintf("Read failed: %d\n", res.status);
-            total = 0;
+            /* end of file */
             break;
         }
+        else if (count < DFS_NFS_READAHEAD && sequential &&
+                 (fd->ra_buf != NULL || (fd->ra_buf = rt_malloc(DFS_NFS_READAHEAD)) != NULL))
+        {
+            /* sequential reading, read ahead to the buffer */
+            fd->ra_len = 0;
+            result = nfs_transfer(nfs, fd, NFSPROC3_READ, fd->offset,
+                                  fd->ra_buf, DFS_NFS_READAHEAD, &eof);
+            if (result <= 0)
+                break;
+
+            fd->ra_offset = fd->offset;
+            fd->ra_len = result;
+            fd->ra_eof = eof;
+            continue;
+        }
         else
         {
-            bytes = res.READ3res_u.resok.count;
-            total += bytes;
-            fd->offset += bytes;
-            /* update current position */
-            file->pos = fd->offset;
-            memcpy(buf, res.READ3res_u.resok.data.data_val, bytes);
-            buf = (void *)((char *)buf + args.count);
-            if (res.READ3res_u.resok.eof)
-            {
-                /* something should probably be here */
-                fd->eof = TRUE;
+            /* read to the buffer of caller directly */
+            result = nfs_transfer(nfs, fd, NFSPROC3_READ, fd->offset,
+                                  buf, count, &eof);
+            if (result < 0)
                 break;
-            }
+
+            bytes = result;
+            count = bytes;
         }
-        xdr_free((xdrproc_t)xdr_READ3res, (char *)&res);
-    } while(count > 0);
 
-    xdr_free((xdrproc_t)xdr_READ3res, (char *)&res);
+        total += bytes;
+        count -= bytes;
+        fd->offset += bytes;
+        buf = (void *)((char *)buf + bytes);
+        if (bytes == 0)
+            break;
+    }
+
+    /* update current position */
+    file->pos = fd->offset;
+    fd->next = fd->offset;
+
+    if (total == 0 && result < 0)
+        return result;
 
     return total;
 }
 
 int nfs_write(struct dfs_fd *file, const void *buf, size_t count)
 {
-    WRITE3args args;
-    WRITE3res res;
-    ssize_t bytes, total=0;
+    int result = 0;
+    size_t bytes, total = 0;
     nfs_file *fd;
     nfs_filesystem *nfs;
 
@@ -653,50 +1173,95 @@ int nfs_write(struct dfs_fd *file, const void *buf, size_t count)
     if (nfs->nfs_client == NULL)
         return -1;
 
-    args.file = fd->handle;
-    args.stable = FILE_SYNC;
+    /* the data read ahead is out of date */
+    fd->ra_len = 0;
+    fd->ra_eof = FALSE;
 
-    do {
-        args.offset = fd->offset;
-
-        memset(&res, 0, sizeof(res));
-        args.data.data_val=(void *)buf;
-        args.count = count > DFS_NFS_MAX_MTU ? DFS_NFS_MAX_MTU : count;
-        args.data.data_len = args.count;
-        count -= args.count;
-        buf = (const void *)((char *)buf + args.count);
+    /* the buffered data isn't followed by this write */
+    if (fd->wb_len > 0 && fd->offset != fd->wb_offset + fd->wb_len)
+    {
+        result = nfs_file_flush(nfs, fd);
+        if (result < 0)
+            return result;
+    }
 
-        if (nfsproc3_write_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
-        {
-            rt_kprintf("Write failed\n");
-            total = 0;
-            break;
-        }
-        else if (res.status != NFS3_OK)
+    while (count > 0)
+    {
+        if (fd->wb_len == 0 && (count >= DFS_NFS_WRITEBEHIND ||
+            (fd->wb_buf == NULL && (fd->wb_buf = rt_malloc(DFS_NFS_WRITEBEHIND)) == NULL)))
         {
-            rt_kprintf("Write failed: %d\n", res.status);
-            total = 0;
-            break;
+            /* write from the buffer of caller directly */
+            result = nfs_transfer(nfs, fd, NFSPROC3_WRITE, fd->offset,
+                                  (char *)buf, count, NULL);
+            if (result <= 0)
+                break;
+
+            bytes = result;
+            count = bytes;
         }
         else
         {
-            bytes = res.WRITE3res_u.resok.count;
-            fd->offset += bytes;
-            total += bytes;
-            /* update current position */
-            file->pos = fd->offset;
-            /* update file size */
-            if (fd->size < fd->offset) fd->size = fd->offset;
-            file->size = fd->size;
+            /* write behind */
+            if (fd->wb_len == 0)
+                fd->wb_offset = fd->offset;
+
+            bytes = DFS_NFS_WRITEBEHIND - fd->wb_len;
+            if (bytes > count)
+                bytes = count;
+            memcpy(fd->wb_buf + fd->wb_len, buf, bytes);
+            fd->wb_len += bytes;
+
+            if (fd->wb_len == DFS_NFS_WRITEBEHIND)
+            {
+                result = nfs_file_flush(nfs, fd);
+                if (result < 0)
+                    break;
+            }
         }
-        xdr_free((xdrproc_t)xdr_WRITE3res, (char *)&res);
-    } while (count > 0);
 
-    xdr_free((xdrproc_t)xdr_WRITE3res, (char *)&res);
+        total += bytes;
+        count -= bytes;
+        fd->offset += bytes;
+        buf = (const void *)((char *)buf + bytes);
+    }
+
+    /* update current position */
+    file->pos = fd->offset;
+    /* update file size */
+    if (fd->size < fd->offset) fd->size = fd->offset;
+    file->size = fd->size;
+
+    if (result < 0)
+        return result;
 
     return total;
 }
 
+int nfs_flush(struct dfs_fd *file)
+{
+    int result;
+    nfs_file *fd;
+    nfs_filesystem *nfs;
+
+    if (file->type == FT_DIRECTORY)
+        return -EISDIR;
+
+    RT_ASSERT(file->data != NULL);
+    struct dfs_filesystem *dfs_nfs  = ((struct dfs_filesystem*)(file->data));
+    nfs = (struct nfs_filesystem *)(dfs_nfs->data);
+    fd = (nfs_file *)(nfs->data);
+    RT_ASSERT(fd != NULL);
+
+    if (nfs->nfs_client == NULL)
+        return -1;
+
+    result = nfs_file_flush(nfs, fd);
+    if (result == 0)
+        result = nfs_file_commit(nfs, fd);
+
+    return result;
+}
+
 int nfs_lseek(struct dfs_fd *file, off_t offset)
 {
     nfs_file *fd;
@@ -735,6 +1300,8 @@ int nfs_close(struct dfs_fd *file)
         dir = (struct nfs_dir *)nfs->data;
         xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&dir->handle);
         xdr_free((xdrproc_t)xdr_READDIR3res, (char *)&dir->res);
+        xdr_free((xdrproc_t)xdr_READDIRPLUS3res, (char *)&dir->resplus);
+        rt_free(dir->path);
         rt_free(dir);
     }
     else if (file->type == FT_REGULAR)
@@ -743,7 +1310,20 @@ int nfs_close(struct dfs_fd *file)
 
         fd = (struct nfs_file *)nfs->data;
 
+        /* the file is closed even if the data isn't written */
+        if (nfs->nfs_client != NULL &&
+            (nfs_file_flush(nfs, fd) < 0 || nfs_file_commit(nfs, fd) < 0))
+        {
+            rt_kprintf("nfs: the data of %s may be lost\n", file->path);
+        }
+
+        /* the size and time of file are changed */
+        if (file->flags & (O_WRONLY | O_RDWR))
+            nfs_cache_remove(nfs, file->path, strlen(file->path), RT_FALSE);
+
         xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&fd->handle);
+        rt_free(fd->ra_buf);
+        rt_free(fd->wb_buf);
         rt_free(fd);
     }
 
@@ -778,6 +1358,7 @@ int nfs_open(struct dfs_fd *file)
     {
         nfs_file *fp;
         nfs_fh3 *handle;
+        fattr3 attr;
 
         /* create file */
         if (file->flags & O_CREAT)
@@ -790,8 +1371,13 @@ int nfs_open(struct dfs_fd *file)
         fp = rt_malloc(sizeof(nfs_file));
         if (fp == NULL)
             return -ENOMEM;
+        memset(fp, 0, sizeof(nfs_file));
+
+        /* close-to-open consistency, get the latest attributes on open */
+        if (!(file->flags & O_CREAT))
+            nfs_cache_remove(nfs, file->path, strlen(file->path), RT_FALSE);
 
-        handle = get_handle(nfs, file->path);
+        handle = nfs_lookup(nfs, file->path, strlen(file->path), &attr);
         if (handle == NULL)
         {
             rt_free(fp);
@@ -800,9 +1386,8 @@ int nfs_open(struct dfs_fd *file)
         }
 
         /* get size of file */
-        fp->size = nfs_get_filesize(nfs, handle);
+        fp->size = attr.size;
         fp->offset = 0;
-        fp->eof = FALSE;
 
         copy_handle(&fp->handle, handle);
         xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
@@ -812,6 +1397,7 @@ int nfs_open(struct dfs_fd *file)
         {
             fp->offset = fp->size;
         }
+        fp->next = fp->offset;
 
         /* set private file */
         nfs->data = fp;
@@ -823,9 +1409,7 @@ int nfs_open(struct dfs_fd *file)
 
 int nfs_stat(struct dfs_filesystem *fs, const char *path, struct stat *st)
 {
-    GETATTR3args args;
-    GETATTR3res res;
-    fattr3 *info;
+    fattr3 attr;
     nfs_fh3 *handle;
     nfs_filesystem *nfs;
 
@@ -833,40 +1417,23 @@ int nfs_stat(struct dfs_filesystem *fs, const char *path, struct stat *st)
     RT_ASSERT(fs->data != NULL);
     nfs = (nfs_filesystem *)fs->data;
 
-    handle = get_handle(nfs, path);
+    /* the cached attributes are used */
+    handle = nfs_lookup(nfs, path, strlen(path), &attr);
     if (handle == NULL)
         return -1;
 
-    args.object = *handle;
-
-    memset(&res, '\0', sizeof(res));
-
-    if (nfsproc3_getattr_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
-    {
-        rt_kprintf("GetAttr failed\n");
-        return -1;
-    }
-    else if (res.status != NFS3_OK)
-    {
-        rt_kprintf("Getattr failed: %d\n", res.status);
-        return -1;
-    }
-
-    info = &res.GETATTR3res_u.resok.obj_attributes;
-
     st->st_dev = 0;
 
     st->st_mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH | S_IWUSR | S_IWGRP | S_IWOTH;
-    if (info->type == NFS3DIR)
+    if (attr.type == NFS3DIR)
     {
         st->st_mode &= ~S_IFREG;
         st->st_mode |= S_IFDIR | S_IXUSR | S_IXGRP | S_IXOTH;
     }
 
-    st->st_size  = info->size;
-    st->st_mtime = info->mtime.seconds;
+    st->st_size  = attr.size;
+    st->st_mtime = attr.mtime.seconds;
 
-    xdr_free((xdrproc_t)xdr_GETATTR3res, (char *)&res);
     xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
     rt_free(handle);
 
@@ -901,9 +1468,105 @@ nfs_dir *nfs_opendir(nfs_filesystem *nfs, const char *path)
     dir->eof = FALSE;
     memset(&dir->res, '\0', sizeof(dir->res));
 
+    dir->path = rt_strdup(path);
+    dir->plus = TRUE;
+    dir->entryplus = NULL;
+    memset(&dir->resplus, '\0', sizeof(dir->resplus));
+    dir->type = NFS3REG;
+
     return dir;
 }
 
+/* cache the handle and attributes of the entry got by READDIRPLUS */
+static void nfs_cache_entry(nfs_filesystem *nfs, nfs_dir *dir, entryplus3 *entry)
+{
+    char *path;
+    size_t len;
+
+    if (dir->path == NULL || !entry->name_handle.handle_follows ||
+        !entry->name_attributes.attributes_follow ||
+        strcmp(entry->name, ".") == 0 || strcmp(entry->name, "..") == 0)
+        return;
+
+    len = strlen(dir->path);
+    /* the root directory */
+    if (len == 1 && dir->path[0] == '/')
+        len = 0;
+
+    path = rt_malloc(len + strlen(entry->name) + 2);
+    if (path == NULL)
+        return;
+
+    memcpy(path, dir->path, len);
+    path[len] = '/';
+    strcpy(&path[len + 1], entry->name);
+
+    nfs_cache_insert(nfs, path, strlen(path), &entry->name_handle.post_op_fh3_u.handle,
+                     &entry->name_attributes.post_op_attr_u.attributes);
+    rt_free(path);
+}
+
+/* read directory by READDIRPLUS, which gets the handles and attributes of
+ * entries too. dir->plus is cleared if it's not supported by server. */
+static char *nfs_readdirplus(nfs_filesystem *nfs, nfs_dir *dir, char *name)
+{
+    entryplus3 *entry;
+
+    while (dir->entryplus == NULL)
+    {
+        READDIRPLUS3args args;
+
+        if (dir->eof == TRUE)
+            return NULL;
+
+        xdr_free((xdrproc_t)xdr_READDIRPLUS3res, (char *)&dir->resplus);
+        memset(&dir->resplus, '\0', sizeof(dir->resplus));
+
+        args.dir = dir->handle;
+        args.cookie = dir->cookie;
+        memcpy(&args.cookieverf, &dir->cookieverf, sizeof(cookieverf3));
+        args.dircount = 1024;
+        args.maxcount = DFS_NFS_READDIRPLUS_MAX;
+
+        if (nfsproc3_readdirplus_3(args, &dir->resplus, nfs->nfs_client) != RPC_SUCCESS)
+        {
+            rt_kprintf("Readdirplus failed\n");
+
+            return NULL;
+        }
+        else if (dir->resplus.status == NFS3ERR_NOTSUPP)
+        {
+            dir->plus = FALSE;
+
+            return NULL;
+        }
+        else if (dir->resplus.status != NFS3_OK)
+        {
+            rt_kprintf("Readdirplus failed: %d\n", dir->resplus.status);
+
+            return NULL;
+        }
+
+        memcpy(&dir->cookieverf, &dir->resplus.READDIRPLUS3res_u.resok.cookieverf, sizeof(cookieverf3));
+        dir->eof = dir->resplus.READDIRPLUS3res_u.resok.reply.eof;
+        dir->entryplus = dir->resplus.READDIRPLUS3res_u.resok.reply.entries;
+
+        for (entry = dir->entryplus; entry != NULL; entry = entry->nextentry)
+            nfs_cache_entry(nfs, dir, entry);
+    }
+
+    entry = dir->entryplus;
+    dir->cookie = entry->cookie;
+    dir->type = NFS3REG;
+    if (entry->name_attributes.attributes_follow)
+        dir->type = entry->name_attributes.post_op_attr_u.attributes.type;
+    strncpy(name, entry->name, NAME_MAX-1);
+    dir->entryplus = entry->nextentry;
+    name[NAME_MAX - 1] = '\0';
+
+    return name;
+}
+
 char *nfs_readdir(nfs_filesystem *nfs, nfs_dir *dir)
 {
     static char name[NAME_MAX];
@@ -911,6 +1574,16 @@ char *nfs_readdir(nfs_filesystem *nfs, nfs_dir *dir)
     if (nfs->nfs_client == NULL || dir == NULL)
         return NULL;
 
+    if (dir->plus)
+    {
+        char *result = nfs_readdirplus(nfs, dir, name);
+
+        /* read by READDIR if READDIRPLUS isn't supported */
+        if (dir->plus)
+            return result;
+    }
+
+    dir->type = NFS3REG;
     if (dir->entry == NULL)
     {
         READDIR3args args;
@@ -990,6 +1663,11 @@ int nfs_unlink(struct dfs_filesystem *fs, const char *path)
             rt_kprintf("Remove failed: %d\n", res.status);
             ret = -1;
         }
+        else
+        {
+            nfs_cache_remove(nfs, path, strlen(path), RT_FALSE);
+            nfs_cache_wcc(nfs, path, nfs_parent_len(path), &res.REMOVE3res_u.resok.dir_wcc);
+        }
         xdr_free((xdrproc_t)xdr_REMOVE3res, (char *)&res);
         xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
         rt_free(handle);
@@ -1024,6 +1702,11 @@ int nfs_unlink(struct dfs_filesystem *fs, const char *path)
             rt_kprintf("Rmdir failed: %d\n", res.status);
             ret = -1;
         }
+        else
+        {
+            nfs_cache_remove(nfs, path, strlen(path), RT_TRUE);
+            nfs_cache_wcc(nfs, path, nfs_parent_len(path), &res.RMDIR3res_u.resok.dir_wcc);
+        }
 
         xdr_free((xdrproc_t)xdr_RMDIR3res, (char *)&res);
         xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
@@ -1055,7 +1738,12 @@ int nfs_rename(struct dfs_filesystem *fs, const char *src, const char *dest)
 
     dHandle = get_dir_handle(nfs, dest);
     if (dHandle == NULL)
+    {
+        xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)sHandle);
+        rt_free(sHandle);
+
         return -1;
+    }
 
     args.from.dir = *sHandle;
     args.from.name = strrchr(src, '/') + 1;
@@ -1063,7 +1751,7 @@ int nfs_rename(struct dfs_filesystem *fs, const char *src, const char *dest)
         args.from.name = (char *)src;
 
     args.to.dir = *dHandle;
-    args.to.name = strrchr(src, '/') + 1;
+    args.to.name = strrchr(dest, '/') + 1;
     if (args.to.name == NULL)
         args.to.name = (char *)dest;
 
@@ -1079,10 +1767,19 @@ int nfs_rename(struct dfs_filesystem *fs, const char *src, const char *dest)
         rt_kprintf("Rename failed: %d\n", res.status);
         ret = -1;
     }
+    else
+    {
+        nfs_cache_remove(nfs, src, strlen(src), RT_TRUE);
+        nfs_cache_remove(nfs, dest, strlen(dest), RT_TRUE);
+        nfs_cache_wcc(nfs, src, nfs_parent_len(src), &res.RENAME3res_u.resok.fromdir_wcc);
+        nfs_cache_wcc(nfs, dest, nfs_parent_len(dest), &res.RENAME3res_u.resok.todir_wcc);
+    }
 
     xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)sHandle);
     xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)dHandle);
     xdr_free((xdrproc_t)xdr_RENAME3res, (char *)&res);
+    rt_free(sHandle);
+    rt_free(dHandle);
 
     return ret;
 }
@@ -1116,7 +1813,7 @@ int nfs_getdents(struct dfs_fd *file, struct dirent *dirp, uint32_t count)
         if (name == NULL)
             break;
 
-        d->d_type = DT_REG;
+        d->d_type = dir->type == NFS3DIR ? DT_DIR : DT_REG;
 
         d->d_namlen = rt_strlen(name);
         d->d_reclen = (rt_uint16_t)sizeof(struct dirent);
@@ -1137,7 +1834,7 @@ static const struct dfs_file_ops nfs_fops =
         nfs_ioctl,
         nfs_read,
         nfs_write,
-        NULL, /* flush */
+        nfs_flush,
         nfs_lseek,
         nfs_getdents,
         NULL, /* poll */
@@ -1146,7 +1843,7 @@ static const struct dfs_file_ops nfs_fops =
 static const struct dfs_filesystem_ops _nfs = 
 {
     "nfs",
-    DFS_FS_FLAG_DEFAULT,
+    DFS_FS_FLAG_LOCKED | DFS_FS_FLAG_REMOTE,
     &nfs_fops,
     nfs_mount,
     nfs_unmount,
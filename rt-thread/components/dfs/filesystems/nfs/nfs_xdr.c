@@ -707,13 +707,19 @@ xdr_READ3args(register XDR *xdrs, READ3args *objp)
 bool_t
 xdr_READ3resok(register XDR *xdrs, READ3resok *objp)
 {
+	unsigned int maxsize = ~0;
+
+	/* decode the data to the buffer of caller directly if it's preset */
+	if (xdrs->x_op == XDR_DECODE && objp->data.data_val != NULL)
+		maxsize = objp->data.data_len;
+
 	if (!xdr_post_op_attr(xdrs, &objp->file_attributes))
 		return (FALSE);
 	if (!xdr_count3(xdrs, &objp->count))
 		return (FALSE);
 	if (!xdr_bool(xdrs, &objp->eof))
 		return (FALSE);
-	if (!xdr_bytes(xdrs, (char **)&objp->data.data_val, (unsigned int *) &objp->data.data_len, ~0))
+	if (!xdr_bytes(xdrs, (char **)&objp->data.data_val, (unsigned int *) &objp->data.data_len, maxsize))
 		return (FALSE);
 	return (TRUE);
 }
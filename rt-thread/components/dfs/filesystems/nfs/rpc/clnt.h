@@ -309,6 +309,42 @@ extern CLIENT *clntudp_bufcreate (struct sockaddr_in *__raddr,
 				  struct timeval __wait_resend, int *__sockp,
 				  unsigned int __sendsz, unsigned int __recvsz);
 
+/*
+ * Pipelined UDP based rpc.
+ * uint32_t
+ * clntudp_newxid(cl)
+ *	CLIENT *cl;
+ *
+ * enum clnt_stat
+ * clntudp_send(cl, proc, xargs, argsp, xid)
+ *	CLIENT *cl;
+ *	unsigned long proc;
+ *	xdrproc_t xargs;
+ *	char* argsp;
+ *	uint32_t xid;
+ *
+ * Receive a reply of the pending calls, the index of call is returned and its
+ * xid is cleared. RPC_TIMEDOUT is returned if no reply in the timeout.
+ * enum clnt_stat
+ * clntudp_recv(cl, pending, count, index)
+ *	CLIENT *cl;
+ *	struct clnt_pending *pending;
+ *	int count;
+ *	int *index;
+ */
+struct clnt_pending
+{
+	uint32_t xid;			/* 0 if no pending call */
+	xdrproc_t xresults;
+	char* resultsp;
+};
+
+extern uint32_t clntudp_newxid (CLIENT *__cl);
+extern enum clnt_stat clntudp_send (CLIENT *__cl, unsigned long __proc,
+				    xdrproc_t __xargs, char* __argsp, uint32_t __xid);
+extern enum clnt_stat clntudp_recv (CLIENT *__cl, struct clnt_pending *__pending,
+				    int __count, int *__index);
+
 extern int callrpc (const char *__host, const unsigned long __prognum,
 		    const unsigned long __versnum, const unsigned long __procnum,
 		    const xdrproc_t __inproc, const char *__in,
@@ -258,6 +258,7 @@ send_again:
 	reply_msg.acpted_rply.ar_results.proc = xresults;
 
 	/* do recv */
+recv_again:
 	do
 	{
 		fromlen = sizeof(struct sockaddr);
@@ -276,9 +277,10 @@ send_again:
 		return RPC_CANTRECV;
 	}
 
-	/* see if reply transaction id matches sent id */
+	/* see if reply transaction id matches sent id, the reply of a former
+	 * call is dropped */
 	if (*((uint32_t *) (cu->cu_inbuf)) != *((uint32_t *) (cu->cu_outbuf)))
-		goto send_again;
+		goto recv_again;
 
 	/* we now assume we have the proper reply */
 
@@ -325,6 +327,149 @@ send_again:
 	return (enum clnt_stat)(cu->cu_error.re_status);
 }
 
+/*
+ * Pipelined calls.
+ *
+ * Several calls are sent by clntudp_send() before their replies are received
+ * by clntudp_recv(), the replies are matched with the calls by transaction id.
+ * A call is retransmitted with the same transaction id, so the reply of the
+ * former transmission is accepted too.
+ */
+uint32_t clntudp_newxid(CLIENT *cl)
+{
+	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
+	uint32_t *xid = (uint32_t *) (cu->cu_outbuf);
+
+	/* 0 is the transaction id of no pending call */
+	if (++(*xid) == 0)
+		++(*xid);
+
+	return *xid;
+}
+
+enum clnt_stat clntudp_send(CLIENT *cl, unsigned long proc,
+	xdrproc_t xargs, char* argsp, uint32_t xid)
+{
+	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
+	register XDR *xdrs = &(cu->cu_outxdrs);
+	uint32_t last_xid;
+	int outlen;
+
+	/* keep the last transaction id for the next call */
+	last_xid = *(uint32_t *) (cu->cu_outbuf);
+	*(uint32_t *) (cu->cu_outbuf) = xid;
+
+	xdrs->x_op = XDR_ENCODE;
+	XDR_SETPOS(xdrs, cu->cu_xdrpos);
+	if ((!XDR_PUTLONG(xdrs, (long *) &proc)) ||
+			(!AUTH_MARSHALL(cl->cl_auth, xdrs)) || (!(*xargs) (xdrs, argsp)))
+	{
+		cu->cu_error.re_status = RPC_CANTENCODEARGS;
+		goto __exit;
+	}
+	outlen = (int) XDR_GETPOS(xdrs);
+
+	if (sendto(cu->cu_sock, cu->cu_outbuf, outlen, 0,
+			   (struct sockaddr *) &(cu->cu_raddr), cu->cu_rlen)
+			!= outlen)
+	{
+		cu->cu_error.re_errno = errno;
+		cu->cu_error.re_status = RPC_CANTSEND;
+		goto __exit;
+	}
+	cu->cu_error.re_status = RPC_SUCCESS;
+
+__exit:
+	*(uint32_t *) (cu->cu_outbuf) = last_xid;
+
+	return (enum clnt_stat)(cu->cu_error.re_status);
+}
+
+enum clnt_stat clntudp_recv(CLIENT *cl, struct clnt_pending *pending,
+	int count, int *index)
+{
+	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
+	register int inlen;
+	socklen_t fromlen;
+
+	struct sockaddr_in from;
+	struct rpc_msg reply_msg;
+	XDR reply_xdrs;
+	uint32_t xid;
+	bool_t ok;
+	int i;
+
+	for (;;)
+	{
+		do
+		{
+			fromlen = sizeof(struct sockaddr);
+
+			inlen = recvfrom(cu->cu_sock, cu->cu_inbuf,
+							 (int) cu->cu_recvsz, 0,
+							 (struct sockaddr *) &from, &fromlen);
+		} while (inlen < 0 && errno == EINTR);
+
+		if (inlen < 4)
+		{
+			cu->cu_error.re_errno = errno;
+			if (inlen < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+				cu->cu_error.re_status = RPC_TIMEDOUT;
+			else
+				cu->cu_error.re_status = RPC_CANTRECV;
+
+			return (enum clnt_stat)(cu->cu_error.re_status);
+		}
+
+		xid = *((uint32_t *) (cu->cu_inbuf));
+		for (i = 0; i < count; i ++)
+		{
+			if (pending[i].xid != 0 && pending[i].xid == xid)
+				break;
+		}
+
+		if (i < count)
+			break;
+
+		/* drop the reply of a retransmitted or abandoned call */
+	}
+	*index = i;
+	pending[i].xid = 0;
+
+	reply_msg.acpted_rply.ar_verf = _null_auth;
+	reply_msg.acpted_rply.ar_results.where = pending[i].resultsp;
+	reply_msg.acpted_rply.ar_results.proc = pending[i].xresults;
+
+	xdrmem_create(&reply_xdrs, cu->cu_inbuf, (unsigned int) inlen, XDR_DECODE);
+	ok = xdr_replymsg(&reply_xdrs, &reply_msg);
+	if (ok)
+	{
+		_seterr_reply(&reply_msg, &(cu->cu_error));
+		if (cu->cu_error.re_status == RPC_SUCCESS)
+		{
+			if (!AUTH_VALIDATE(cl->cl_auth,
+							   &reply_msg.acpted_rply.ar_verf))
+			{
+				cu->cu_error.re_status = RPC_AUTHERROR;
+				cu->cu_error.re_why = AUTH_INVALIDRESP;
+			}
+			if (reply_msg.acpted_rply.ar_verf.oa_base != NULL)
+			{
+				extern bool_t xdr_opaque_auth(XDR *xdrs, struct opaque_auth *ap);
+
+				reply_xdrs.x_op = XDR_FREE;
+				(void) xdr_opaque_auth(&reply_xdrs, &(reply_msg.acpted_rply.ar_verf));
+			}
+		}
+	}
+	else
+	{
+		cu->cu_error.re_status = RPC_CANTDECODERES;
+	}
+
+	return (enum clnt_stat)(cu->cu_error.re_status);
+}
+
 static void clntudp_geterr(CLIENT *cl, struct rpc_err *errp)
 {
 	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
@@ -31,6 +31,298 @@
 
 #include "dfs_ramfs.h"
 
+/*
+ * The directories are trees of ramfs_dirent, which are looked up in the hash
+ * table of file system by the parent and the name. The data of file is stored
+ * in pages allocated on writing, the page table is doubled when the file
+ * grows, so appending doesn't copy the data. The pages never written are
+ * holes, which are read as zero.
+ */
+
+#define RAMFS_PAGE_INDEX(pos)   ((pos) / DFS_RAMFS_PAGE_SIZE)
+#define RAMFS_PAGE_OFFSET(pos)  ((pos) % DFS_RAMFS_PAGE_SIZE)
+
+static void *ramfs_alloc(struct dfs_ramfs *ramfs, rt_size_t size)
+{
+#ifdef RT_USING_HEAP
+    if (ramfs->heap)
+        return rt_malloc(size);
+#endif
+
+    return rt_memheap_alloc(&(ramfs->memheap), size);
+}
+
+static void *ramfs_realloc(struct dfs_ramfs *ramfs, void *ptr, rt_size_t size)
+{
+#ifdef RT_USING_HEAP
+    if (ramfs->heap)
+        return rt_realloc(ptr, size);
+#endif
+
+    return rt_memheap_realloc(&(ramfs->memheap), ptr, size);
+}
+
+static void ramfs_free(struct dfs_ramfs *ramfs, void *ptr)
+{
+#ifdef RT_USING_HEAP
+    if (ramfs->heap)
+    {
+        rt_free(ptr);
+
+        return;
+    }
+#endif
+
+    rt_memheap_free(ptr);
+}
+
+static rt_uint8_t *ramfs_page_alloc(struct dfs_ramfs *ramfs)
+{
+    rt_uint8_t *page;
+
+    if (ramfs->used_size + DFS_RAMFS_PAGE_SIZE > ramfs->size)
+        return NULL;
+
+    page = (rt_uint8_t *)ramfs_alloc(ramfs, DFS_RAMFS_PAGE_SIZE);
+    if (page != NULL)
+    {
+        /* the bytes not written are read as zero */
+        rt_memset(page, 0, DFS_RAMFS_PAGE_SIZE);
+        ramfs->used_size += DFS_RAMFS_PAGE_SIZE;
+    }
+
+    return page;
+}
+
+static void ramfs_page_free(struct dfs_ramfs *ramfs, rt_uint8_t *page)
+{
+    ramfs_free(ramfs, page);
+    ramfs->used_size -= DFS_RAMFS_PAGE_SIZE;
+}
+
+/* make the page table have the number of pages at least */
+static int ramfs_file_expand(struct ramfs_dirent *dirent, rt_size_t pages)
+{
+    rt_uint8_t **table;
+    rt_size_t count;
+
+    if (pages <= dirent->page_count)
+        return 0;
+
+    count = dirent->page_count ? dirent->page_count : 4;
+    while (count < pages)
+        count *= 2;
+
+    table = (rt_uint8_t **)ramfs_realloc(dirent->fs, dirent->pages, count * sizeof(rt_uint8_t *));
+    if (table == NULL)
+        return -ENOMEM;
+
+    rt_memset(table + dirent->page_count, 0,
+              (count - dirent->page_count) * sizeof(rt_uint8_t *));
+    dirent->pages = table;
+    dirent->page_count = count;
+
+    return 0;
+}
+
+static void ramfs_file_truncate(struct ramfs_dirent *dirent)
+{
+    rt_size_t index;
+
+    for (index = 0; index < dirent->page_count; index ++)
+    {
+        if (dirent->pages[index] != NULL)
+            ramfs_page_free(dirent->fs, dirent->pages[index]);
+    }
+
+    if (dirent->pages != NULL)
+        ramfs_free(dirent->fs, dirent->pages);
+    dirent->pages = NULL;
+    dirent->page_count = 0;
+    dirent->size = 0;
+}
+
+/*
+ * write data to file at the position, the buffer NULL writes zero. It
+ * returns the length written, which is less than count if no memory.
+ */
+static rt_size_t ramfs_file_write(struct ramfs_dirent *dirent, rt_size_t pos,
+                                  const rt_uint8_t *buf, rt_size_t count)
+{
+    rt_size_t offset, length;
+    rt_uint8_t **page;
+
+    if (count == 0)
+        return 0;
+
+    if (ramfs_file_expand(dirent, RAMFS_PAGE_INDEX(pos + count + DFS_RAMFS_PAGE_SIZE - 1)) != 0)
+        return 0;
+
+    for (offset = 0; offset < count; offset += length)
+    {
+        length = DFS_RAMFS_PAGE_SIZE - RAMFS_PAGE_OFFSET(pos + offset);
+        if (length > count - offset)
+            length = count - offset;
+
+        page = &(dirent->pages[RAMFS_PAGE_INDEX(pos + offset)]);
+        if (*page == NULL)
+        {
+            /* zero in a hole */
+            if (buf == NULL)
+                continue;
+
+            *page = ramfs_page_alloc(dirent->fs);
+            if (*page == NULL)
+                break;
+        }
+
+        if (buf != NULL)
+            rt_memcpy(*page + RAMFS_PAGE_OFFSET(pos + offset), buf + offset, length);
+        else
+            rt_memset(*page + RAMFS_PAGE_OFFSET(pos + offset), 0, length);
+    }
+
+    if (pos + offset > dirent->size)
+        dirent->size = pos + offset;
+
+    return offset;
+}
+
+static rt_uint32_t ramfs_hash(struct ramfs_dirent *parent, const char *name, rt_size_t length)
+{
+    rt_uint32_t hash = (rt_uint32_t)(rt_ubase_t)parent;
+
+    while (length --)
+        hash = hash * 31 + (rt_uint8_t)*name++;
+
+    return hash % DFS_RAMFS_HASH_SIZE;
+}
+
+static struct ramfs_dirent *ramfs_find(struct dfs_ramfs *ramfs,
+                                       struct ramfs_dirent *parent,
+                                       const char *name, rt_size_t length)
+{
+    rt_list_t *node;
+    struct ramfs_dirent *dirent;
+
+    rt_list_for_each(node, &(ramfs->hash_table[ramfs_hash(parent, name, length)]))
+    {
+        dirent = rt_list_entry(node, struct ramfs_dirent, hash);
+        if (dirent->parent == parent && rt_strncmp(dirent->name, name, length) == 0 &&
+            dirent->name[length] == '\0')
+            return dirent;
+    }
+
+    return NULL;
+}
+
+/* add the entry to directory */
+static void ramfs_link(struct dfs_ramfs *ramfs, struct ramfs_dirent *parent,
+                       struct ramfs_dirent *dirent)
+{
+    dirent->parent = parent;
+    rt_list_insert_before(&(parent->entries), &(dirent->list));
+    rt_list_insert_after(&(ramfs->hash_table[ramfs_hash(parent, dirent->name, rt_strlen(dirent->name))]),
+                         &(dirent->hash));
+    parent->size ++;
+}
+
+/* remove the entry from directory */
+static void ramfs_unlink(struct ramfs_dirent *dirent)
+{
+    rt_list_remove(&(dirent->list));
+    rt_list_remove(&(dirent->hash));
+    dirent->parent->size --;
+    dirent->parent = NULL;
+}
+
+static void ramfs_dirent_free(struct ramfs_dirent *dirent)
+{
+    struct dfs_ramfs *ramfs = dirent->fs;
+
+    ramfs_file_truncate(dirent);
+    ramfs_free(ramfs, dirent->name);
+    ramfs_free(ramfs, dirent);
+}
+
+static struct ramfs_dirent *ramfs_dirent_create(struct dfs_ramfs *ramfs,
+                                                struct ramfs_dirent *parent,
+                                                const char *name, rt_size_t length,
+                                                rt_uint8_t type)
+{
+    struct ramfs_dirent *dirent;
+
+    dirent = (struct ramfs_dirent *)ramfs_alloc(ramfs, sizeof(struct ramfs_dirent));
+    if (dirent == NULL)
+        return NULL;
+    rt_memset(dirent, 0, sizeof(struct ramfs_dirent));
+
+    dirent->name = (char *)ramfs_alloc(ramfs, length + 1);
+    if (dirent->name == NULL)
+    {
+        ramfs_free(ramfs, dirent);
+
+        return NULL;
+    }
+    rt_memcpy(dirent->name, name, length);
+    dirent->name[length] = '\0';
+
+    dirent->fs = ramfs;
+    dirent->type = type;
+    rt_list_init(&(dirent->entries));
+    ramfs_link(ramfs, parent, dirent);
+
+    return dirent;
+}
+
+/*
+ * look up the parent directory of path, the last name of path is returned in
+ * name and length, the length is 0 for the root directory.
+ */
+static struct ramfs_dirent *ramfs_lookup_parent(struct dfs_ramfs *ramfs,
+                                                const char *path,
+                                                const char **name,
+                                                rt_size_t *length)
+{
+    const char *subpath, *subpath_end, *next;
+    struct ramfs_dirent *parent, *dirent;
+
+    parent = &(ramfs->root);
+
+    /* skip /// */
+    subpath = path;
+    while (*subpath == '/')
+        subpath ++;
+    subpath_end = subpath;
+    while (*subpath_end && *subpath_end != '/')
+        subpath_end ++;
+
+    while (1)
+    {
+        next = subpath_end;
+        while (*next == '/')
+            next ++;
+        /* it's the last name */
+        if (*next == '\0')
+            break;
+
+        dirent = ramfs_find(ramfs, parent, subpath, subpath_end - subpath);
+        if (dirent == NULL || dirent->type != RAMFS_DIRENT_DIR)
+            return NULL;
+        parent = dirent;
+
+        subpath = next;
+        subpath_end = next;
+        while (*subpath_end && *subpath_end != '/')
+            subpath_end ++;
+    }
+
+    *name = subpath;
+    *length = subpath_end - subpath;
+
+    return parent;
+}
+
 int dfs_ramfs_mount(struct dfs_filesystem *fs,
                     unsigned long          rwflag,
                     const void            *data)
@@ -61,9 +353,17 @@ int dfs_ramfs_statfs(struct dfs_filesystem *fs, struct statfs *buf)
     RT_ASSERT(ramfs != NULL);
     RT_ASSERT(buf != NULL);
 
-    buf->f_bsize  = 512;
-    buf->f_blocks = ramfs->memheap.pool_size/512;
-    buf->f_bfree  = ramfs->memheap.available_size/512;
+    buf->f_bsize  = DFS_RAMFS_PAGE_SIZE;
+    if (ramfs->heap)
+    {
+        buf->f_blocks = ramfs->size / DFS_RAMFS_PAGE_SIZE;
+        buf->f_bfree  = (ramfs->size - ramfs->used_size) / DFS_RAMFS_PAGE_SIZE;
+    }
+    else
+    {
+        buf->f_blocks = ramfs->memheap.pool_size / DFS_RAMFS_PAGE_SIZE;
+        buf->f_bfree  = ramfs->memheap.available_size / DFS_RAMFS_PAGE_SIZE;
+    }
 
     return RT_EOK;
 }
@@ -77,50 +377,57 @@ struct ramfs_dirent *dfs_ramfs_lookup(struct dfs_ramfs *ramfs,
                                       const char       *path,
                                       rt_size_t        *size)
 {
-    const char *subpath;
+    const char *name;
+    rt_size_t length;
     struct ramfs_dirent *dirent;
 
-    subpath = path;
-    while (*subpath == '/' && *subpath)
-        subpath ++;
-    if (! *subpath) /* is root directory */
-    {
-        *size = 0;
-
-        return &(ramfs->root);
-    }
+    dirent = ramfs_lookup_parent(ramfs, path, &name, &length);
+    if (dirent == NULL)
+        return NULL;
 
-    for (dirent = rt_list_entry(ramfs->root.list.next, struct ramfs_dirent, list);
-         dirent != &(ramfs->root);
-         dirent = rt_list_entry(dirent->list.next, struct ramfs_dirent, list))
+    /* not the root directory */
+    if (length != 0)
     {
-        if (rt_strcmp(dirent->name, subpath) == 0)
-        {
-            *size = dirent->size;
-
-            return dirent;
-        }
+        dirent = ramfs_find(ramfs, dirent, name, length);
+        if (dirent == NULL)
+            return NULL;
     }
 
-    /* not found */
-    return NULL;
+    *size = dirent->type == RAMFS_DIRENT_FILE ? dirent->size : 0;
+
+    return dirent;
 }
 
 int dfs_ramfs_read(struct dfs_fd *file, void *buf, size_t count)
 {
-    rt_size_t length;
+    rt_size_t length, offset, chunk, pos;
+    rt_uint8_t *page;
     struct ramfs_dirent *dirent;
 
     dirent = (struct ramfs_dirent *)file->data;
     RT_ASSERT(dirent != NULL);
 
-    if (count < file->size - file->pos)
+    if ((rt_size_t)file->pos >= dirent->size)
+        return 0;
+
+    if (count < dirent->size - file->pos)
         length = count;
     else
-        length = file->size - file->pos;
+        length = dirent->size - file->pos;
 
-    if (length > 0)
-        memcpy(buf, &(dirent->data[file->pos]), length);
+    for (offset = 0; offset < length; offset += chunk)
+    {
+        pos = file->pos + offset;
+        chunk = DFS_RAMFS_PAGE_SIZE - RAMFS_PAGE_OFFSET(pos);
+        if (chunk > length - offset)
+            chunk = length - offset;
+
+        page = dirent->pages[RAMFS_PAGE_INDEX(pos)];
+        if (page != NULL)
+            memcpy((rt_uint8_t *)buf + offset, page + RAMFS_PAGE_OFFSET(pos), chunk);
+        else
+            memset((rt_uint8_t *)buf + offset, 0, chunk);
+    }
 
     /* update file current position */
     file->pos += length;
@@ -130,44 +437,83 @@ int dfs_ramfs_read(struct dfs_fd *file, void *buf, size_t count)
 
 int dfs_ramfs_write(struct dfs_fd *fd, const void *buf, size_t count)
 {
+    rt_size_t length;
     struct ramfs_dirent *dirent;
-    struct dfs_ramfs *ramfs;
 
     dirent = (struct ramfs_dirent*)fd->data;
     RT_ASSERT(dirent != NULL);
 
-    ramfs = dirent->fs;
-    RT_ASSERT(ramfs != NULL);
+    length = ramfs_file_write(dirent, fd->pos, (const rt_uint8_t *)buf, count);
+    if (length == 0 && count > 0)
+    {
+        rt_set_errno(-ENOMEM);
+
+        return 0;
+    }
+
+    /* update file current position and size */
+    fd->pos += length;
+    fd->size = dirent->size;
+
+    return length;
+}
+
+int dfs_ramfs_copy_range(struct dfs_fd *fd_in, struct dfs_fd *fd_out, size_t count)
+{
+    rt_size_t length, offset, chunk, pos, result;
+    rt_uint8_t *page;
+    struct ramfs_dirent *dirent, *dirent_out;
+
+    dirent = (struct ramfs_dirent *)fd_in->data;
+    RT_ASSERT(dirent != NULL);
+    dirent_out = (struct ramfs_dirent *)fd_out->data;
+    RT_ASSERT(dirent_out != NULL);
+
+    /* the ranges in the same file may overlap */
+    if (dirent_out == dirent)
+        return -ENOSYS;
+
+    if ((rt_size_t)fd_in->pos >= dirent->size)
+        return 0;
+
+    if (count < dirent->size - fd_in->pos)
+        length = count;
+    else
+        length = dirent->size - fd_in->pos;
 
-    if (count + fd->pos > fd->size)
+    /* copy from the pages of file directly, the hole is kept */
+    for (offset = 0; offset < length; offset += chunk)
     {
-        rt_uint8_t *ptr;
-        ptr = rt_memheap_realloc(&(ramfs->memheap), dirent->data, fd->pos + count);
-        if (ptr == NULL)
+        pos = fd_in->pos + offset;
+        chunk = DFS_RAMFS_PAGE_SIZE - RAMFS_PAGE_OFFSET(pos);
+        if (chunk > length - offset)
+            chunk = length - offset;
+
+        page = dirent->pages[RAMFS_PAGE_INDEX(pos)];
+        result = ramfs_file_write(dirent_out, fd_out->pos + offset,
+                                  page != NULL ? page + RAMFS_PAGE_OFFSET(pos) : NULL, chunk);
+        if (result < chunk)
         {
-            rt_set_errno(-ENOMEM);
-
-            return 0;
+            offset += result;
+            break;
         }
-
-        /* update dirent and file size */
-        dirent->data = ptr;
-        dirent->size = fd->pos + count;
-        fd->size = dirent->size;
     }
 
-    if (count > 0)
-        memcpy(dirent->data + fd->pos, buf, count);
+    if (offset == 0)
+        return -ENOMEM;
 
     /* update file current position */
-    fd->pos += count;
+    fd_in->pos += offset;
+    fd_out->pos += offset;
+    fd_out->size = dirent_out->size;
 
-    return count;
+    return offset;
 }
 
 int dfs_ramfs_lseek(struct dfs_fd *file, off_t offset)
 {
-    if (offset <= (off_t)file->size)
+    /* seeking beyond the end makes a hole on writing */
+    if (offset >= 0)
     {
         file->pos = offset;
 
@@ -179,6 +525,16 @@ int dfs_ramfs_lseek(struct dfs_fd *file, off_t offset)
 
 int dfs_ramfs_close(struct dfs_fd *file)
 {
+    struct ramfs_dirent *dirent;
+
+    dirent = (struct ramfs_dirent *)file->data;
+    RT_ASSERT(dirent != NULL);
+
+    dirent->ref_count --;
+    /* the file is unlinked when it's opened */
+    if (dirent->unlinked && dirent->ref_count == 0)
+        ramfs_dirent_free(dirent);
+
     file->data = NULL;
 
     return RT_EOK;
@@ -186,9 +542,10 @@ int dfs_ramfs_close(struct dfs_fd *file)
 
 int dfs_ramfs_open(struct dfs_fd *file)
 {
-    rt_size_t size;
+    const char *name;
+    rt_size_t length;
     struct dfs_ramfs *ramfs;
-    struct ramfs_dirent *dirent;
+    struct ramfs_dirent *dirent, *parent;
     struct dfs_filesystem *fs;
 
     fs = (struct dfs_filesystem *)file->data;
@@ -196,61 +553,47 @@ int dfs_ramfs_open(struct dfs_fd *file)
     ramfs = (struct dfs_ramfs *)fs->data;
     RT_ASSERT(ramfs != NULL);
 
+    parent = ramfs_lookup_parent(ramfs, file->path, &name, &length);
+    if (parent == NULL)
+        return -ENOENT;
+
+    if (length == 0) /* it's root directory */
+        dirent = &(ramfs->root);
+    else
+        dirent = ramfs_find(ramfs, parent, name, length);
+
     if (file->flags & O_DIRECTORY)
     {
         if (file->flags & O_CREAT)
         {
-            return -ENOSPC;
+            if (dirent != NULL)
+                return -EEXIST;
+
+            /* create a directory entry */
+            dirent = ramfs_dirent_create(ramfs, parent, name, length, RAMFS_DIRENT_DIR);
+            if (dirent == NULL)
+                return -ENOMEM;
         }
 
         /* open directory */
-        dirent = dfs_ramfs_lookup(ramfs, file->path, &size);
         if (dirent == NULL)
             return -ENOENT;
-        if (dirent == &(ramfs->root)) /* it's root directory */
-        {
-            if (!(file->flags & O_DIRECTORY))
-            {
-                return -ENOENT;
-            }
-        }
+        if (dirent->type != RAMFS_DIRENT_DIR)
+            return -ENOTDIR;
     }
     else
     {
-        dirent = dfs_ramfs_lookup(ramfs, file->path, &size);
-        if (dirent == &(ramfs->root)) /* it's root directory */
-        {
-            return -ENOENT;
-        }
+        if (dirent != NULL && dirent->type == RAMFS_DIRENT_DIR)
+            return -EISDIR;
 
         if (dirent == NULL)
         {
             if (file->flags & O_CREAT || file->flags & O_WRONLY)
             {
-                char *name_ptr;
-
                 /* create a file entry */
-                dirent = (struct ramfs_dirent *)
-                         rt_memheap_alloc(&(ramfs->memheap),
-                                          sizeof(struct ramfs_dirent));
+                dirent = ramfs_dirent_create(ramfs, parent, name, length, RAMFS_DIRENT_FILE);
                 if (dirent == NULL)
-                {
                     return -ENOMEM;
-                }
-
-                /* remove '/' separator */
-                name_ptr = file->path;
-                while (*name_ptr == '/' && *name_ptr)
-                    name_ptr ++;
-                strncpy(dirent->name, name_ptr, RAMFS_NAME_MAX);
-
-                rt_list_init(&(dirent->list));
-                dirent->data = NULL;
-                dirent->size = 0;
-                dirent->fs = ramfs;
-
-                /* add to the root directory */
-                rt_list_insert_after(&(ramfs->root.list), &(dirent->list));
             }
             else
                 return -ENOENT;
@@ -260,18 +603,13 @@ int dfs_ramfs_open(struct dfs_fd *file)
          * If the file is existing, it is truncated and overwritten.
          */
         if (file->flags & O_TRUNC)
-        {
-            dirent->size = 0;
-            if (dirent->data != NULL)
-            {
-                rt_memheap_free(dirent->data);
-                dirent->data = NULL;
-            }
-        }
+            ramfs_file_truncate(dirent);
     }
 
+    dirent->ref_count ++;
+
     file->data = dirent;
-    file->size = dirent->size;
+    file->size = dirent->type == RAMFS_DIRENT_FILE ? dirent->size : 0;
     if (file->flags & O_APPEND)
         file->pos = file->size;
     else 
@@ -298,7 +636,13 @@ int dfs_ramfs_stat(struct dfs_filesystem *fs,
     st->st_mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH |
                   S_IWUSR | S_IWGRP | S_IWOTH;
 
-    st->st_size = dirent->size;
+    if (dirent->type == RAMFS_DIRENT_DIR)
+    {
+        st->st_mode &= ~S_IFREG;
+        st->st_mode |= S_IFDIR | S_IXUSR | S_IXGRP | S_IXOTH;
+    }
+
+    st->st_size = size;
     st->st_mtime = 0;
 
     return RT_EOK;
@@ -309,16 +653,14 @@ int dfs_ramfs_getdents(struct dfs_fd *file,
                        uint32_t    count)
 {
     rt_size_t index, end;
+    rt_list_t *node;
     struct dirent *d;
-    struct ramfs_dirent *dirent;
-    struct dfs_ramfs *ramfs;
+    struct ramfs_dirent *dirent, *sub_dirent;
 
     dirent = (struct ramfs_dirent *)file->data;
+    RT_ASSERT(dirent != RT_NULL);
 
-    ramfs  = dirent->fs;
-    RT_ASSERT(ramfs != RT_NULL);
-
-    if (dirent != &(ramfs->root))
+    if (dirent->type != RAMFS_DIRENT_DIR)
         return -EINVAL;
 
     /* make integer count */
@@ -329,17 +671,21 @@ int dfs_ramfs_getdents(struct dfs_fd *file,
     end = file->pos + count;
     index = 0;
     count = 0;
-    for (dirent = rt_list_entry(dirent->list.next, struct ramfs_dirent, list);
-         dirent != &(ramfs->root) && index < end;
-         dirent = rt_list_entry(dirent->list.next, struct ramfs_dirent, list))
+    for (node = dirent->entries.next; node != &(dirent->entries) && index < end;
+         node = node->next)
     {
         if (index >= (rt_size_t)file->pos)
         {
+            sub_dirent = rt_list_entry(node, struct ramfs_dirent, list);
+
             d = dirp + count;
-            d->d_type = DT_REG;
-            d->d_namlen = RT_NAME_MAX;
+            if (sub_dirent->type == RAMFS_DIRENT_DIR)
+                d->d_type = DT_DIR;
+            else
+                d->d_type = DT_REG;
+            d->d_namlen = rt_strlen(sub_dirent->name);
             d->d_reclen = (rt_uint16_t)sizeof(struct dirent);
-            rt_strncpy(d->d_name, dirent->name, RAMFS_NAME_MAX);
+            rt_strncpy(d->d_name, sub_dirent->name, sizeof(d->d_name));
 
             count += 1;
             file->pos += 1;
@@ -362,11 +708,17 @@ int dfs_ramfs_unlink(struct dfs_filesystem *fs, const char *path)
     dirent = dfs_ramfs_lookup(ramfs, path, &size);
     if (dirent == NULL)
         return -ENOENT;
-
-    rt_list_remove(&(dirent->list));
-    if (dirent->data != NULL)
-        rt_memheap_free(dirent->data);
-    rt_memheap_free(dirent);
+    if (dirent == &(ramfs->root))
+        return -EBUSY;
+    if (dirent->type == RAMFS_DIRENT_DIR && !rt_list_isempty(&(dirent->entries)))
+        return -ENOTEMPTY;
+
+    ramfs_unlink(dirent);
+    /* the opened file is freed on the last close */
+    if (dirent->ref_count > 0)
+        dirent->unlinked = 1;
+    else
+        ramfs_dirent_free(dirent);
 
     return RT_EOK;
 }
@@ -375,22 +727,44 @@ int dfs_ramfs_rename(struct dfs_filesystem *fs,
                      const char            *oldpath,
                      const char            *newpath)
 {
-    struct ramfs_dirent *dirent;
+    const char *name;
+    char *new_name;
+    rt_size_t length, size;
+    struct ramfs_dirent *dirent, *parent, *ancestor;
     struct dfs_ramfs *ramfs;
-    rt_size_t size;
 
     ramfs = (struct dfs_ramfs *)fs->data;
     RT_ASSERT(ramfs != NULL);
 
-    dirent = dfs_ramfs_lookup(ramfs, newpath, &size);
-    if (dirent != NULL)
+    parent = ramfs_lookup_parent(ramfs, newpath, &name, &length);
+    if (parent == NULL)
+        return -ENOENT;
+    if (length == 0 || ramfs_find(ramfs, parent, name, length) != NULL)
         return -EEXIST;
 
     dirent = dfs_ramfs_lookup(ramfs, oldpath, &size);
     if (dirent == NULL)
         return -ENOENT;
+    if (dirent == &(ramfs->root))
+        return -EBUSY;
+
+    /* a directory can't be moved into itself */
+    for (ancestor = parent; ancestor != NULL; ancestor = ancestor->parent)
+    {
+        if (ancestor == dirent)
+            return -EINVAL;
+    }
 
-    strncpy(dirent->name, newpath, RAMFS_NAME_MAX);
+    new_name = (char *)ramfs_alloc(ramfs, length + 1);
+    if (new_name == NULL)
+        return -ENOMEM;
+    rt_memcpy(new_name, name, length);
+    new_name[length] = '\0';
+
+    ramfs_unlink(dirent);
+    ramfs_free(ramfs, dirent->name);
+    dirent->name = new_name;
+    ramfs_link(ramfs, parent, dirent);
 
     return RT_EOK;
 }
@@ -405,12 +779,14 @@ static const struct dfs_file_ops _ram_fops =
     NULL, /* flush */
     dfs_ramfs_lseek,
     dfs_ramfs_getdents,
+    NULL, /* poll */
+    dfs_ramfs_copy_range,
 };
 
 static const struct dfs_filesystem_ops _ramfs =
 {
     "ram",
-    DFS_FS_FLAG_DEFAULT,
+    DFS_FS_FLAG_LOCKED,
     &_ram_fops,
 
     dfs_ramfs_mount,
@@ -432,36 +808,72 @@ int dfs_ramfs_init(void)
 }
 INIT_COMPONENT_EXPORT(dfs_ramfs_init);
 
+/**
+ * this function will create a ram file system object, which is mounted with
+ * it as the data.
+ *
+ * @param pool the memory pool of ramfs, or RT_NULL to allocate from the
+ *             system heap.
+ * @param size the size of pool, or the maximal size of file data if the
+ *             system heap is used.
+ *
+ * @return the ramfs object, RT_NULL on failed.
+ */
 struct dfs_ramfs* dfs_ramfs_create(rt_uint8_t *pool, rt_size_t size)
 {
     struct dfs_ramfs *ramfs;
     rt_uint8_t *data_ptr;
     rt_err_t result;
+    int index;
 
-    size  = RT_ALIGN_DOWN(size, RT_ALIGN_SIZE);
-    ramfs = (struct dfs_ramfs *)pool;
-
-    data_ptr = (rt_uint8_t *)(ramfs + 1);
-    size = size - sizeof(struct dfs_ramfs);
-    size = RT_ALIGN_DOWN(size, RT_ALIGN_SIZE);
-
-    result = rt_memheap_init(&ramfs->memheap, "ramfs", data_ptr, size);
-    if (result != RT_EOK)
+    if (pool == RT_NULL)
+    {
+#ifdef RT_USING_HEAP
+        ramfs = (struct dfs_ramfs *)rt_malloc(sizeof(struct dfs_ramfs));
+        if (ramfs == RT_NULL)
+            return NULL;
+        rt_memset(ramfs, 0, sizeof(struct dfs_ramfs));
+
+        ramfs->heap = RT_TRUE;
+        ramfs->size = size;
+#else
         return NULL;
-    /* detach this memheap object from the system */
-    rt_object_detach((rt_object_t)&(ramfs->memheap));
+#endif
+    }
+    else
+    {
+        size  = RT_ALIGN_DOWN(size, RT_ALIGN_SIZE);
+        ramfs = (struct dfs_ramfs *)pool;
+
+        data_ptr = (rt_uint8_t *)(ramfs + 1);
+        size = size - sizeof(struct dfs_ramfs);
+        size = RT_ALIGN_DOWN(size, RT_ALIGN_SIZE);
+
+        result = rt_memheap_init(&ramfs->memheap, "ramfs", data_ptr, size);
+        if (result != RT_EOK)
+            return NULL;
+        /* detach this memheap object from the system */
+        rt_object_detach((rt_object_t)&(ramfs->memheap));
+        ramfs->memheap.parent.type = RT_Object_Class_MemHeap | RT_Object_Class_Static;
+
+        ramfs->heap = RT_FALSE;
+        ramfs->size = size;
+    }
 
     /* initialize ramfs object */
     ramfs->magic = RAMFS_MAGIC;
-    ramfs->memheap.parent.type = RT_Object_Class_MemHeap | RT_Object_Class_Static;
+    ramfs->used_size = 0;
+    for (index = 0; index < DFS_RAMFS_HASH_SIZE; index ++)
+        rt_list_init(&(ramfs->hash_table[index]));
 
     /* initialize root directory */
     memset(&(ramfs->root), 0x00, sizeof(ramfs->root));
     rt_list_init(&(ramfs->root.list));
-    ramfs->root.size = 0;
-    strcpy(ramfs->root.name, ".");
+    rt_list_init(&(ramfs->root.hash));
+    rt_list_init(&(ramfs->root.entries));
+    ramfs->root.name = ".";
+    ramfs->root.type = RAMFS_DIRENT_DIR;
     ramfs->root.fs = ramfs;
 
     return ramfs;
 }
-
@@ -29,18 +29,37 @@
 #include <rtthread.h>
 #include <rtservice.h>
 
-#define RAMFS_NAME_MAX  32
 #define RAMFS_MAGIC     0x0A0A0A0A
 
+/* the file data is stored in pages of this size, a power of 2 */
+#ifndef DFS_RAMFS_PAGE_SIZE
+#define DFS_RAMFS_PAGE_SIZE     512
+#endif
+
+#ifndef DFS_RAMFS_HASH_SIZE
+#define DFS_RAMFS_HASH_SIZE     32
+#endif
+
+#define RAMFS_DIRENT_FILE   0x00
+#define RAMFS_DIRENT_DIR    0x01
+
 struct ramfs_dirent
 {
-    rt_list_t list;
+    rt_list_t list;             /* node in the entries of parent directory */
+    rt_list_t hash;             /* node in the hash table of file system */
     struct dfs_ramfs *fs;       /* file system ref */
+    struct ramfs_dirent *parent;
+
+    char *name;                 /* dirent name */
+    rt_uint8_t type;            /* file or directory */
+    rt_uint8_t unlinked;        /* removed, freed when it's closed */
+    rt_uint16_t ref_count;      /* opened times */
 
-    char name[RAMFS_NAME_MAX];  /* dirent name */
-    rt_uint8_t* data;
+    rt_list_t entries;          /* entries of directory */
 
-    rt_size_t size;             /* file size */
+    rt_uint8_t **pages;         /* page table of file data, NULL page is a hole */
+    rt_size_t page_count;       /* size of page table */
+    rt_size_t size;             /* file size, or number of entries of directory */
 };
 
 /**
@@ -50,8 +69,13 @@ struct dfs_ramfs
 {
     rt_uint32_t magic;
 
-    struct rt_memheap memheap;
+    struct rt_memheap memheap;  /* the pool of ramfs, unused with system heap */
+    rt_bool_t heap;             /* allocate from system heap */
+    rt_size_t size;             /* the maximal size of file data */
+    rt_size_t used_size;        /* the size of allocated pages */
+
     struct ramfs_dirent root;
+    rt_list_t hash_table[DFS_RAMFS_HASH_SIZE];
 };
 
 int dfs_ramfs_init(void);
@@ -46,25 +46,96 @@ int dfs_romfs_unmount(struct dfs_filesystem *fs)
     return RT_EOK;
 }
 
+rt_inline int check_dirent(struct romfs_dirent *dirent)
+{
+    if ((dirent->type != ROMFS_DIRENT_FILE && ROMFS_DIRENT_TYPE(dirent) != ROMFS_DIRENT_DIR)
+        || dirent->size == ~0)
+        return -1;
+    return 0;
+}
+
 int dfs_romfs_ioctl(struct dfs_fd *file, int cmd, void *args)
 {
+    struct romfs_dirent *dirent;
+
+    dirent = (struct romfs_dirent *)file->data;
+    RT_ASSERT(dirent != NULL);
+
+    switch (cmd)
+    {
+    case RT_FIOGETADDR:
+        /* the file data is in the image, it can be used without copying */
+        if (check_dirent(dirent) != 0 || dirent->type != ROMFS_DIRENT_FILE)
+            return -EINVAL;
+        *(const rt_uint8_t **)args = dirent->data;
+        return RT_EOK;
+    }
+
     return -EIO;
 }
 
-rt_inline int check_dirent(struct romfs_dirent *dirent)
+/* compare the name of entry with the subpath of length, as unsigned bytes */
+static int romfs_name_cmp(const char *name, const char *subpath, rt_size_t length)
 {
-    if ((dirent->type != ROMFS_DIRENT_FILE && dirent->type != ROMFS_DIRENT_DIR)
-        || dirent->size == ~0)
-        return -1;
-    return 0;
+    rt_size_t index;
+
+    for (index = 0; index < length; index ++)
+    {
+        if (name[index] != subpath[index])
+            return (rt_uint8_t)name[index] - (rt_uint8_t)subpath[index];
+        if (name[index] == '\0')
+            return -1;
+    }
+
+    return name[length] == '\0' ? 0 : 1;
+}
+
+static struct romfs_dirent *romfs_find_dirent(struct romfs_dirent *parent,
+        struct romfs_dirent *dirent, rt_size_t dirent_size,
+        const char *subpath, rt_size_t length)
+{
+    rt_size_t index, low, high;
+    int result;
+
+    if (parent->type & ROMFS_DIRENT_SORTED)
+    {
+        /* binary search in the sorted folder */
+        low = 0;
+        high = dirent_size;
+        while (low < high)
+        {
+            index = low + (high - low) / 2;
+            if (check_dirent(&dirent[index]) != 0)
+                return NULL;
+
+            result = romfs_name_cmp(dirent[index].name, subpath, length);
+            if (result == 0)
+                return &dirent[index];
+            if (result < 0)
+                low = index + 1;
+            else
+                high = index;
+        }
+
+        return NULL;
+    }
+
+    /* search in folder */
+    for (index = 0; index < dirent_size; index ++)
+    {
+        if (check_dirent(&dirent[index]) != 0)
+            return NULL;
+        if (romfs_name_cmp(dirent[index].name, subpath, length) == 0)
+            return &dirent[index];
+    }
+
+    return NULL;
 }
 
 struct romfs_dirent *dfs_romfs_lookup(struct romfs_dirent *root_dirent, const char *path, rt_size_t *size)
 {
-    rt_size_t index, found;
     const char *subpath, *subpath_end;
-    struct romfs_dirent *dirent;
-    rt_size_t dirent_size;
+    struct romfs_dirent *dirent, *parent;
 
     /* Check the root_dirent. */
     if (check_dirent(root_dirent) != 0)
@@ -76,9 +147,7 @@ struct romfs_dirent *dfs_romfs_lookup(struct romfs_dirent *root_dirent, const ch
         return root_dirent;
     }
 
-    /* goto root directy entries */
-    dirent = (struct romfs_dirent *)root_dirent->data;
-    dirent_size = root_dirent->size;
+    parent = root_dirent;
 
     /* get the end position of this subpath */
     subpath_end = path;
@@ -89,53 +158,32 @@ struct romfs_dirent *dfs_romfs_lookup(struct romfs_dirent *root_dirent, const ch
     while ((*subpath_end != '/') && *subpath_end)
         subpath_end ++;
 
-    while (dirent != NULL)
+    while (1)
     {
-        found = 0;
+        /* only the directory has entries */
+        if (ROMFS_DIRENT_TYPE(parent) != ROMFS_DIRENT_DIR)
+            break;
 
-        /* search in folder */
-        for (index = 0; index < dirent_size; index ++)
+        dirent = romfs_find_dirent(parent, (struct romfs_dirent *)parent->data, parent->size,
+                                   subpath, subpath_end - subpath);
+        if (dirent == NULL)
+            break; /* not found */
+
+        /* skip /// */
+        while (*subpath_end && *subpath_end == '/')
+            subpath_end ++;
+        subpath = subpath_end;
+        while ((*subpath_end != '/') && *subpath_end)
+            subpath_end ++;
+
+        if (!(*subpath))
         {
-            if (check_dirent(&dirent[index]) != 0)
-                return NULL;
-            if (rt_strlen(dirent[index].name) == (subpath_end - subpath) &&
-                    rt_strncmp(dirent[index].name, subpath, (subpath_end - subpath)) == 0)
-            {
-                dirent_size = dirent[index].size;
-
-                /* skip /// */
-                while (*subpath_end && *subpath_end == '/')
-                    subpath_end ++;
-                subpath = subpath_end;
-                while ((*subpath_end != '/') && *subpath_end)
-                    subpath_end ++;
-
-                if (!(*subpath))
-                {
-                    *size = dirent_size;
-                    return &dirent[index];
-                }
-
-                if (dirent[index].type == ROMFS_DIRENT_DIR)
-                {
-                    /* enter directory */
-                    dirent = (struct romfs_dirent*)dirent[index].data;
-                    found = 1;
-                    break;
-                }
-                else
-                {
-                    /* return file dirent */
-                    if (subpath != NULL)
-                        break; /* not the end of path */
-
-                    return &dirent[index];
-                }
-            }
+            *size = dirent->size;
+            return dirent;
         }
 
-        if (!found)
-            break; /* not found */
+        /* enter directory */
+        parent = dirent;
     }
 
     /* not found */
@@ -207,7 +255,7 @@ int dfs_romfs_open(struct dfs_fd *file)
         return -ENOENT;
 
     /* entry is a directory file type */
-    if (dirent->type == ROMFS_DIRENT_DIR)
+    if (ROMFS_DIRENT_TYPE(dirent) == ROMFS_DIRENT_DIR)
     {
         if (!(file->flags & O_DIRECTORY))
             return -ENOENT;
@@ -242,7 +290,7 @@ int dfs_romfs_stat(struct dfs_filesystem *fs, const char *path, struct stat *st)
     st->st_mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH |
     S_IWUSR | S_IWGRP | S_IWOTH;
 
-    if (dirent->type == ROMFS_DIRENT_DIR)
+    if (ROMFS_DIRENT_TYPE(dirent) == ROMFS_DIRENT_DIR)
     {
         st->st_mode &= ~S_IFREG;
         st->st_mode |= S_IFDIR | S_IXUSR | S_IXGRP | S_IXOTH;
@@ -264,7 +312,7 @@ int dfs_romfs_getdents(struct dfs_fd *file, struct dirent *dirp, uint32_t count)
     dirent = (struct romfs_dirent *)file->data;
     if (check_dirent(dirent) != 0)
         return -EIO;
-    RT_ASSERT(dirent->type == ROMFS_DIRENT_DIR);
+    RT_ASSERT(ROMFS_DIRENT_TYPE(dirent) == ROMFS_DIRENT_DIR);
 
     /* enter directory */
     dirent = (struct romfs_dirent *)dirent->data;
@@ -283,7 +331,7 @@ int dfs_romfs_getdents(struct dfs_fd *file, struct dirent *dirp, uint32_t count)
         name = sub_dirent->name;
 
         /* fill dirent */
-        if (sub_dirent->type == ROMFS_DIRENT_DIR)
+        if (ROMFS_DIRENT_TYPE(sub_dirent) == ROMFS_DIRENT_DIR)
             d->d_type = DT_DIR;
         else
             d->d_type = DT_REG;
@@ -28,6 +28,10 @@
 
 #define ROMFS_DIRENT_FILE	0x00
 #define ROMFS_DIRENT_DIR	0x01
+/* the entries of directory are sorted by name, looked up by binary search */
+#define ROMFS_DIRENT_SORTED	0x10
+
+#define ROMFS_DIRENT_TYPE(dirent)	((dirent)->type & ~ROMFS_DIRENT_SORTED)
 
 struct romfs_dirent
 {
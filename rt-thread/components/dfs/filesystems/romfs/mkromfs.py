@@ -93,10 +93,14 @@ class Folder(object):
                 self._children.append(File(ent))
 
     def sort(self):
+        # The folder is marked with ROMFS_DIRENT_SORTED and looked up by
+        # binary search, so sort the names as the bytes compared in C.
         def _sort(x, y):
-            if x.name == y.name:
+            x_name = x.name.encode('utf-8')
+            y_name = y.name.encode('utf-8')
+            if x_name == y_name:
                 return 0
-            elif x.name > y.name:
+            elif x_name > y_name:
                 return 1
             else:
                 return -1
@@ -129,7 +133,7 @@ class Folder(object):
             if isinstance(c, File):
                 tp = 'ROMFS_DIRENT_FILE'
             elif isinstance(c, Folder):
-                tp = 'ROMFS_DIRENT_DIR'
+                tp = 'ROMFS_DIRENT_DIR | ROMFS_DIRENT_SORTED'
             else:
                 assert False, 'Unkown instance:%s' % str(c)
             body_li.append(body_fmt.format(type=tp,
@@ -171,8 +175,8 @@ class Folder(object):
                 # ROMFS_DIRENT_FILE
                 tp = 0
             elif isinstance(c, Folder):
-                # ROMFS_DIRENT_DIR
-                tp = 1
+                # ROMFS_DIRENT_DIR | ROMFS_DIRENT_SORTED
+                tp = 0x11
             else:
                 assert False, 'Unkown instance:%s' % str(c)
 
@@ -207,7 +211,7 @@ def get_c_data(tree):
 {data}
 
 const struct romfs_dirent {name} = {{
-    ROMFS_DIRENT_DIR, "/", (rt_uint8_t *){rootdirent}, sizeof({rootdirent})/sizeof({rootdirent}[0])
+    ROMFS_DIRENT_DIR | ROMFS_DIRENT_SORTED, "/", (rt_uint8_t *){rootdirent}, sizeof({rootdirent})/sizeof({rootdirent}[0])
 }};
 '''
 
@@ -222,7 +226,7 @@ def get_bin_data(tree, base_addr):
     v_len += len(name)
     data_addr = v_len
     # root entry
-    data = Folder.bin_fmt.pack(*Folder.bin_item(type=1,
+    data = Folder.bin_fmt.pack(*Folder.bin_item(type=0x11,
                                                 name=name_addr,
                                                 data=data_addr,
                                                 size=tree.entry_size))
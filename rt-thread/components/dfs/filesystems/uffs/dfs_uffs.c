@@ -109,6 +109,20 @@ static int uffs_result_to_dfs(int result)
     return status;
 }
 
+/* the operations on the opened files and dirs set the error of their device */
+static int uffs_file_error(struct dfs_fd *file)
+{
+    int index;
+
+    for (index = 0; index < UFFS_DEVICE_MAX; index++)
+    {
+        if (nand_part[index].dev == RT_MTD_NAND_DEVICE(file->fs->dev_id))
+            return uffs_get_dev_error(&nand_part[index].uffs_dev);
+    }
+
+    return uffs_get_error();
+}
+
 static URET _device_init(uffs_Device *dev)
 {
     dev->attr->_private = NULL; // hook nand_chip data structure to attr->_private
@@ -125,6 +139,7 @@ static URET _device_release(uffs_Device *dev)
 static int init_uffs_fs(
     struct _nand_dev * nand_part)
 {
+    int result;
     uffs_MountTable * mtb;
     struct rt_mtd_nand_device * nand;
     struct uffs_StorageAttrSt * flash_storage;
@@ -136,6 +151,9 @@ static int init_uffs_fs(
     /* setup nand storage attributes */
     uffs_setup_storage(flash_storage, nand);
 
+    /* the mount table is shared by all devices */
+    uffs_GlobalFsLockLock();
+
     /* register mount table */
     if(mtb->dev)
     {
@@ -151,9 +169,17 @@ static int init_uffs_fs(
         uffs_RegisterMountTable(mtb);
     }
     /* mount uffs partion on nand device */
-    return uffs_Mount(nand_part->mount_path) == U_SUCC ? 0 : -1;
+    result = uffs_Mount(nand_part->mount_path) == U_SUCC ? 0 : -1;
+    uffs_GlobalFsLockUnlock();
+
+    return result;
 }
 
+/*
+ * data: RT_NULL, or a uffs_Config of the partition, such as the number of
+ * page buffers and block info caches, and the flush mode. The zero fields
+ * take the default values in uffs_config.h.
+ */
 static int dfs_uffs_mount(
     struct dfs_filesystem* fs,
     unsigned long rwflag,
@@ -187,6 +213,8 @@ static int dfs_uffs_mount(
     mount_part->mount   = nand_part[index].mount_path;
     mount_part->dev = &(nand_part[index].uffs_dev);
     rt_memset(mount_part->dev, 0, sizeof(uffs_Device));//in order to make uffs happy.
+    if (data != RT_NULL)
+        mount_part->dev->cfg = *(const uffs_Config *)data;
     mount_part->dev->_private = dev;   /* save dev_id into uffs */
     mount_part->start_block = dev->block_start;
     mount_part->end_block = dev->block_end;
@@ -209,12 +237,15 @@ static int dfs_uffs_unmount(struct dfs_filesystem* fs)
         if (nand_part[index].dev == RT_MTD_NAND_DEVICE(fs->dev_id))
         {
             nand_part[index].dev = RT_NULL;
+            uffs_GlobalFsLockLock();
             result = uffs_UnMount(nand_part[index].mount_path);
+            if (result == U_SUCC)
+                result = uffs_UnRegisterMountTable(& nand_part[index].mount_table);
+            uffs_GlobalFsLockUnlock();
+
             if (result != U_SUCC)
                 break;
-
-            result = uffs_UnRegisterMountTable(& nand_part[index].mount_table);
-            return (result == U_SUCC) ? RT_EOK : -1;
+            return RT_EOK;
         }
     }
     return -ENOENT;
@@ -240,7 +271,9 @@ static int dfs_uffs_mkfs(rt_device_t dev_id)
     }
 
     /*2. then unmount the partition */
+    uffs_GlobalFsLockLock();
     uffs_Mount(nand_part[index].mount_path);
+    uffs_GlobalFsLockUnlock();
     mtd = nand_part[index].dev;
 
     /*3. erase all blocks on the partition */
@@ -282,7 +315,9 @@ static int dfs_uffs_statfs(struct dfs_filesystem* fs,
     
     buf->f_bsize = mtd->page_size*mtd->pages_per_block;
     buf->f_blocks = (mtd->block_end - mtd->block_start + 1);
+    uffs_DeviceLock(&nand_part[index].uffs_dev);
     buf->f_bfree = uffs_GetDeviceFree(&nand_part[index].uffs_dev)/buf->f_bsize ;
+    uffs_DeviceUnLock(&nand_part[index].uffs_dev);
     
     return 0;
 }
@@ -373,7 +408,7 @@ static int dfs_uffs_close(struct dfs_fd* file)
     {
         /* operations about dir */
         if (uffs_closedir((uffs_DIR *)(file->data)) < 0)
-            return uffs_result_to_dfs(uffs_get_error());
+            return uffs_result_to_dfs(uffs_file_error(file));
 
         return 0;
     }
@@ -383,7 +418,7 @@ static int dfs_uffs_close(struct dfs_fd* file)
     if (uffs_close(fd) == 0)
         return 0;
 
-    return uffs_result_to_dfs(uffs_get_error());
+    return uffs_result_to_dfs(uffs_file_error(file));
 }
 
 static int dfs_uffs_ioctl(struct dfs_fd * file, int cmd, void* args)
@@ -399,7 +434,7 @@ static int dfs_uffs_read(struct dfs_fd * file, void* buf, size_t len)
     fd = (int)(file->data);
     char_read = uffs_read(fd, buf, len);
     if (char_read < 0)
-        return uffs_result_to_dfs(uffs_get_error());
+        return uffs_result_to_dfs(uffs_file_error(file));
 
     /* update position */
     file->pos = uffs_seek(fd, 0, USEEK_CUR);
@@ -417,7 +452,7 @@ static int dfs_uffs_write(struct dfs_fd* file,
 
     char_write = uffs_write(fd, buf, len);
     if (char_write < 0)
-        return uffs_result_to_dfs(uffs_get_error());
+        return uffs_result_to_dfs(uffs_file_error(file));
 
     /* update position */
     file->pos = uffs_seek(fd, 0, USEEK_CUR);
@@ -433,7 +468,7 @@ static int dfs_uffs_flush(struct dfs_fd* file)
 
     result = uffs_flush(fd);
     if (result < 0 )
-        return uffs_result_to_dfs(uffs_get_error());
+        return uffs_result_to_dfs(uffs_file_error(file));
     return 0;
 }
 
@@ -474,7 +509,7 @@ static int dfs_uffs_seek(struct dfs_fd* file,
             return offset;
     }
 
-    return uffs_result_to_dfs(uffs_get_error());
+    return uffs_result_to_dfs(uffs_file_error(file));
 }
 
 /* return the size of struct dirent*/
@@ -513,7 +548,7 @@ static int dfs_uffs_getdents(
         if (uffs_d == RT_NULL)
         {
             rt_free(file_path);
-            return (uffs_result_to_dfs(uffs_get_error()));
+            return (uffs_result_to_dfs(uffs_file_error(file)));
         }
 
         if (file->path[0] == '/' && !(file->path[1] == 0))
@@ -552,7 +587,7 @@ static int dfs_uffs_getdents(
     rt_free(file_path);
     
     if (index == 0)
-        return uffs_result_to_dfs(uffs_get_error());
+        return uffs_result_to_dfs(uffs_file_error(file));
 
     file->pos += index * sizeof(struct dirent);
 
@@ -38,6 +38,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
 #include "uffs_config.h"
 #include "uffs/uffs_public.h"
 #include "uffs/uffs_fd.h"
@@ -1041,6 +1042,97 @@ static int cmd_tread(int argc, char *argv[])
 	return ret;
 }
 
+/**
+ * write <size> KB to <file> in <n> bytes per call, then read it back,
+ * print the throughput and the flash pages written/read.
+ *	t_perf <file> [<size> [<n>]]
+ */
+static int cmd_tperf(int argc, char *argv[])
+{
+	const char *name;
+	int fd, size = 256, n = 512;
+	int i, len, ret = 0;
+	uffs_Device *dev;
+	uffs_FlashStat st;
+	clock_t start, ticks;
+	u8 buf[MAX_TEST_BUF_LEN];
+
+	CHK_ARGC(2, 4);
+	name = argv[1];
+	if (argc > 2 && sscanf(argv[2], "%d", &size) != 1)
+		return CLI_INVALID_ARG;
+	if (argc > 3 && sscanf(argv[3], "%d", &n) != 1)
+		return CLI_INVALID_ARG;
+	if (size <= 0 || n <= 0 || n > sizeof(buf))
+		return CLI_INVALID_ARG;
+
+	dev = uffs_FindDeviceFromPath(name);
+	if (dev == NULL) {
+		MSGLN("Can't find the device of %s", name);
+		return -1;
+	}
+	MSGLN("page buffers: %d, block info caches: %d, flush mode: %s",
+		dev->cfg.page_buffers, dev->cfg.bc_caches,
+		dev->cfg.flush_mode == UFFS_FLUSH_WRITE_BACK ? "write back" : "after write");
+
+	fd = uffs_open(name, UO_RDWR | UO_CREATE | UO_TRUNC);
+	if (fd < 0) {
+		MSGLN("Can't create file %s", name);
+		return -1;
+	}
+
+	st = dev->st;
+	start = clock();
+	for (i = 0; i < size * 1024; i += len) {
+		len = (size * 1024 - i < n ? size * 1024 - i : n);
+		memcp_seq(buf, len, i);
+		if (uffs_write(fd, buf, len) != len) {
+			MSGLN("Write fail at %d", i);
+			ret = -1;
+			break;
+		}
+	}
+	if (ret == 0 && uffs_close(fd) < 0)
+		ret = -1;
+	ticks = clock() - start;
+	if (ret < 0)
+		goto ext;
+
+	MSGLN("write: %d KB in %ld ms, %ld KB/s, %d pages written",
+		size, (long)(ticks * 1000 / CLOCKS_PER_SEC),
+		ticks ? (long)(size * CLOCKS_PER_SEC / ticks) : 0L,
+		dev->st.page_write_count - st.page_write_count);
+
+	fd = uffs_open(name, UO_RDONLY);
+	if (fd < 0) {
+		MSGLN("Can't open file %s", name);
+		return -1;
+	}
+
+	st = dev->st;
+	start = clock();
+	for (i = 0; i < size * 1024; i += len) {
+		len = (size * 1024 - i < n ? size * 1024 - i : n);
+		if (uffs_read(fd, buf, len) != len) {
+			MSGLN("Read fail at %d", i);
+			ret = -1;
+			break;
+		}
+	}
+	ticks = clock() - start;
+	if (ret == 0)
+		MSGLN("read: %d KB in %ld ms, %ld KB/s, %d pages read",
+			size, (long)(ticks * 1000 / CLOCKS_PER_SEC),
+			ticks ? (long)(size * CLOCKS_PER_SEC / ticks) : 0L,
+			dev->st.page_read_count - st.page_read_count);
+
+ext:
+	uffs_close(fd);
+	uffs_remove(name);
+
+	return ret;
+}
+
 
 static void do_dump_page(uffs_Device *dev, uffs_Buf *buf)
 {
@@ -1166,6 +1258,7 @@ static const struct cli_command test_cmds[] =
 	{ cmd_twrite_seq,			"t_write_seq",	"<fd> <size>",	"write seq file <fd>", },
 	{ cmd_tseek,				"t_seek",		"<fd> <offset> [<origin>]",	"seek <fd> file pointer to <offset> from <origin>", },
 	{ cmd_tclose,				"t_close",		"<fd>",				"close <fd>", },
+	{ cmd_tperf,				"t_perf",		"<file> [<size> [<n>]]",	"write/read <size> KB to <file> in <n> bytes, print throughput", },
 	{ cmd_dump,					"dump",			"<mount>",			"dump <mount>", },
 
 	{ cmd_apisrv,				"apisrv",		NULL,				"start API test server", },
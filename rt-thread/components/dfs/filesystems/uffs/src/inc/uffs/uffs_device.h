@@ -159,8 +159,14 @@ typedef struct uffs_ConfigSt {
 	int dirty_pages;
 	int dirty_groups;
 	int reserved_free_blocks;
+	int flush_mode;				//!< UFFS_FLUSH_AFTER_WRITE or UFFS_FLUSH_WRITE_BACK
 } uffs_Config;
 
+/** flush the page buffers of file in each 'write' call */
+#define UFFS_FLUSH_AFTER_WRITE	1
+/** keep the dirty page buffers until flush, close, or the buffers are full */
+#define UFFS_FLUSH_WRITE_BACK	2
+
 
 /** 
  * \struct uffs_DeviceSt
@@ -186,6 +192,7 @@ struct uffs_DeviceSt {
 	struct uffs_ConfigSt			cfg;		//!< uffs config
 	u32	ref_count;								//!< device reference count
 	int	dev_num;								//!< device number (partition number)	
+	int	err;									//!< errno of the operations on opened objects
 };
 
 
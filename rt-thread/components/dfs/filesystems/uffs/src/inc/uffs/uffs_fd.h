@@ -132,6 +132,8 @@ void uffs_rewinddir(uffs_DIR *dirp);
 
 int uffs_get_error(void);
 int uffs_set_error(int err);
+int uffs_get_dev_error(uffs_Device *dev);
+int uffs_set_dev_error(uffs_Device *dev, int err);
 
 int uffs_version(void);
 int uffs_format(const char *mount_point);
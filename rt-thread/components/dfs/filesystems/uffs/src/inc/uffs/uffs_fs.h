@@ -53,6 +53,7 @@ struct uffs_ObjectSt {
 	/******* objects manager ********/
 	int dev_lock_count;
 	int dev_get_count;
+	int fd_ref_count;					//!< fd operations in progress
 
 	/******** init level 0 ********/
 	const char * name;					//!< pointer to the start of name, for open or create
@@ -84,6 +84,9 @@ uffs_Device * uffs_GetDeviceFromMountPoint(const char *mount);
 /** get uffs device from mount point */
 uffs_Device * uffs_GetDeviceFromMountPointEx(const char *mount, int len);	
 
+/** find uffs device from absolute path, without increasing references */
+uffs_Device * uffs_FindDeviceFromPath(const char *path);
+
 /** get mount point name from uffs device */
 const char * uffs_GetDeviceMountPoint(uffs_Device *dev);		
 
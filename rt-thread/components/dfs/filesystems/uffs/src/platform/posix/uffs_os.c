@@ -92,8 +92,7 @@ int uffs_SemDelete(OSSEM *sem)
 
 int uffs_OSGetTaskId(void)
 {
-	//TODO: ... return current task ID ...
-	return 0;
+	return (int)(unsigned long)pthread_self();
 }
 
 unsigned int uffs_GetCurDateTime(void)
@@ -93,7 +93,7 @@ int uffs_SemDelete(OSSEM *sem)
 
 int uffs_OSGetTaskId(void)
 {
-	return 0;
+	return (int)GetCurrentThreadId();
 }
 
 unsigned int uffs_GetCurDateTime(void)
@@ -58,8 +58,19 @@ void uffs_DeviceReleaseLock(uffs_Device *dev)
 	uffs_SemDelete(&dev->lock.sem);
 }
 
+/*
+ * The device lock is recursive: the file handle APIs lock the device of
+ * the object, then the object APIs lock the same device again.
+ */
 void uffs_DeviceLock(uffs_Device *dev)
 {
+	int task_id = uffs_OSGetTaskId();
+
+	if (dev->lock.counter > 0 && dev->lock.task_id == task_id) {
+		dev->lock.counter++;
+		return;
+	}
+
 	uffs_SemWait(dev->lock.sem);
 	
 	if (dev->lock.counter != 0) {
@@ -67,18 +78,22 @@ void uffs_DeviceLock(uffs_Device *dev)
 					"Lock device, counter %d NOT zero?!", dev->lock.counter);
 	}
 
-	dev->lock.counter++;
+	dev->lock.task_id = task_id;
+	dev->lock.counter = 1;
 }
 
 void uffs_DeviceUnLock(uffs_Device *dev)
 {
-	dev->lock.counter--;
-
-	if (dev->lock.counter != 0) {
+	if (dev->lock.counter <= 0) {
 		uffs_Perror(UFFS_MSG_NORMAL,
-					"Unlock device, counter %d NOT zero?!", dev->lock.counter);
+					"Unlock device, counter %d NOT positive?!", dev->lock.counter);
+		return;
 	}
-	
+
+	if (--dev->lock.counter > 0)
+		return;
+
+	dev->lock.task_id = UFFS_TASK_ID_NOT_EXIST;
 	uffs_SemSignal(dev->lock.sem);
 }
 
@@ -70,11 +70,40 @@ struct uffs_dirSt {
 		+ FD_OFFSET \
 	)
 
+#ifdef CONFIG_USE_PER_DEVICE_LOCK
+/**
+ * The global lock protects the handles and the name space operations, the
+ * operations on an opened object only hold the lock of its device, so the
+ * objects on different devices are accessed in parallel. The object is
+ * referenced before the global lock is released, and put by its last user
+ * after it's closed.
+ * Lock order: global lock -> device lock.
+ */
+#define DEV_LOCK(dev)		do { if (dev) uffs_DeviceLock(dev); } while (0)
+#define DEV_UNLOCK(dev)		do { if (dev) uffs_DeviceUnLock(dev); } while (0)
+#define OBJ_LOCK_DEV(obj, dev)	\
+	do { (obj)->fd_ref_count++; uffs_GlobalFsLockUnlock(); DEV_LOCK(dev); } while (0)
+#define OBJ_UNLOCK_DEV(obj, dev)	\
+	do { DEV_UNLOCK(dev); uffs_GlobalFsLockLock(); ObjUnRef(obj); uffs_GlobalFsLockUnlock(); } while (0)
+#define DIR_UNLOCK_DEV(dirp, dev)	\
+	do { DEV_UNLOCK(dev); uffs_GlobalFsLockLock(); DirUnRef(dirp); uffs_GlobalFsLockUnlock(); } while (0)
+#else
+/* the global lock is held by all operations */
+#define DEV_LOCK(dev)		do { (void)(dev); } while (0)
+#define DEV_UNLOCK(dev)		do { (void)(dev); } while (0)
+#define OBJ_LOCK_DEV(obj, dev)	do { (void)(dev); (obj)->fd_ref_count++; } while (0)
+#define OBJ_UNLOCK_DEV(obj, dev)	\
+	do { (void)(dev); ObjUnRef(obj); uffs_GlobalFsLockUnlock(); } while (0)
+#define DIR_UNLOCK_DEV(dirp, dev)	\
+	do { (void)(dev); DirUnRef(dirp); uffs_GlobalFsLockUnlock(); } while (0)
+#endif
+
 /**
  * check #fd signature, convert #fd to #obj
- * if success, hold global file system lock, otherwise return with #ret
+ * if success, reference #obj and hold the lock of its device (saved to #dev),
+ * otherwise return with #ret
  */
-#define CHK_OBJ_LOCK(fd, obj, ret)	\
+#define CHK_OBJ_LOCK(fd, obj, dev, ret)	\
 	do { \
 		uffs_GlobalFsLockLock(); \
 		fd -= FD_OFFSET; \
@@ -89,48 +118,59 @@ struct uffs_dirSt {
 		obj = (uffs_Object *)uffs_PoolGetBufByIndex(uffs_GetObjectPool(), fd); \
 		if ((obj) == NULL || \
 				uffs_PoolVerify(uffs_GetObjectPool(), (obj)) == U_FALSE || \
-				uffs_PoolCheckFreeList(uffs_GetObjectPool(), (obj)) == U_TRUE) { \
+				uffs_PoolCheckFreeList(uffs_GetObjectPool(), (obj)) == U_TRUE || \
+				(obj)->open_succ != U_TRUE) { \
 			uffs_set_error(-UEBADF); \
 			uffs_Perror(UFFS_MSG_NOISY, "invalid obj"); \
 			uffs_GlobalFsLockUnlock(); \
 			return (ret); \
 		} \
+		dev = (obj)->dev; \
+		OBJ_LOCK_DEV(obj, dev); \
 	} while(0)
 
 /**
  * check #dirp signature,
- * if success, hold global file system lock,
+ * if success, reference dir object and hold the lock of its device (saved to #dev),
  * otherwise return with #ret
  */
-#define CHK_DIR_LOCK(dirp, ret)	\
+#define CHK_DIR_LOCK(dirp, dev, ret)	\
 	do { \
 		uffs_GlobalFsLockLock(); \
 		if ((dirp) == NULL || \
 				uffs_PoolVerify(&_dir_pool, (dirp)) == U_FALSE || \
-				uffs_PoolCheckFreeList(&_dir_pool, (dirp)) == U_TRUE) { \
+				uffs_PoolCheckFreeList(&_dir_pool, (dirp)) == U_TRUE || \
+				(dirp)->obj == NULL || \
+				(dirp)->obj->open_succ != U_TRUE) { \
 			uffs_set_error(-UEBADF); \
 			uffs_Perror(UFFS_MSG_NOISY, "invalid dirp"); \
 			uffs_GlobalFsLockUnlock(); \
 			return (ret); \
 		} \
+		dev = (dirp)->obj->dev; \
+		OBJ_LOCK_DEV((dirp)->obj, dev); \
 	} while(0)
 
 /**
  * check #dirp signature,
- * if success, hold global file system lock,
+ * if success, reference dir object and hold the lock of its device (saved to #dev),
  * otherwise return void
  */
-#define CHK_DIR_VOID_LOCK(dirp)	\
+#define CHK_DIR_VOID_LOCK(dirp, dev)	\
 	do { \
 		uffs_GlobalFsLockLock(); \
 		if ((dirp) == NULL || \
 				uffs_PoolVerify(&_dir_pool, (dirp)) == U_FALSE || \
-				uffs_PoolCheckFreeList(&_dir_pool, (dirp)) == U_TRUE) { \
+				uffs_PoolCheckFreeList(&_dir_pool, (dirp)) == U_TRUE || \
+				(dirp)->obj == NULL || \
+				(dirp)->obj->open_succ != U_TRUE) { \
 			uffs_set_error(-UEBADF); \
 			uffs_Perror(UFFS_MSG_NOISY, "invalid dirp"); \
 			uffs_GlobalFsLockUnlock(); \
 			return; \
 		} \
+		dev = (dirp)->obj->dev; \
+		OBJ_LOCK_DEV((dirp)->obj, dev); \
 	} while(0)
 
 
@@ -216,6 +256,28 @@ static void PutDirEntry(uffs_DIR *p)
 	uffs_PoolPut(&_dir_pool, p);
 }
 
+/**
+ * drop the reference of #obj, put it if it's closed and not used,
+ * the global lock is held
+ */
+static void ObjUnRef(uffs_Object *obj)
+{
+	if (--obj->fd_ref_count == 0 && obj->open_succ != U_TRUE)
+		uffs_PutObject(obj);
+}
+
+/**
+ * drop the reference of #dirp object, put them if it's closed and not used,
+ * the global lock is held
+ */
+static void DirUnRef(uffs_DIR *dirp)
+{
+	if (--dirp->obj->fd_ref_count == 0 && dirp->obj->open_succ != U_TRUE) {
+		uffs_PutObject(dirp->obj);
+		PutDirEntry(dirp);
+	}
+}
+
 
 /** get global errno
  */
@@ -231,11 +293,29 @@ int uffs_set_error(int err)
 	return (_uffs_errno = err);
 }
 
+/** get errno of the operations on the opened files and dirs of #dev
+ */
+int uffs_get_dev_error(uffs_Device *dev)
+{
+	return dev ? dev->err : _uffs_errno;
+}
+
+/** set errno of #dev, the lock of #dev is held
+ */
+int uffs_set_dev_error(uffs_Device *dev, int err)
+{
+	if (dev == NULL)
+		return uffs_set_error(err);
+
+	return (dev->err = err);
+}
+
 /* POSIX compliant file system APIs */
 
 int uffs_open(const char *name, int oflag, ...)
 {
 	uffs_Object *obj;
+	uffs_Device *dev;
 	int ret = 0;
 
 	uffs_GlobalFsLockLock();
@@ -246,6 +326,8 @@ int uffs_open(const char *name, int oflag, ...)
 		ret = -1;
 	}
 	else {
+		dev = uffs_FindDeviceFromPath(name);
+		DEV_LOCK(dev);
 		if (uffs_OpenObject(obj, name, oflag) == U_FAIL) {
 			uffs_set_error(-uffs_GetObjectErr(obj));
 			uffs_PutObject(obj);
@@ -254,6 +336,7 @@ int uffs_open(const char *name, int oflag, ...)
 		else {
 			ret = OBJ2FD(obj);
 		}
+		DEV_UNLOCK(dev);
 	}
 
 	uffs_GlobalFsLockUnlock();
@@ -265,20 +348,21 @@ int uffs_close(int fd)
 {
 	int ret = 0;
 	uffs_Object *obj;
+	uffs_Device *dev;
 
-	CHK_OBJ_LOCK(fd, obj, -1);
+	CHK_OBJ_LOCK(fd, obj, dev, -1);
 
 	uffs_ClearObjectErr(obj);
 	if (uffs_CloseObject(obj) == U_FAIL) {
-		uffs_set_error(-uffs_GetObjectErr(obj));
+		uffs_set_dev_error(dev, -uffs_GetObjectErr(obj));
 		ret = -1;
 	}
 	else {
-		uffs_PutObject(obj);
 		ret = 0;
 	}
 
-	uffs_GlobalFsLockUnlock();
+	/* the closed object is put by its last user */
+	OBJ_UNLOCK_DEV(obj, dev);
 
 	return ret;
 }
@@ -287,13 +371,14 @@ int uffs_read(int fd, void *data, int len)
 {
 	int ret;
 	uffs_Object *obj;
+	uffs_Device *dev;
 
-	CHK_OBJ_LOCK(fd, obj, -1);
+	CHK_OBJ_LOCK(fd, obj, dev, -1);
 	uffs_ClearObjectErr(obj);
 	ret = uffs_ReadObject(obj, data, len);
-	uffs_set_error(-uffs_GetObjectErr(obj));
+	uffs_set_dev_error(dev, -uffs_GetObjectErr(obj));
 
-	uffs_GlobalFsLockUnlock();
+	OBJ_UNLOCK_DEV(obj, dev);
 
 	return ret;
 }
@@ -302,13 +387,14 @@ int uffs_write(int fd, const void *data, int len)
 {
 	int ret;
 	uffs_Object *obj;
+	uffs_Device *dev;
 
-	CHK_OBJ_LOCK(fd, obj, -1);
+	CHK_OBJ_LOCK(fd, obj, dev, -1);
 	uffs_ClearObjectErr(obj);
 	ret = uffs_WriteObject(obj, data, len);
-	uffs_set_error(-uffs_GetObjectErr(obj));
+	uffs_set_dev_error(dev, -uffs_GetObjectErr(obj));
 
-	uffs_GlobalFsLockUnlock();
+	OBJ_UNLOCK_DEV(obj, dev);
 
 	return ret;
 }
@@ -317,13 +403,14 @@ long uffs_seek(int fd, long offset, int origin)
 {
 	int ret;
 	uffs_Object *obj;
+	uffs_Device *dev;
 
-	CHK_OBJ_LOCK(fd, obj, -1);
+	CHK_OBJ_LOCK(fd, obj, dev, -1);
 	uffs_ClearObjectErr(obj);
 	ret = uffs_SeekObject(obj, offset, origin);
-	uffs_set_error(-uffs_GetObjectErr(obj));
+	uffs_set_dev_error(dev, -uffs_GetObjectErr(obj));
 	
-	uffs_GlobalFsLockUnlock();
+	OBJ_UNLOCK_DEV(obj, dev);
 
 	return ret;
 }
@@ -332,13 +419,14 @@ long uffs_tell(int fd)
 {
 	long ret;
 	uffs_Object *obj;
+	uffs_Device *dev;
 
-	CHK_OBJ_LOCK(fd, obj, -1);
+	CHK_OBJ_LOCK(fd, obj, dev, -1);
 	uffs_ClearObjectErr(obj);
 	ret = (long) uffs_GetCurOffset(obj);
-	uffs_set_error(-uffs_GetObjectErr(obj));
+	uffs_set_dev_error(dev, -uffs_GetObjectErr(obj));
 	
-	uffs_GlobalFsLockUnlock();
+	OBJ_UNLOCK_DEV(obj, dev);
 
 	return ret;
 }
@@ -347,13 +435,14 @@ int uffs_eof(int fd)
 {
 	int ret;
 	uffs_Object *obj;
+	uffs_Device *dev;
 
-	CHK_OBJ_LOCK(fd, obj, -1);
+	CHK_OBJ_LOCK(fd, obj, dev, -1);
 	uffs_ClearObjectErr(obj);
 	ret = uffs_EndOfFile(obj);
-	uffs_set_error(-uffs_GetObjectErr(obj));
+	uffs_set_dev_error(dev, -uffs_GetObjectErr(obj));
 	
-	uffs_GlobalFsLockUnlock();
+	OBJ_UNLOCK_DEV(obj, dev);
 
 	return ret;
 }
@@ -362,13 +451,14 @@ int uffs_flush(int fd)
 {
 	int ret;
 	uffs_Object *obj;
+	uffs_Device *dev;
 
-	CHK_OBJ_LOCK(fd, obj, -1);
+	CHK_OBJ_LOCK(fd, obj, dev, -1);
 	uffs_ClearObjectErr(obj);
 	ret = (uffs_FlushObject(obj) == U_SUCC) ? 0 : -1;
-	uffs_set_error(-uffs_GetObjectErr(obj));
+	uffs_set_dev_error(dev, -uffs_GetObjectErr(obj));
 	
-	uffs_GlobalFsLockUnlock();
+	OBJ_UNLOCK_DEV(obj, dev);
 
 	return ret;
 }
@@ -377,10 +467,21 @@ int uffs_rename(const char *old_name, const char *new_name)
 {
 	int err = 0;
 	int ret = 0;
+	uffs_Device *dev, *new_dev;
 
 	uffs_GlobalFsLockLock();
+	dev = uffs_FindDeviceFromPath(old_name);
+	new_dev = uffs_FindDeviceFromPath(new_name);
+	DEV_LOCK(dev);
+	if (new_dev != dev)
+		DEV_LOCK(new_dev);
+
 	ret = (uffs_RenameObject(old_name, new_name, &err) == U_SUCC) ? 0 : -1;
 	uffs_set_error(-err);
+
+	if (new_dev != dev)
+		DEV_UNLOCK(new_dev);
+	DEV_UNLOCK(dev);
 	uffs_GlobalFsLockUnlock();
 
 	return ret;
@@ -391,6 +492,7 @@ int uffs_remove(const char *name)
 	int err = 0;
 	int ret = 0;
 	struct uffs_stat st;
+	uffs_Device *dev;
 
 	if (uffs_stat(name, &st) < 0) {
 		err = UENOENT;
@@ -402,12 +504,15 @@ int uffs_remove(const char *name)
 	}
 	else {
 		uffs_GlobalFsLockLock();
+		dev = uffs_FindDeviceFromPath(name);
+		DEV_LOCK(dev);
 		if (uffs_DeleteObject(name, &err) == U_SUCC) {
 			ret = 0;
 		}
 		else {
 			ret = -1;
 		}
+		DEV_UNLOCK(dev);
 		uffs_GlobalFsLockUnlock();
 	}
 
@@ -419,23 +524,23 @@ int uffs_ftruncate(int fd, long remain)
 {
 	int ret;
 	uffs_Object *obj;
+	uffs_Device *dev;
 
-	CHK_OBJ_LOCK(fd, obj, -1);
+	CHK_OBJ_LOCK(fd, obj, dev, -1);
 	uffs_ClearObjectErr(obj);
 	ret = (uffs_TruncateObject(obj, remain) == U_SUCC) ? 0 : -1;
-	uffs_set_error(-uffs_GetObjectErr(obj));
-	uffs_GlobalFsLockUnlock();
+	uffs_set_dev_error(dev, -uffs_GetObjectErr(obj));
+	OBJ_UNLOCK_DEV(obj, dev);
 	
 	return ret;
 }
 
-static int do_stat(uffs_Object *obj, struct uffs_stat *buf)
+static int do_stat(uffs_Object *obj, struct uffs_stat *buf, int *err)
 {
 	uffs_ObjectInfo info;
 	int ret = 0;
-	int err = 0;
 
-	if (uffs_GetObjectInfo(obj, &info, &err) == U_FAIL) {
+	if (uffs_GetObjectInfo(obj, &info, err) == U_FAIL) {
 		ret = -1;
 	}
 	else {
@@ -456,7 +561,6 @@ static int do_stat(uffs_Object *obj, struct uffs_stat *buf)
 			buf->st_mode |= US_IRWXU;
 	}
 
-	uffs_set_error(-err);
 	return ret;
 }
 
@@ -466,11 +570,14 @@ int uffs_stat(const char *name, struct uffs_stat *buf)
 	int ret = 0;
 	int err = 0;
 	URET result;
+	uffs_Device *dev;
 
 	uffs_GlobalFsLockLock();
 
 	obj = uffs_GetObject();
 	if (obj) {
+		dev = uffs_FindDeviceFromPath(name);
+		DEV_LOCK(dev);
 		if (*name && name[strlen(name) - 1] == '/') {
 			result = uffs_OpenObject(obj, name, UO_RDONLY | UO_DIR);
 		}
@@ -479,13 +586,14 @@ int uffs_stat(const char *name, struct uffs_stat *buf)
 				result = uffs_OpenObject(obj, name, UO_RDONLY | UO_DIR);	// then try dir
 		}
 		if (result == U_SUCC) {
-			ret = do_stat(obj, buf);
+			ret = do_stat(obj, buf, &err);
 			uffs_CloseObject(obj);
 		}
 		else {
 			err = uffs_GetObjectErr(obj);
 			ret = -1;
 		}
+		DEV_UNLOCK(dev);
 		uffs_PutObject(obj);
 	}
 	else {
@@ -507,27 +615,30 @@ int uffs_lstat(const char *name, struct uffs_stat *buf)
 int uffs_fstat(int fd, struct uffs_stat *buf)
 {
 	int ret;
+	int err = 0;
 	uffs_Object *obj;
+	uffs_Device *dev;
 
-	CHK_OBJ_LOCK(fd, obj, -1);
+	CHK_OBJ_LOCK(fd, obj, dev, -1);
 
-	ret = do_stat(obj, buf);
-	uffs_GlobalFsLockUnlock();
+	ret = do_stat(obj, buf, &err);
+	uffs_set_dev_error(dev, -err);
+	OBJ_UNLOCK_DEV(obj, dev);
 
 	return ret;
 }
 
 int uffs_closedir(uffs_DIR *dirp)
 {
-	CHK_DIR_LOCK(dirp, -1);
+	uffs_Device *dev;
+
+	CHK_DIR_LOCK(dirp, dev, -1);
 
 	uffs_FindObjectClose(&dirp->f);
-	if (dirp->obj) {
-		uffs_CloseObject(dirp->obj);
-		uffs_PutObject(dirp->obj);
-	}
-	PutDirEntry(dirp);
-	uffs_GlobalFsLockUnlock();
+	uffs_CloseObject(dirp->obj);
+
+	/* the closed dir is put by its last user */
+	DIR_UNLOCK_DEV(dirp, dev);
 
 	return 0;
 }
@@ -537,6 +648,7 @@ uffs_DIR * uffs_opendir(const char *path)
 	int err = 0;
 	uffs_DIR *ret = NULL;
 	uffs_DIR *dirp;
+	uffs_Device *dev;
 
 	uffs_GlobalFsLockLock();
 
@@ -545,8 +657,11 @@ uffs_DIR * uffs_opendir(const char *path)
 	if (dirp) {
 		dirp->obj = uffs_GetObject();
 		if (dirp->obj) {
+			dev = uffs_FindDeviceFromPath(path);
+			DEV_LOCK(dev);
 			if (uffs_OpenObject(dirp->obj, path, UO_RDONLY | UO_DIR) == U_SUCC) {
 				if (uffs_FindObjectOpen(&dirp->f, dirp->obj) == U_SUCC) {
+					DEV_UNLOCK(dev);
 					ret = dirp;
 					goto ext;
 				}
@@ -557,6 +672,7 @@ uffs_DIR * uffs_opendir(const char *path)
 			else {
 				err = uffs_GetObjectErr(dirp->obj);
 			}
+			DEV_UNLOCK(dev);
 			uffs_PutObject(dirp->obj);
 			dirp->obj = NULL;
 		}
@@ -578,8 +694,9 @@ ext:
 struct uffs_dirent * uffs_readdir(uffs_DIR *dirp)
 {
 	struct uffs_dirent *ent = NULL;
+	uffs_Device *dev;
 
-	CHK_DIR_LOCK(dirp, NULL);
+	CHK_DIR_LOCK(dirp, dev, NULL);
 
 	if (uffs_FindObjectNext(&dirp->info, &dirp->f) == U_SUCC) {
 		ent = &dirp->dirent;
@@ -591,18 +708,20 @@ struct uffs_dirent * uffs_readdir(uffs_DIR *dirp)
 		ent->d_reclen = sizeof(struct uffs_dirent);
 		ent->d_type = dirp->info.info.attr;
 	}
-	uffs_GlobalFsLockUnlock();
+	DIR_UNLOCK_DEV(dirp, dev);
 
 	return ent;
 }
 
 void uffs_rewinddir(uffs_DIR *dirp)
 {
-	CHK_DIR_VOID_LOCK(dirp);
+	uffs_Device *dev;
+
+	CHK_DIR_VOID_LOCK(dirp, dev);
 
 	uffs_FindObjectRewind(&dirp->f);
 
-	uffs_GlobalFsLockUnlock();
+	DIR_UNLOCK_DEV(dirp, dev);
 }
 
 
@@ -611,11 +730,14 @@ int uffs_mkdir(const char *name, ...)
 	uffs_Object *obj;
 	int ret = 0;
 	int err = 0;
+	uffs_Device *dev;
 
 	uffs_GlobalFsLockLock();
 
 	obj = uffs_GetObject();
 	if (obj) {
+		dev = uffs_FindDeviceFromPath(name);
+		DEV_LOCK(dev);
 		if (uffs_CreateObject(obj, name, UO_CREATE|UO_DIR) != U_SUCC) {
 			err = obj->err;
 			ret = -1;
@@ -624,6 +746,7 @@ int uffs_mkdir(const char *name, ...)
 			uffs_CloseObject(obj);
 			ret = 0;
 		}
+		DEV_UNLOCK(dev);
 		uffs_PutObject(obj);
 	}
 	else {
@@ -642,6 +765,7 @@ int uffs_rmdir(const char *name)
 	int err = 0;
 	int ret = 0;
 	struct uffs_stat st;
+	uffs_Device *dev;
 
 	if (uffs_stat(name, &st) < 0) {
 		err = UENOENT;
@@ -653,12 +777,15 @@ int uffs_rmdir(const char *name)
 	}
 	else {
 		uffs_GlobalFsLockLock();
+		dev = uffs_FindDeviceFromPath(name);
+		DEV_LOCK(dev);
 		if (uffs_DeleteObject(name, &err) == U_SUCC) {
 			ret = 0;
 		}
 		else {
 			ret = -1;
 		}
+		DEV_UNLOCK(dev);
 		uffs_GlobalFsLockUnlock();
 	}
 	uffs_set_error(-err);
@@ -677,9 +804,8 @@ int uffs_format(const char *mount_point)
 
 	dev = uffs_GetDeviceFromMountPoint(mount_point);
 	if (dev) {
-		uffs_GlobalFsLockLock();
+		// uffs_FormatDevice() takes the locks itself
 		ret = uffs_FormatDevice(dev, U_TRUE);
-		uffs_GlobalFsLockUnlock();
 	}
 
 	return ret == U_SUCC ? 0 : -1;
@@ -693,7 +819,9 @@ long uffs_space_total(const char *mount_point)
 	dev = uffs_GetDeviceFromMountPoint(mount_point);
 	if (dev) {
 		uffs_GlobalFsLockLock();
+		DEV_LOCK(dev);
 		ret = (long) uffs_GetDeviceTotal(dev);
+		DEV_UNLOCK(dev);
 		uffs_GlobalFsLockUnlock();
 	}
 
@@ -708,7 +836,9 @@ long uffs_space_used(const char *mount_point)
 	dev = uffs_GetDeviceFromMountPoint(mount_point);
 	if (dev) {
 		uffs_GlobalFsLockLock();
+		DEV_LOCK(dev);
 		ret = (long) uffs_GetDeviceUsed(dev);
+		DEV_UNLOCK(dev);
 		uffs_GlobalFsLockUnlock();
 	}
 
@@ -723,7 +853,9 @@ long uffs_space_free(const char *mount_point)
 	dev = uffs_GetDeviceFromMountPoint(mount_point);
 	if (dev) {
 		uffs_GlobalFsLockLock();
+		DEV_LOCK(dev);
 		ret = (long) uffs_GetDeviceFree(dev);
+		DEV_UNLOCK(dev);
 		uffs_GlobalFsLockUnlock();
 	}
 
@@ -738,8 +870,10 @@ void uffs_flush_all(const char *mount_point)
 	dev = uffs_GetDeviceFromMountPoint(mount_point);
 	if (dev) {
 		uffs_GlobalFsLockLock();
+		DEV_LOCK(dev);
 		uffs_BufFlushAll(dev);
 		uffs_PutDevice(dev);
+		DEV_UNLOCK(dev);
 		uffs_GlobalFsLockUnlock();
 	}
 }
@@ -206,7 +206,7 @@ uffs_Object * uffs_GetObjectByIndex(int idx)
 	return (uffs_Object *) uffs_PoolGetBufByIndex(&_object_pool, idx);
 }
 
-#ifdef CONFIG_PER_DEVICE_LOCK
+#ifdef CONFIG_USE_PER_DEVICE_LOCK
 static void uffs_ObjectDevLock(uffs_Object *obj)
 {
 	if (obj) {
@@ -1002,12 +1002,12 @@ static int do_WriteObject(uffs_Object *obj, const void *data, int len)
 			size = do_WriteInternalBlock(obj, dnode, fdn,
 									data ? (u8 *)data + len - remain : NULL, remain,
 									write_start - GetStartOfDataBlock(obj, fdn));
-#ifdef CONFIG_FLUSH_BUF_AFTER_WRITE
-			if (fdn == 0)
-				uffs_BufFlushGroup(dev, fnode->u.file.parent, fnode->u.file.serial);
-			else
-				uffs_BufFlushGroup(dev, fnode->u.file.serial, fdn);
-#endif
+			if (dev->cfg.flush_mode == UFFS_FLUSH_AFTER_WRITE) {
+				if (fdn == 0)
+					uffs_BufFlushGroup(dev, fnode->u.file.parent, fnode->u.file.serial);
+				else
+					uffs_BufFlushGroup(dev, fnode->u.file.serial, fdn);
+			}
 			if (size == 0)
 				break;
 
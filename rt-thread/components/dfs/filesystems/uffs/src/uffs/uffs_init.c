@@ -56,6 +56,14 @@ static URET uffs_InitDeviceConfig(uffs_Device *dev)
 						"invalid config: dirty_groups = %d\n", dev->cfg.dirty_groups))
 		return U_FAIL;
 
+	if (dev->cfg.flush_mode == 0) {
+#ifdef CONFIG_FLUSH_BUF_AFTER_WRITE
+		dev->cfg.flush_mode = UFFS_FLUSH_AFTER_WRITE;
+#else
+		dev->cfg.flush_mode = UFFS_FLUSH_WRITE_BACK;
+#endif
+	}
+
 #if CONFIG_USE_STATIC_MEMORY_ALLOCATOR > 0
 	dev->cfg.bc_caches = MAX_CACHED_BLOCK_INFO;
 	dev->cfg.page_buffers = MAX_PAGE_BUFFERS;
@@ -66,14 +74,22 @@ static URET uffs_InitDeviceConfig(uffs_Device *dev)
 		dev->cfg.bc_caches = MAX_CACHED_BLOCK_INFO;
 	if (dev->cfg.page_buffers == 0)
 		dev->cfg.page_buffers = MAX_PAGE_BUFFERS;
-	if (dev->cfg.dirty_pages == 0)
+	if (dev->cfg.dirty_pages == 0) {
 		dev->cfg.dirty_pages = MAX_DIRTY_PAGES_IN_A_BLOCK;
+		// fewer page buffers than the default, leave room for clone buffers
+		if (dev->cfg.dirty_pages > dev->cfg.page_buffers - CLONE_BUFFERS_THRESHOLD - 1)
+			dev->cfg.dirty_pages = dev->cfg.page_buffers - CLONE_BUFFERS_THRESHOLD - 1;
+	}
 	if (dev->cfg.reserved_free_blocks == 0)
 		dev->cfg.reserved_free_blocks = MINIMUN_ERASED_BLOCK;
 
 	if (!uffs_Assert(dev->cfg.page_buffers - CLONE_BUFFERS_THRESHOLD >= 3, "invalid config: page_buffers = %d\n", dev->cfg.page_buffers))
 		return U_FAIL;
 
+	if (!uffs_Assert(dev->cfg.dirty_pages < dev->cfg.page_buffers - CLONE_BUFFERS_THRESHOLD,
+						"invalid config: dirty_pages = %d\n", dev->cfg.dirty_pages))
+		return U_FAIL;
+
 #endif
 	return U_SUCC;
 }
@@ -144,6 +144,18 @@ static uffs_MountTable * uffs_GetMountTableByMountPoint(const char *mount, uffs_
 	return work;
 }
 
+static uffs_MountTable * uffs_GetMountTableByMountPointEx(const char *mount, int len)
+{
+	uffs_MountTable *work = NULL;
+
+	for (work = m_head; work; work = work->next) {
+		if (strlen(work->mount) == len &&
+				strncmp(mount, work->mount, len) == 0)
+			break;
+	}
+	return work;
+}
+
 /**
  * \brief mount partition
  * \param[in] mount partition mount point
@@ -273,7 +285,6 @@ int uffs_UnMount(const char *mount)
 int uffs_GetMatchedMountPointSize(const char *path)
 {
 	int pos;
-	uffs_Device *dev;
 
 	if (path[0] != '/')
 		return 0;
@@ -281,8 +292,7 @@ int uffs_GetMatchedMountPointSize(const char *path)
 	pos = strlen(path);
 
 	while (pos > 0) {
-		if ((dev = uffs_GetDeviceFromMountPointEx(path, pos)) != NULL ) {
-			uffs_PutDevice(dev);
+		if (uffs_GetMountTableByMountPointEx(path, pos) != NULL) {
 			return pos;
 		}
 		else {
@@ -324,19 +334,34 @@ uffs_Device * uffs_GetDeviceFromMountPoint(const char *mount)
  */
 uffs_Device * uffs_GetDeviceFromMountPointEx(const char *mount, int len)
 {
-	uffs_MountTable *work = NULL;
+	uffs_MountTable *mtb = uffs_GetMountTableByMountPointEx(mount, len);
 
-	for (work = m_head; work; work = work->next) {
-		if (strlen(work->mount) == len &&
-				strncmp(mount, work->mount, len) == 0) {
-			work->dev->ref_count++;
-			return work->dev;
-		}
+	if (mtb) {
+		mtb->dev->ref_count++;
+		return mtb->dev;
 	}
 
 	return NULL;
 }
 
+/**
+ * find the device of a given full absolute path.
+ *
+ * \param[in] path full path
+ * \return NULL if no mount point matches the path.
+ *
+ * \note the device reference count is not increased, so the device of
+ *       other path can be found without touching its reference count.
+ */
+uffs_Device * uffs_FindDeviceFromPath(const char *path)
+{
+	uffs_MountTable *mtb;
+
+	mtb = uffs_GetMountTableByMountPointEx(path, uffs_GetMatchedMountPointSize(path));
+
+	return mtb ? mtb->dev : NULL;
+}
+
 
 /**
  * return mount point from device
@@ -52,10 +52,11 @@
 
 #define SPOOL(dev) &((dev)->mem.spare_pool)
 
-#ifdef CONFIG_USE_GLOBAL_FS_LOCK
+#if defined(CONFIG_USE_GLOBAL_FS_LOCK) || defined(CONFIG_USE_PER_DEVICE_LOCK)
 static OSSEM _global_lock = OSSEM_NOT_INITED;
 
-/* global file system lock */
+/* global file system lock, with CONFIG_USE_PER_DEVICE_LOCK it only protects
+   the object handles, the mount table and the name space operations */
 void uffs_InitGlobalFsLock(void)
 {
 	uffs_SemCreate(&_global_lock);
@@ -220,6 +221,7 @@ URET uffs_FormatDevice(uffs_Device *dev, UBOOL force)
 		return U_FAIL;
 
 	uffs_GlobalFsLockLock();
+	uffs_DeviceLock(dev);
 
 	ret = uffs_BufFlushAll(dev);
 
@@ -291,6 +293,7 @@ URET uffs_FormatDevice(uffs_Device *dev, UBOOL force)
 		ret = U_FAIL;
 	}
 
+	uffs_DeviceUnLock(dev);
 	uffs_GlobalFsLockUnlock();
 
 	return ret;
@@ -39,6 +39,8 @@
 #ifndef _UFFS_CONFIG_H_
 #define _UFFS_CONFIG_H_
 
+#include <rtconfig.h>
+
 /**
  * \def UFFS_MAX_PAGE_SIZE
  * \note maximum page size UFFS support
@@ -58,17 +60,27 @@
 /**
  * \def MAX_CACHED_BLOCK_INFO
  * \note uffs cache the block info for opened directories and files,
- *       a practical value is 5 ~ MAX_OBJECT_HANDLE
+ *       a practical value is 5 ~ MAX_OBJECT_HANDLE.
+ *       this is the default of uffs_Config.bc_caches of device.
  */
+#ifdef RT_UFFS_BLOCK_INFO_CACHES
+#define MAX_CACHED_BLOCK_INFO	RT_UFFS_BLOCK_INFO_CACHES
+#else
 #define MAX_CACHED_BLOCK_INFO	50
+#endif
 
 /** 
  * \def MAX_PAGE_BUFFERS
  * \note the bigger value will bring better read/write performance.
  *       but few writing performance will be improved when this 
- *       value is become larger than 'max pages per block'
+ *       value is become larger than 'max pages per block'.
+ *       this is the default of uffs_Config.page_buffers of device.
  */
+#ifdef RT_UFFS_PAGE_BUFFERS
+#define MAX_PAGE_BUFFERS		RT_UFFS_PAGE_BUFFERS
+#else
 #define MAX_PAGE_BUFFERS		40
+#endif
 
 
 /** 
@@ -92,7 +104,11 @@
  *
  *       the smaller the value the frequently the buffer will be flushed.
  */
-#define MAX_DIRTY_PAGES_IN_A_BLOCK 32	
+#if (MAX_PAGE_BUFFERS - CLONE_BUFFERS_THRESHOLD - 1) < 32
+#define MAX_DIRTY_PAGES_IN_A_BLOCK (MAX_PAGE_BUFFERS - CLONE_BUFFERS_THRESHOLD - 1)
+#else
+#define MAX_DIRTY_PAGES_IN_A_BLOCK 32
+#endif
 
 /**
  * \def MAX_DIRTY_BUF_GROUPS
@@ -111,15 +127,21 @@
  * \note use global lock instead of per-device lock.
  *       this is required if you use fd APIs in multi-thread environment.
  */
+#ifndef RT_UFFS_USING_PER_DEVICE_LOCK
 #define CONFIG_USE_GLOBAL_FS_LOCK
+#endif
 
 
 /**
  * \def CONFIG_USE_PER_DEVICE_LOCK
  * \note use per-device lock.
  *		 this is required if you use fs APIs in multi-thread environment.
+ *		 the fd APIs on different devices are executed in parallel, only
+ *		 the handles and name space operations are serialized.
  */
-//#define CONFIG_USE_PER_DEVICE_LOCK
+#ifdef RT_UFFS_USING_PER_DEVICE_LOCK
+#define CONFIG_USE_PER_DEVICE_LOCK
+#endif
 
 
 
@@ -148,8 +170,11 @@
  *       (which means lesser data lost when power failure but
  *		 poorer writing performance).
  *		 It's not recommended to open this define for normal applications.
+ *		 this is the default of uffs_Config.flush_mode of device.
  */
+#ifndef RT_UFFS_USING_WRITE_BACK
 #define CONFIG_FLUSH_BUF_AFTER_WRITE
+#endif
 
 
 /**
@@ -85,8 +85,7 @@ int uffs_SemDelete(OSSEM *sem)
 
 int uffs_OSGetTaskId(void)
 {
-	//TODO: ... return current task ID ...
-	return 0;
+	return (int)(rt_ubase_t)rt_thread_self();
 }
 
 unsigned int uffs_GetCurDateTime(void)
@@ -63,6 +63,9 @@
 
 #define DFS_FS_FLAG_DEFAULT     0x00    /* default flag */
 #define DFS_FS_FLAG_FULLPATH    0x01    /* set full path to underlaying file system */
+#define DFS_FS_FLAG_LOCKED      0x02    /* serialize the calls into file system by DFS */
+#define DFS_FS_FLAG_STREAM      0x04    /* no file position to be protected, such as device */
+#define DFS_FS_FLAG_REMOTE      0x08    /* files can be changed by others, not cached by DFS */
 
 /* File types */
 #define FT_REGULAR               0   /* regular file */
@@ -75,6 +78,11 @@
 #define DFS_F_DIRECTORY         0x02000000
 #define DFS_F_EOF               0x04000000
 #define DFS_F_ERR               0x08000000
+#define DFS_F_POS_LOCK          0x10000000  /* the position lock is initialized */
+#define DFS_F_DIRTY             0x20000000  /* written since the last fsync */
+
+/* File io control commands */
+#define RT_FIOGETADDR           0x52540001U /* get the address of file data in memory (XIP), args is void ** */
 
 #ifdef __cplusplus
 extern "C" {
@@ -99,6 +107,7 @@ struct dfs_fdtable
 {
     uint32_t maxfd;
     struct dfs_fd **fds;
+    uint32_t *bitmap;           /* used fd entries, in the memory of fds */
 };
 
 /* Initialization of dfs */
@@ -111,10 +120,16 @@ void dfs_lock(void);
 void dfs_unlock(void);
 
 /* FD APIs */
+struct dfs_file_ops;
+struct dfs_filesystem;
+
 int fd_new(void);
+int fd_new_anon(const struct dfs_file_ops *fops, void *data, uint32_t flags);
 struct dfs_fd *fd_get(int fd);
 void fd_put(struct dfs_fd *fd);
 int fd_is_open(const char *pathname);
+struct dfs_fd *fd_find(const char *pathname);
+rt_bool_t fd_fs_in_use(struct dfs_filesystem *fs);
 
 struct dfs_fdtable* dfs_fdtable_get(void);
 
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef DFS_DCACHE_H__
+#define DFS_DCACHE_H__
+
+#include <dfs.h>
+#include <dfs_fs.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef RT_USING_DFS_DCACHE
+
+#ifndef DFS_DCACHE_SIZE
+#define DFS_DCACHE_SIZE     32
+#endif
+
+struct dfs_dcache_stat
+{
+    rt_uint32_t hit;                /* positive entry found */
+    rt_uint32_t negative;           /* negative entry found */
+    rt_uint32_t miss;               /* path looked up in file system */
+    rt_uint32_t entries;            /* cached entries */
+};
+
+int  dfs_dcache_init(void);
+
+rt_bool_t dfs_dcache_lookup(struct dfs_filesystem *fs, const char *path,
+                            struct stat *buf, int *result);
+rt_uint32_t dfs_dcache_generation(void);
+void dfs_dcache_insert(struct dfs_filesystem *fs, const char *path,
+                       const struct stat *buf, rt_uint32_t generation);
+
+void dfs_dcache_invalidate(struct dfs_filesystem *fs, const char *path, rt_bool_t subtree);
+void dfs_dcache_invalidate_parent(struct dfs_filesystem *fs, const char *path);
+void dfs_dcache_invalidate_fs(struct dfs_filesystem *fs);
+
+void dfs_dcache_stat_get(struct dfs_dcache_stat *stat);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
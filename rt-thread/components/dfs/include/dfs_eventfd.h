@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef DFS_EVENTFD_H__
+#define DFS_EVENTFD_H__
+
+#include <dfs_poll.h>
+
+#ifdef RT_USING_POSIX
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EFD_SEMAPHORE   0x00001
+#define EFD_NONBLOCK    O_NONBLOCK
+#define EFD_CLOEXEC     0x80000
+
+typedef uint64_t eventfd_t;
+
+int eventfd(unsigned int initval, int flags);
+int eventfd_read(int fd, eventfd_t *value);
+int eventfd_write(int fd, eventfd_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+#endif
@@ -46,6 +46,10 @@ struct dfs_file_ops
     int (*getdents) (struct dfs_fd *fd, struct dirent *dirp, uint32_t count);
 
     int (*poll)     (struct dfs_fd *fd, struct rt_pollreq *req);
+
+    /* copy data between two files of the same file system type at their
+     * current positions, return -ENOSYS to use the generic copy. */
+    int (*copy_range)(struct dfs_fd *fd_in, struct dfs_fd *fd_out, size_t count);
 };
 
 /* file descriptor */
@@ -57,6 +61,7 @@ struct dfs_fd
 
     char *path;                  /* Name (below mount point) */
     int ref_count;               /* Descriptor reference count */
+    int index;                   /* Index of entry in fd table */
 
     const struct dfs_file_ops *fops;
 
@@ -65,6 +70,12 @@ struct dfs_fd
     off_t    pos;                /* Current file position */
 
     void *data;                  /* Specific file system data */
+
+    struct dfs_filesystem *fs;   /* File system of file, NULL for others */
+    struct rt_mutex pos_lock;    /* Protect the file position */
+#ifdef RT_USING_DFS_PAGECACHE
+    void *pcache;                /* File in page cache, NULL if not cached */
+#endif
 };
 
 int dfs_file_open(struct dfs_fd *fd, const char *path, int flags);
@@ -76,6 +87,9 @@ int dfs_file_unlink(const char *path);
 int dfs_file_write(struct dfs_fd *fd, const void *buf, size_t len);
 int dfs_file_flush(struct dfs_fd *fd);
 int dfs_file_lseek(struct dfs_fd *fd, off_t offset);
+int dfs_file_pread(struct dfs_fd *fd, void *buf, size_t len, off_t offset);
+int dfs_file_pwrite(struct dfs_fd *fd, const void *buf, size_t len, off_t offset);
+int dfs_file_copy_range(struct dfs_fd *fd_in, struct dfs_fd *fd_out, size_t len);
 
 int dfs_file_stat(const char *path, struct stat *buf);
 int dfs_file_rename(const char *oldpath, const char *newpath);
@@ -66,6 +66,8 @@ struct dfs_filesystem
     const struct dfs_filesystem_ops *ops; /* Operations for file system type */
 
     void *data;             /* Specific file system data */
+
+    struct rt_mutex lock;   /* Serialize the calls if DFS_FS_FLAG_LOCKED */
 };
 
 /* file system partition table */
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef DFS_PCACHE_H__
+#define DFS_PCACHE_H__
+
+#include <dfs.h>
+#include <dfs_fs.h>
+#include <dfs_file.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef RT_USING_DFS_PAGECACHE
+
+#ifndef DFS_PAGECACHE_PAGE_SIZE
+#define DFS_PAGECACHE_PAGE_SIZE         4096
+#endif
+
+#ifndef DFS_PAGECACHE_MAX_PAGES
+#define DFS_PAGECACHE_MAX_PAGES         16
+#endif
+
+#ifndef DFS_PAGECACHE_READAHEAD
+#define DFS_PAGECACHE_READAHEAD         4
+#endif
+
+#ifndef DFS_PAGECACHE_WRITEBACK_MS
+#define DFS_PAGECACHE_WRITEBACK_MS      1000
+#endif
+
+struct dfs_pcache_stat
+{
+    rt_uint32_t hit;                /* page found in cache */
+    rt_uint32_t miss;               /* page read from file system */
+    rt_uint32_t readahead;          /* page read ahead */
+    rt_uint32_t writeback;          /* dirty page written back */
+    rt_uint32_t evict;              /* clean page reclaimed */
+
+    rt_uint32_t pages;              /* allocated pages */
+    rt_uint32_t dirty;              /* dirty pages */
+};
+
+int  dfs_pcache_init(void);
+
+void dfs_pcache_open(struct dfs_fd *fd);
+int  dfs_pcache_close(struct dfs_fd *fd);
+int  dfs_pcache_read(struct dfs_fd *fd, void *buf, size_t len);
+int  dfs_pcache_write(struct dfs_fd *fd, const void *buf, size_t len);
+int  dfs_pcache_lseek(struct dfs_fd *fd, off_t offset);
+int  dfs_pcache_flush(struct dfs_fd *fd);
+off_t dfs_pcache_size(struct dfs_fd *fd);
+
+void dfs_pcache_invalidate(struct dfs_filesystem *fs, const char *path);
+int  dfs_pcache_invalidate_fs(struct dfs_filesystem *fs);
+void dfs_pcache_rename(struct dfs_filesystem *fs, const char *oldpath, const char *newpath);
+
+int  dfs_pcache_sync(void);
+void dfs_pcache_stat_get(struct dfs_pcache_stat *stat);
+
+/* the size of file including the data in cache */
+#define DFS_FD_SIZE(fd)     ((fd)->pcache ? dfs_pcache_size(fd) : (off_t)(fd)->size)
+#else
+#define DFS_FD_SIZE(fd)     ((off_t)(fd)->size)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,6 +2,8 @@
 #define DFS_PRIVATE_H__
 
 #include <dfs.h>
+#include <dfs_fs.h>
+#include <dfs_file.h>
 
 // #define DBG_ENABLE
 #define DBG_SECTION_NAME	"DFS"
@@ -18,4 +20,62 @@ extern const struct dfs_mount_tbl mount_table[];
 
 extern char working_directory[];
 
+/* serialize the calls into the file system which is not thread safe, it fails
+ * if the file system is unmounted while waiting */
+rt_inline int dfs_fs_lock(struct dfs_filesystem *fs)
+{
+    if (fs != NULL && (fs->ops->flags & DFS_FS_FLAG_LOCKED))
+    {
+        if (rt_mutex_take(&(fs->lock), RT_WAITING_FOREVER) != RT_EOK)
+            return -ENODEV;
+
+        if (fs->path == NULL)
+        {
+            rt_mutex_release(&(fs->lock));
+            return -ENODEV;
+        }
+    }
+
+    return 0;
+}
+
+rt_inline void dfs_fs_unlock(struct dfs_filesystem *fs)
+{
+    if (fs != NULL && (fs->ops->flags & DFS_FS_FLAG_LOCKED))
+        rt_mutex_release(&(fs->lock));
+}
+
+/* the file position is protected for the files of file system except stream */
+#define DFS_FD_POS_LOCKED(fd) \
+    ((fd)->fs != NULL && !((fd)->fs->ops->flags & DFS_FS_FLAG_STREAM))
+
+/* the position lock is kept after closed for the threads waiting on it, it
+ * fails if the file is closed while waiting */
+rt_inline int dfs_fd_lock(struct dfs_fd *fd)
+{
+    if (fd->flags & DFS_F_POS_LOCK)
+    {
+        if (rt_mutex_take(&(fd->pos_lock), RT_WAITING_FOREVER) != RT_EOK)
+            return -EBADF;
+
+        if (fd->fs == NULL)
+        {
+            rt_mutex_release(&(fd->pos_lock));
+            return -EBADF;
+        }
+    }
+
+    return 0;
+}
+
+rt_inline void dfs_fd_unlock(struct dfs_fd *fd)
+{
+    if (fd->flags & DFS_F_POS_LOCK)
+        rt_mutex_release(&(fd->pos_lock));
+}
+
+#ifdef RT_USING_POSIX
+void dfs_epoll_file_release(struct dfs_fd *fd);
+#endif
+
 #endif
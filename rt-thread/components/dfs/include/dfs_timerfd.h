@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef DFS_TIMERFD_H__
+#define DFS_TIMERFD_H__
+
+#include <dfs_poll.h>
+
+#ifdef RT_USING_POSIX
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TFD_TIMER_ABSTIME   0x00001
+#define TFD_NONBLOCK        O_NONBLOCK
+#define TFD_CLOEXEC         0x80000
+
+#ifndef CLOCK_REALTIME
+#define CLOCK_REALTIME      1
+#endif
+#ifndef CLOCK_MONOTONIC
+#define CLOCK_MONOTONIC     4
+#endif
+
+#ifndef RT_USING_NEWLIB
+struct itimerspec
+{
+    struct timespec it_interval;    /* timer period */
+    struct timespec it_value;       /* timer expiration */
+};
+#endif
+
+int timerfd_create(int clockid, int flags);
+int timerfd_settime(int fd, int flags, const struct itimerspec *new_value,
+                    struct itimerspec *old_value);
+int timerfd_gettime(int fd, struct itimerspec *curr_value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+#endif
@@ -24,9 +24,16 @@
  * 2018-03-20     Heyuanjie    dynamic allocation FD
  */
 
+#include <rthw.h>
 #include <dfs.h>
 #include <dfs_fs.h>
 #include <dfs_file.h>
+#ifdef RT_USING_DFS_PAGECACHE
+#include <dfs_pcache.h>
+#endif
+#ifdef RT_USING_DFS_DCACHE
+#include <dfs_dcache.h>
+#endif
 #include "dfs_private.h"
 #ifdef RT_USING_LWP
 #include <lwp.h>
@@ -36,15 +43,24 @@
 const struct dfs_filesystem_ops *filesystem_operation_table[DFS_FILESYSTEM_TYPES_MAX];
 struct dfs_filesystem filesystem_table[DFS_FILESYSTEMS_MAX];
 
-/* device filesystem lock */
+/* device filesystem lock, which protects the mount table and working directory */
 static struct rt_mutex fslock;
 
+/* the lock of fd table expansion, the fd table is accessed with interrupt disabled */
+static struct rt_mutex fdlock;
+
+#ifdef RT_USING_MEMPOOL
+/* the pool of file descriptor objects, it falls back to heap when it's used up */
+static rt_mp_t fd_pool = RT_NULL;
+#endif
+
+#define FD_BITMAP_WORDS(n)  (((n) + 31) / 32)
+
 #ifdef DFS_USING_WORKDIR
 char working_directory[DFS_PATH_MAX] = {"/"};
 #endif
 
 static struct dfs_fdtable _fdtab;
-static int  fd_alloc(struct dfs_fdtable *fdt, int startfd);
 
 /**
  * @addtogroup DFS
@@ -74,6 +90,10 @@ int dfs_init(void)
 
     /* create device filesystem lock */
     rt_mutex_init(&fslock, "fslock", RT_IPC_FLAG_FIFO);
+    rt_mutex_init(&fdlock, "fdlock", RT_IPC_FLAG_FIFO);
+#ifdef RT_USING_MEMPOOL
+    fd_pool = rt_mp_create("dfs_fd", DFS_FD_MAX, sizeof(struct dfs_fd));
+#endif
 
 #ifdef DFS_USING_WORKDIR
     /* set current working directory */
@@ -92,6 +112,13 @@ int dfs_init(void)
     }
 #endif
 
+#ifdef RT_USING_DFS_DCACHE
+    dfs_dcache_init();
+#endif
+#ifdef RT_USING_DFS_PAGECACHE
+    dfs_pcache_init();
+#endif
+
     init_ok = RT_TRUE;
 
     return 0;
@@ -128,52 +155,132 @@ void dfs_unlock(void)
     rt_mutex_release(&fslock);
 }
 
-static int fd_alloc(struct dfs_fdtable *fdt, int startfd)
+static struct dfs_fd *fd_object_alloc(void)
 {
-    int idx;
+    struct dfs_fd *d;
 
-    /* find an empty fd entry */
-    for (idx = startfd; idx < fdt->maxfd; idx++)
+#ifdef RT_USING_MEMPOOL
+    if (fd_pool != RT_NULL)
     {
-        if (fdt->fds[idx] == RT_NULL)
-            break;
-        if (fdt->fds[idx]->ref_count == 0)
-            break;
+        d = (struct dfs_fd *)rt_mp_alloc(fd_pool, 0);
+        if (d != RT_NULL)
+        {
+            memset(d, 0, sizeof(struct dfs_fd));
+            return d;
+        }
     }
+#endif
+
+    d = (struct dfs_fd *)rt_calloc(1, sizeof(struct dfs_fd));
 
-    /* allocate a larger FD container */
-    if (idx == fdt->maxfd && fdt->maxfd < DFS_FD_MAX)
+    return d;
+}
+
+static void fd_object_free(struct dfs_fd *d)
+{
+    /* nobody is waiting on the position lock after the last reference */
+    if (d->flags & DFS_F_POS_LOCK)
+        rt_mutex_detach(&(d->pos_lock));
+
+#ifdef RT_USING_MEMPOOL
+    if (fd_pool != RT_NULL &&
+        (rt_uint8_t *)d >= (rt_uint8_t *)fd_pool->start_address &&
+        (rt_uint8_t *)d <  (rt_uint8_t *)fd_pool->start_address + fd_pool->size)
     {
-        int cnt, index;
-        struct dfs_fd **fds;
+        rt_mp_free(d);
+        return;
+    }
+#endif
 
-        /* increase the number of FD with 4 step length */
-        cnt = fdt->maxfd + 4;
-        cnt = cnt > DFS_FD_MAX? DFS_FD_MAX : cnt;
+    rt_free(d);
+}
 
-        fds = rt_realloc(fdt->fds, cnt * sizeof(struct dfs_fd *));
-        if (fds == NULL) goto __exit; /* return fdt->maxfd */
+/*
+ * find a free fd entry in bitmap and mark it as used, the interrupt shall be
+ * disabled.
+ *
+ * @return the index of entry, or maxfd if the table is full.
+ */
+static int fd_slot_alloc(struct dfs_fdtable *fdt)
+{
+    int word, bit, idx;
 
-        /* clean the new allocated fds */
-        for (index = fdt->maxfd; index < cnt; index ++)
-        {
-            fds[index] = NULL;
-        }
+    for (word = 0; word < FD_BITMAP_WORDS(fdt->maxfd); word ++)
+    {
+        if (fdt->bitmap[word] == 0xffffffff)
+            continue;
+
+        bit = __rt_ffs((int)~fdt->bitmap[word]) - 1;
+        idx = word * 32 + bit;
+        if (idx >= fdt->maxfd)
+            break;
+
+        fdt->bitmap[word] |= 1ul << bit;
+        return idx;
+    }
+
+    return fdt->maxfd;
+}
+
+/*
+ * expand the fd table geometrically, the fd table expansion lock shall be
+ * held.
+ *
+ * @return 0 on successful, -1 on failed.
+ */
+static int fd_table_expand(struct dfs_fdtable *fdt, uint32_t maxfd)
+{
+    int cnt, index;
+    rt_base_t level;
+    struct dfs_fd **fds;
+    uint32_t *bitmap;
+    void *old;
+
+    /* it's expanded by others */
+    if (fdt->maxfd > maxfd)
+        return 0;
 
-        fdt->fds   = fds;
-        fdt->maxfd = cnt;
+    if (fdt->maxfd >= DFS_FD_MAX)
+        return -1;
+
+    cnt = fdt->maxfd ? fdt->maxfd * 2 : 4;
+    cnt = cnt > DFS_FD_MAX ? DFS_FD_MAX : cnt;
+
+    /* the bitmap follows the fd entries in the same memory */
+    fds = rt_malloc(cnt * sizeof(struct dfs_fd *) + FD_BITMAP_WORDS(cnt) * sizeof(uint32_t));
+    if (fds == NULL)
+        return -1;
+    bitmap = (uint32_t *)(fds + cnt);
+
+    /* clean the new allocated fds */
+    for (index = fdt->maxfd; index < cnt; index ++)
+    {
+        fds[index] = NULL;
+    }
+    for (index = FD_BITMAP_WORDS(fdt->maxfd); index < FD_BITMAP_WORDS(cnt); index ++)
+    {
+        bitmap[index] = 0;
     }
 
-    /* allocate  'struct dfs_fd' */
-    if (idx < fdt->maxfd &&fdt->fds[idx] == RT_NULL)
+    /* the entries may be changed by fd_new and fd_put, copy them in lock */
+    level = rt_hw_interrupt_disable();
+    for (index = 0; index < fdt->maxfd; index ++)
+    {
+        fds[index] = fdt->fds[index];
+    }
+    for (index = 0; index < FD_BITMAP_WORDS(fdt->maxfd); index ++)
     {
-        fdt->fds[idx] = rt_calloc(1, sizeof(struct dfs_fd));
-        if (fdt->fds[idx] == RT_NULL)
-            idx = fdt->maxfd;
+        bitmap[index] = fdt->bitmap[index];
     }
+    old = fdt->fds;
+    fdt->fds    = fds;
+    fdt->bitmap = bitmap;
+    fdt->maxfd  = cnt;
+    rt_hw_interrupt_enable(level);
 
-__exit:
-    return idx;
+    rt_free(old);
+
+    return 0;
 }
 
 /**
@@ -184,32 +291,88 @@ __exit:
  */
 int fd_new(void)
 {
-    struct dfs_fd *d;
     int idx;
+    uint32_t maxfd;
+    rt_base_t level;
+    struct dfs_fd *d;
     struct dfs_fdtable *fdt;
 
     fdt = dfs_fdtable_get();
-    /* lock filesystem */
-    dfs_lock();
 
-    /* find an empty fd entry */
-    idx = fd_alloc(fdt, 0);
+    d = fd_object_alloc();
+    if (d == RT_NULL)
+        goto __failed;
+    d->ref_count = 1;
+    d->magic = DFS_FD_MAGIC;
 
-    /* can't find an empty fd entry */
-    if (idx == fdt->maxfd)
+    while (1)
     {
-        idx = -(1 + DFS_FD_OFFSET);
-        dbg_log(DBG_ERROR, "DFS fd new is failed! Could not found an empty fd entry.");
-        goto __result;
-    }
+        /* find an empty fd entry */
+        level = rt_hw_interrupt_disable();
+        maxfd = fdt->maxfd;
+        idx = fd_slot_alloc(fdt);
+        if (idx < maxfd)
+        {
+            fdt->fds[idx] = d;
+            d->index = idx;
+        }
+        rt_hw_interrupt_enable(level);
 
-    d = fdt->fds[idx];
-    d->ref_count = 1;
-    d->magic = DFS_FD_MAGIC;
+        if (idx < maxfd)
+            break;
+
+        /* allocate a larger FD container */
+        rt_mutex_take(&fdlock, RT_WAITING_FOREVER);
+        idx = fd_table_expand(fdt, maxfd);
+        rt_mutex_release(&fdlock);
+        if (idx < 0)
+        {
+            fd_object_free(d);
+            goto __failed;
+        }
+    }
 
-__result:
-    dfs_unlock();
     return idx + DFS_FD_OFFSET;
+
+__failed:
+    /* can't find an empty fd entry */
+    dbg_log(DBG_ERROR, "DFS fd new is failed! Could not found an empty fd entry.");
+    return -1;
+}
+
+/**
+ * @ingroup Fd
+ * This function will allocate a file descriptor for an anonymous file, which
+ * does not belong to any file system, such as epoll, eventfd and timerfd.
+ *
+ * @param fops the file operations.
+ * @param data the private data of file.
+ * @param flags the file flags, such as O_RDWR and O_NONBLOCK.
+ *
+ * @return -1 on failed or the allocated file descriptor.
+ */
+int fd_new_anon(const struct dfs_file_ops *fops, void *data, uint32_t flags)
+{
+    int fd;
+    struct dfs_fd *d;
+
+    fd = fd_new();
+    if (fd < 0)
+        return -1;
+
+    d = fd_get(fd);
+    d->type  = FT_USER;
+    d->path  = NULL;
+    d->fops  = fops;
+    d->flags = flags | DFS_F_OPEN;
+    d->size  = 0;
+    d->pos   = 0;
+    d->data  = data;
+
+    /* release the ref-count of fd */
+    fd_put(d);
+
+    return fd;
 }
 
 /**
@@ -224,26 +387,31 @@ __result:
 struct dfs_fd *fd_get(int fd)
 {
     struct dfs_fd *d;
+    rt_base_t level;
     struct dfs_fdtable *fdt;
 
     fdt = dfs_fdtable_get();
     fd = fd - DFS_FD_OFFSET;
+
+    level = rt_hw_interrupt_disable();
     if (fd < 0 || fd >= fdt->maxfd)
+    {
+        rt_hw_interrupt_enable(level);
         return NULL;
+    }
 
-    dfs_lock();
     d = fdt->fds[fd];
 
     /* check dfs_fd valid or not */
-    if (d->magic != DFS_FD_MAGIC)
+    if (d == NULL || d->magic != DFS_FD_MAGIC)
     {
-        dfs_unlock();
+        rt_hw_interrupt_enable(level);
         return NULL;
     }
 
     /* increase the reference count */
     d->ref_count ++;
-    dfs_unlock();
+    rt_hw_interrupt_enable(level);
 
     return d;
 }
@@ -255,42 +423,53 @@ struct dfs_fd *fd_get(int fd)
  */
 void fd_put(struct dfs_fd *fd)
 {
+    int index;
+    rt_base_t level;
+    struct dfs_fdtable *fdt;
+
     RT_ASSERT(fd != NULL);
 
-    dfs_lock();
+    fdt = dfs_fdtable_get();
 
+    level = rt_hw_interrupt_disable();
     fd->ref_count --;
 
     /* clear this fd entry */
     if (fd->ref_count == 0)
     {
-        int index;
-        struct dfs_fdtable *fdt;
-
-        fdt = dfs_fdtable_get();
-        for (index = 0; index < fdt->maxfd; index ++)
+        index = fd->index;
+        if (index < fdt->maxfd && fdt->fds[index] == fd)
         {
-            if (fdt->fds[index] == fd)
-            {
-                rt_free(fd);
-                fdt->fds[index] = 0;
-                break;
-            }
+            fdt->fds[index] = 0;
+            fdt->bitmap[index / 32] &= ~(1ul << (index % 32));
         }
+        else
+        {
+            fd = NULL;
+        }
+    }
+    else
+    {
+        fd = NULL;
     }
-    dfs_unlock();
+    rt_hw_interrupt_enable(level);
+
+    /* free the fd out of lock */
+    if (fd != NULL)
+        fd_object_free(fd);
 }
 
 /**
  * @ingroup Fd
  *
- * This function will return whether this file has been opend.
+ * This function will find the file descriptor of an opened file by path.
  *
  * @param pathname the file path name.
  *
- * @return 0 on file has been open successfully, -1 on open failed.
+ * @return the file descriptor with a reference which shall be put by fd_put,
+ *         NULL if the file is not opened.
  */
-int fd_is_open(const char *pathname)
+struct dfs_fd *fd_find(const char *pathname)
 {
     char *fullpath;
     unsigned int index;
@@ -309,7 +488,7 @@ int fd_is_open(const char *pathname)
             /* can't find mounted file system */
             rt_free(fullpath);
 
-            return -1;
+            return NULL;
         }
 
         /* get file path name under mounted file system */
@@ -318,28 +497,103 @@ int fd_is_open(const char *pathname)
         else
             mountpath = fullpath + strlen(fs->path);
 
-        dfs_lock();
-
         for (index = 0; index < fdt->maxfd; index++)
         {
+            rt_base_t level;
+
+            /* hold the fd to check it out of lock */
+            level = rt_hw_interrupt_disable();
             fd = fdt->fds[index];
-            if (fd == NULL || fd->fops == NULL || fd->path == NULL) continue;
+            if (fd != NULL)
+                fd->ref_count ++;
+            rt_hw_interrupt_enable(level);
+
+            if (fd == NULL) continue;
 
-            if (fd->fops == fs->ops->fops && strcmp(fd->path, mountpath) == 0)
+            if (fd->fops != NULL && fd->path != NULL &&
+                fd->fops == fs->ops->fops && strcmp(fd->path, mountpath) == 0)
             {
                 /* found file in file descriptor table */
                 rt_free(fullpath);
-                dfs_unlock();
 
-                return 0;
+                return fd;
             }
+            fd_put(fd);
         }
-        dfs_unlock();
 
         rt_free(fullpath);
     }
 
-    return -1;
+    return NULL;
+}
+
+/**
+ * @ingroup Fd
+ *
+ * This function will return whether this file has been opend.
+ *
+ * @param pathname the file path name.
+ *
+ * @return 0 on file has been open successfully, -1 on open failed.
+ */
+int fd_is_open(const char *pathname)
+{
+    struct dfs_fd *fd;
+
+    fd = fd_find(pathname);
+    if (fd == NULL)
+        return -1;
+
+    fd_put(fd);
+
+    return 0;
+}
+
+static rt_bool_t fd_table_uses_fs(struct dfs_fdtable *fdt, struct dfs_filesystem *fs)
+{
+    unsigned int index;
+    rt_base_t level;
+    struct dfs_fd *fd;
+
+    for (index = 0; index < fdt->maxfd; index++)
+    {
+        /* the table may be expanded, read it in lock */
+        level = rt_hw_interrupt_disable();
+        fd = index < fdt->maxfd ? fdt->fds[index] : NULL;
+        if (fd != NULL && fd->fs == fs)
+        {
+            rt_hw_interrupt_enable(level);
+            return RT_TRUE;
+        }
+        rt_hw_interrupt_enable(level);
+    }
+
+    return RT_FALSE;
+}
+
+/**
+ * @ingroup Fd
+ *
+ * This function will return whether any file descriptor refers to a file
+ * system, which can't be unmounted then.
+ *
+ * @param fs the file system.
+ *
+ * @return RT_TRUE if the file system is in use, RT_FALSE otherwise.
+ */
+rt_bool_t fd_fs_in_use(struct dfs_filesystem *fs)
+{
+    struct dfs_fdtable *fdt;
+
+    if (fd_table_uses_fs(&_fdtab, fs))
+        return RT_TRUE;
+
+    /* the table of current process */
+    fdt = dfs_fdtable_get();
+    if (fdt != &_fdtab && fd_table_uses_fs(fdt, fs))
+        return RT_TRUE;
+
+    return RT_FALSE;
 }
 
 /**
@@ -0,0 +1,392 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Dentry cache of path lookup.
+ *
+ * The result of looking up a path in file system is cached by the file system
+ * and the path in it: the stat of an existing file, or a negative entry for
+ * the path doesn't exist. The entries are invalidated when the file is
+ * created, unlinked or renamed, synced or closed after written, and when the
+ * file system is unmounted. The entry of parent directory is invalidated too
+ * when a file is created, unlinked or renamed in it. The file system with DFS_FS_FLAG_REMOTE is not
+ * cached, the files in it can be changed by others, neither is the one with
+ * DFS_FS_FLAG_STREAM such as devfs.
+ *
+ * A lookup missed records the generation of cache, which is increased by
+ * every invalidation, the result is not inserted if the path may be changed
+ * during the file system lookup.
+ */
+
+#include <rtthread.h>
+#include <dfs.h>
+#include <dfs_fs.h>
+#include <dfs_dcache.h>
+#include "dfs_private.h"
+
+#define DCACHE_HASH_SIZE    32
+
+struct dfs_dentry
+{
+    rt_list_t hash_node;
+    rt_list_t lru_node;
+
+    struct dfs_filesystem *fs;      /* NULL for free entry */
+    char *path;
+    rt_uint32_t hash;
+
+    int result;                     /* 0 or -ENOENT */
+    struct stat stat;
+};
+
+static struct rt_mutex dcache_lock;
+static struct dfs_dentry dcache_entries[DFS_DCACHE_SIZE];
+static rt_list_t dcache_hash[DCACHE_HASH_SIZE];
+static rt_list_t dcache_lru;        /* the most recently used is at head */
+static rt_uint32_t dcache_generation;
+static struct dfs_dcache_stat dcache_stat;
+
+static rt_uint32_t dcache_hash_path(struct dfs_filesystem *fs, const char *path)
+{
+    rt_uint32_t hash = (rt_uint32_t)(rt_ubase_t)fs;
+
+    while (*path)
+        hash = hash * 31 + (rt_uint8_t)*path++;
+
+    return hash;
+}
+
+static struct dfs_dentry *dcache_find(struct dfs_filesystem *fs, const char *path,
+                                      rt_uint32_t hash)
+{
+    rt_list_t *node;
+
+    rt_list_for_each(node, &dcache_hash[hash % DCACHE_HASH_SIZE])
+    {
+        struct dfs_dentry *dentry = rt_list_entry(node, struct dfs_dentry, hash_node);
+
+        if (dentry->hash == hash && dentry->fs == fs && strcmp(dentry->path, path) == 0)
+            return dentry;
+    }
+
+    return RT_NULL;
+}
+
+/* free the entry and put it at the tail of LRU for reusing */
+static void dcache_remove(struct dfs_dentry *dentry)
+{
+    rt_list_remove(&(dentry->hash_node));
+    rt_list_remove(&(dentry->lru_node));
+    rt_list_insert_before(&dcache_lru, &(dentry->lru_node));
+
+    rt_free(dentry->path);
+    dentry->path = RT_NULL;
+    dentry->fs = RT_NULL;
+    dcache_stat.entries --;
+}
+
+/* the path is in the subtree of the directory */
+static rt_bool_t dcache_path_under(const char *path, const char *dir)
+{
+    size_t len = strlen(dir);
+
+    /* the root directory of file system */
+    if (len == 1 && dir[0] == '/')
+        return RT_TRUE;
+
+    return strncmp(path, dir, len) == 0 && (path[len] == '\0' || path[len] == '/');
+}
+
+/**
+ * this function will initialize the dentry cache.
+ *
+ * @return 0 on successful.
+ */
+int dfs_dcache_init(void)
+{
+    int index;
+
+    rt_mutex_init(&dcache_lock, "dcache", RT_IPC_FLAG_FIFO);
+    for (index = 0; index < DCACHE_HASH_SIZE; index ++)
+        rt_list_init(&dcache_hash[index]);
+
+    rt_list_init(&dcache_lru);
+    for (index = 0; index < DFS_DCACHE_SIZE; index ++)
+    {
+        rt_memset(&dcache_entries[index], 0, sizeof(struct dfs_dentry));
+        rt_list_init(&(dcache_entries[index].hash_node));
+        rt_list_insert_before(&dcache_lru, &(dcache_entries[index].lru_node));
+    }
+
+    dcache_generation = 0;
+    rt_memset(&dcache_stat, 0, sizeof(dcache_stat));
+
+    return 0;
+}
+
+/**
+ * this function will look up a path in the dentry cache.
+ *
+ * @param fs the file system of path.
+ * @param path the path in file system.
+ * @param buf the buffer to save the stat of file, it can be NULL.
+ * @param result the result of looking up in file system, 0 or -ENOENT.
+ *
+ * @return RT_TRUE if the path is cached, otherwise RT_FALSE.
+ */
+rt_bool_t dfs_dcache_lookup(struct dfs_filesystem *fs, const char *path,
+                            struct stat *buf, int *result)
+{
+    rt_uint32_t hash;
+    struct dfs_dentry *dentry;
+
+    /* the remote file system keeps its own cache, and the stream file system
+     * such as devfs changes the state of files itself */
+    if (fs->ops->flags & (DFS_FS_FLAG_REMOTE | DFS_FS_FLAG_STREAM))
+        return RT_FALSE;
+
+    hash = dcache_hash_path(fs, path);
+
+    rt_mutex_take(&dcache_lock, RT_WAITING_FOREVER);
+    dentry = dcache_find(fs, path, hash);
+    if (dentry == RT_NULL)
+    {
+        dcache_stat.miss ++;
+        rt_mutex_release(&dcache_lock);
+
+        return RT_FALSE;
+    }
+
+    rt_list_remove(&(dentry->lru_node));
+    rt_list_insert_after(&dcache_lru, &(dentry->lru_node));
+
+    *result = dentry->result;
+    if (dentry->result == 0)
+    {
+        if (buf != RT_NULL)
+            *buf = dentry->stat;
+        dcache_stat.hit ++;
+    }
+    else
+    {
+        dcache_stat.negative ++;
+    }
+    rt_mutex_release(&dcache_lock);
+
+    return RT_TRUE;
+}
+
+/**
+ * this function will return the generation of dentry cache, which shall be
+ * got before looking up the path in file system.
+ *
+ * @return the generation of dentry cache.
+ */
+rt_uint32_t dfs_dcache_generation(void)
+{
+    rt_uint32_t generation;
+
+    rt_mutex_take(&dcache_lock, RT_WAITING_FOREVER);
+    generation = dcache_generation;
+    rt_mutex_release(&dcache_lock);
+
+    return generation;
+}
+
+/**
+ * this function will insert the result of looking up a path to dentry cache.
+ *
+ * @param fs the file system of path.
+ * @param path the path in file system.
+ * @param buf the stat of file, NULL for the path doesn't exist.
+ * @param generation the generation of dentry cache before looking up.
+ */
+void dfs_dcache_insert(struct dfs_filesystem *fs, const char *path,
+                       const struct stat *buf, rt_uint32_t generation)
+{
+    char *name;
+    rt_uint32_t hash;
+    struct dfs_dentry *dentry;
+
+    if (fs->ops->flags & (DFS_FS_FLAG_REMOTE | DFS_FS_FLAG_STREAM))
+        return;
+
+    name = rt_strdup(path);
+    if (name == RT_NULL)
+        return;
+    hash = dcache_hash_path(fs, path);
+
+    rt_mutex_take(&dcache_lock, RT_WAITING_FOREVER);
+    /* the path may be changed during looking up */
+    if (generation != dcache_generation)
+    {
+        rt_mutex_release(&dcache_lock);
+        rt_free(name);
+
+        return;
+    }
+
+    dentry = dcache_find(fs, path, hash);
+    if (dentry == RT_NULL)
+    {
+        /* reuse the least recently used entry */
+        dentry = rt_list_entry(dcache_lru.prev, struct dfs_dentry, lru_node);
+        if (dentry->fs != RT_NULL)
+            dcache_remove(dentry);
+
+        dentry->fs = fs;
+        dentry->path = name;
+        dentry->hash = hash;
+        rt_list_insert_after(&dcache_hash[hash % DCACHE_HASH_SIZE], &(dentry->hash_node));
+        dcache_stat.entries ++;
+        name = RT_NULL;
+    }
+
+    rt_list_remove(&(dentry->lru_node));
+    rt_list_insert_after(&dcache_lru, &(dentry->lru_node));
+
+    if (buf != RT_NULL)
+    {
+        dentry->result = 0;
+        dentry->stat = *buf;
+    }
+    else
+    {
+        dentry->result = -ENOENT;
+    }
+    rt_mutex_release(&dcache_lock);
+
+    rt_free(name);
+}
+
+/**
+ * this function will invalidate the cached entries of a path.
+ *
+ * @param fs the file system of path.
+ * @param path the path in file system.
+ * @param subtree RT_TRUE to invalidate the entries under the path too.
+ */
+void dfs_dcache_invalidate(struct dfs_filesystem *fs, const char *path, rt_bool_t subtree)
+{
+    int index;
+    struct dfs_dentry *dentry;
+
+    rt_mutex_take(&dcache_lock, RT_WAITING_FOREVER);
+    dcache_generation ++;
+
+    if (!subtree)
+    {
+        dentry = dcache_find(fs, path, dcache_hash_path(fs, path));
+        if (dentry != RT_NULL)
+            dcache_remove(dentry);
+    }
+    else
+    {
+        for (index = 0; index < DFS_DCACHE_SIZE; index ++)
+        {
+            dentry = &dcache_entries[index];
+            if (dentry->fs == fs && dcache_path_under(dentry->path, path))
+                dcache_remove(dentry);
+        }
+    }
+    rt_mutex_release(&dcache_lock);
+}
+
+/**
+ * this function will invalidate the cached entry of the parent directory of a
+ * path, whose entries are changed.
+ *
+ * @param fs the file system of path.
+ * @param path the path in file system.
+ */
+void dfs_dcache_invalidate_parent(struct dfs_filesystem *fs, const char *path)
+{
+    char *parent, *name;
+    struct dfs_dentry *dentry;
+
+    parent = rt_strdup(path);
+    if (parent == RT_NULL)
+    {
+        /* drop all the entries of file system */
+        dfs_dcache_invalidate_fs(fs);
+        return;
+    }
+
+    name = strrchr(parent, '/');
+    if (name == RT_NULL || (name == parent && name[1] == '\0'))
+    {
+        /* no parent of the root directory */
+        rt_free(parent);
+        return;
+    }
+    if (name == parent)
+        name ++;
+    *name = '\0';
+
+    rt_mutex_take(&dcache_lock, RT_WAITING_FOREVER);
+    dcache_generation ++;
+
+    dentry = dcache_find(fs, parent, dcache_hash_path(fs, parent));
+    if (dentry != RT_NULL)
+        dcache_remove(dentry);
+    rt_mutex_release(&dcache_lock);
+
+    rt_free(parent);
+}
+
+/**
+ * this function will invalidate all the cached entries of a file system.
+ *
+ * @param fs the file system, NULL for all file systems.
+ */
+void dfs_dcache_invalidate_fs(struct dfs_filesystem *fs)
+{
+    int index;
+    struct dfs_dentry *dentry;
+
+    rt_mutex_take(&dcache_lock, RT_WAITING_FOREVER);
+    dcache_generation ++;
+
+    for (index = 0; index < DFS_DCACHE_SIZE; index ++)
+    {
+        dentry = &dcache_entries[index];
+        if (dentry->fs != RT_NULL && (fs == RT_NULL || dentry->fs == fs))
+            dcache_remove(dentry);
+    }
+    rt_mutex_release(&dcache_lock);
+}
+
+/**
+ * this function will get the statistics of dentry cache.
+ *
+ * @param stat the buffer to save the statistics.
+ */
+void dfs_dcache_stat_get(struct dfs_dcache_stat *stat)
+{
+    rt_mutex_take(&dcache_lock, RT_WAITING_FOREVER);
+    *stat = dcache_stat;
+    rt_mutex_release(&dcache_lock);
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+int list_dcache(void)
+{
+    struct dfs_dcache_stat stat;
+
+    dfs_dcache_stat_get(&stat);
+
+    rt_kprintf("entries  : %d/%d\n", stat.entries, DFS_DCACHE_SIZE);
+    rt_kprintf("hit      : %d\n", stat.hit);
+    rt_kprintf("negative : %d\n", stat.negative);
+    rt_kprintf("miss     : %d\n", stat.miss);
+
+    return 0;
+}
+FINSH_FUNCTION_EXPORT(list_dcache, list dentry cache statistics);
+MSH_CMD_EXPORT(list_dcache, list dentry cache statistics);
+#endif
@@ -24,9 +24,20 @@
  * 2015-05-27     Bernard      Fix the fd clear issue.
  */
 
+#include <rthw.h>
 #include <dfs.h>
 #include <dfs_file.h>
 #include <dfs_private.h>
+#ifdef RT_USING_DFS_PAGECACHE
+#include <dfs_pcache.h>
+#endif
+#ifdef RT_USING_DFS_DCACHE
+#include <dfs_dcache.h>
+#endif
+
+#ifndef DFS_COPY_BUFSZ
+#define DFS_COPY_BUFSZ      4096
+#endif
 
 /**
  * @addtogroup FileApi
@@ -48,6 +59,9 @@ int dfs_file_open(struct dfs_fd *fd, const char *path, int flags)
     struct dfs_filesystem *fs;
     char *fullpath;
     int result;
+#ifdef RT_USING_DFS_DCACHE
+    rt_uint32_t generation;
+#endif
 
     /* parameter check */
     if (fd == NULL)
@@ -84,10 +98,14 @@ int dfs_file_open(struct dfs_fd *fd, const char *path, int flags)
 
     /* initialize the fd item */
     fd->type  = FT_REGULAR;
-    fd->flags = flags;
+    fd->flags = flags & ~DFS_F_POS_LOCK;
     fd->size  = 0;
     fd->pos   = 0;
     fd->data  = fs;
+    fd->fs    = fs;
+#ifdef RT_USING_DFS_PAGECACHE
+    fd->pcache = NULL;
+#endif
 
     if (!(fs->ops->flags & DFS_FS_FLAG_FULLPATH))
     {
@@ -109,34 +127,80 @@ int dfs_file_open(struct dfs_fd *fd, const char *path, int flags)
         /* clear fd */
         rt_free(fd->path);
         fd->path = NULL;
+        fd->fs = NULL;
 
         return -ENOSYS;
     }
 
-    if ((result = fd->fops->open(fd)) < 0)
+#ifdef RT_USING_DFS_DCACHE
+    /* the path is known to be not existing */
+    if (!(flags & O_CREAT) && dfs_dcache_lookup(fs, fd->path, NULL, &result) &&
+        result == -ENOENT)
+    {
+        rt_free(fd->path);
+        fd->path = NULL;
+        fd->fs = NULL;
+
+        return -ENOENT;
+    }
+    generation = dfs_dcache_generation();
+#endif
+
+    result = dfs_fs_lock(fs);
+    if (result == 0)
+    {
+        result = fd->fops->open(fd);
+        dfs_fs_unlock(fs);
+    }
+
+#ifdef RT_USING_DFS_DCACHE
+    if (flags & O_CREAT)
+        dfs_dcache_invalidate_parent(fs, fd->path);
+    if (flags & (O_CREAT | O_TRUNC))
+        dfs_dcache_invalidate(fs, fd->path, RT_FALSE);
+    else if (result == -ENOENT)
+        dfs_dcache_insert(fs, fd->path, NULL, generation);
+#endif
+
+    if (result < 0)
     {
         /* clear fd */
         rt_free(fd->path);
         fd->path = NULL;
+        fd->fs = NULL;
 
         dbg_log(DBG_ERROR, "open failed\n");
 
         return result;
     }
 
+    if (DFS_FD_POS_LOCKED(fd))
+    {
+        rt_mutex_init(&(fd->pos_lock), "fdpos", RT_IPC_FLAG_FIFO);
+        fd->flags |= DFS_F_POS_LOCK;
+    }
+
     fd->flags |= DFS_F_OPEN;
     if (flags & O_DIRECTORY)
     {
         fd->type = FT_DIRECTORY;
         fd->flags |= DFS_F_DIRECTORY;
     }
+#ifdef RT_USING_DFS_PAGECACHE
+    else if (DFS_FD_POS_LOCKED(fd) && !(fs->ops->flags & DFS_FS_FLAG_REMOTE))
+    {
+        /* the file is not cached on failure */
+        dfs_pcache_open(fd);
+    }
+#endif
 
     dbg_log(DBG_INFO, "open successful\n");
     return 0;
 }
 
 /**
- * this function will close a file descriptor.
+ * this function will close a file descriptor. The file operations in progress
+ * are finished before closing, and the ones waiting fail with -EBADF.
  *
  * @param fd the file descriptor to be closed.
  *
@@ -149,15 +213,57 @@ int dfs_file_close(struct dfs_fd *fd)
     if (fd == NULL)
         return -ENXIO;
 
+    result = dfs_fd_lock(fd);
+    if (result < 0)
+        return result;
+
+#ifdef RT_USING_POSIX
+    /* remove it from the interest list of epoll */
+    dfs_epoll_file_release(fd);
+#endif
+
     if (fd->fops->close != NULL)
-        result = fd->fops->close(fd);
+    {
+        result = dfs_fs_lock(fd->fs);
+        if (result == 0)
+        {
+            result = fd->fops->close(fd);
+            dfs_fs_unlock(fd->fs);
+        }
+    }
 
     /* close fd error, return */
     if (result < 0)
+    {
+        dfs_fd_unlock(fd);
         return result;
+    }
+
+#ifdef RT_USING_DFS_PAGECACHE
+    /* the data is written back through the handle of page cache, which is
+     * closed after this opening to leave the final state of file */
+    if (fd->pcache != NULL && dfs_pcache_close(fd) < 0)
+        dbg_log(DBG_ERROR, "write back failed, the data is lost\n");
+#endif
+
+#ifdef RT_USING_DFS_DCACHE
+    /* the size and time of file are changed */
+    if (fd->fs != NULL && (fd->flags & O_ACCMODE) != O_RDONLY)
+        dfs_dcache_invalidate(fd->fs, fd->path, RT_FALSE);
+#endif
+
+    fd->fs = NULL;
 
     rt_free(fd->path);
     fd->path = NULL;
+    dfs_fd_unlock(fd);
+
+    /* the position lock of the file in fd table is detached on freeing */
+    if (fd->magic != DFS_FD_MAGIC && (fd->flags & DFS_F_POS_LOCK))
+    {
+        rt_mutex_detach(&(fd->pos_lock));
+        fd->flags &= ~DFS_F_POS_LOCK;
+    }
 
     return result;
 }
@@ -197,7 +303,18 @@ int dfs_file_ioctl(struct dfs_fd *fd, int cmd, void *args)
     }
 
     if (fd->fops->ioctl != NULL)
-        return fd->fops->ioctl(fd, cmd, args);
+    {
+        int result;
+
+        result = dfs_fs_lock(fd->fs);
+        if (result == 0)
+        {
+            result = fd->fops->ioctl(fd, cmd, args);
+            dfs_fs_unlock(fd->fs);
+        }
+
+        return result;
+    }
 
     return -ENOSYS;
 }
@@ -222,8 +339,27 @@ int dfs_file_read(struct dfs_fd *fd, void *buf, size_t len)
     if (fd->fops->read == NULL)
         return -ENOSYS;
 
-    if ((result = fd->fops->read(fd, buf, len)) < 0)
-        fd->flags |= DFS_F_EOF;
+    result = dfs_fd_lock(fd);
+    if (result < 0)
+        return result;
+#ifdef RT_USING_DFS_PAGECACHE
+    if (fd->pcache != NULL)
+    {
+        if ((result = dfs_pcache_read(fd, buf, len)) < 0)
+            fd->flags |= DFS_F_EOF;
+        dfs_fd_unlock(fd);
+
+        return result;
+    }
+#endif
+    result = dfs_fs_lock(fd->fs);
+    if (result == 0)
+    {
+        if ((result = fd->fops->read(fd, buf, len)) < 0)
+            fd->flags |= DFS_F_EOF;
+        dfs_fs_unlock(fd->fs);
+    }
+    dfs_fd_unlock(fd);
 
     return result;
 }
@@ -244,7 +380,22 @@ int dfs_file_getdents(struct dfs_fd *fd, struct dirent *dirp, size_t nbytes)
         return -EINVAL;
 
     if (fd->fops->getdents != NULL)
-        return fd->fops->getdents(fd, dirp, nbytes);
+    {
+        int result;
+
+        result = dfs_fd_lock(fd);
+        if (result < 0)
+            return result;
+        result = dfs_fs_lock(fd->fs);
+        if (result == 0)
+        {
+            result = fd->fops->getdents(fd, dirp, nbytes);
+            dfs_fs_unlock(fd->fs);
+        }
+        dfs_fd_unlock(fd);
+
+        return result;
+    }
 
     return -ENOSYS;
 }
@@ -285,15 +436,32 @@ int dfs_file_unlink(const char *path)
 
     if (fs->ops->unlink != NULL)
     {
+        const char *subpath;
+
         if (!(fs->ops->flags & DFS_FS_FLAG_FULLPATH))
         {
             if (dfs_subdir(fs->path, fullpath) == NULL)
-                result = fs->ops->unlink(fs, "/");
+                subpath = "/";
             else
-                result = fs->ops->unlink(fs, dfs_subdir(fs->path, fullpath));
+                subpath = dfs_subdir(fs->path, fullpath);
         }
         else
-            result = fs->ops->unlink(fs, fullpath);
+            subpath = fullpath;
+
+        result = dfs_fs_lock(fs);
+        if (result == 0)
+        {
+            result = fs->ops->unlink(fs, subpath);
+            dfs_fs_unlock(fs);
+        }
+#ifdef RT_USING_DFS_DCACHE
+        dfs_dcache_invalidate_parent(fs, subpath);
+        dfs_dcache_invalidate(fs, subpath, RT_TRUE);
+#endif
+#ifdef RT_USING_DFS_PAGECACHE
+        if (result == 0)
+            dfs_pcache_invalidate(fs, subpath);
+#endif
     }
     else result = -ENOSYS;
 
@@ -313,13 +481,40 @@ __exit:
  */
 int dfs_file_write(struct dfs_fd *fd, const void *buf, size_t len)
 {
+    int result;
+
     if (fd == NULL)
         return -EINVAL;
 
     if (fd->fops->write == NULL)
         return -ENOSYS;
 
-    return fd->fops->write(fd, buf, len);
+    result = dfs_fd_lock(fd);
+    if (result < 0)
+        return result;
+#ifdef RT_USING_DFS_PAGECACHE
+    if (fd->pcache != NULL)
+    {
+        result = dfs_pcache_write(fd, buf, len);
+    }
+    else
+#endif
+    {
+        result = dfs_fs_lock(fd->fs);
+        if (result == 0)
+        {
+            result = fd->fops->write(fd, buf, len);
+            dfs_fs_unlock(fd->fs);
+        }
+    }
+#ifdef RT_USING_DFS_DCACHE
+    /* the dentry is invalidated once on fsync or close */
+    if (result > 0)
+        fd->flags |= DFS_F_DIRTY;
+#endif
+    dfs_fd_unlock(fd);
+
+    return result;
 }
 
 /**
@@ -331,13 +526,40 @@ int dfs_file_write(struct dfs_fd *fd, const void *buf, size_t len)
  */
 int dfs_file_flush(struct dfs_fd *fd)
 {
+    int result = -ENOSYS;
+
     if (fd == NULL)
         return -EINVAL;
 
-    if (fd->fops->flush == NULL)
-        return -ENOSYS;
+#ifdef RT_USING_DFS_PAGECACHE
+    if (fd->pcache != NULL)
+    {
+        result = dfs_pcache_flush(fd);
+        if (result < 0)
+            return result;
+    }
+#endif
+
+    if (fd->fops->flush != NULL)
+    {
+        result = dfs_fs_lock(fd->fs);
+        if (result == 0)
+        {
+            result = fd->fops->flush(fd);
+            dfs_fs_unlock(fd->fs);
+        }
+    }
+
+#ifdef RT_USING_DFS_DCACHE
+    /* the size and time of file are changed by writing */
+    if (fd->fs != NULL && (fd->flags & DFS_F_DIRTY))
+    {
+        fd->flags &= ~DFS_F_DIRTY;
+        dfs_dcache_invalidate(fd->fs, fd->path, RT_FALSE);
+    }
+#endif
 
-    return fd->fops->flush(fd);
+    return result;
 }
 
 /**
@@ -358,15 +580,230 @@ int dfs_file_lseek(struct dfs_fd *fd, off_t offset)
     if (fd->fops->lseek == NULL)
         return -ENOSYS;
 
-    result = fd->fops->lseek(fd, offset);
+    result = dfs_fd_lock(fd);
+    if (result < 0)
+        return result;
+#ifdef RT_USING_DFS_PAGECACHE
+    if (fd->pcache != NULL)
+    {
+        result = dfs_pcache_lseek(fd, offset);
+        dfs_fd_unlock(fd);
+
+        return result;
+    }
+#endif
+    result = dfs_fs_lock(fd->fs);
+    if (result == 0)
+    {
+        result = fd->fops->lseek(fd, offset);
+
+        /* update current position */
+        if (result >= 0)
+            fd->pos = result;
+        dfs_fs_unlock(fd->fs);
+    }
+    dfs_fd_unlock(fd);
+
+    return result;
+}
 
-    /* update current position */
+/* read or write at the offset, the position is restored under its lock, which
+ * is recursive for the file operations */
+static int dfs_file_pio(struct dfs_fd *fd, void *buf, size_t len, off_t offset,
+                        rt_bool_t write)
+{
+    int result;
+    off_t pos;
+
+    if (fd == NULL)
+        return -EINVAL;
+
+    result = dfs_fd_lock(fd);
+    if (result < 0)
+        return result;
+
+    pos = fd->pos;
+    result = dfs_file_lseek(fd, offset);
     if (result >= 0)
-        fd->pos = result;
+    {
+        if (write)
+            result = dfs_file_write(fd, buf, len);
+        else
+            result = dfs_file_read(fd, buf, len);
+    }
+    dfs_file_lseek(fd, pos);
+    dfs_fd_unlock(fd);
 
     return result;
 }
 
+/**
+ * this function will read data from a file at the offset without changing the
+ * file position.
+ *
+ * @param fd the file descriptor.
+ * @param buf the buffer to save the read data.
+ * @param len the length of data buffer to be read.
+ * @param offset the offset in file.
+ *
+ * @return the actual read data bytes or 0 on end of file or failed.
+ */
+int dfs_file_pread(struct dfs_fd *fd, void *buf, size_t len, off_t offset)
+{
+    return dfs_file_pio(fd, buf, len, offset, RT_FALSE);
+}
+
+/**
+ * this function will write data to a file at the offset without changing the
+ * file position.
+ *
+ * @param fd the file descriptor.
+ * @param buf the data buffer to be written.
+ * @param len the data buffer length.
+ * @param offset the offset in file.
+ *
+ * @return the actual written data length.
+ */
+int dfs_file_pwrite(struct dfs_fd *fd, const void *buf, size_t len, off_t offset)
+{
+    return dfs_file_pio(fd, (void *)buf, len, offset, RT_TRUE);
+}
+
+/* the bounce buffer is cached for the next copy */
+static void *copy_buffer = NULL;
+
+static void *dfs_copy_buffer_get(void)
+{
+    void *buffer;
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    buffer = copy_buffer;
+    copy_buffer = NULL;
+    rt_hw_interrupt_enable(level);
+
+    /* it's in use by another copy */
+    if (buffer == NULL)
+        buffer = rt_malloc_align(DFS_COPY_BUFSZ, RT_CPU_CACHE_LINE_SZ);
+
+    return buffer;
+}
+
+static void dfs_copy_buffer_put(void *buffer)
+{
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    if (copy_buffer == NULL)
+    {
+        copy_buffer = buffer;
+        buffer = NULL;
+    }
+    rt_hw_interrupt_enable(level);
+
+    if (buffer)
+        rt_free_align(buffer);
+}
+
+/**
+ * this function will copy data from a file to another file at their current
+ * positions. The copy_range of file system is used if both files are on the
+ * same file system, otherwise the data is copied through a bounce
+ * buffer with the reading aligned to the buffer size.
+ *
+ * @param fd_in the file descriptor to read data from.
+ * @param fd_out the file descriptor to write data to.
+ * @param len the maximal number of bytes to copy.
+ *
+ * @return the number of bytes copied, 0 on end-of-file, or error code.
+ */
+int dfs_file_copy_range(struct dfs_fd *fd_in, struct dfs_fd *fd_out, size_t len)
+{
+    int result = 0, length;
+    size_t total = 0, chunk;
+    rt_uint8_t *buffer;
+
+    if (fd_in == NULL || fd_out == NULL)
+        return -EINVAL;
+
+    if (fd_in->fops->read == NULL || fd_out->fops->write == NULL)
+        return -ENOSYS;
+
+    if (fd_in->fs != NULL && fd_in->fs == fd_out->fs &&
+        fd_in->fops->copy_range != NULL && fd_in != fd_out
+#ifdef RT_USING_DFS_PAGECACHE
+        /* the cached data is copied through the page cache */
+        && fd_in->pcache == NULL && fd_out->pcache == NULL
+#endif
+        )
+    {
+        struct dfs_fd *first, *second;
+
+        /* lock the file positions in order of address */
+        first  = fd_in < fd_out ? fd_in : fd_out;
+        second = fd_in < fd_out ? fd_out : fd_in;
+
+        result = dfs_fd_lock(first);
+        if (result < 0)
+            return result;
+        result = dfs_fd_lock(second);
+        if (result < 0)
+        {
+            dfs_fd_unlock(first);
+            return result;
+        }
+        result = dfs_fs_lock(fd_in->fs);
+        if (result == 0)
+        {
+            result = fd_in->fops->copy_range(fd_in, fd_out, len);
+            dfs_fs_unlock(fd_in->fs);
+        }
+        dfs_fd_unlock(second);
+        dfs_fd_unlock(first);
+
+        if (result != -ENOSYS)
+            return result;
+    }
+
+    buffer = dfs_copy_buffer_get();
+    if (buffer == NULL)
+        return -ENOMEM;
+
+    while (total < len)
+    {
+        /* the following readings are whole blocks once the first one is
+         * aligned, which are transferred by the storage device directly */
+        chunk = DFS_COPY_BUFSZ - (fd_in->pos % DFS_COPY_BUFSZ);
+        if (chunk > len - total)
+            chunk = len - total;
+
+        result = dfs_file_read(fd_in, buffer, chunk);
+        if (result <= 0)
+            break;
+
+        length = dfs_file_write(fd_out, buffer, result);
+        if (length != result)
+        {
+            /* give back the data which is not written */
+            dfs_file_lseek(fd_in, fd_in->pos - (length > 0 ? result - length : result));
+
+            if (length > 0)
+                total += length;
+            result = length;
+            break;
+        }
+        total += length;
+
+        /* end-of-file */
+        if ((size_t)result < chunk)
+            break;
+    }
+
+    dfs_copy_buffer_put(buffer);
+
+    return total ? total : result;
+}
+
 /**
  * this function will get file information.
  *
@@ -379,7 +816,11 @@ int dfs_file_stat(const char *path, struct stat *buf)
 {
     int result;
     char *fullpath;
+    const char *subpath;
     struct dfs_filesystem *fs;
+#ifdef RT_USING_DFS_DCACHE
+    rt_uint32_t generation;
+#endif
 
     fullpath = dfs_normalize_path(NULL, path);
     if (fullpath == NULL)
@@ -427,9 +868,33 @@ int dfs_file_stat(const char *path, struct stat *buf)
 
         /* get the real file path and get file stat */
         if (fs->ops->flags & DFS_FS_FLAG_FULLPATH)
-            result = fs->ops->stat(fs, fullpath, buf);
+            subpath = fullpath;
         else
-            result = fs->ops->stat(fs, dfs_subdir(fs->path, fullpath), buf);
+            subpath = dfs_subdir(fs->path, fullpath);
+
+#ifdef RT_USING_DFS_DCACHE
+        if (dfs_dcache_lookup(fs, subpath, buf, &result))
+        {
+            rt_free(fullpath);
+
+            return result;
+        }
+        generation = dfs_dcache_generation();
+#endif
+
+        result = dfs_fs_lock(fs);
+        if (result == 0)
+        {
+            result = fs->ops->stat(fs, subpath, buf);
+            dfs_fs_unlock(fs);
+        }
+
+#ifdef RT_USING_DFS_DCACHE
+        if (result == 0)
+            dfs_dcache_insert(fs, subpath, buf, generation);
+        else if (result == -ENOENT)
+            dfs_dcache_insert(fs, subpath, NULL, generation);
+#endif
     }
 
     rt_free(fullpath);
@@ -480,13 +945,39 @@ int dfs_file_rename(const char *oldpath, const char *newpath)
         }
         else
         {
+            const char *oldsubpath, *newsubpath;
+
             if (oldfs->ops->flags & DFS_FS_FLAG_FULLPATH)
-                result = oldfs->ops->rename(oldfs, oldfullpath, newfullpath);
+            {
+                oldsubpath = oldfullpath;
+                newsubpath = newfullpath;
+            }
             else
+            {
                 /* use sub directory to rename in file system */
-                result = oldfs->ops->rename(oldfs,
-                                            dfs_subdir(oldfs->path, oldfullpath),
-                                            dfs_subdir(newfs->path, newfullpath));
+                oldsubpath = dfs_subdir(oldfs->path, oldfullpath);
+                newsubpath = dfs_subdir(newfs->path, newfullpath);
+            }
+
+            result = dfs_fs_lock(oldfs);
+            if (result == 0)
+            {
+                result = oldfs->ops->rename(oldfs, oldsubpath, newsubpath);
+                dfs_fs_unlock(oldfs);
+            }
+#ifdef RT_USING_DFS_DCACHE
+            if (oldsubpath != NULL && newsubpath != NULL)
+            {
+                dfs_dcache_invalidate_parent(oldfs, oldsubpath);
+                dfs_dcache_invalidate_parent(oldfs, newsubpath);
+                dfs_dcache_invalidate(oldfs, oldsubpath, RT_TRUE);
+                dfs_dcache_invalidate(oldfs, newsubpath, RT_TRUE);
+            }
+#endif
+#ifdef RT_USING_DFS_PAGECACHE
+            if (result == 0 && oldsubpath != NULL && newsubpath != NULL)
+                dfs_pcache_rename(oldfs, oldsubpath, newsubpath);
+#endif
         }
     }
     else
@@ -611,31 +1102,21 @@ void cat(const char* filename)
 }
 FINSH_FUNCTION_EXPORT(cat, print file);
 
-#define BUF_SZ  4096
 static void copyfile(const char *src, const char *dst)
 {
     struct dfs_fd src_fd;
-    rt_uint8_t *block_ptr;
-    rt_int32_t read_bytes;
-
-    block_ptr = rt_malloc(BUF_SZ);
-    if (block_ptr == NULL)
-    {
-        rt_kprintf("out of memory\n");
-
-        return;
-    }
+    int length;
 
+    /* not a file in fd table */
+    memset(&src_fd, 0, sizeof(src_fd));
     if (dfs_file_open(&src_fd, src, O_RDONLY) < 0)
     {
-        rt_free(block_ptr);
         rt_kprintf("Read %s failed\n", src);
 
         return;
     }
     if (dfs_file_open(&fd, dst, O_WRONLY | O_CREAT) < 0)
     {
-        rt_free(block_ptr);
         dfs_file_close(&src_fd);
 
         rt_kprintf("Write %s failed\n", dst);
@@ -645,24 +1126,17 @@ static void copyfile(const char *src, const char *dst)
 
     do
     {
-        read_bytes = dfs_file_read(&src_fd, block_ptr, BUF_SZ);
-        if (read_bytes > 0)
+        length = dfs_file_copy_range(&src_fd, &fd, src_fd.size);
+        if (length < 0)
         {
-            int length;
-
-            length = dfs_file_write(&fd, block_ptr, read_bytes);
-            if (length != read_bytes)
-            {
-                /* write failed. */
-                rt_kprintf("Write file data failed, errno=%d\n", length);
-                break;
-            }
+            /* write failed. */
+            rt_kprintf("Write file data failed, errno=%d\n", length);
+            break;
         }
-    } while (read_bytes > 0);
+    } while (length > 0);
 
     dfs_file_close(&src_fd);
     dfs_file_close(&fd);
-    rt_free(block_ptr);
 }
 
 extern int mkdir(const char *path, mode_t mode);
@@ -672,6 +1146,9 @@ static void copydir(const char * src, const char * dst)
     struct stat stat;
     int length;
     struct dfs_fd cpfd;
+
+    /* not a file in fd table */
+    memset(&cpfd, 0, sizeof(cpfd));
     if (dfs_file_open(&cpfd, src, O_DIRECTORY) < 0)
     {
         rt_kprintf("open %s failed\n", src);
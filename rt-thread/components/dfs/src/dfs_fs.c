@@ -28,6 +28,10 @@
 
 #include <dfs_fs.h>
 #include <dfs_file.h>
+#ifdef RT_USING_DFS_DCACHE
+#include <dfs_dcache.h>
+#endif
+#include <dfs_pcache.h>
 #include "dfs_private.h"
 
 /**
@@ -287,6 +291,8 @@ int dfs_mount(const char   *device_name,
     {
         struct dfs_fd fd;
 
+        /* not a file in fd table */
+        memset(&fd, 0, sizeof(fd));
         if (dfs_file_open(&fd, fullpath, O_RDONLY | O_DIRECTORY) < 0)
         {
             rt_free(fullpath);
@@ -326,6 +332,7 @@ int dfs_mount(const char   *device_name,
     fs->path   = fullpath;
     fs->ops    = *ops;
     fs->dev_id = dev_id;
+    rt_mutex_init(&(fs->lock), "fs", RT_IPC_FLAG_FIFO);
     /* release filesystem_table lock */
     dfs_unlock();
 
@@ -337,6 +344,7 @@ int dfs_mount(const char   *device_name,
         {
             /* The underlaying device has error, clear the entry. */
             dfs_lock();
+            rt_mutex_detach(&(fs->lock));
             memset(fs, 0, sizeof(struct dfs_filesystem));
 
             goto err1;
@@ -353,6 +361,7 @@ int dfs_mount(const char   *device_name,
         /* mount failed */
         dfs_lock();
         /* clear filesystem table entry */
+        rt_mutex_detach(&(fs->lock));
         memset(fs, 0, sizeof(struct dfs_filesystem));
 
         goto err1;
@@ -402,12 +411,44 @@ int dfs_unmount(const char *specialfile)
         }
     }
 
-    if (fs == NULL ||
-        fs->ops->unmount == NULL ||
-        fs->ops->unmount(fs) < 0)
+    if (fs == NULL || fs->ops->unmount == NULL)
+    {
+        goto err1;
+    }
+
+    /* the opened files refer to it */
+    if (fd_fs_in_use(fs))
+    {
+        rt_set_errno(-EBUSY);
+        goto err1;
+    }
+
+#ifdef RT_USING_DFS_PAGECACHE
+    /* the cached pages are keyed by the slot of file system table */
+    if (dfs_pcache_invalidate_fs(fs) < 0)
     {
         goto err1;
     }
+#endif
+
+    /* wait for the call in progress into the file system, and check again
+     * for the file opened by it */
+    rt_mutex_take(&(fs->lock), RT_WAITING_FOREVER);
+    if (fd_fs_in_use(fs))
+    {
+        rt_mutex_release(&(fs->lock));
+        rt_set_errno(-EBUSY);
+        goto err1;
+    }
+    if (fs->ops->unmount(fs) < 0)
+    {
+        rt_mutex_release(&(fs->lock));
+        goto err1;
+    }
+
+#ifdef RT_USING_DFS_DCACHE
+    dfs_dcache_invalidate_fs(fs);
+#endif
 
     /* close device, but do not check the status of device */
     if (fs->dev_id != NULL)
@@ -415,8 +456,18 @@ int dfs_unmount(const char *specialfile)
 
     if (fs->path != NULL)
         rt_free(fs->path);
+    fs->path = NULL;
+
+    /* hand the lock over to the waiters, which fail on the unmounted file
+     * system, until nobody is waiting on it */
+    while (!rt_list_isempty(&(fs->lock.parent.suspend_thread)))
+    {
+        rt_mutex_release(&(fs->lock));
+        rt_mutex_take(&(fs->lock), RT_WAITING_FOREVER);
+    }
 
     /* clear this filesystem table entry */
+    rt_mutex_detach(&(fs->lock));
     memset(fs, 0, sizeof(struct dfs_filesystem));
 
     dfs_unlock();
@@ -477,7 +528,18 @@ int dfs_mkfs(const char *fs_name, const char *device_name)
             return -1;
         }
 
+#ifdef RT_USING_DFS_DCACHE
+        {
+            int result = ops->mkfs(dev_id);
+
+            /* the file system mounted on device is not known */
+            dfs_dcache_invalidate_fs(NULL);
+
+            return result;
+        }
+#else
         return ops->mkfs(dev_id);
+#endif
     }
 
     dbg_log(DBG_ERROR, "File system (%s) was not found.\n", fs_name);
@@ -501,7 +563,18 @@ int dfs_statfs(const char *path, struct statfs *buffer)
     if (fs != NULL)
     {
         if (fs->ops->statfs != NULL)
-            return fs->ops->statfs(fs, buffer);
+        {
+            int result;
+
+            result = dfs_fs_lock(fs);
+            if (result == 0)
+            {
+                result = fs->ops->statfs(fs, buffer);
+                dfs_fs_unlock(fs);
+            }
+
+            return result;
+        }
     }
 
     return -1;
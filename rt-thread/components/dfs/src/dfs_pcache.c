@@ -0,0 +1,1321 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Page cache of regular files.
+ *
+ * The data of file is cached in pages of DFS_PAGECACHE_PAGE_SIZE bytes, which
+ * are indexed by (file, offset) in a hash table and kept in a LRU list. The
+ * sequential reading triggers read-ahead in the "pcache" thread, and the
+ * written data is kept in dirty pages which are written back by the thread
+ * periodically, or on fsync(), sync() and close().
+ *
+ * The file system is accessed through a private handle of each cached file,
+ * which is opened for reading and writing whatever the openings are, so the
+ * pages of one opening can be filled and written back for the others.
+ *
+ * Locking order: fd position lock -> file lock -> file system lock -> cache
+ * lock. The cache lock protects the hash table, the lists and the reference
+ * count of pages; a page is only used with the lock of its file held and
+ * pinned, and only the clean pages without pin are reclaimed.
+ */
+
+#include <rtthread.h>
+#include <dfs.h>
+#include <dfs_fs.h>
+#include <dfs_file.h>
+#include <dfs_pcache.h>
+#include "dfs_private.h"
+
+#ifndef DFS_PAGECACHE_THREAD_STACK_SIZE
+#define DFS_PAGECACHE_THREAD_STACK_SIZE     2048
+#endif
+
+#ifndef DFS_PAGECACHE_THREAD_PRIORITY
+#define DFS_PAGECACHE_THREAD_PRIORITY       (RT_THREAD_PRIORITY_MAX - 2)
+#endif
+
+#define PCACHE_HASH_SIZE    64
+#define PCACHE_PAGE_MASK    ((off_t)DFS_PAGECACHE_PAGE_SIZE - 1)
+
+struct dfs_pcache_file
+{
+    rt_list_t list;                 /* node in the file list */
+    rt_list_t pages;                /* pages of file in order of offset */
+    rt_list_t ra_node;              /* node in the read-ahead list */
+
+    struct dfs_filesystem *fs;
+    char *path;
+    int open_count;                 /* the openings attached */
+    struct dfs_fd handle;           /* the private opening of file */
+    struct dfs_fd *fd;              /* the handle while it's opened, NULL
+                                     * after all closed */
+
+    struct rt_mutex lock;
+    int ref_count;
+
+    off_t size;                     /* file size with the dirty data */
+    off_t disk_size;                /* file size on file system */
+    int dirty_count;
+    int error;                      /* the error of last write back */
+
+    off_t ra_next;                  /* the position of next sequential read */
+    int ra_window;                  /* pages to read ahead */
+    off_t ra_offset;                /* the pending read-ahead request */
+    int ra_count;
+};
+
+struct dfs_page
+{
+    rt_list_t hash_node;
+    rt_list_t lru_node;
+    rt_list_t file_node;
+
+    struct dfs_pcache_file *file;
+    off_t offset;                   /* aligned to page size */
+    size_t len;                     /* valid bytes in page */
+    int ref_count;                  /* pinned while it's in use */
+    rt_bool_t dirty;
+
+    rt_uint8_t *data;
+};
+
+static struct rt_mutex pcache_lock;
+static rt_list_t pcache_hash[PCACHE_HASH_SIZE];
+static rt_list_t pcache_lru;        /* the most recently used is at head */
+static rt_list_t pcache_files;
+static rt_list_t pcache_ra_list;
+static struct dfs_pcache_stat pcache_stat;
+
+static struct rt_semaphore pcache_sem;
+static rt_thread_t pcache_thread = RT_NULL;
+
+rt_inline rt_list_t *pcache_bucket(struct dfs_pcache_file *file, off_t offset)
+{
+    rt_ubase_t key;
+
+    key = ((rt_ubase_t)file >> 4) ^ (rt_ubase_t)(offset / DFS_PAGECACHE_PAGE_SIZE);
+
+    return &pcache_hash[key % PCACHE_HASH_SIZE];
+}
+
+rt_inline rt_bool_t pcache_readable(struct dfs_fd *fd)
+{
+    return (fd->flags & O_ACCMODE) != O_WRONLY;
+}
+
+/* release the file, the cache lock shall be held */
+static void pcache_file_release(struct dfs_pcache_file *file)
+{
+    if (file->ref_count > 0 || !rt_list_isempty(&(file->pages)))
+        return;
+
+    rt_list_remove(&(file->list));
+    rt_mutex_detach(&(file->lock));
+    rt_free(file->path);
+    rt_free(file);
+}
+
+static void pcache_file_put(struct dfs_pcache_file *file)
+{
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    file->ref_count --;
+    pcache_file_release(file);
+    rt_mutex_release(&pcache_lock);
+}
+
+/* remove page from the cache, the cache lock shall be held */
+static void pcache_page_remove(struct dfs_page *page)
+{
+    rt_list_remove(&(page->hash_node));
+    rt_list_remove(&(page->lru_node));
+    rt_list_remove(&(page->file_node));
+
+    if (page->dirty)
+    {
+        page->dirty = RT_FALSE;
+        page->file->dirty_count --;
+        pcache_stat.dirty --;
+    }
+    page->file = RT_NULL;
+}
+
+/* find the page and pin it, the counter of statistics is increased if found */
+static struct dfs_page *pcache_page_lookup(struct dfs_pcache_file *file, off_t offset,
+                                           rt_uint32_t *counter)
+{
+    rt_list_t *bucket, *node;
+    struct dfs_page *page;
+
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    bucket = pcache_bucket(file, offset);
+    rt_list_for_each(node, bucket)
+    {
+        page = rt_list_entry(node, struct dfs_page, hash_node);
+        if (page->file == file && page->offset == offset)
+        {
+            /* pin it and move to the head of LRU */
+            page->ref_count ++;
+            rt_list_remove(&(page->lru_node));
+            rt_list_insert_after(&pcache_lru, &(page->lru_node));
+            if (counter != RT_NULL)
+                (*counter) ++;
+            rt_mutex_release(&pcache_lock);
+
+            return page;
+        }
+    }
+    rt_mutex_release(&pcache_lock);
+
+    return RT_NULL;
+}
+
+/* allocate a pinned page, which reclaims the least recently used clean page
+ * when the cache is full. */
+static struct dfs_page *pcache_page_alloc(void)
+{
+    rt_list_t *node;
+    struct dfs_page *page = RT_NULL;
+
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    if (pcache_stat.pages < DFS_PAGECACHE_MAX_PAGES)
+    {
+        page = (struct dfs_page *)rt_malloc(sizeof(struct dfs_page) + DFS_PAGECACHE_PAGE_SIZE);
+        if (page != RT_NULL)
+        {
+            page->data = (rt_uint8_t *)(page + 1);
+            pcache_stat.pages ++;
+        }
+    }
+
+    if (page == RT_NULL)
+    {
+        for (node = pcache_lru.prev; node != &pcache_lru; node = node->prev)
+        {
+            struct dfs_page *victim = rt_list_entry(node, struct dfs_page, lru_node);
+            struct dfs_pcache_file *file = victim->file;
+
+            if (victim->ref_count == 0 && !victim->dirty)
+            {
+                pcache_page_remove(victim);
+                pcache_file_release(file);
+                pcache_stat.evict ++;
+
+                page = victim;
+                break;
+            }
+        }
+    }
+
+    if (page != RT_NULL)
+    {
+        rt_list_init(&(page->hash_node));
+        rt_list_init(&(page->lru_node));
+        rt_list_init(&(page->file_node));
+        page->file = RT_NULL;
+        page->offset = 0;
+        page->len = 0;
+        page->ref_count = 1;
+        page->dirty = RT_FALSE;
+    }
+    rt_mutex_release(&pcache_lock);
+
+    return page;
+}
+
+/* free a page which is not inserted into cache */
+static void pcache_page_free(struct dfs_page *page)
+{
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    pcache_stat.pages --;
+    rt_mutex_release(&pcache_lock);
+
+    rt_free(page);
+}
+
+/* insert the page into cache, the counter of statistics is increased */
+static void pcache_page_insert(struct dfs_pcache_file *file, struct dfs_page *page,
+                               rt_uint32_t *counter)
+{
+    rt_list_t *node;
+
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    if (counter != RT_NULL)
+        (*counter) ++;
+    page->file = file;
+    rt_list_insert_after(pcache_bucket(file, page->offset), &(page->hash_node));
+    rt_list_insert_after(&pcache_lru, &(page->lru_node));
+
+    /* the pages are appended mostly, so search from the tail */
+    for (node = file->pages.prev; node != &(file->pages); node = node->prev)
+    {
+        if (rt_list_entry(node, struct dfs_page, file_node)->offset < page->offset)
+            break;
+    }
+    rt_list_insert_after(node, &(page->file_node));
+    rt_mutex_release(&pcache_lock);
+}
+
+static void pcache_page_put(struct dfs_page *page)
+{
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    page->ref_count --;
+    rt_mutex_release(&pcache_lock);
+}
+
+static void pcache_page_dirty(struct dfs_page *page)
+{
+    rt_bool_t wakeup = RT_FALSE;
+
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    if (!page->dirty)
+    {
+        page->dirty = RT_TRUE;
+        page->file->dirty_count ++;
+        pcache_stat.dirty ++;
+
+        /* start write back before the cache is full of dirty pages */
+        if (pcache_stat.dirty == DFS_PAGECACHE_MAX_PAGES / 2)
+            wakeup = RT_TRUE;
+    }
+    rt_mutex_release(&pcache_lock);
+
+    if (wakeup)
+        rt_sem_release(&pcache_sem);
+}
+
+/* drop the unpinned pages of file in the range [start, end) */
+static void pcache_file_drop(struct dfs_pcache_file *file, off_t start, off_t end)
+{
+    rt_list_t *node, *next;
+
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    rt_list_for_each_safe(node, next, &(file->pages))
+    {
+        struct dfs_page *page = rt_list_entry(node, struct dfs_page, file_node);
+
+        if (page->ref_count == 0 &&
+            page->offset + DFS_PAGECACHE_PAGE_SIZE > start && page->offset < end)
+        {
+            pcache_page_remove(page);
+            pcache_stat.pages --;
+            rt_free(page);
+        }
+    }
+    rt_mutex_release(&pcache_lock);
+}
+
+/* open the private handle of file, the file lock shall be held */
+static int pcache_handle_open(struct dfs_pcache_file *file)
+{
+    int result;
+    struct dfs_fd *fd = &(file->handle);
+
+    /* it's not in the fd table */
+    rt_memset(fd, 0, sizeof(struct dfs_fd));
+    fd->type  = FT_REGULAR;
+    fd->flags = O_RDWR;
+    fd->path  = file->path;
+    fd->fops  = file->fs->ops->fops;
+    fd->data  = file->fs;
+    fd->fs    = file->fs;
+
+    result = dfs_fs_lock(fd->fs);
+    if (result < 0)
+        return result;
+    result = fd->fops->open(fd);
+    dfs_fs_unlock(fd->fs);
+    if (result < 0)
+        return result;
+
+    fd->flags |= DFS_F_OPEN;
+    file->fd = fd;
+
+    return 0;
+}
+
+/* close the private handle of file, the file lock shall be held */
+static void pcache_handle_close(struct dfs_pcache_file *file)
+{
+    struct dfs_fd *fd = file->fd;
+
+    if (fd == RT_NULL)
+        return;
+
+    if (fd->fops->close != RT_NULL && dfs_fs_lock(fd->fs) == 0)
+    {
+        fd->fops->close(fd);
+        dfs_fs_unlock(fd->fs);
+    }
+    file->fd = RT_NULL;
+}
+
+/* commit the written data of handle to file system, the file lock shall be held */
+static int pcache_handle_sync(struct dfs_pcache_file *file)
+{
+    int result = 0;
+    struct dfs_fd *fd = file->fd;
+
+    if (fd->fops->flush == RT_NULL)
+        return 0;
+
+    result = dfs_fs_lock(fd->fs);
+    if (result == 0)
+    {
+        result = fd->fops->flush(fd);
+        dfs_fs_unlock(fd->fs);
+    }
+
+    return result == -ENOSYS ? 0 : result;
+}
+
+/* read or write file on file system at the offset through the handle, the
+ * file lock shall be held, which protects the position of handle */
+static int pcache_io(struct dfs_pcache_file *file, off_t offset, void *buf,
+                     size_t len, rt_bool_t write)
+{
+    int result;
+    struct dfs_fd *fd = file->fd;
+
+    if (fd == RT_NULL)
+        return -EBADF;
+
+    result = dfs_fs_lock(fd->fs);
+    if (result < 0)
+        return result;
+
+    result = fd->fops->lseek(fd, offset);
+    if (result >= 0)
+    {
+        fd->pos = result;
+        if (write)
+            result = fd->fops->write(fd, buf, len);
+        else
+            result = fd->fops->read(fd, buf, len);
+    }
+
+    if (write && result > 0)
+    {
+        file->disk_size = fd->size;
+        if (file->size < file->disk_size)
+            file->size = file->disk_size;
+    }
+    dfs_fs_unlock(fd->fs);
+
+    return result;
+}
+
+/* fill the page from file system, the unused part is cleared */
+static int pcache_page_fill(struct dfs_pcache_file *file, struct dfs_page *page)
+{
+    int result = 0;
+    size_t len;
+
+    if (page->offset < file->disk_size)
+    {
+        len = file->disk_size - page->offset;
+        if (len > DFS_PAGECACHE_PAGE_SIZE)
+            len = DFS_PAGECACHE_PAGE_SIZE;
+
+        result = pcache_io(file, page->offset, page->data, len, RT_FALSE);
+        if (result < 0)
+            return result;
+    }
+
+    page->len = result;
+    rt_memset(page->data + result, 0, DFS_PAGECACHE_PAGE_SIZE - result);
+
+    return 0;
+}
+
+/* get the pinned page of offset, which is filled from file system if it's
+ * not in cache and fill is true. */
+static struct dfs_page *pcache_page_get(struct dfs_pcache_file *file, off_t offset,
+                                        rt_bool_t fill, int *error)
+{
+    struct dfs_page *page;
+
+    page = pcache_page_lookup(file, offset, &pcache_stat.hit);
+    if (page != RT_NULL)
+        return page;
+
+    page = pcache_page_alloc();
+    if (page == RT_NULL)
+        return RT_NULL;
+
+    page->offset = offset;
+    if (fill)
+    {
+        *error = pcache_page_fill(file, page);
+        if (*error < 0)
+        {
+            pcache_page_free(page);
+            return RT_NULL;
+        }
+    }
+    else
+    {
+        rt_memset(page->data, 0, DFS_PAGECACHE_PAGE_SIZE);
+    }
+    pcache_page_insert(file, page, fill ? &pcache_stat.miss : RT_NULL);
+
+    return page;
+}
+
+/* write back the dirty pages in order of offset, the file lock shall be held */
+static int pcache_file_flush(struct dfs_pcache_file *file)
+{
+    int result;
+    size_t len;
+    off_t offset = 0;
+    rt_list_t *node;
+    struct dfs_page *page;
+    rt_bool_t written = RT_FALSE;
+
+    while (file->dirty_count > 0)
+    {
+        page = RT_NULL;
+
+        rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+        rt_list_for_each(node, &(file->pages))
+        {
+            struct dfs_page *p = rt_list_entry(node, struct dfs_page, file_node);
+
+            if (p->dirty && p->offset >= offset)
+            {
+                page = p;
+                page->ref_count ++;
+                break;
+            }
+        }
+        rt_mutex_release(&pcache_lock);
+
+        if (page == RT_NULL)
+            break;
+
+        len = page->len;
+        offset = page->offset + DFS_PAGECACHE_PAGE_SIZE;
+        result = pcache_io(file, page->offset, page->data, len, RT_TRUE);
+        if (result == (int)len)
+        {
+            rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+            page->dirty = RT_FALSE;
+            file->dirty_count --;
+            pcache_stat.dirty --;
+            pcache_stat.writeback ++;
+            rt_mutex_release(&pcache_lock);
+            written = RT_TRUE;
+        }
+        pcache_page_put(page);
+
+        if (result != (int)len)
+        {
+            file->error = result < 0 ? result : -EIO;
+            return file->error;
+        }
+    }
+
+    /* the handle is not left with uncommitted data, which may be stale after
+     * the file is changed by the other openings */
+    if (written)
+    {
+        result = pcache_handle_sync(file);
+        if (result < 0)
+        {
+            file->error = result;
+            return result;
+        }
+    }
+
+    return 0;
+}
+
+static void pcache_readahead(struct dfs_pcache_file *file, off_t offset, int count)
+{
+    int error;
+    struct dfs_page *page;
+
+    for (; count > 0 && offset < file->size; count --, offset += DFS_PAGECACHE_PAGE_SIZE)
+    {
+        page = pcache_page_lookup(file, offset, RT_NULL);
+        if (page == RT_NULL)
+        {
+            page = pcache_page_alloc();
+            if (page == RT_NULL)
+                break;
+
+            page->offset = offset;
+            error = pcache_page_fill(file, page);
+            if (error < 0)
+            {
+                pcache_page_free(page);
+                break;
+            }
+            pcache_page_insert(file, page, &pcache_stat.readahead);
+        }
+        pcache_page_put(page);
+    }
+}
+
+/* request the pages after the sequential reading, the file lock shall be held */
+static void pcache_readahead_request(struct dfs_pcache_file *file, off_t start, off_t end)
+{
+    if (start == file->ra_next)
+    {
+        file->ra_window = file->ra_window ? file->ra_window * 2 : 1;
+        if (file->ra_window > DFS_PAGECACHE_READAHEAD)
+            file->ra_window = DFS_PAGECACHE_READAHEAD;
+    }
+    else
+    {
+        /* random reading */
+        file->ra_window = 0;
+    }
+    file->ra_next = end;
+
+    if (file->ra_window == 0 || pcache_thread == RT_NULL)
+        return;
+
+    file->ra_offset = (end + PCACHE_PAGE_MASK) & ~PCACHE_PAGE_MASK;
+    file->ra_count = file->ra_window;
+    if (file->ra_offset >= file->size)
+        return;
+
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    if (rt_list_isempty(&(file->ra_node)))
+    {
+        file->ref_count ++;
+        rt_list_insert_before(&pcache_ra_list, &(file->ra_node));
+    }
+    rt_mutex_release(&pcache_lock);
+
+    rt_sem_release(&pcache_sem);
+}
+
+static void pcache_thread_entry(void *parameter)
+{
+    rt_list_t *node;
+    struct dfs_pcache_file *file;
+
+    while (1)
+    {
+        rt_sem_take(&pcache_sem, rt_tick_from_millisecond(DFS_PAGECACHE_WRITEBACK_MS));
+
+        /* read ahead */
+        while (1)
+        {
+            rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+            if (rt_list_isempty(&pcache_ra_list))
+            {
+                rt_mutex_release(&pcache_lock);
+                break;
+            }
+            file = rt_list_entry(pcache_ra_list.next, struct dfs_pcache_file, ra_node);
+            rt_list_remove(&(file->ra_node));
+            rt_mutex_release(&pcache_lock);
+
+            rt_mutex_take(&(file->lock), RT_WAITING_FOREVER);
+            if (file->fd != RT_NULL)
+                pcache_readahead(file, file->ra_offset, file->ra_count);
+            rt_mutex_release(&(file->lock));
+
+            pcache_file_put(file);
+        }
+
+        /* write back */
+        while (1)
+        {
+            file = RT_NULL;
+
+            rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+            rt_list_for_each(node, &pcache_files)
+            {
+                struct dfs_pcache_file *f = rt_list_entry(node, struct dfs_pcache_file, list);
+
+                /* the file failed to write back is left to fsync() */
+                if (f->fd != RT_NULL && f->dirty_count > 0 && f->error == 0)
+                {
+                    file = f;
+                    file->ref_count ++;
+                    break;
+                }
+            }
+            rt_mutex_release(&pcache_lock);
+
+            if (file == RT_NULL)
+                break;
+
+            rt_mutex_take(&(file->lock), RT_WAITING_FOREVER);
+            if (file->fd != RT_NULL)
+                pcache_file_flush(file);
+            rt_mutex_release(&(file->lock));
+
+            pcache_file_put(file);
+        }
+    }
+}
+
+/**
+ * this function will initialize the page cache and start the thread of
+ * read-ahead and write-back.
+ *
+ * @return 0 on successful, -1 on failed.
+ */
+int dfs_pcache_init(void)
+{
+    int index;
+
+    rt_mutex_init(&pcache_lock, "pcache", RT_IPC_FLAG_FIFO);
+    for (index = 0; index < PCACHE_HASH_SIZE; index ++)
+        rt_list_init(&pcache_hash[index]);
+    rt_list_init(&pcache_lru);
+    rt_list_init(&pcache_files);
+    rt_list_init(&pcache_ra_list);
+    rt_memset(&pcache_stat, 0, sizeof(pcache_stat));
+
+    rt_sem_init(&pcache_sem, "pcache", 0, RT_IPC_FLAG_FIFO);
+    pcache_thread = rt_thread_create("pcache", pcache_thread_entry, RT_NULL,
+                                     DFS_PAGECACHE_THREAD_STACK_SIZE,
+                                     DFS_PAGECACHE_THREAD_PRIORITY, 10);
+    if (pcache_thread == RT_NULL)
+    {
+        /* the dirty pages are written back on fsync and close only */
+        dbg_log(DBG_ERROR, "create pcache thread failed\n");
+        return -1;
+    }
+    rt_thread_startup(pcache_thread);
+
+    return 0;
+}
+
+/**
+ * this function will attach an opened regular file to the page cache. The
+ * openings of the same file share the cached pages, and the pages of last
+ * opening are reused if the file is not changed. The file is not cached if
+ * its private handle can't be opened.
+ *
+ * @param fd the opened file descriptor.
+ */
+void dfs_pcache_open(struct dfs_fd *fd)
+{
+    rt_list_t *node;
+    struct dfs_pcache_file *file = RT_NULL;
+
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    rt_list_for_each(node, &pcache_files)
+    {
+        struct dfs_pcache_file *f = rt_list_entry(node, struct dfs_pcache_file, list);
+
+        if (f->fs == fd->fs && strcmp(f->path, fd->path) == 0)
+        {
+            file = f;
+            file->ref_count ++;
+            break;
+        }
+    }
+    rt_mutex_release(&pcache_lock);
+
+    if (file == RT_NULL)
+    {
+        file = (struct dfs_pcache_file *)rt_calloc(1, sizeof(struct dfs_pcache_file));
+        if (file == RT_NULL)
+            return;
+        file->path = rt_strdup(fd->path);
+        if (file->path == RT_NULL)
+        {
+            rt_free(file);
+            return;
+        }
+
+        file->fs = fd->fs;
+        file->ref_count = 1;
+        rt_list_init(&(file->pages));
+        rt_list_init(&(file->ra_node));
+        rt_mutex_init(&(file->lock), "pcfile", RT_IPC_FLAG_FIFO);
+
+        rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+        rt_list_insert_after(&pcache_files, &(file->list));
+        rt_mutex_release(&pcache_lock);
+    }
+
+    rt_mutex_take(&(file->lock), RT_WAITING_FOREVER);
+    if (file->fd == RT_NULL)
+    {
+        if (pcache_handle_open(file) < 0)
+        {
+            rt_mutex_release(&(file->lock));
+            pcache_file_put(file);
+            return;
+        }
+
+        /* the file is truncated or changed by others */
+        if ((fd->flags & O_TRUNC) || file->disk_size != (off_t)file->fd->size)
+            pcache_file_drop(file, 0, file->size > file->disk_size ? file->size : file->disk_size);
+
+        file->size = file->disk_size = file->fd->size;
+        file->error = 0;
+        file->ra_next = fd->pos;
+        file->ra_window = 0;
+    }
+    else if (fd->flags & O_TRUNC)
+    {
+        /* the file is truncated under the other openings, reopen the handle
+         * to see the new size, which fails the I/O of them if it can't */
+        pcache_file_drop(file, 0, file->size > file->disk_size ? file->size : file->disk_size);
+        pcache_handle_close(file);
+        pcache_handle_open(file);
+        file->size = file->disk_size = file->fd ? (off_t)file->fd->size : 0;
+    }
+    file->open_count ++;
+    rt_mutex_release(&(file->lock));
+
+    fd->pcache = file;
+}
+
+/**
+ * this function will write back the dirty pages and detach the file from
+ * the page cache. The private handle is closed after the last opening, and
+ * the clean pages are kept for the next opening.
+ *
+ * @param fd the file descriptor to be closed.
+ *
+ * @return 0 on successful, the error of write back on failed.
+ */
+int dfs_pcache_close(struct dfs_fd *fd)
+{
+    int result = 0;
+    struct dfs_pcache_file *file = (struct dfs_pcache_file *)fd->pcache;
+
+    rt_mutex_take(&(file->lock), RT_WAITING_FOREVER);
+    if (file->fd != RT_NULL)
+        result = pcache_file_flush(file);
+
+    file->open_count --;
+    if (file->open_count == 0)
+    {
+        if (result < 0 || file->fd == RT_NULL)
+        {
+            /* the data can't be written back, drop them */
+            pcache_file_drop(file, 0, file->size);
+            file->disk_size = -1;
+        }
+        pcache_handle_close(file);
+    }
+
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    if (file->fd == RT_NULL && !rt_list_isempty(&(file->ra_node)))
+    {
+        rt_list_remove(&(file->ra_node));
+        file->ref_count --;
+    }
+    rt_mutex_release(&pcache_lock);
+    rt_mutex_release(&(file->lock));
+
+    fd->pcache = RT_NULL;
+    pcache_file_put(file);
+
+    return result;
+}
+
+/**
+ * this function will read data from the page cache, the missed pages are
+ * read from file system.
+ *
+ * @param fd the file descriptor.
+ * @param buf the buffer to save the read data.
+ * @param len the length of data buffer to be read.
+ *
+ * @return the actual read data bytes or 0 on end of file or failed.
+ */
+int dfs_pcache_read(struct dfs_fd *fd, void *buf, size_t len)
+{
+    int result = 0;
+    off_t pos, offset;
+    size_t count, total = 0;
+    struct dfs_page *page;
+    struct dfs_pcache_file *file = (struct dfs_pcache_file *)fd->pcache;
+
+    if (!pcache_readable(fd))
+        return -EBADF;
+
+    rt_mutex_take(&(file->lock), RT_WAITING_FOREVER);
+    pos = fd->pos;
+    while (total < len && pos < file->size)
+    {
+        offset = pos & ~PCACHE_PAGE_MASK;
+
+        page = pcache_page_get(file, offset, RT_TRUE, &result);
+        if (page == RT_NULL)
+        {
+            if (result < 0)
+                break;
+
+            /* no page available, read the rest from file system */
+            result = pcache_file_flush(file);
+            if (result == 0)
+                result = pcache_io(file, pos, (rt_uint8_t *)buf + total, len - total, RT_FALSE);
+            if (result > 0)
+            {
+                total += result;
+                pos += result;
+            }
+            break;
+        }
+
+        /* the data after the end of file on disk is zero */
+        count = file->size - offset;
+        if (count > DFS_PAGECACHE_PAGE_SIZE)
+            count = DFS_PAGECACHE_PAGE_SIZE;
+        if (page->len < count)
+            page->len = count;
+
+        count = page->len - (pos - offset);
+        if (count > len - total)
+            count = len - total;
+        rt_memcpy((rt_uint8_t *)buf + total, page->data + (pos - offset), count);
+        pcache_page_put(page);
+
+        total += count;
+        pos += count;
+    }
+
+    if (total > 0)
+        pcache_readahead_request(file, fd->pos, pos);
+    fd->pos = pos;
+    rt_mutex_release(&(file->lock));
+
+    return total ? (int)total : result;
+}
+
+/**
+ * this function will write data to the page cache, which is written back to
+ * file system later.
+ *
+ * @param fd the file descriptor.
+ * @param buf the data buffer to be written.
+ * @param len the data buffer length
+ *
+ * @return the actual written data length.
+ */
+int dfs_pcache_write(struct dfs_fd *fd, const void *buf, size_t len)
+{
+    int result = 0;
+    off_t pos, offset;
+    size_t count, total = 0;
+    rt_bool_t fill;
+    struct dfs_page *page;
+    struct dfs_pcache_file *file = (struct dfs_pcache_file *)fd->pcache;
+
+    if ((fd->flags & O_ACCMODE) == O_RDONLY)
+        return -EBADF;
+
+    rt_mutex_take(&(file->lock), RT_WAITING_FOREVER);
+    pos = (fd->flags & O_APPEND) ? file->size : fd->pos;
+    while (total < len)
+    {
+        offset = pos & ~PCACHE_PAGE_MASK;
+        count = DFS_PAGECACHE_PAGE_SIZE - (pos - offset);
+        if (count > len - total)
+            count = len - total;
+
+        /* the data on disk is needed unless the page is overwritten */
+        fill = offset < file->disk_size && count != DFS_PAGECACHE_PAGE_SIZE;
+
+        page = pcache_page_get(file, offset, fill, &result);
+        if (page == RT_NULL && result == 0)
+        {
+            /* make room by writing back the dirty pages of file */
+            result = pcache_file_flush(file);
+            if (result == 0)
+                page = pcache_page_get(file, offset, fill, &result);
+        }
+        if (result < 0)
+            break;
+
+        if (page == RT_NULL)
+        {
+            /* write the rest to file system directly */
+            result = pcache_file_flush(file);
+            if (result == 0)
+            {
+                pcache_file_drop(file, pos, pos + (len - total));
+                result = pcache_io(file, pos, (rt_uint8_t *)buf + total, len - total, RT_TRUE);
+            }
+            if (result > 0)
+            {
+                total += result;
+                pos += result;
+            }
+            break;
+        }
+
+        if (page->len < (size_t)(pos - offset))
+            rt_memset(page->data + page->len, 0, (pos - offset) - page->len);
+        rt_memcpy(page->data + (pos - offset), (const rt_uint8_t *)buf + total, count);
+        if (page->len < (size_t)(pos - offset) + count)
+            page->len = (pos - offset) + count;
+        pcache_page_dirty(page);
+        pcache_page_put(page);
+
+        total += count;
+        pos += count;
+        if (file->size < pos)
+            file->size = pos;
+    }
+    fd->pos = pos;
+    rt_mutex_release(&(file->lock));
+
+    return total ? (int)total : result;
+}
+
+/**
+ * this function will seek the offset of a cached file. The offset beyond the
+ * end of file is passed to file system after the dirty pages written back.
+ *
+ * @param fd the file descriptor.
+ * @param offset the offset to be sought.
+ *
+ * @return the current position after seek.
+ */
+int dfs_pcache_lseek(struct dfs_fd *fd, off_t offset)
+{
+    int result;
+    struct dfs_pcache_file *file = (struct dfs_pcache_file *)fd->pcache;
+
+    rt_mutex_take(&(file->lock), RT_WAITING_FOREVER);
+    if (offset <= file->size || (fd->flags & O_ACCMODE) == O_RDONLY)
+    {
+        /* nothing is read after the end of file */
+        fd->pos = offset;
+        result = offset;
+    }
+    else if (file->fd == RT_NULL)
+    {
+        result = -EBADF;
+    }
+    else
+    {
+        result = pcache_file_flush(file);
+        if (result == 0)
+        {
+            result = dfs_fs_lock(file->fs);
+            if (result == 0)
+            {
+                result = file->fd->fops->lseek(file->fd, offset);
+                if (result >= 0)
+                    file->fd->pos = fd->pos = result;
+                dfs_fs_unlock(file->fs);
+            }
+
+            if (result >= 0)
+            {
+                /* the file may be expanded by file system */
+                pcache_file_drop(file, 0, file->size);
+                file->size = file->disk_size = file->fd->size;
+            }
+        }
+    }
+    rt_mutex_release(&(file->lock));
+
+    return result;
+}
+
+/**
+ * this function will write back the dirty pages of a file.
+ *
+ * @param fd the file descriptor.
+ *
+ * @return 0 on successful, the error of write back on failed.
+ */
+int dfs_pcache_flush(struct dfs_fd *fd)
+{
+    int result;
+    struct dfs_pcache_file *file = (struct dfs_pcache_file *)fd->pcache;
+
+    rt_mutex_take(&(file->lock), RT_WAITING_FOREVER);
+    file->error = 0;
+    result = pcache_file_flush(file);
+    rt_mutex_release(&(file->lock));
+
+    return result;
+}
+
+/**
+ * this function will return the size of a cached file including the data
+ * which is not written back.
+ *
+ * @param fd the file descriptor.
+ *
+ * @return the file size.
+ */
+off_t dfs_pcache_size(struct dfs_fd *fd)
+{
+    return ((struct dfs_pcache_file *)fd->pcache)->size;
+}
+
+static struct dfs_pcache_file *pcache_file_find(struct dfs_filesystem *fs, const char *path)
+{
+    rt_list_t *node;
+
+    rt_list_for_each(node, &pcache_files)
+    {
+        struct dfs_pcache_file *file = rt_list_entry(node, struct dfs_pcache_file, list);
+
+        if (file->fs == fs && strcmp(file->path, path) == 0)
+            return file;
+    }
+
+    return RT_NULL;
+}
+
+/* drop the pages of a closed file, the cache lock shall be held */
+static void pcache_file_remove(struct dfs_pcache_file *file)
+{
+    rt_list_t *node, *next;
+
+    rt_list_for_each_safe(node, next, &(file->pages))
+    {
+        struct dfs_page *page = rt_list_entry(node, struct dfs_page, file_node);
+
+        if (page->ref_count == 0)
+        {
+            pcache_page_remove(page);
+            pcache_stat.pages --;
+            rt_free(page);
+        }
+    }
+
+    /* it will never be found again */
+    rt_list_remove(&(file->list));
+    if (file->ref_count == 0 && rt_list_isempty(&(file->pages)))
+    {
+        rt_mutex_detach(&(file->lock));
+        rt_free(file->path);
+        rt_free(file);
+    }
+}
+
+/**
+ * this function will drop the cached pages of a file which is removed.
+ *
+ * @param fs the file system of file.
+ * @param path the path of file in file system.
+ */
+void dfs_pcache_invalidate(struct dfs_filesystem *fs, const char *path)
+{
+    struct dfs_pcache_file *file;
+
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    file = pcache_file_find(fs, path);
+    if (file != RT_NULL && file->fd == RT_NULL)
+        pcache_file_remove(file);
+    rt_mutex_release(&pcache_lock);
+}
+
+/**
+ * this function will write back the dirty pages of a file system and drop the
+ * cached pages of its closed files, which is used before unmounting. Nothing
+ * is dropped if any file fails to write back.
+ *
+ * @param fs the file system to be unmounted.
+ *
+ * @return 0 on successful, the error of the last failed file.
+ */
+int dfs_pcache_invalidate_fs(struct dfs_filesystem *fs)
+{
+    int result = 0;
+    rt_list_t *node, *next;
+    struct dfs_pcache_file *file, *last = RT_NULL;
+
+    /* retry the files failed to write back before */
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    rt_list_for_each(node, &pcache_files)
+    {
+        file = rt_list_entry(node, struct dfs_pcache_file, list);
+        if (file->fs == fs)
+            file->error = 0;
+    }
+    rt_mutex_release(&pcache_lock);
+
+    while (1)
+    {
+        file = RT_NULL;
+
+        rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+        if (last != RT_NULL)
+        {
+            last->ref_count --;
+            pcache_file_release(last);
+        }
+        rt_list_for_each(node, &pcache_files)
+        {
+            struct dfs_pcache_file *f = rt_list_entry(node, struct dfs_pcache_file, list);
+
+            /* the file failed in this round is skipped */
+            if (f->fs == fs && f->fd != RT_NULL && f->dirty_count > 0 && f->error == 0)
+            {
+                file = f;
+                file->ref_count ++;
+                break;
+            }
+        }
+        rt_mutex_release(&pcache_lock);
+
+        if (file == RT_NULL)
+            break;
+
+        rt_mutex_take(&(file->lock), RT_WAITING_FOREVER);
+        if (file->fd != RT_NULL && pcache_file_flush(file) < 0)
+            result = file->error;
+        rt_mutex_release(&(file->lock));
+
+        last = file;
+    }
+
+    if (result < 0)
+        return result;
+
+    /* the slot of file system table is reused by the next mounting */
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    rt_list_for_each_safe(node, next, &pcache_files)
+    {
+        file = rt_list_entry(node, struct dfs_pcache_file, list);
+        if (file->fs == fs && file->fd == RT_NULL)
+            pcache_file_remove(file);
+    }
+    rt_mutex_release(&pcache_lock);
+
+    return result;
+}
+
+/**
+ * this function will move the cached pages of a file which is renamed.
+ *
+ * @param fs the file system of file.
+ * @param oldpath the old path of file in file system.
+ * @param newpath the new path of file in file system.
+ */
+void dfs_pcache_rename(struct dfs_filesystem *fs, const char *oldpath, const char *newpath)
+{
+    char *path;
+    struct dfs_pcache_file *file;
+
+    path = rt_strdup(newpath);
+
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    /* the target is replaced */
+    file = pcache_file_find(fs, newpath);
+    if (file != RT_NULL && file->fd == RT_NULL)
+        pcache_file_remove(file);
+
+    file = pcache_file_find(fs, oldpath);
+    if (file != RT_NULL && file->fd == RT_NULL)
+    {
+        if (path != RT_NULL)
+        {
+            rt_free(file->path);
+            file->path = path;
+            path = RT_NULL;
+        }
+        else
+        {
+            pcache_file_remove(file);
+        }
+    }
+    rt_mutex_release(&pcache_lock);
+
+    rt_free(path);
+}
+
+/**
+ * this function will write back the dirty pages of all files.
+ *
+ * @return 0 on successful, the error of the last failed file.
+ */
+int dfs_pcache_sync(void)
+{
+    int result = 0;
+    rt_list_t *node;
+    struct dfs_pcache_file *file, *last = RT_NULL;
+
+    /* retry the files failed to write back before */
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    rt_list_for_each(node, &pcache_files)
+        rt_list_entry(node, struct dfs_pcache_file, list)->error = 0;
+    rt_mutex_release(&pcache_lock);
+
+    while (1)
+    {
+        file = RT_NULL;
+
+        rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+        if (last != RT_NULL)
+        {
+            last->ref_count --;
+            pcache_file_release(last);
+        }
+        rt_list_for_each(node, &pcache_files)
+        {
+            struct dfs_pcache_file *f = rt_list_entry(node, struct dfs_pcache_file, list);
+
+            /* the file failed in this round is skipped */
+            if (f->fd != RT_NULL && f->dirty_count > 0 && f->error == 0)
+            {
+                file = f;
+                file->ref_count ++;
+                break;
+            }
+        }
+        rt_mutex_release(&pcache_lock);
+
+        if (file == RT_NULL)
+            break;
+
+        rt_mutex_take(&(file->lock), RT_WAITING_FOREVER);
+        if (file->fd != RT_NULL && pcache_file_flush(file) < 0)
+            result = file->error;
+        rt_mutex_release(&(file->lock));
+
+        last = file;
+    }
+
+    return result;
+}
+
+/**
+ * this function will get the statistics of page cache.
+ *
+ * @param stat the buffer to save the statistics.
+ */
+void dfs_pcache_stat_get(struct dfs_pcache_stat *stat)
+{
+    rt_mutex_take(&pcache_lock, RT_WAITING_FOREVER);
+    *stat = pcache_stat;
+    rt_mutex_release(&pcache_lock);
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+int list_pcache(void)
+{
+    struct dfs_pcache_stat stat;
+
+    dfs_pcache_stat_get(&stat);
+
+    rt_kprintf("page size : %d\n", DFS_PAGECACHE_PAGE_SIZE);
+    rt_kprintf("pages     : %d/%d, dirty %d\n", stat.pages, DFS_PAGECACHE_MAX_PAGES, stat.dirty);
+    rt_kprintf("hit       : %d\n", stat.hit);
+    rt_kprintf("miss      : %d\n", stat.miss);
+    rt_kprintf("readahead : %d\n", stat.readahead);
+    rt_kprintf("writeback : %d\n", stat.writeback);
+    rt_kprintf("evict     : %d\n", stat.evict);
+
+    return 0;
+}
+FINSH_FUNCTION_EXPORT(list_pcache, list page cache statistics);
+MSH_CMD_EXPORT(list_pcache, list page cache statistics);
+#endif
@@ -25,6 +25,7 @@
 
 #include <dfs.h>
 #include <dfs_posix.h>
+#include <dfs_pcache.h>
 #include "dfs_private.h"
 
 /**
@@ -235,7 +236,7 @@ off_t lseek(int fd, off_t offset, int whence)
         break;
 
     case SEEK_END:
-        offset += d->size;
+        offset += DFS_FD_SIZE(d);
         break;
 
     default:
@@ -376,7 +377,7 @@ int fstat(int fildes, struct stat *buf)
         buf->st_mode |= S_IFDIR | S_IXUSR | S_IXGRP | S_IXOTH;
     }
 
-    buf->st_size    = d->size;
+    buf->st_size    = DFS_FD_SIZE(d);
     buf->st_mtime   = 0;
 
     fd_put(d);
@@ -416,6 +417,18 @@ int fsync(int fildes)
 }
 RTM_EXPORT(fsync);
 
+/**
+ * this function is a POSIX compliant version, which shall cause all the data
+ * cached in the page cache to be written to file systems.
+ */
+void sync(void)
+{
+#ifdef RT_USING_DFS_PAGECACHE
+    dfs_pcache_sync();
+#endif
+}
+RTM_EXPORT(sync);
+
 /**
  * this function is a POSIX compliant version, which shall perform a variety of
  * control functions on devices.
@@ -485,6 +498,153 @@ int ioctl(int fildes, int cmd, ...)
 }
 RTM_EXPORT(ioctl);
 
+/* copy data at the given offsets without changing the file positions, the
+ * positions are locked in order of address across the whole copy */
+static int dfs_copy_range(struct dfs_fd *fd_in, off_t *off_in,
+                          struct dfs_fd *fd_out, off_t *off_out, size_t len)
+{
+    int result;
+    off_t pos_in = 0, pos_out = 0;
+    struct dfs_fd *first, *second;
+
+    first  = fd_in < fd_out ? fd_in : fd_out;
+    second = fd_in < fd_out ? fd_out : fd_in;
+
+    result = dfs_fd_lock(first);
+    if (result < 0)
+        return result;
+    if (second != first)
+    {
+        result = dfs_fd_lock(second);
+        if (result < 0)
+        {
+            dfs_fd_unlock(first);
+            return result;
+        }
+    }
+
+    if (off_in)
+    {
+        pos_in = fd_in->pos;
+        result = dfs_file_lseek(fd_in, *off_in);
+        if (result < 0)
+            goto __exit;
+    }
+
+    if (off_out)
+    {
+        pos_out = fd_out->pos;
+        result = dfs_file_lseek(fd_out, *off_out);
+        if (result < 0)
+        {
+            if (off_in)
+                dfs_file_lseek(fd_in, pos_in);
+            goto __exit;
+        }
+    }
+
+    result = dfs_file_copy_range(fd_in, fd_out, len);
+
+    if (off_in)
+    {
+        *off_in = fd_in->pos;
+        dfs_file_lseek(fd_in, pos_in);
+    }
+    if (off_out)
+    {
+        *off_out = fd_out->pos;
+        dfs_file_lseek(fd_out, pos_out);
+    }
+
+__exit:
+    if (second != first)
+        dfs_fd_unlock(second);
+    dfs_fd_unlock(first);
+
+    return result;
+}
+
+/**
+ * this function is a POSIX compliant version, which will copy data from a
+ * file to another file or device in kernel.
+ *
+ * @param out_fd the file descriptor to write data to.
+ * @param in_fd the file descriptor to read data from.
+ * @param offset the offset to read from, which is updated on return. The
+ *        current file position is used and updated if it's NULL.
+ * @param count the maximal number of bytes to copy.
+ *
+ * @return the number of bytes copied, -1 on failed.
+ */
+ssize_t sendfile(int out_fd, int in_fd, off_t *offset, size_t count)
+{
+    return copy_file_range(in_fd, offset, out_fd, RT_NULL, count, 0);
+}
+RTM_EXPORT(sendfile);
+
+/**
+ * this function is a POSIX compliant version, which will copy a range of
+ * data from a file to another file in kernel.
+ *
+ * @param fd_in the file descriptor to read data from.
+ * @param off_in the offset to read from, which is updated on return. The
+ *        current file position is used and updated if it's NULL.
+ * @param fd_out the file descriptor to write data to.
+ * @param off_out the offset to write to, as same as off_in.
+ * @param len the maximal number of bytes to copy.
+ * @param flags must be 0.
+ *
+ * @return the number of bytes copied, -1 on failed.
+ */
+ssize_t copy_file_range(int fd_in, off_t *off_in, int fd_out, off_t *off_out,
+                        size_t len, unsigned int flags)
+{
+    int result;
+    struct dfs_fd *d_in, *d_out;
+
+    if (flags != 0)
+    {
+        rt_set_errno(-EINVAL);
+
+        return -1;
+    }
+
+    d_in = fd_get(fd_in);
+    if (d_in == NULL)
+    {
+        rt_set_errno(-EBADF);
+
+        return -1;
+    }
+
+    d_out = fd_get(fd_out);
+    if (d_out == NULL)
+    {
+        fd_put(d_in);
+        rt_set_errno(-EBADF);
+
+        return -1;
+    }
+
+    if ((d_in->flags & O_ACCMODE) == O_WRONLY || (d_out->flags & O_ACCMODE) == O_RDONLY)
+        result = -EBADF;
+    else
+        result = dfs_copy_range(d_in, off_in, d_out, off_out, len);
+
+    fd_put(d_out);
+    fd_put(d_in);
+
+    if (result < 0)
+    {
+        rt_set_errno(result);
+
+        return -1;
+    }
+
+    return result;
+}
+RTM_EXPORT(copy_file_range);
+
 /**
  * this function is a POSIX compliant version, which will return the
  * information about a mounted file system.
@@ -0,0 +1,710 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+
+#include <rthw.h>
+#include <rtdevice.h>
+#include <rtthread.h>
+
+#include <dfs.h>
+#include <dfs_file.h>
+#include <dfs_posix.h>
+#include <dfs_poll.h>
+#include <dfs_epoll.h>
+#include <dfs_private.h>
+
+/*
+ * The epoll instance keeps the interest list of fd persistently. Each item
+ * hangs its wait queue nodes on the wait queues of the file by fops->poll
+ * once, and the wakeup callback of them puts the item to the ready list, so
+ * epoll_wait only checks the ready items instead of all of fd.
+ */
+
+#define EP_PRIVATE_BITS     (EPOLLONESHOT | EPOLLET)
+
+struct rt_eventpoll;
+struct rt_epitem;
+
+struct rt_ep_wqnode
+{
+    struct rt_wqueue_node wqn;
+    struct rt_epitem *epi;
+    struct rt_ep_wqnode *next;
+};
+
+struct rt_epitem
+{
+    rt_list_t node;                 /* node in interest list */
+    rt_list_t ready_node;           /* node in ready list */
+
+    struct rt_eventpoll *ep;
+    struct dfs_fd *file;
+    int fd;
+
+    struct epoll_event event;
+    struct rt_ep_wqnode *wqnodes;   /* the nodes on wait queues of file */
+};
+
+struct rt_eventpoll
+{
+    rt_list_t node;                 /* node in all of epoll instances */
+
+    struct rt_mutex lock;           /* protect the interest list */
+    rt_list_t interest_list;
+    rt_list_t ready_list;           /* protected by interrupt lock */
+
+    rt_wqueue_t wait_queue;         /* the threads in epoll_wait */
+    rt_wqueue_t poll_queue;         /* the poll on epoll fd itself */
+};
+
+struct rt_ep_pqueue
+{
+    rt_pollreq_t req;
+    struct rt_epitem *epi;
+};
+
+static rt_list_t _ep_list = RT_LIST_OBJECT_INIT(_ep_list);
+static struct rt_mutex _ep_list_lock;
+static rt_bool_t _ep_inited = RT_FALSE;
+
+/* resume the waiters of queue like rt_wqueue_wakeup without scheduling, the
+ * interrupt shall be disabled. Return whether any thread is resumed. */
+static rt_bool_t ep_wqueue_resume(rt_wqueue_t *queue, void *key)
+{
+    int result;
+    rt_bool_t resumed = RT_FALSE;
+    struct rt_list_node *node;
+    struct rt_wqueue_node *entry;
+
+    queue->flag = RT_WQ_FLAG_WAKEUP;
+    for (node = queue->waiting_list.next; node != &(queue->waiting_list); node = node->next)
+    {
+        entry = rt_list_entry(node, struct rt_wqueue_node, list);
+        result = entry->wakeup(entry, key);
+        if (result == 0)
+        {
+            rt_thread_resume(entry->polling_thread);
+            rt_list_remove(&(entry->list));
+
+            return RT_TRUE;
+        }
+        else if (result > 0)
+        {
+            resumed = RT_TRUE;
+        }
+    }
+
+    return resumed;
+}
+
+/* it's called by the wakeup of file, which is walking the wait queue of file
+ * with interrupt disabled. The waiters of epoll are only resumed here, and
+ * the file schedules them after the walking, so they can't remove the node
+ * in use. */
+static int ep_poll_callback(struct rt_wqueue_node *wait, void *key)
+{
+    rt_base_t level;
+    rt_bool_t resumed;
+    struct rt_epitem *epi;
+    struct rt_eventpoll *ep;
+
+    epi = rt_container_of(wait, struct rt_ep_wqnode, wqn)->epi;
+    ep = epi->ep;
+
+    /* the events are disabled or not interested */
+    if (!(epi->event.events & ~EP_PRIVATE_BITS))
+        return -1;
+    if (key && !((rt_uint32_t)key & (epi->event.events | POLLERR | POLLHUP)))
+        return -1;
+
+    level = rt_hw_interrupt_disable();
+    if (rt_list_isempty(&(epi->ready_node)))
+        rt_list_insert_before(&(ep->ready_list), &(epi->ready_node));
+
+    resumed = ep_wqueue_resume(&(ep->wait_queue), RT_NULL);
+    if (ep_wqueue_resume(&(ep->poll_queue), (void *)POLLIN))
+        resumed = RT_TRUE;
+    rt_hw_interrupt_enable(level);
+
+    /* never consume the wakeup of file, let other waiters go on */
+    return resumed ? 1 : -1;
+}
+
+static void ep_ptable_queue_proc(rt_wqueue_t *wq, rt_pollreq_t *req)
+{
+    rt_base_t level;
+    struct rt_epitem *epi;
+    struct rt_ep_wqnode *node;
+
+    epi = rt_container_of(req, struct rt_ep_pqueue, req)->epi;
+
+    node = rt_malloc(sizeof(struct rt_ep_wqnode));
+    if (node == RT_NULL)
+        return;
+
+    node->wqn.polling_thread = RT_NULL;
+    node->wqn.wakeup = ep_poll_callback;
+    node->wqn.key = 0;
+    node->epi = epi;
+    node->next = epi->wqnodes;
+    epi->wqnodes = node;
+
+    /* put it on the head to be called before the waiting threads */
+    level = rt_hw_interrupt_disable();
+    rt_list_insert_after(&(wq->waiting_list), &(node->wqn.list));
+    rt_hw_interrupt_enable(level);
+}
+
+static int ep_item_poll(struct rt_epitem *epi, rt_pollreq_t *req)
+{
+    int mask = POLLMASK_DEFAULT;
+
+    if (epi->file->fops->poll)
+        mask = epi->file->fops->poll(epi->file, req);
+
+    /* the item disabled by EPOLLONESHOT reports nothing until it's modified */
+    if (!(epi->event.events & ~EP_PRIVATE_BITS))
+        return 0;
+
+    return mask & (epi->event.events | POLLERR | POLLHUP);
+}
+
+static struct rt_epitem *ep_find(struct rt_eventpoll *ep, int fd)
+{
+    struct rt_list_node *node;
+    struct rt_epitem *epi;
+
+    rt_list_for_each(node, &(ep->interest_list))
+    {
+        epi = rt_list_entry(node, struct rt_epitem, node);
+        if (epi->fd == fd)
+            return epi;
+    }
+
+    return RT_NULL;
+}
+
+static int ep_insert(struct rt_eventpoll *ep, int fd, struct dfs_fd *file,
+                     struct epoll_event *event)
+{
+    rt_base_t level;
+    int mask;
+    struct rt_epitem *epi;
+    struct rt_ep_pqueue epq;
+
+    if (file->fops->poll == RT_NULL)
+        return -EPERM;
+
+    epi = rt_malloc(sizeof(struct rt_epitem));
+    if (epi == RT_NULL)
+        return -ENOMEM;
+
+    rt_list_init(&(epi->ready_node));
+    epi->ep = ep;
+    epi->file = file;
+    epi->fd = fd;
+    epi->event = *event;
+    epi->wqnodes = RT_NULL;
+
+    /* hang on the wait queues of file, and get the current events */
+    epq.req._proc = ep_ptable_queue_proc;
+    epq.req._key = event->events | POLLERR | POLLHUP;
+    epq.epi = epi;
+    mask = ep_item_poll(epi, &epq.req);
+    if (epi->wqnodes == RT_NULL)
+    {
+        rt_free(epi);
+        return -ENOMEM;
+    }
+
+    rt_list_insert_before(&(ep->interest_list), &(epi->node));
+
+    if (mask)
+    {
+        level = rt_hw_interrupt_disable();
+        rt_list_insert_before(&(ep->ready_list), &(epi->ready_node));
+        rt_hw_interrupt_enable(level);
+
+        rt_wqueue_wakeup(&(ep->wait_queue), RT_NULL);
+        rt_wqueue_wakeup(&(ep->poll_queue), (void *)POLLIN);
+    }
+
+    return 0;
+}
+
+static void ep_remove(struct rt_eventpoll *ep, struct rt_epitem *epi)
+{
+    rt_base_t level;
+    struct rt_ep_wqnode *node, *next;
+
+    level = rt_hw_interrupt_disable();
+    for (node = epi->wqnodes; node != RT_NULL; node = node->next)
+        rt_list_remove(&(node->wqn.list));
+    rt_list_remove(&(epi->ready_node));
+    rt_hw_interrupt_enable(level);
+
+    for (node = epi->wqnodes; node != RT_NULL; node = next)
+    {
+        next = node->next;
+        rt_free(node);
+    }
+
+    rt_list_remove(&(epi->node));
+    rt_free(epi);
+}
+
+static int ep_modify(struct rt_eventpoll *ep, struct rt_epitem *epi,
+                     struct epoll_event *event)
+{
+    rt_base_t level;
+    rt_pollreq_t req;
+
+    epi->event = *event;
+
+    req._proc = RT_NULL;
+    req._key = event->events | POLLERR | POLLHUP;
+    if (ep_item_poll(epi, &req))
+    {
+        level = rt_hw_interrupt_disable();
+        if (rt_list_isempty(&(epi->ready_node)))
+            rt_list_insert_before(&(ep->ready_list), &(epi->ready_node));
+        rt_hw_interrupt_enable(level);
+
+        rt_wqueue_wakeup(&(ep->wait_queue), RT_NULL);
+        rt_wqueue_wakeup(&(ep->poll_queue), (void *)POLLIN);
+    }
+
+    return 0;
+}
+
+/* collect the ready events, the ep->lock shall be taken before invoking */
+static int ep_send_events(struct rt_eventpoll *ep, struct epoll_event *events,
+                          int maxevents)
+{
+    rt_base_t level;
+    int num = 0;
+    int mask;
+    rt_list_t txlist;
+    rt_pollreq_t req;
+    struct rt_epitem *epi;
+
+    req._proc = RT_NULL;
+
+    /* take all of the ready items */
+    rt_list_init(&txlist);
+    level = rt_hw_interrupt_disable();
+    if (!rt_list_isempty(&(ep->ready_list)))
+    {
+        txlist.next = ep->ready_list.next;
+        txlist.prev = ep->ready_list.prev;
+        txlist.next->prev = &txlist;
+        txlist.prev->next = &txlist;
+        rt_list_init(&(ep->ready_list));
+    }
+    rt_hw_interrupt_enable(level);
+
+    while (!rt_list_isempty(&txlist) && num < maxevents)
+    {
+        epi = rt_list_entry(txlist.next, struct rt_epitem, ready_node);
+
+        level = rt_hw_interrupt_disable();
+        rt_list_remove(&(epi->ready_node));
+        rt_hw_interrupt_enable(level);
+
+        /* check the events again, it may be consumed */
+        req._key = epi->event.events | POLLERR | POLLHUP;
+        mask = ep_item_poll(epi, &req);
+        if (mask == 0)
+            continue;
+
+        events[num].events = mask;
+        events[num].data = epi->event.data;
+        num ++;
+
+        if (epi->event.events & EPOLLONESHOT)
+        {
+            /* disabled until EPOLL_CTL_MOD */
+            epi->event.events &= EP_PRIVATE_BITS;
+        }
+        else if (!(epi->event.events & EPOLLET))
+        {
+            /* level triggered, keep it ready until it's not */
+            level = rt_hw_interrupt_disable();
+            if (rt_list_isempty(&(epi->ready_node)))
+                rt_list_insert_before(&(ep->ready_list), &(epi->ready_node));
+            rt_hw_interrupt_enable(level);
+        }
+    }
+
+    /* give back the items not checked */
+    level = rt_hw_interrupt_disable();
+    while (!rt_list_isempty(&txlist))
+    {
+        epi = rt_list_entry(txlist.next, struct rt_epitem, ready_node);
+        rt_list_remove(&(epi->ready_node));
+        rt_list_insert_before(&(ep->ready_list), &(epi->ready_node));
+    }
+    rt_hw_interrupt_enable(level);
+
+    return num;
+}
+
+/* wait for ready items or timeout */
+static void ep_wait_timeout(struct rt_eventpoll *ep, rt_int32_t timeout)
+{
+    rt_base_t level;
+    struct rt_thread *thread;
+    struct rt_wqueue_node wait;
+
+    thread = rt_thread_self();
+
+    level = rt_hw_interrupt_disable();
+    if (timeout != 0 && rt_list_isempty(&(ep->ready_list)))
+    {
+        wait.polling_thread = thread;
+        wait.wakeup = __wqueue_default_wake;
+        wait.key = 0;
+        rt_list_init(&(wait.list));
+        rt_wqueue_add(&(ep->wait_queue), &wait);
+
+        rt_thread_suspend(thread);
+        if (timeout > 0)
+        {
+            rt_timer_control(&(thread->thread_timer),
+                             RT_TIMER_CTRL_SET_TIME,
+                             &timeout);
+            rt_timer_start(&(thread->thread_timer));
+        }
+
+        rt_hw_interrupt_enable(level);
+
+        rt_schedule();
+
+        level = rt_hw_interrupt_disable();
+        rt_list_remove(&(wait.list));
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+static int epoll_fops_close(struct dfs_fd *fd)
+{
+    struct rt_eventpoll *ep;
+
+    ep = (struct rt_eventpoll *)fd->data;
+
+    rt_mutex_take(&_ep_list_lock, RT_WAITING_FOREVER);
+    rt_list_remove(&(ep->node));
+    rt_mutex_release(&_ep_list_lock);
+
+    rt_mutex_take(&(ep->lock), RT_WAITING_FOREVER);
+    while (!rt_list_isempty(&(ep->interest_list)))
+    {
+        ep_remove(ep, rt_list_entry(ep->interest_list.next, struct rt_epitem, node));
+    }
+    rt_mutex_release(&(ep->lock));
+
+    rt_mutex_detach(&(ep->lock));
+    rt_free(ep);
+    fd->data = RT_NULL;
+
+    return 0;
+}
+
+static int epoll_fops_poll(struct dfs_fd *fd, rt_pollreq_t *req)
+{
+    struct rt_eventpoll *ep;
+
+    ep = (struct rt_eventpoll *)fd->data;
+    rt_poll_add(&(ep->poll_queue), req);
+
+    return rt_list_isempty(&(ep->ready_list)) ? 0 : POLLIN;
+}
+
+static const struct dfs_file_ops epoll_fops =
+{
+    RT_NULL,
+    epoll_fops_close,
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    epoll_fops_poll,
+};
+
+static struct dfs_fd *ep_fd_get(int epfd)
+{
+    struct dfs_fd *d;
+
+    d = fd_get(epfd);
+    if (d == RT_NULL)
+        return RT_NULL;
+
+    if (d->fops != &epoll_fops)
+    {
+        fd_put(d);
+        return RT_NULL;
+    }
+
+    return d;
+}
+
+/**
+ * this function will release the epoll items of a file, which is closing.
+ *
+ * @param fd the file descriptor.
+ */
+void dfs_epoll_file_release(struct dfs_fd *fd)
+{
+    struct rt_list_node *node, *item, *next;
+    struct rt_eventpoll *ep;
+    struct rt_epitem *epi;
+
+    /* no epoll instance */
+    if (rt_list_isempty(&_ep_list))
+        return;
+
+    rt_mutex_take(&_ep_list_lock, RT_WAITING_FOREVER);
+    rt_list_for_each(node, &_ep_list)
+    {
+        ep = rt_list_entry(node, struct rt_eventpoll, node);
+
+        rt_mutex_take(&(ep->lock), RT_WAITING_FOREVER);
+        for (item = ep->interest_list.next; item != &(ep->interest_list); item = next)
+        {
+            next = item->next;
+            epi = rt_list_entry(item, struct rt_epitem, node);
+            if (epi->file == fd)
+                ep_remove(ep, epi);
+        }
+        rt_mutex_release(&(ep->lock));
+    }
+    rt_mutex_release(&_ep_list_lock);
+}
+
+/**
+ * this function is a POSIX compliant version, which will create an epoll
+ * instance.
+ *
+ * @param flags 0 or EPOLL_CLOEXEC.
+ *
+ * @return the file descriptor of epoll instance, -1 on failed.
+ */
+int epoll_create1(int flags)
+{
+    int fd;
+    struct rt_eventpoll *ep;
+
+    rt_enter_critical();
+    if (!_ep_inited)
+    {
+        rt_mutex_init(&_ep_list_lock, "epoll", RT_IPC_FLAG_FIFO);
+        _ep_inited = RT_TRUE;
+    }
+    rt_exit_critical();
+
+    ep = rt_malloc(sizeof(struct rt_eventpoll));
+    if (ep == RT_NULL)
+    {
+        rt_set_errno(-ENOMEM);
+        return -1;
+    }
+
+    rt_mutex_init(&(ep->lock), "epoll", RT_IPC_FLAG_FIFO);
+    rt_list_init(&(ep->interest_list));
+    rt_list_init(&(ep->ready_list));
+    rt_wqueue_init(&(ep->wait_queue));
+    rt_wqueue_init(&(ep->poll_queue));
+
+    fd = fd_new_anon(&epoll_fops, ep, O_RDWR);
+    if (fd < 0)
+    {
+        rt_mutex_detach(&(ep->lock));
+        rt_free(ep);
+        rt_set_errno(-ENOMEM);
+        return -1;
+    }
+
+    rt_mutex_take(&_ep_list_lock, RT_WAITING_FOREVER);
+    rt_list_insert_after(&_ep_list, &(ep->node));
+    rt_mutex_release(&_ep_list_lock);
+
+    return fd;
+}
+RTM_EXPORT(epoll_create1);
+
+/**
+ * this function is a POSIX compliant version, which will create an epoll
+ * instance.
+ *
+ * @param size ignored, but must be greater than zero.
+ *
+ * @return the file descriptor of epoll instance, -1 on failed.
+ */
+int epoll_create(int size)
+{
+    if (size <= 0)
+    {
+        rt_set_errno(-EINVAL);
+        return -1;
+    }
+
+    return epoll_create1(0);
+}
+RTM_EXPORT(epoll_create);
+
+/**
+ * this function is a POSIX compliant version, which will add, modify or
+ * remove an entry in the interest list of epoll instance.
+ *
+ * @param epfd the epoll file descriptor.
+ * @param op EPOLL_CTL_ADD, EPOLL_CTL_MOD or EPOLL_CTL_DEL.
+ * @param fd the target file descriptor.
+ * @param event the events and user data of target.
+ *
+ * @return 0 on successful, -1 on failed.
+ */
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event *event)
+{
+    int result = 0;
+    struct dfs_fd *d, *file;
+    struct rt_eventpoll *ep;
+    struct rt_epitem *epi;
+
+    if (op != EPOLL_CTL_DEL && event == RT_NULL)
+    {
+        rt_set_errno(-EFAULT);
+        return -1;
+    }
+
+    d = ep_fd_get(epfd);
+    if (d == RT_NULL)
+    {
+        rt_set_errno(-EBADF);
+        return -1;
+    }
+    ep = (struct rt_eventpoll *)d->data;
+
+    file = fd_get(fd);
+    if (file == RT_NULL)
+    {
+        fd_put(d);
+        rt_set_errno(-EBADF);
+        return -1;
+    }
+    if (file == d)
+    {
+        result = -EINVAL;
+        goto __exit;
+    }
+
+    rt_mutex_take(&(ep->lock), RT_WAITING_FOREVER);
+    epi = ep_find(ep, fd);
+    switch (op)
+    {
+    case EPOLL_CTL_ADD:
+        if (epi != RT_NULL)
+            result = -EEXIST;
+        else
+            result = ep_insert(ep, fd, file, event);
+        break;
+
+    case EPOLL_CTL_MOD:
+        if (epi == RT_NULL)
+            result = -ENOENT;
+        else
+            result = ep_modify(ep, epi, event);
+        break;
+
+    case EPOLL_CTL_DEL:
+        if (epi == RT_NULL)
+            result = -ENOENT;
+        else
+            ep_remove(ep, epi);
+        break;
+
+    default:
+        result = -EINVAL;
+        break;
+    }
+    rt_mutex_release(&(ep->lock));
+
+__exit:
+    fd_put(file);
+    fd_put(d);
+
+    if (result < 0)
+    {
+        rt_set_errno(result);
+        return -1;
+    }
+
+    return 0;
+}
+RTM_EXPORT(epoll_ctl);
+
+/**
+ * this function is a POSIX compliant version, which will wait for events on
+ * epoll instance.
+ *
+ * @param epfd the epoll file descriptor.
+ * @param events the ready events will be saved in.
+ * @param maxevents the maximal number of events.
+ * @param timeout the waiting time in millisecond, -1 for waiting forever.
+ *
+ * @return the number of ready events, -1 on failed.
+ */
+int epoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout)
+{
+    int num;
+    rt_int32_t tick;
+    rt_tick_t deadline;
+    struct dfs_fd *d;
+    struct rt_eventpoll *ep;
+
+    if (events == RT_NULL || maxevents <= 0)
+    {
+        rt_set_errno(-EINVAL);
+        return -1;
+    }
+
+    d = ep_fd_get(epfd);
+    if (d == RT_NULL)
+    {
+        rt_set_errno(-EBADF);
+        return -1;
+    }
+    ep = (struct rt_eventpoll *)d->data;
+
+    tick = rt_tick_from_millisecond(timeout);
+    deadline = rt_tick_get() + tick;
+
+    while (1)
+    {
+        rt_mutex_take(&(ep->lock), RT_WAITING_FOREVER);
+        num = ep_send_events(ep, events, maxevents);
+        rt_mutex_release(&(ep->lock));
+
+        if (num || tick == 0)
+            break;
+
+        ep_wait_timeout(ep, tick);
+        if (tick > 0)
+        {
+            /* collect once more after timeout */
+            tick = deadline - rt_tick_get();
+            if (tick < 0)
+                tick = 0;
+        }
+    }
+
+    fd_put(d);
+
+    return num;
+}
+RTM_EXPORT(epoll_wait);
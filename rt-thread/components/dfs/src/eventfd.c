@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+
+#include <rthw.h>
+#include <rtdevice.h>
+#include <rtthread.h>
+
+#include <dfs.h>
+#include <dfs_file.h>
+#include <dfs_posix.h>
+#include <dfs_poll.h>
+#include <dfs_eventfd.h>
+
+#define EFD_COUNT_MAX   ((eventfd_t)0xfffffffffffffffeULL)
+
+struct rt_eventfd
+{
+    eventfd_t count;                /* protected by interrupt lock */
+    int flags;
+
+    rt_wqueue_t reader_queue;
+    rt_wqueue_t writer_queue;
+};
+
+static int eventfd_fops_close(struct dfs_fd *fd)
+{
+    rt_free(fd->data);
+    fd->data = RT_NULL;
+
+    return 0;
+}
+
+static int eventfd_fops_read(struct dfs_fd *fd, void *buf, size_t count)
+{
+    rt_base_t level;
+    eventfd_t value;
+    struct rt_eventfd *efd;
+
+    efd = (struct rt_eventfd *)fd->data;
+    if (count < sizeof(eventfd_t))
+        return -EINVAL;
+
+    level = rt_hw_interrupt_disable();
+    while (efd->count == 0)
+    {
+        rt_hw_interrupt_enable(level);
+
+        if (fd->flags & O_NONBLOCK)
+            return -EAGAIN;
+        rt_wqueue_wait(&(efd->reader_queue), 0, -1);
+
+        level = rt_hw_interrupt_disable();
+    }
+
+    if (efd->flags & EFD_SEMAPHORE)
+    {
+        value = 1;
+        efd->count --;
+    }
+    else
+    {
+        value = efd->count;
+        efd->count = 0;
+    }
+    rt_hw_interrupt_enable(level);
+
+    rt_memcpy(buf, &value, sizeof(eventfd_t));
+    rt_wqueue_wakeup(&(efd->writer_queue), (void *)POLLOUT);
+
+    return sizeof(eventfd_t);
+}
+
+static int eventfd_fops_write(struct dfs_fd *fd, const void *buf, size_t count)
+{
+    rt_base_t level;
+    eventfd_t value;
+    struct rt_eventfd *efd;
+
+    efd = (struct rt_eventfd *)fd->data;
+    if (count < sizeof(eventfd_t))
+        return -EINVAL;
+
+    rt_memcpy(&value, buf, sizeof(eventfd_t));
+    if (value > EFD_COUNT_MAX)
+        return -EINVAL;
+
+    level = rt_hw_interrupt_disable();
+    while (EFD_COUNT_MAX - efd->count < value)
+    {
+        rt_hw_interrupt_enable(level);
+
+        if (fd->flags & O_NONBLOCK)
+            return -EAGAIN;
+        rt_wqueue_wait(&(efd->writer_queue), 0, -1);
+
+        level = rt_hw_interrupt_disable();
+    }
+    efd->count += value;
+    rt_hw_interrupt_enable(level);
+
+    if (value)
+        rt_wqueue_wakeup(&(efd->reader_queue), (void *)POLLIN);
+
+    return sizeof(eventfd_t);
+}
+
+static int eventfd_fops_poll(struct dfs_fd *fd, rt_pollreq_t *req)
+{
+    int mask = 0;
+    struct rt_eventfd *efd;
+
+    efd = (struct rt_eventfd *)fd->data;
+
+    rt_poll_add(&(efd->reader_queue), req);
+    rt_poll_add(&(efd->writer_queue), req);
+
+    if (efd->count > 0)
+        mask |= POLLIN;
+    if (efd->count < EFD_COUNT_MAX)
+        mask |= POLLOUT;
+
+    return mask;
+}
+
+static const struct dfs_file_ops eventfd_fops =
+{
+    RT_NULL,
+    eventfd_fops_close,
+    RT_NULL,
+    eventfd_fops_read,
+    eventfd_fops_write,
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    eventfd_fops_poll,
+};
+
+/**
+ * this function is a POSIX compliant version, which will create a file
+ * descriptor for event notification, which is a 64-bit counter.
+ *
+ * @param initval the initial value of counter.
+ * @param flags EFD_SEMAPHORE, EFD_NONBLOCK or EFD_CLOEXEC.
+ *
+ * @return the file descriptor, -1 on failed.
+ */
+int eventfd(unsigned int initval, int flags)
+{
+    int fd;
+    struct rt_eventfd *efd;
+
+    if (flags & ~(EFD_SEMAPHORE | EFD_NONBLOCK | EFD_CLOEXEC))
+    {
+        rt_set_errno(-EINVAL);
+        return -1;
+    }
+
+    efd = rt_malloc(sizeof(struct rt_eventfd));
+    if (efd == RT_NULL)
+    {
+        rt_set_errno(-ENOMEM);
+        return -1;
+    }
+
+    efd->count = initval;
+    efd->flags = flags;
+    rt_wqueue_init(&(efd->reader_queue));
+    rt_wqueue_init(&(efd->writer_queue));
+
+    fd = fd_new_anon(&eventfd_fops, efd, O_RDWR | (flags & EFD_NONBLOCK));
+    if (fd < 0)
+    {
+        rt_free(efd);
+        rt_set_errno(-ENOMEM);
+        return -1;
+    }
+
+    return fd;
+}
+RTM_EXPORT(eventfd);
+
+int eventfd_read(int fd, eventfd_t *value)
+{
+    return read(fd, value, sizeof(eventfd_t)) == sizeof(eventfd_t) ? 0 : -1;
+}
+RTM_EXPORT(eventfd_read);
+
+int eventfd_write(int fd, eventfd_t value)
+{
+    return write(fd, &value, sizeof(eventfd_t)) == sizeof(eventfd_t) ? 0 : -1;
+}
+RTM_EXPORT(eventfd_write);
@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+
+#include <rthw.h>
+#include <rtdevice.h>
+#include <rtthread.h>
+
+#include <dfs.h>
+#include <dfs_file.h>
+#include <dfs_posix.h>
+#include <dfs_poll.h>
+#include <dfs_timerfd.h>
+
+#define NANOSECOND_PER_SECOND   1000000000UL
+
+struct rt_timerfd
+{
+    struct rt_timer timer;
+    int clockid;
+
+    /* protected by interrupt lock */
+    uint64_t expirations;           /* expirations since the last read */
+    rt_tick_t interval;             /* period in tick, 0 for one shot */
+    rt_tick_t expire;               /* the tick of next expiration */
+    rt_bool_t armed;
+
+    rt_wqueue_t reader_queue;
+};
+
+static rt_tick_t timespec_to_tick(const struct timespec *ts)
+{
+    rt_tick_t tick;
+
+    tick = ts->tv_sec * RT_TICK_PER_SECOND;
+    /* round up to one tick */
+    tick += ((uint64_t)ts->tv_nsec * RT_TICK_PER_SECOND + NANOSECOND_PER_SECOND - 1) /
+            NANOSECOND_PER_SECOND;
+
+    return tick;
+}
+
+static void tick_to_timespec(rt_tick_t tick, struct timespec *ts)
+{
+    ts->tv_sec  = tick / RT_TICK_PER_SECOND;
+    ts->tv_nsec = (tick % RT_TICK_PER_SECOND) * (NANOSECOND_PER_SECOND / RT_TICK_PER_SECOND);
+}
+
+static void timerfd_timeout(void *parameter)
+{
+    rt_base_t level;
+    struct rt_timerfd *tfd;
+
+    tfd = (struct rt_timerfd *)parameter;
+
+    level = rt_hw_interrupt_disable();
+    tfd->expirations ++;
+    if (tfd->interval)
+    {
+        /* it's periodic after the first expiration */
+        tfd->expire = rt_tick_get() + tfd->interval;
+        rt_timer_control(&(tfd->timer), RT_TIMER_CTRL_SET_TIME, &(tfd->interval));
+        rt_timer_control(&(tfd->timer), RT_TIMER_CTRL_SET_PERIODIC, RT_NULL);
+    }
+    else
+    {
+        tfd->armed = RT_FALSE;
+    }
+    rt_hw_interrupt_enable(level);
+
+    rt_wqueue_wakeup(&(tfd->reader_queue), (void *)POLLIN);
+}
+
+static int timerfd_fops_close(struct dfs_fd *fd)
+{
+    struct rt_timerfd *tfd;
+
+    tfd = (struct rt_timerfd *)fd->data;
+
+    rt_timer_detach(&(tfd->timer));
+    rt_free(tfd);
+    fd->data = RT_NULL;
+
+    return 0;
+}
+
+static int timerfd_fops_read(struct dfs_fd *fd, void *buf, size_t count)
+{
+    rt_base_t level;
+    uint64_t value;
+    struct rt_timerfd *tfd;
+
+    tfd = (struct rt_timerfd *)fd->data;
+    if (count < sizeof(uint64_t))
+        return -EINVAL;
+
+    level = rt_hw_interrupt_disable();
+    while (tfd->expirations == 0)
+    {
+        rt_hw_interrupt_enable(level);
+
+        if (fd->flags & O_NONBLOCK)
+            return -EAGAIN;
+        rt_wqueue_wait(&(tfd->reader_queue), 0, -1);
+
+        level = rt_hw_interrupt_disable();
+    }
+    value = tfd->expirations;
+    tfd->expirations = 0;
+    rt_hw_interrupt_enable(level);
+
+    rt_memcpy(buf, &value, sizeof(uint64_t));
+
+    return sizeof(uint64_t);
+}
+
+static int timerfd_fops_poll(struct dfs_fd *fd, rt_pollreq_t *req)
+{
+    struct rt_timerfd *tfd;
+
+    tfd = (struct rt_timerfd *)fd->data;
+    rt_poll_add(&(tfd->reader_queue), req);
+
+    return tfd->expirations ? POLLIN : 0;
+}
+
+static const struct dfs_file_ops timerfd_fops =
+{
+    RT_NULL,
+    timerfd_fops_close,
+    RT_NULL,
+    timerfd_fops_read,
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    timerfd_fops_poll,
+};
+
+static struct dfs_fd *timerfd_get(int fd)
+{
+    struct dfs_fd *d;
+
+    d = fd_get(fd);
+    if (d == RT_NULL)
+        return RT_NULL;
+
+    if (d->fops != &timerfd_fops)
+    {
+        fd_put(d);
+        return RT_NULL;
+    }
+
+    return d;
+}
+
+/* the interrupt shall be disabled before invoking */
+static void timerfd_value_get(struct rt_timerfd *tfd, struct itimerspec *value)
+{
+    rt_tick_t remain = 0;
+
+    if (tfd->armed)
+    {
+        remain = tfd->expire - rt_tick_get();
+        if (remain >= RT_TICK_MAX / 2)
+            remain = 0;
+    }
+
+    tick_to_timespec(remain, &(value->it_value));
+    tick_to_timespec(tfd->interval, &(value->it_interval));
+}
+
+/**
+ * this function is a POSIX compliant version, which will create a timer
+ * that notifies the expirations via a file descriptor.
+ *
+ * @param clockid CLOCK_MONOTONIC or CLOCK_REALTIME.
+ * @param flags TFD_NONBLOCK or TFD_CLOEXEC.
+ *
+ * @return the file descriptor, -1 on failed.
+ */
+int timerfd_create(int clockid, int flags)
+{
+    int fd;
+    struct rt_timerfd *tfd;
+
+    if ((clockid != CLOCK_MONOTONIC && clockid != CLOCK_REALTIME) ||
+        (flags & ~(TFD_NONBLOCK | TFD_CLOEXEC)))
+    {
+        rt_set_errno(-EINVAL);
+        return -1;
+    }
+
+    tfd = rt_malloc(sizeof(struct rt_timerfd));
+    if (tfd == RT_NULL)
+    {
+        rt_set_errno(-ENOMEM);
+        return -1;
+    }
+
+    rt_timer_init(&(tfd->timer), "timerfd", timerfd_timeout, tfd, 1,
+                  RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_HARD_TIMER);
+    tfd->clockid = clockid;
+    tfd->expirations = 0;
+    tfd->interval = 0;
+    tfd->expire = 0;
+    tfd->armed = RT_FALSE;
+    rt_wqueue_init(&(tfd->reader_queue));
+
+    fd = fd_new_anon(&timerfd_fops, tfd, O_RDONLY | (flags & TFD_NONBLOCK));
+    if (fd < 0)
+    {
+        rt_timer_detach(&(tfd->timer));
+        rt_free(tfd);
+        rt_set_errno(-ENOMEM);
+        return -1;
+    }
+
+    return fd;
+}
+RTM_EXPORT(timerfd_create);
+
+/**
+ * this function is a POSIX compliant version, which will arm or disarm the
+ * timer of file descriptor.
+ *
+ * @param fd the file descriptor of timer.
+ * @param flags 0 for relative time, or TFD_TIMER_ABSTIME for the absolute
+ *        time since system startup of CLOCK_MONOTONIC.
+ * @param new_value the initial expiration and interval, zero it_value to
+ *        disarm the timer.
+ * @param old_value the previous setting will be saved in if it's not NULL.
+ *
+ * @return 0 on successful, -1 on failed.
+ */
+int timerfd_settime(int fd, int flags, const struct itimerspec *new_value,
+                    struct itimerspec *old_value)
+{
+    rt_base_t level;
+    rt_tick_t tick, interval, now;
+    struct dfs_fd *d;
+    struct rt_timerfd *tfd;
+
+    if (new_value == RT_NULL ||
+        new_value->it_value.tv_nsec < 0 ||
+        new_value->it_value.tv_nsec >= NANOSECOND_PER_SECOND ||
+        new_value->it_interval.tv_nsec < 0 ||
+        new_value->it_interval.tv_nsec >= NANOSECOND_PER_SECOND)
+    {
+        rt_set_errno(-EINVAL);
+        return -1;
+    }
+
+    d = timerfd_get(fd);
+    if (d == RT_NULL)
+    {
+        rt_set_errno(-EBADF);
+        return -1;
+    }
+    tfd = (struct rt_timerfd *)d->data;
+
+    /* only the time since system startup is known for absolute time */
+    if ((flags & TFD_TIMER_ABSTIME) && tfd->clockid != CLOCK_MONOTONIC)
+    {
+        fd_put(d);
+        rt_set_errno(-EINVAL);
+        return -1;
+    }
+
+    tick = timespec_to_tick(&(new_value->it_value));
+    interval = timespec_to_tick(&(new_value->it_interval));
+
+    level = rt_hw_interrupt_disable();
+    if (old_value)
+        timerfd_value_get(tfd, old_value);
+
+    rt_timer_stop(&(tfd->timer));
+    tfd->expirations = 0;
+    tfd->interval = interval;
+    tfd->armed = RT_FALSE;
+
+    if (new_value->it_value.tv_sec || new_value->it_value.tv_nsec)
+    {
+        now = rt_tick_get();
+        if (flags & TFD_TIMER_ABSTIME)
+        {
+            tick = tick - now;
+            /* it's expired, fire it on next tick */
+            if (tick == 0 || tick >= RT_TICK_MAX / 2)
+                tick = 1;
+        }
+
+        tfd->expire = now + tick;
+        tfd->armed = RT_TRUE;
+        rt_timer_control(&(tfd->timer), RT_TIMER_CTRL_SET_ONESHOT, RT_NULL);
+        rt_timer_control(&(tfd->timer), RT_TIMER_CTRL_SET_TIME, &tick);
+        rt_timer_start(&(tfd->timer));
+    }
+    rt_hw_interrupt_enable(level);
+
+    fd_put(d);
+
+    return 0;
+}
+RTM_EXPORT(timerfd_settime);
+
+/**
+ * this function is a POSIX compliant version, which will get the time until
+ * next expiration and the interval of the timer.
+ *
+ * @param fd the file descriptor of timer.
+ * @param curr_value the current setting will be saved in.
+ *
+ * @return 0 on successful, -1 on failed.
+ */
+int timerfd_gettime(int fd, struct itimerspec *curr_value)
+{
+    rt_base_t level;
+    struct dfs_fd *d;
+
+    if (curr_value == RT_NULL)
+    {
+        rt_set_errno(-EINVAL);
+        return -1;
+    }
+
+    d = timerfd_get(fd);
+    if (d == RT_NULL)
+    {
+        rt_set_errno(-EBADF);
+        return -1;
+    }
+
+    level = rt_hw_interrupt_disable();
+    timerfd_value_get((struct rt_timerfd *)d->data, curr_value);
+    rt_hw_interrupt_enable(level);
+
+    fd_put(d);
+
+    return 0;
+}
+RTM_EXPORT(timerfd_gettime);
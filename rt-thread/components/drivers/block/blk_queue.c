@@ -0,0 +1,535 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Request queue of block device.
+ *
+ * The requests are sorted by sector and dispatched by a one-way elevator in
+ * the thread of queue, the request waits longer than its deadline is served
+ * first. The following contiguous requests of the same direction are merged
+ * into one transfer of device, through a bounce buffer if their buffers are
+ * not contiguous. The order of arrival is kept while there are overlapped
+ * requests in queue.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#ifndef RT_BLK_QUEUE_MERGE_SECTORS
+#define RT_BLK_QUEUE_MERGE_SECTORS      64
+#endif
+
+#ifndef RT_BLK_QUEUE_READ_EXPIRE_MS
+#define RT_BLK_QUEUE_READ_EXPIRE_MS     100
+#endif
+
+#ifndef RT_BLK_QUEUE_WRITE_EXPIRE_MS
+#define RT_BLK_QUEUE_WRITE_EXPIRE_MS    1000
+#endif
+
+#ifndef RT_BLK_QUEUE_STACK_SIZE
+#define RT_BLK_QUEUE_STACK_SIZE         2048
+#endif
+
+#ifndef RT_BLK_QUEUE_THREAD_PRIORITY
+#define RT_BLK_QUEUE_THREAD_PRIORITY    20
+#endif
+
+static rt_list_t blk_queues = RT_LIST_OBJECT_INIT(blk_queues);
+
+#define blk_req_end(req)    ((req)->sector + (rt_off_t)(req)->count)
+
+static rt_bool_t blk_req_overlap(struct rt_blk_request *a, struct rt_blk_request *b)
+{
+    /* the readings don't depend on each other */
+    if (a->dir == RT_BLK_REQ_READ && b->dir == RT_BLK_REQ_READ)
+        return RT_FALSE;
+
+    return a->sector < blk_req_end(b) && b->sector < blk_req_end(a);
+}
+
+static struct rt_blk_request *blk_queue_pick(struct rt_blk_queue *queue)
+{
+    int dir;
+    rt_list_t *node;
+    rt_tick_t now;
+    struct rt_blk_request *req, *first[2] = {RT_NULL, RT_NULL};
+
+    for (dir = RT_BLK_REQ_READ; dir <= RT_BLK_REQ_WRITE; dir ++)
+    {
+        if (!rt_list_isempty(&(queue->fifo[dir])))
+            first[dir] = rt_list_entry(queue->fifo[dir].next, struct rt_blk_request, fifo_node);
+    }
+
+    /* keep the order of arrival for the overlapped requests */
+    if (queue->overlaps > 0)
+    {
+        if (first[RT_BLK_REQ_READ] == RT_NULL)
+            return first[RT_BLK_REQ_WRITE];
+        if (first[RT_BLK_REQ_WRITE] == RT_NULL)
+            return first[RT_BLK_REQ_READ];
+
+        return (rt_int32_t)(first[RT_BLK_REQ_READ]->seq - first[RT_BLK_REQ_WRITE]->seq) < 0 ?
+               first[RT_BLK_REQ_READ] : first[RT_BLK_REQ_WRITE];
+    }
+
+    /* the expired request, reading first */
+    now = rt_tick_get();
+    for (dir = RT_BLK_REQ_READ; dir <= RT_BLK_REQ_WRITE; dir ++)
+    {
+        if (first[dir] != RT_NULL && now - first[dir]->deadline < RT_TICK_MAX / 2)
+        {
+            queue->stat.expired ++;
+            return first[dir];
+        }
+    }
+
+    /* the nearest request after the last transfer */
+    rt_list_for_each(node, &(queue->sort_list))
+    {
+        req = rt_list_entry(node, struct rt_blk_request, sort_node);
+        if (req->sector >= queue->position)
+            return req;
+    }
+
+    return rt_list_entry(queue->sort_list.next, struct rt_blk_request, sort_node);
+}
+
+static void blk_queue_remove(struct rt_blk_queue *queue, struct rt_blk_request *req)
+{
+    rt_list_remove(&(req->sort_node));
+    rt_list_remove(&(req->fifo_node));
+    queue->depth --;
+    if (req->overlap)
+        queue->overlaps --;
+}
+
+/* take the request and merge the following ones, return the total sectors */
+static rt_size_t blk_queue_take(struct rt_blk_queue *queue, struct rt_blk_request *req)
+{
+    rt_size_t total = req->count;
+    rt_list_t *node = req->sort_node.next;
+    struct rt_blk_request *last = req, *next;
+
+    blk_queue_remove(queue, req);
+    req->merged = RT_NULL;
+
+    while (queue->overlaps == 0 && node != &(queue->sort_list))
+    {
+        next = rt_list_entry(node, struct rt_blk_request, sort_node);
+        if (next->dir != req->dir || next->sector != blk_req_end(last) ||
+            total + next->count > queue->max_merge)
+            break;
+
+        node = node->next;
+        blk_queue_remove(queue, next);
+        next->merged = RT_NULL;
+        last->merged = next;
+        last = next;
+        total += next->count;
+        queue->stat.merges ++;
+    }
+
+    return total;
+}
+
+static rt_err_t blk_queue_transfer(struct rt_blk_queue *queue, struct rt_blk_request *req,
+                                   rt_size_t total)
+{
+    rt_err_t result = RT_EOK;
+    rt_size_t count;
+    rt_off_t sector;
+    rt_uint8_t *ptr;
+    struct rt_blk_request *r;
+
+    /* the buffers are contiguous, transfer without copying */
+    for (r = req; r->merged != RT_NULL; r = r->merged)
+    {
+        if ((rt_uint8_t *)r->buffer + r->count * queue->sector_size != r->merged->buffer)
+            break;
+    }
+
+    if (r->merged == RT_NULL || queue->bounce == RT_NULL)
+    {
+        if (r->merged != RT_NULL)
+            total = req->count;
+
+        sector = req->sector;
+        ptr = (rt_uint8_t *)req->buffer;
+        while (total > 0 && result == RT_EOK)
+        {
+            count = total > queue->max_blk_count ? queue->max_blk_count : total;
+            result = queue->ops->transfer(queue, sector, ptr, count, req->dir);
+            queue->stat.transfers ++;
+
+            sector += count;
+            ptr += count * queue->sector_size;
+            total -= count;
+        }
+
+        /* the merged requests can't be transferred without bounce buffer */
+        if (r->merged != RT_NULL && result == RT_EOK)
+        {
+            for (r = req->merged; r != RT_NULL && result == RT_EOK; r = r->merged)
+            {
+                result = queue->ops->transfer(queue, r->sector, r->buffer, r->count, r->dir);
+                queue->stat.transfers ++;
+            }
+        }
+
+        return result;
+    }
+
+    if (req->dir == RT_BLK_REQ_WRITE)
+    {
+        for (r = req, ptr = queue->bounce; r != RT_NULL; r = r->merged)
+        {
+            rt_memcpy(ptr, r->buffer, r->count * queue->sector_size);
+            ptr += r->count * queue->sector_size;
+        }
+    }
+
+    result = queue->ops->transfer(queue, req->sector, queue->bounce, total, req->dir);
+    queue->stat.transfers ++;
+
+    if (req->dir == RT_BLK_REQ_READ && result == RT_EOK)
+    {
+        for (r = req, ptr = queue->bounce; r != RT_NULL; r = r->merged)
+        {
+            rt_memcpy(r->buffer, ptr, r->count * queue->sector_size);
+            ptr += r->count * queue->sector_size;
+        }
+    }
+
+    return result;
+}
+
+static void blk_queue_thread_entry(void *parameter)
+{
+    rt_err_t result;
+    rt_size_t total;
+    struct rt_blk_request *req, *next;
+    struct rt_blk_queue *queue = (struct rt_blk_queue *)parameter;
+
+    while (!queue->stop)
+    {
+        rt_sem_take(&(queue->sem), RT_WAITING_FOREVER);
+
+        while (1)
+        {
+            rt_mutex_take(&(queue->lock), RT_WAITING_FOREVER);
+            if (queue->depth == 0)
+            {
+                rt_mutex_release(&(queue->lock));
+                break;
+            }
+            req = blk_queue_pick(queue);
+            total = blk_queue_take(queue, req);
+            queue->position = req->sector + total;
+            rt_mutex_release(&(queue->lock));
+
+            result = blk_queue_transfer(queue, req, total);
+            if (result == RT_EOK)
+                queue->stat.sectors[req->dir] += total;
+            else
+                queue->stat.errors ++;
+
+            /* the request may be released in completion */
+            for (; req != RT_NULL; req = next)
+            {
+                next = req->merged;
+                req->result = result;
+                if (req->done != RT_NULL)
+                    req->done(req);
+            }
+        }
+    }
+
+    rt_completion_done(&(queue->exited));
+}
+
+/**
+ * This function will initialize a request queue of block device and start
+ * its thread.
+ *
+ * @param queue the request queue.
+ * @param name the name of queue and its thread.
+ * @param ops the operations of device.
+ * @param sector_size the bytes of sector.
+ * @param max_blk_count the maximal sectors of a transfer of device.
+ * @param user_data the private data of device.
+ *
+ * @return RT_EOK on successful, -RT_ENOMEM on failed.
+ */
+rt_err_t rt_blk_queue_init(struct rt_blk_queue *queue, const char *name,
+                           const struct rt_blk_queue_ops *ops,
+                           rt_size_t sector_size, rt_size_t max_blk_count,
+                           void *user_data)
+{
+    rt_base_t level;
+
+    RT_ASSERT(queue != RT_NULL);
+    RT_ASSERT(ops != RT_NULL && ops->transfer != RT_NULL);
+    RT_ASSERT(sector_size > 0 && max_blk_count > 0);
+
+    rt_memset(queue, 0, sizeof(struct rt_blk_queue));
+    rt_strncpy(queue->name, name, RT_NAME_MAX);
+    queue->ops = ops;
+    queue->user_data = user_data;
+    queue->sector_size = sector_size;
+    queue->max_blk_count = max_blk_count;
+    queue->max_merge = max_blk_count < RT_BLK_QUEUE_MERGE_SECTORS ?
+                       max_blk_count : RT_BLK_QUEUE_MERGE_SECTORS;
+
+    rt_list_init(&(queue->sort_list));
+    rt_list_init(&(queue->fifo[RT_BLK_REQ_READ]));
+    rt_list_init(&(queue->fifo[RT_BLK_REQ_WRITE]));
+
+    /* the requests are transferred one by one without bounce buffer */
+    if (queue->max_merge > 1)
+        queue->bounce = rt_malloc_align(queue->max_merge * sector_size, RT_CPU_CACHE_LINE_SZ);
+
+    queue->thread = rt_thread_create(name, blk_queue_thread_entry, queue,
+                                     RT_BLK_QUEUE_STACK_SIZE,
+                                     RT_BLK_QUEUE_THREAD_PRIORITY, 10);
+    if (queue->thread == RT_NULL)
+    {
+        if (queue->bounce != RT_NULL)
+            rt_free_align(queue->bounce);
+
+        return -RT_ENOMEM;
+    }
+
+    rt_mutex_init(&(queue->lock), name, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&(queue->sem), name, 0, RT_IPC_FLAG_FIFO);
+    rt_completion_init(&(queue->exited));
+
+    level = rt_hw_interrupt_disable();
+    rt_list_insert_after(&blk_queues, &(queue->list));
+    rt_hw_interrupt_enable(level);
+
+    rt_thread_startup(queue->thread);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_blk_queue_init);
+
+/**
+ * This function will stop the thread of queue after all the requests
+ * completed, and release the resource of queue.
+ *
+ * @param queue the request queue.
+ */
+void rt_blk_queue_detach(struct rt_blk_queue *queue)
+{
+    rt_base_t level;
+
+    RT_ASSERT(queue != RT_NULL);
+
+    level = rt_hw_interrupt_disable();
+    rt_list_remove(&(queue->list));
+    rt_hw_interrupt_enable(level);
+
+    queue->stop = RT_TRUE;
+    rt_sem_release(&(queue->sem));
+    rt_completion_wait(&(queue->exited), RT_WAITING_FOREVER);
+
+    rt_sem_detach(&(queue->sem));
+    rt_mutex_detach(&(queue->lock));
+    if (queue->bounce != RT_NULL)
+        rt_free_align(queue->bounce);
+    queue->bounce = RT_NULL;
+}
+RTM_EXPORT(rt_blk_queue_detach);
+
+/**
+ * This function will initialize a request.
+ *
+ * @param req the request.
+ * @param dir RT_BLK_REQ_READ or RT_BLK_REQ_WRITE.
+ * @param sector the first sector.
+ * @param buffer the data buffer.
+ * @param count the number of sectors.
+ * @param done the callback on completion, which is invoked in the thread of
+ *        queue and shall not wait for another request of the queue.
+ * @param user_data the private data of the callback.
+ */
+void rt_blk_request_init(struct rt_blk_request *req, rt_uint8_t dir,
+                         rt_off_t sector, void *buffer, rt_size_t count,
+                         rt_blk_done_t done, void *user_data)
+{
+    RT_ASSERT(req != RT_NULL);
+    RT_ASSERT(dir == RT_BLK_REQ_READ || dir == RT_BLK_REQ_WRITE);
+
+    rt_memset(req, 0, sizeof(struct rt_blk_request));
+    rt_list_init(&(req->sort_node));
+    rt_list_init(&(req->fifo_node));
+    req->dir = dir;
+    req->sector = sector;
+    req->buffer = buffer;
+    req->count = count;
+    req->done = done;
+    req->user_data = user_data;
+}
+RTM_EXPORT(rt_blk_request_init);
+
+/**
+ * This function will submit a request to queue, the result is reported by
+ * the callback of request.
+ *
+ * @param queue the request queue.
+ * @param req the request, which shall be kept until it's completed.
+ *
+ * @return RT_EOK on successful, -RT_EINVAL on empty request.
+ */
+rt_err_t rt_blk_queue_submit(struct rt_blk_queue *queue, struct rt_blk_request *req)
+{
+    rt_list_t *node;
+    struct rt_blk_request *r;
+
+    RT_ASSERT(queue != RT_NULL);
+    RT_ASSERT(req != RT_NULL);
+
+    if (req->count == 0)
+        return -RT_EINVAL;
+
+    req->overlap = RT_FALSE;
+    req->merged = RT_NULL;
+    req->result = RT_EOK;
+    req->deadline = rt_tick_get() + rt_tick_from_millisecond(req->dir == RT_BLK_REQ_READ ?
+                    RT_BLK_QUEUE_READ_EXPIRE_MS : RT_BLK_QUEUE_WRITE_EXPIRE_MS);
+
+    rt_mutex_take(&(queue->lock), RT_WAITING_FOREVER);
+    req->seq = queue->seq ++;
+
+    /* insert in the order of sector */
+    rt_list_for_each(node, &(queue->sort_list))
+    {
+        r = rt_list_entry(node, struct rt_blk_request, sort_node);
+        if (!req->overlap && blk_req_overlap(req, r))
+        {
+            req->overlap = RT_TRUE;
+            queue->overlaps ++;
+        }
+        if (r->sector > req->sector)
+            break;
+    }
+    rt_list_insert_before(node, &(req->sort_node));
+
+    /* check the rest for overlapping */
+    for (; !req->overlap && node != &(queue->sort_list); node = node->next)
+    {
+        r = rt_list_entry(node, struct rt_blk_request, sort_node);
+        if (r->sector >= blk_req_end(req))
+            break;
+        if (blk_req_overlap(req, r))
+        {
+            req->overlap = RT_TRUE;
+            queue->overlaps ++;
+        }
+    }
+
+    rt_list_insert_before(&(queue->fifo[req->dir]), &(req->fifo_node));
+    queue->depth ++;
+    if (queue->depth > queue->stat.max_depth)
+        queue->stat.max_depth = queue->depth;
+    queue->stat.reqs[req->dir] ++;
+    rt_mutex_release(&(queue->lock));
+
+    rt_sem_release(&(queue->sem));
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_blk_queue_submit);
+
+static void blk_sync_done(struct rt_blk_request *req)
+{
+    rt_completion_done((struct rt_completion *)req->user_data);
+}
+
+static rt_size_t blk_queue_sync(struct rt_blk_queue *queue, rt_uint8_t dir,
+                                rt_off_t sector, void *buffer, rt_size_t count)
+{
+    struct rt_blk_request req;
+    struct rt_completion done;
+
+    rt_completion_init(&done);
+    rt_blk_request_init(&req, dir, sector, buffer, count, blk_sync_done, &done);
+    if (rt_blk_queue_submit(queue, &req) != RT_EOK)
+        return 0;
+
+    rt_completion_wait(&done, RT_WAITING_FOREVER);
+
+    return req.result == RT_EOK ? count : 0;
+}
+
+/**
+ * This function will read sectors through the queue and wait for the
+ * completion. It shall not be invoked in the callback of request.
+ *
+ * @param queue the request queue.
+ * @param sector the first sector.
+ * @param buffer the buffer to save data.
+ * @param count the number of sectors.
+ *
+ * @return the number of sectors read, 0 on failed.
+ */
+rt_size_t rt_blk_queue_read(struct rt_blk_queue *queue, rt_off_t sector,
+                            void *buffer, rt_size_t count)
+{
+    return blk_queue_sync(queue, RT_BLK_REQ_READ, sector, buffer, count);
+}
+RTM_EXPORT(rt_blk_queue_read);
+
+/**
+ * This function will write sectors through the queue and wait for the
+ * completion. It shall not be invoked in the callback of request.
+ *
+ * @param queue the request queue.
+ * @param sector the first sector.
+ * @param buffer the data to be written.
+ * @param count the number of sectors.
+ *
+ * @return the number of sectors written, 0 on failed.
+ */
+rt_size_t rt_blk_queue_write(struct rt_blk_queue *queue, rt_off_t sector,
+                             const void *buffer, rt_size_t count)
+{
+    return blk_queue_sync(queue, RT_BLK_REQ_WRITE, sector, (void *)buffer, count);
+}
+RTM_EXPORT(rt_blk_queue_write);
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+int list_blk_queue(void)
+{
+    rt_base_t level;
+    rt_list_t *node;
+    struct rt_blk_queue *queue;
+
+    rt_kprintf("queue    reads    writes   rd-sect  wr-sect  xfers    merges   expired  errors   depth\n");
+    rt_kprintf("-------- -------- -------- -------- -------- -------- -------- -------- -------- -----\n");
+
+    level = rt_hw_interrupt_disable();
+    rt_list_for_each(node, &blk_queues)
+    {
+        queue = rt_list_entry(node, struct rt_blk_queue, list);
+        rt_kprintf("%-8.*s %-8d %-8d %-8d %-8d %-8d %-8d %-8d %-8d %d\n",
+                   RT_NAME_MAX, queue->name,
+                   queue->stat.reqs[RT_BLK_REQ_READ], queue->stat.reqs[RT_BLK_REQ_WRITE],
+                   queue->stat.sectors[RT_BLK_REQ_READ], queue->stat.sectors[RT_BLK_REQ_WRITE],
+                   queue->stat.transfers, queue->stat.merges, queue->stat.expired,
+                   queue->stat.errors, queue->stat.max_depth);
+    }
+    rt_hw_interrupt_enable(level);
+
+    return 0;
+}
+FINSH_FUNCTION_EXPORT(list_blk_queue, list request queues of block device);
+MSH_CMD_EXPORT(list_blk_queue, list request queues of block device);
+#endif
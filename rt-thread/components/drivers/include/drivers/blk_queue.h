@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __BLK_QUEUE_H__
+#define __BLK_QUEUE_H__
+
+#include <rtdevice.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RT_BLK_REQ_READ         0
+#define RT_BLK_REQ_WRITE        1
+
+struct rt_blk_queue;
+struct rt_blk_request;
+
+typedef void (*rt_blk_done_t)(struct rt_blk_request *req);
+
+struct rt_blk_request
+{
+    rt_list_t sort_node;                /* in the order of sector */
+    rt_list_t fifo_node;                /* in the order of arrival */
+
+    rt_off_t  sector;
+    rt_size_t count;                    /* number of sectors */
+    void     *buffer;
+    rt_uint8_t dir;                     /* RT_BLK_REQ_READ or RT_BLK_REQ_WRITE */
+    rt_bool_t overlap;                  /* overlapped with a queued request */
+
+    rt_uint32_t seq;                    /* the sequence of arrival */
+    rt_tick_t deadline;
+
+    rt_err_t result;
+    rt_blk_done_t done;                 /* invoked in the thread of queue */
+    void *user_data;
+
+    struct rt_blk_request *merged;      /* the next request of transfer */
+};
+
+struct rt_blk_queue_ops
+{
+    /* transfer the contiguous sectors, the count isn't more than max_blk_count */
+    rt_err_t (*transfer)(struct rt_blk_queue *queue, rt_off_t sector, void *buffer,
+                         rt_size_t count, rt_uint8_t dir);
+};
+
+struct rt_blk_queue_stat
+{
+    rt_uint32_t reqs[2];                /* submitted requests */
+    rt_uint32_t sectors[2];             /* transferred sectors */
+    rt_uint32_t transfers;              /* transfers of device */
+    rt_uint32_t merges;                 /* requests merged into a transfer */
+    rt_uint32_t expired;                /* requests dispatched by deadline */
+    rt_uint32_t errors;
+    rt_uint32_t max_depth;
+};
+
+struct rt_blk_queue
+{
+    char name[RT_NAME_MAX];
+    rt_list_t list;
+
+    const struct rt_blk_queue_ops *ops;
+    void *user_data;
+
+    rt_size_t sector_size;
+    rt_size_t max_blk_count;            /* the maximal sectors of a transfer */
+    rt_size_t max_merge;                /* the maximal sectors of merging */
+
+    struct rt_mutex lock;
+    rt_list_t sort_list;
+    rt_list_t fifo[2];
+    rt_size_t depth;
+    rt_size_t overlaps;
+    rt_uint32_t seq;
+    rt_off_t position;                  /* the sector after last transfer */
+
+    struct rt_semaphore sem;
+    rt_thread_t thread;
+    rt_bool_t stop;
+    struct rt_completion exited;
+    rt_uint8_t *bounce;                 /* buffer of merged transfer */
+
+    struct rt_blk_queue_stat stat;
+};
+
+rt_err_t rt_blk_queue_init(struct rt_blk_queue *queue, const char *name,
+                           const struct rt_blk_queue_ops *ops,
+                           rt_size_t sector_size, rt_size_t max_blk_count,
+                           void *user_data);
+void rt_blk_queue_detach(struct rt_blk_queue *queue);
+
+void rt_blk_request_init(struct rt_blk_request *req, rt_uint8_t dir,
+                         rt_off_t sector, void *buffer, rt_size_t count,
+                         rt_blk_done_t done, void *user_data);
+rt_err_t rt_blk_queue_submit(struct rt_blk_queue *queue, struct rt_blk_request *req);
+
+rt_size_t rt_blk_queue_read(struct rt_blk_queue *queue, rt_off_t sector,
+                            void *buffer, rt_size_t count);
+rt_size_t rt_blk_queue_write(struct rt_blk_queue *queue, rt_off_t sector,
+                             const void *buffer, rt_size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
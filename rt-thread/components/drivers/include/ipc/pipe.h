@@ -17,20 +17,39 @@ struct rt_pipe_device
 {
     struct rt_device parent;
 
-    /* ring buffer in pipe device */
-    struct rt_ringbuffer *fifo;
-    rt_uint16_t bufsz;
+    /* fifo buffer in pipe device */
+    rt_uint8_t *fifo;
+    rt_size_t bufsz;
+    rt_size_t read_index;
+    rt_size_t data_len;
 
     rt_uint8_t readers;
     rt_uint8_t writers;
+    rt_uint8_t reader_waiting;      /* the readers blocked on empty fifo */
+    rt_uint8_t writer_waiting;      /* the writers blocked on full fifo */
 
     rt_wqueue_t reader_queue;
     rt_wqueue_t writer_queue;
 
-    struct rt_mutex lock;
+    struct rt_mutex lock;           /* protect the fifo indexes and states */
+    struct rt_mutex read_lock;      /* serialize the readers */
+    struct rt_mutex write_lock;     /* serialize the writers */
 };
 typedef struct rt_pipe_device rt_pipe_t;
 
 rt_pipe_t *rt_pipe_create(const char *name, int bufsz);
 int rt_pipe_delete(const char *name);
+
+#ifdef RT_USING_POSIX
+#include <sys/types.h>
+
+/* fcntl commands to get and set the capacity of pipe */
+#define F_SETPIPE_SZ        1031
+#define F_GETPIPE_SZ        1032
+
+#define SPLICE_F_NONBLOCK   0x02
+
+ssize_t splice(int fd_in, off_t *off_in, int fd_out, off_t *off_out,
+               size_t len, unsigned int flags);
+#endif
 #endif /* PIPE_H__ */
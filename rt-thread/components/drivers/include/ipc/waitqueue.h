@@ -32,6 +32,9 @@
 #define RT_WQ_FLAG_WAKEUP   0x01
 
 struct rt_wqueue_node;
+/* the wakeup function returns 0 to resume the polling thread and stop, a
+ * negative value to go on with the next node, or a positive value to go on
+ * after it has resumed its own waiters without scheduling. */
 typedef int (*rt_wqueue_func_t)(struct rt_wqueue_node *wait, void *key);
 
 struct rt_wqueue_node
@@ -13,12 +13,22 @@ struct rt_workqueue
     rt_thread_t    work_thread;
 };
 
+struct rt_work_pool;
+
+/* work state */
+#define RT_WORK_STATE_PENDING    0x0001     /* work is in the list of a pool */
+#define RT_WORK_STATE_DELAYED    0x0002     /* work is waiting for its time */
+
 struct rt_work
 {
     rt_list_t list;
 
     void (*work_func)(struct rt_work* work, void* work_data);
     void *work_data;
+
+    rt_uint16_t flags;
+    rt_tick_t timeout;                      /* expiration tick of delayed work */
+    struct rt_work_pool *pool;              /* the pool work is submitted to */
 };
 
 #ifdef RT_USING_HEAP
@@ -31,12 +41,31 @@ rt_err_t rt_workqueue_dowork(struct rt_workqueue* queue, struct rt_work* work);
 rt_err_t rt_workqueue_cancel_work(struct rt_workqueue* queue, struct rt_work* work);
 rt_err_t rt_workqueue_cancel_work_sync(struct rt_workqueue* queue, struct rt_work* work);
 
+#ifdef RT_USING_SYSTEM_WORKQUEUE
+/**
+ * System WorkQueue, one worker pool per CPU and an unbound high priority pool
+ */
+#define RT_WORK_CPU_ANY         (-1)
+
+int rt_work_sys_init(void);
+rt_err_t rt_work_submit(struct rt_work* work);
+rt_err_t rt_work_submit_on(struct rt_work* work, int cpu);
+rt_err_t rt_work_submit_delayed(struct rt_work* work, rt_tick_t ticks);
+rt_err_t rt_work_submit_delayed_on(struct rt_work* work, int cpu, rt_tick_t ticks);
+rt_err_t rt_work_submit_highpri(struct rt_work* work);
+rt_err_t rt_work_cancel(struct rt_work* work);
+rt_err_t rt_work_cancel_sync(struct rt_work* work);
+#endif
+
 rt_inline void rt_work_init(struct rt_work* work, void (*work_func)(struct rt_work* work, void* work_data),
     void* work_data)
 {
     rt_list_init(&(work->list));
     work->work_func = work_func;
     work->work_data = work_data;
+    work->flags = 0;
+    work->timeout = 0;
+    work->pool = RT_NULL;
 }
 #endif
 
@@ -12,6 +12,9 @@
 #include <dfs_fs.h>
 
 #include <drivers/mmcsd_core.h>
+#ifdef RT_USING_BLK_QUEUE
+#include <drivers/blk_queue.h>
+#endif
 
 #define DBG_ENABLE
 #define DBG_SECTION_NAME               "[SDIO]"
@@ -35,6 +38,9 @@ struct mmcsd_blk_device
     struct dfs_partition part;
     struct rt_device_blk_geometry geometry;
     rt_size_t max_req_size;
+#ifdef RT_USING_BLK_QUEUE
+    struct rt_blk_queue queue;
+#endif
 };
 
 #ifndef RT_MMCSD_MAX_PARTITION
@@ -227,6 +233,13 @@ static rt_err_t rt_mmcsd_control(rt_device_t dev, int cmd, void *args)
     case RT_DEVICE_CTRL_BLK_GETGEOME:
         rt_memcpy(args, &blk_dev->geometry, sizeof(struct rt_device_blk_geometry));
         break;
+#ifdef RT_USING_BLK_QUEUE
+    case RT_DEVICE_CTRL_BLK_QUEUE:
+        if (blk_dev->queue.thread == RT_NULL)
+            return -RT_ENOSYS;
+        *(struct rt_blk_queue **)args = &blk_dev->queue;
+        break;
+#endif
     default:
         break;
     }
@@ -252,6 +265,18 @@ static rt_size_t rt_mmcsd_read(rt_device_t dev,
         return 0;
     }
 
+#ifdef RT_USING_BLK_QUEUE
+    if (blk_dev->queue.thread != RT_NULL)
+    {
+        if (rt_blk_queue_read(&blk_dev->queue, part->offset + pos, buffer, size) != size)
+        {
+            rt_set_errno(-EIO);
+            return 0;
+        }
+        return size;
+    }
+#endif
+
     rt_sem_take(part->lock, RT_WAITING_FOREVER);
     while (remain_size)
     {
@@ -293,6 +318,18 @@ static rt_size_t rt_mmcsd_write(rt_device_t dev,
         return 0;
     }
 
+#ifdef RT_USING_BLK_QUEUE
+    if (blk_dev->queue.thread != RT_NULL)
+    {
+        if (rt_blk_queue_write(&blk_dev->queue, part->offset + pos, buffer, size) != size)
+        {
+            rt_set_errno(-EIO);
+            return 0;
+        }
+        return size;
+    }
+#endif
+
     rt_sem_take(part->lock, RT_WAITING_FOREVER);
     while (remain_size)
     {
@@ -342,6 +379,33 @@ static rt_int32_t mmcsd_set_blksize(struct rt_mmcsd_card *card)
     return 0;
 }
 
+#ifdef RT_USING_BLK_QUEUE
+static rt_err_t rt_mmcsd_transfer(struct rt_blk_queue *queue, rt_off_t sector,
+                                  void *buffer, rt_size_t count, rt_uint8_t dir)
+{
+    struct mmcsd_blk_device *blk_dev = (struct mmcsd_blk_device *)queue->user_data;
+
+    return rt_mmcsd_req_blk(blk_dev->card, sector, buffer, count,
+                            dir == RT_BLK_REQ_WRITE ? 1 : 0);
+}
+
+static const struct rt_blk_queue_ops mmcsd_queue_ops =
+{
+    rt_mmcsd_transfer
+};
+
+static void mmcsd_blk_queue_init(struct mmcsd_blk_device *blk_dev, int index)
+{
+    char qname[8];
+
+    /* the device is accessed directly if the queue is not available */
+    rt_snprintf(qname, 8, "sdq%d", index);
+    if (rt_blk_queue_init(&blk_dev->queue, qname, &mmcsd_queue_ops, 1 << 9,
+                          blk_dev->max_req_size, blk_dev) != RT_EOK)
+        LOG_E("create request queue of sd%d failed!", index);
+}
+#endif
+
 #ifdef RT_USING_DEVICE_OPS
 const static struct rt_device_ops mmcsd_blk_ops = 
 {
@@ -424,6 +488,9 @@ rt_int32_t rt_mmcsd_blk_probe(struct rt_mmcsd_card *card)
                 blk_dev->geometry.bytes_per_sector = 1<<9;
                 blk_dev->geometry.block_size = card->card_blksize;
                 blk_dev->geometry.sector_count = blk_dev->part.size;
+#ifdef RT_USING_BLK_QUEUE
+                mmcsd_blk_queue_init(blk_dev, i);
+#endif
     
                 rt_device_register(&blk_dev->dev, dname,
                     RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_REMOVABLE | RT_DEVICE_FLAG_STANDALONE);
@@ -458,6 +525,9 @@ rt_int32_t rt_mmcsd_blk_probe(struct rt_mmcsd_card *card)
                     blk_dev->geometry.block_size = card->card_blksize;
                     blk_dev->geometry.sector_count = 
                         card->card_capacity * (1024 / 512);
+#ifdef RT_USING_BLK_QUEUE
+                    mmcsd_blk_queue_init(blk_dev, 0);
+#endif
     
                     rt_device_register(&blk_dev->dev, "sd0",
                         RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_REMOVABLE | RT_DEVICE_FLAG_STANDALONE);
@@ -513,6 +583,10 @@ void rt_mmcsd_blk_remove(struct rt_mmcsd_card *card)
         	}
 
             rt_device_unregister(&blk_dev->dev);
+#ifdef RT_USING_BLK_QUEUE
+            if (blk_dev->queue.thread != RT_NULL)
+                rt_blk_queue_detach(&blk_dev->queue);
+#endif
             rt_list_remove(&blk_dev->list);
             rt_free(blk_dev);
         }
@@ -30,6 +30,255 @@
 #include <dfs_file.h>
 #include <dfs_posix.h>
 #include <dfs_poll.h>
+#endif
+
+/*
+ * The fifo helpers shall be invoked with the pipe lock held. The data between
+ * read_index and read_index + data_len belongs to the reader, the rest belongs
+ * to the writer, so the reader and writer can access their own region out of
+ * the pipe lock once it's got.
+ */
+rt_inline rt_size_t pipe_space_len(rt_pipe_t *pipe)
+{
+    return pipe->bufsz - pipe->data_len;
+}
+
+/* get the contiguous data region at the read position */
+static rt_size_t pipe_data_region(rt_pipe_t *pipe, rt_uint8_t **ptr)
+{
+    rt_size_t len;
+
+    len = pipe->bufsz - pipe->read_index;
+    if (len > pipe->data_len)
+        len = pipe->data_len;
+    *ptr = pipe->fifo + pipe->read_index;
+
+    return len;
+}
+
+/* get the contiguous free region at the write position */
+static rt_size_t pipe_space_region(rt_pipe_t *pipe, rt_uint8_t **ptr)
+{
+    rt_size_t index, len;
+
+    /* no reader region is outstanding when fifo is empty, restart at the
+     * beginning of buffer to get the largest region */
+    if (pipe->data_len == 0)
+        pipe->read_index = 0;
+
+    index = pipe->read_index + pipe->data_len;
+    if (index >= pipe->bufsz)
+        index -= pipe->bufsz;
+
+    len = pipe->bufsz - index;
+    if (len > pipe_space_len(pipe))
+        len = pipe_space_len(pipe);
+    *ptr = pipe->fifo + index;
+
+    return len;
+}
+
+rt_inline void pipe_consume(rt_pipe_t *pipe, rt_size_t len)
+{
+    pipe->read_index += len;
+    if (pipe->read_index >= pipe->bufsz)
+        pipe->read_index -= pipe->bufsz;
+    pipe->data_len -= len;
+}
+
+rt_inline void pipe_produce(rt_pipe_t *pipe, rt_size_t len)
+{
+    pipe->data_len += len;
+}
+
+static rt_size_t pipe_get(rt_pipe_t *pipe, rt_uint8_t *buf, rt_size_t count)
+{
+    rt_size_t len, total = 0;
+    rt_uint8_t *ptr;
+
+    while (total < count && pipe->data_len)
+    {
+        len = pipe_data_region(pipe, &ptr);
+        if (len > count - total)
+            len = count - total;
+
+        rt_memcpy(buf + total, ptr, len);
+        pipe_consume(pipe, len);
+        total += len;
+    }
+
+    return total;
+}
+
+static rt_size_t pipe_put(rt_pipe_t *pipe, const rt_uint8_t *buf, rt_size_t count)
+{
+    rt_size_t len, total = 0;
+    rt_uint8_t *ptr;
+
+    while (total < count && pipe_space_len(pipe))
+    {
+        len = pipe_space_region(pipe, &ptr);
+        if (len > count - total)
+            len = count - total;
+
+        rt_memcpy(ptr, buf + total, len);
+        pipe_produce(pipe, len);
+        total += len;
+    }
+
+    return total;
+}
+
+static rt_uint8_t *pipe_fifo_alloc(rt_size_t bufsz)
+{
+    return (rt_uint8_t *)rt_malloc(bufsz);
+}
+
+static void pipe_fifo_free(rt_pipe_t *pipe)
+{
+    if (pipe->fifo)
+    {
+        rt_free(pipe->fifo);
+        pipe->fifo = RT_NULL;
+    }
+    pipe->read_index = 0;
+    pipe->data_len = 0;
+}
+
+#if defined(RT_USING_POSIX)
+/*
+ * wake up the queue only when a thread is blocked (or going to block) on it,
+ * or it's polled. The waiting count is updated with the pipe lock held, which
+ * is held by the caller too.
+ */
+static void pipe_wakeup(rt_wqueue_t *queue, rt_uint8_t waiting, rt_uint32_t key)
+{
+    rt_base_t level;
+    int empty;
+
+    if (waiting == 0)
+    {
+        level = rt_hw_interrupt_disable();
+        empty = rt_list_isempty(&(queue->waiting_list));
+        rt_hw_interrupt_enable(level);
+
+        if (empty)
+            return;
+    }
+
+    rt_wqueue_wakeup(queue, (void*)key);
+}
+
+/*
+ * wait for data in fifo with the pipe lock held.
+ *
+ * @return 1 if there is data, 0 on end-of-file, or -EAGAIN.
+ */
+static int pipe_wait_data(rt_pipe_t *pipe, int nonblock)
+{
+    while (pipe->data_len == 0)
+    {
+        /* no process has the pipe open for writing, return end-of-file */
+        if (pipe->writers == 0)
+            return 0;
+
+        if (nonblock)
+            return -EAGAIN;
+
+        pipe->reader_waiting ++;
+        rt_mutex_release(&(pipe->lock));
+        rt_wqueue_wait(&(pipe->reader_queue), 0, -1);
+        rt_mutex_take(&(pipe->lock), RT_WAITING_FOREVER);
+        pipe->reader_waiting --;
+    }
+
+    return 1;
+}
+
+/*
+ * wait for space in fifo with the pipe lock held.
+ *
+ * @return 1 if there is space, -EPIPE or -EAGAIN.
+ */
+static int pipe_wait_space(rt_pipe_t *pipe, int nonblock)
+{
+    while (1)
+    {
+        if (pipe->readers == 0)
+            return -EPIPE;
+
+        if (pipe_space_len(pipe) != 0)
+            break;
+
+        if (nonblock)
+            return -EAGAIN;
+
+        /* pipe full, waiting on suspended write list */
+        pipe->writer_waiting ++;
+        rt_mutex_release(&(pipe->lock));
+        rt_wqueue_wait(&(pipe->writer_queue), 0, -1);
+        rt_mutex_take(&(pipe->lock), RT_WAITING_FOREVER);
+        pipe->writer_waiting --;
+    }
+
+    return 1;
+}
+
+static int pipe_resize(rt_pipe_t *pipe, int bufsz)
+{
+    int result;
+    rt_uint8_t *fifo;
+
+    if (bufsz <= 0)
+        return -EINVAL;
+
+    rt_mutex_take(&(pipe->write_lock), RT_WAITING_FOREVER);
+    /* don't wait for a reader which may be blocked for the writer */
+    if (rt_mutex_take(&(pipe->read_lock), 0) != RT_EOK)
+    {
+        rt_mutex_release(&(pipe->write_lock));
+        return -EBUSY;
+    }
+    rt_mutex_take(&(pipe->lock), RT_WAITING_FOREVER);
+
+    if ((rt_size_t)bufsz < pipe->data_len)
+    {
+        result = -EBUSY;
+        goto __exit;
+    }
+
+    fifo = pipe_fifo_alloc(bufsz);
+    if (fifo == RT_NULL)
+    {
+        result = -ENOMEM;
+        goto __exit;
+    }
+
+    if (pipe->fifo)
+    {
+        rt_size_t len;
+
+        len = pipe->data_len;
+        pipe_get(pipe, fifo, len);
+        rt_free(pipe->fifo);
+
+        pipe->data_len = len;
+    }
+    pipe->fifo = fifo;
+    pipe->read_index = 0;
+    pipe->bufsz = bufsz;
+
+    if (pipe_space_len(pipe))
+        pipe_wakeup(&(pipe->writer_queue), pipe->writer_waiting, POLLOUT);
+    result = bufsz;
+
+__exit:
+    rt_mutex_release(&(pipe->lock));
+    rt_mutex_release(&(pipe->read_lock));
+    rt_mutex_release(&(pipe->write_lock));
+
+    return result;
+}
 
 static int pipe_fops_open(struct dfs_fd *fd)
 {
@@ -44,7 +293,12 @@ static int pipe_fops_open(struct dfs_fd *fd)
 
     if (device->ref_count == 0)
     {
-        pipe->fifo = rt_ringbuffer_create(pipe->bufsz);
+        pipe->fifo = pipe_fifo_alloc(pipe->bufsz);
+        if (pipe->fifo == RT_NULL)
+        {
+            rt_mutex_release(&(pipe->lock));
+            return -ENOMEM;
+        }
     }
 
     switch (fd->flags & O_ACCMODE)
@@ -104,8 +358,7 @@ static int pipe_fops_close(struct dfs_fd *fd)
 
     if (device->ref_count == 1)
     {
-        rt_ringbuffer_destroy(pipe->fifo);
-        pipe->fifo = RT_NULL;
+        pipe_fifo_free(pipe);
     }
     device->ref_count --;
 
@@ -124,10 +377,16 @@ static int pipe_fops_ioctl(struct dfs_fd *fd, int cmd, void *args)
     switch (cmd)
     {
     case FIONREAD:
-        *((int*)args) = rt_ringbuffer_data_len(pipe->fifo);
+        *((int*)args) = pipe->data_len;
         break;
     case FIONWRITE:
-        *((int*)args) = rt_ringbuffer_space_len(pipe->fifo);
+        *((int*)args) = pipe_space_len(pipe);
+        break;
+    case F_GETPIPE_SZ:
+        ret = pipe->bufsz;
+        break;
+    case F_SETPIPE_SZ:
+        ret = pipe_resize(pipe, (int)(rt_ubase_t)args);
         break;
     default:
         ret = -EINVAL;
@@ -139,50 +398,29 @@ static int pipe_fops_ioctl(struct dfs_fd *fd, int cmd, void *args)
 
 static int pipe_fops_read(struct dfs_fd *fd, void *buf, size_t count)
 {
-    int len = 0;
+    int len;
     rt_pipe_t *pipe;
 
     pipe = (rt_pipe_t *)fd->data;
 
-    /* no process has the pipe open for writing, return end-of-file */
-    if (pipe->writers == 0)
+    if (count == 0)
         return 0;
 
+    rt_mutex_take(&(pipe->read_lock), RT_WAITING_FOREVER);
     rt_mutex_take(&(pipe->lock), RT_WAITING_FOREVER);
 
-    while (1)
+    len = pipe_wait_data(pipe, fd->flags & O_NONBLOCK);
+    if (len > 0)
     {
-        if (pipe->writers == 0)
-        {
-            goto out;
-        }
-
-        len = rt_ringbuffer_get(pipe->fifo, buf, count);
+        len = pipe_get(pipe, (rt_uint8_t*)buf, count);
 
-        if (len > 0)
-        {
-            break;
-        }
-        else
-        {
-            if (fd->flags & O_NONBLOCK)
-            {
-                len = -EAGAIN;
-                goto out;
-            }
-
-            rt_mutex_release(&pipe->lock);
-            rt_wqueue_wakeup(&(pipe->writer_queue), (void*)POLLOUT);
-            rt_wqueue_wait(&(pipe->reader_queue), 0, -1);
-            rt_mutex_take(&(pipe->lock), RT_WAITING_FOREVER);
-        }
+        /* wakeup writer */
+        pipe_wakeup(&(pipe->writer_queue), pipe->writer_waiting, POLLOUT);
     }
 
-    /* wakeup writer */
-    rt_wqueue_wakeup(&(pipe->writer_queue), (void*)POLLOUT);
+    rt_mutex_release(&(pipe->lock));
+    rt_mutex_release(&(pipe->read_lock));
 
-out:
-    rt_mutex_release(&pipe->lock);
     return len;
 }
 
@@ -190,69 +428,37 @@ static int pipe_fops_write(struct dfs_fd *fd, const void *buf, size_t count)
 {
     int len;
     rt_pipe_t *pipe;
-    int wakeup = 0;
     int ret = 0;
-    uint8_t *pbuf;
+    rt_uint8_t *pbuf;
 
     pipe = (rt_pipe_t *)fd->data;
 
-    if (pipe->readers == 0)
-    {
-        ret = -EPIPE;
-        goto out;
-    }
-
     if (count == 0)
         return 0;
 
-    pbuf = (uint8_t*)buf;
-    rt_mutex_take(&pipe->lock, -1);
+    pbuf = (rt_uint8_t*)buf;
+    rt_mutex_take(&(pipe->write_lock), RT_WAITING_FOREVER);
+    rt_mutex_take(&(pipe->lock), RT_WAITING_FOREVER);
 
-    while (1)
+    while (ret < count)
     {
-        if (pipe->readers == 0)
+        len = pipe_wait_space(pipe, fd->flags & O_NONBLOCK);
+        if (len < 0)
         {
             if (ret == 0)
-                ret = -EPIPE;
+                ret = len;
             break;
         }
 
-        len = rt_ringbuffer_put(pipe->fifo, pbuf, count - ret);
-        ret +=  len;
-        pbuf += len;
-        wakeup = 1;
+        ret += pipe_put(pipe, pbuf + ret, count - ret);
 
-        if (ret == count)
-        {
-            break;
-        }
-        else
-        {
-            if (fd->flags & O_NONBLOCK)
-            {
-                if (ret == 0)
-                {
-                    ret = -EAGAIN;
-                }
-
-                break;
-            }
-        }
-
-        rt_mutex_release(&pipe->lock);
-        rt_wqueue_wakeup(&(pipe->reader_queue), (void*)POLLIN);
-        /* pipe full, waiting on suspended write list */
-        rt_wqueue_wait(&(pipe->writer_queue), 0, -1);
-        rt_mutex_take(&pipe->lock, -1);
+        /* wakeup reader, the rest is written when it's consumed */
+        pipe_wakeup(&(pipe->reader_queue), pipe->reader_waiting, POLLIN);
     }
-    rt_mutex_release(&pipe->lock);
 
-    if (wakeup)
-    {
-        rt_wqueue_wakeup(&(pipe->reader_queue), (void*)POLLIN);
-    }
+    rt_mutex_release(&(pipe->lock));
+    rt_mutex_release(&(pipe->write_lock));
 
-out:
     return ret;
 }
 
@@ -281,7 +487,7 @@ static int pipe_fops_poll(struct dfs_fd *fd, rt_pollreq_t *req)
 
     if (mode & 1)
     {
-        if (rt_ringbuffer_data_len(pipe->fifo) != 0)
+        if (pipe->data_len != 0)
         {
             mask |= POLLIN;
         }
@@ -293,7 +499,7 @@ static int pipe_fops_poll(struct dfs_fd *fd, rt_pollreq_t *req)
 
     if (mode & 2)
     {
-        if (rt_ringbuffer_space_len(pipe->fifo) != 0)
+        if (pipe_space_len(pipe) != 0)
         {
             mask |= POLLOUT;
         }
@@ -322,6 +528,7 @@ static const struct dfs_file_ops pipe_fops =
 
 rt_err_t  rt_pipe_open (rt_device_t device, rt_uint16_t oflag)
 {
+    rt_err_t result = RT_EOK;
     rt_pipe_t *pipe = (rt_pipe_t *)device;
 
     if (device == RT_NULL) return -RT_EINVAL;
@@ -329,12 +536,14 @@ rt_err_t  rt_pipe_open (rt_device_t device, rt_uint16_t oflag)
 
     if (pipe->fifo == RT_NULL)
     {
-        pipe->fifo = rt_ringbuffer_create(pipe->bufsz);
+        pipe->fifo = pipe_fifo_alloc(pipe->bufsz);
+        if (pipe->fifo == RT_NULL)
+            result = -RT_ENOMEM;
     }
 
     rt_mutex_release(&(pipe->lock));
 
-    return RT_EOK;
+    return result;
 }
 
 rt_err_t  rt_pipe_close  (rt_device_t device)
@@ -346,8 +555,7 @@ rt_err_t  rt_pipe_close  (rt_device_t device)
 
     if (device->ref_count == 1)
     {
-        rt_ringbuffer_destroy(pipe->fifo);
-        pipe->fifo = RT_NULL;
+        pipe_fifo_free(pipe);
     }
 
     rt_mutex_release(&(pipe->lock));
@@ -357,7 +565,6 @@ rt_err_t  rt_pipe_close  (rt_device_t device)
 
 rt_size_t rt_pipe_read   (rt_device_t device, rt_off_t pos, void *buffer, rt_size_t count)
 {
-    uint8_t *pbuf;
     rt_size_t read_bytes = 0;
     rt_pipe_t *pipe = (rt_pipe_t *)device;
 
@@ -368,24 +575,23 @@ rt_size_t rt_pipe_read   (rt_device_t device, rt_off_t pos, void *buffer, rt_siz
     }
     if (count == 0) return 0;
 
-    pbuf = (uint8_t*)buffer;
+    rt_mutex_take(&(pipe->read_lock), RT_WAITING_FOREVER);
     rt_mutex_take(&(pipe->lock), RT_WAITING_FOREVER);
 
-    while (read_bytes < count)
-    {
-        int len = rt_ringbuffer_get(pipe->fifo, &pbuf[read_bytes], count - read_bytes);
-        if (len <= 0) break;
+    read_bytes = pipe_get(pipe, (rt_uint8_t*)buffer, count);
+#if defined(RT_USING_POSIX)
+    if (read_bytes)
+        pipe_wakeup(&(pipe->writer_queue), pipe->writer_waiting, POLLOUT);
+#endif
 
-        read_bytes += len;
-    }
-    rt_mutex_release(&pipe->lock);
+    rt_mutex_release(&(pipe->lock));
+    rt_mutex_release(&(pipe->read_lock));
 
     return read_bytes;
 }
 
 rt_size_t rt_pipe_write  (rt_device_t device, rt_off_t pos, const void *buffer, rt_size_t count)
 {
-    uint8_t *pbuf;
     rt_size_t write_bytes = 0;
     rt_pipe_t *pipe = (rt_pipe_t *)device;
 
@@ -396,17 +602,17 @@ rt_size_t rt_pipe_write  (rt_device_t device, rt_off_t pos, const void *buffer,
     }
     if (count == 0) return 0;
 
-    pbuf = (uint8_t*)buffer;
-    rt_mutex_take(&pipe->lock, -1);
+    rt_mutex_take(&(pipe->write_lock), RT_WAITING_FOREVER);
+    rt_mutex_take(&(pipe->lock), RT_WAITING_FOREVER);
 
-    while (write_bytes < count)
-    {
-        int len = rt_ringbuffer_put(pipe->fifo, &pbuf[write_bytes], count - write_bytes);
-        if (len <= 0) break;
+    write_bytes = pipe_put(pipe, (const rt_uint8_t*)buffer, count);
+#if defined(RT_USING_POSIX)
+    if (write_bytes)
+        pipe_wakeup(&(pipe->reader_queue), pipe->reader_waiting, POLLIN);
+#endif
 
-        write_bytes += len;
-    }
-    rt_mutex_release(&pipe->lock);
+    rt_mutex_release(&(pipe->lock));
+    rt_mutex_release(&(pipe->write_lock));
 
     return write_bytes;
 }
@@ -433,15 +639,18 @@ rt_pipe_t *rt_pipe_create(const char *name, int bufsz)
     rt_pipe_t *pipe;
     rt_device_t dev;
 
+    RT_ASSERT(bufsz > 0);
+
     pipe = rt_malloc(sizeof(rt_pipe_t));
     if (pipe == RT_NULL) return RT_NULL;
 
     rt_memset(pipe, 0, sizeof(rt_pipe_t));
     rt_mutex_init(&(pipe->lock), name, RT_IPC_FLAG_FIFO);
+    rt_mutex_init(&(pipe->read_lock), name, RT_IPC_FLAG_FIFO);
+    rt_mutex_init(&(pipe->write_lock), name, RT_IPC_FLAG_FIFO);
     rt_wqueue_init(&(pipe->reader_queue));
     rt_wqueue_init(&(pipe->writer_queue));
 
-    RT_ASSERT(bufsz < 0xFFFF);
     pipe->bufsz = bufsz;
 
     dev = &(pipe->parent);
@@ -462,6 +671,9 @@ rt_pipe_t *rt_pipe_create(const char *name, int bufsz)
 
     if (rt_device_register(&(pipe->parent), name, RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_REMOVABLE) != 0)
     {
+        rt_mutex_detach(&(pipe->lock));
+        rt_mutex_detach(&(pipe->read_lock));
+        rt_mutex_detach(&(pipe->write_lock));
         rt_free(pipe);
         return RT_NULL;
     }
@@ -492,14 +704,12 @@ int rt_pipe_delete(const char *name)
             pipe = (rt_pipe_t *)device;
 
             rt_mutex_detach(&(pipe->lock));
+            rt_mutex_detach(&(pipe->read_lock));
+            rt_mutex_detach(&(pipe->write_lock));
             rt_device_unregister(device);
 
-            /* close fifo ringbuffer */
-            if (pipe->fifo) 
-            {
-                rt_ringbuffer_destroy(pipe->fifo);
-                pipe->fifo = RT_NULL;
-            }
+            /* release fifo buffer */
+            pipe_fifo_free(pipe);
             rt_free(pipe);
         }
         else
@@ -560,4 +770,194 @@ int mkfifo(const char *path, mode_t mode)
 
     return 0;
 }
+
+static int splice_file_read(struct dfs_fd *fd, off_t *off, void *buf, size_t len)
+{
+    int result;
+
+    if (off == RT_NULL)
+        return dfs_file_read(fd, buf, len);
+
+    /* read at the given offset without changing the file position */
+    result = dfs_file_pread(fd, buf, len, *off);
+    if (result > 0)
+        *off += result;
+
+    return result;
+}
+
+static int splice_file_write(struct dfs_fd *fd, off_t *off, const void *buf, size_t len)
+{
+    int result;
+
+    if (off == RT_NULL)
+        return dfs_file_write(fd, buf, len);
+
+    /* write at the given offset without changing the file position */
+    result = dfs_file_pwrite(fd, buf, len, *off);
+    if (result > 0)
+        *off += result;
+
+    return result;
+}
+
+/* move the data in pipe to file, the pipe buffer is written to file directly */
+static int pipe_splice_to(rt_pipe_t *pipe, struct dfs_fd *out, off_t *off_out,
+                          size_t len, int nonblock)
+{
+    int result;
+    rt_size_t total = 0, size;
+    rt_uint8_t *ptr;
+
+    rt_mutex_take(&(pipe->read_lock), RT_WAITING_FOREVER);
+    rt_mutex_take(&(pipe->lock), RT_WAITING_FOREVER);
+
+    result = pipe_wait_data(pipe, nonblock);
+    while (result > 0 && total < len && pipe->data_len)
+    {
+        size = pipe_data_region(pipe, &ptr);
+        if (size > len - total)
+            size = len - total;
+
+        /* the region is owned by reader, the writer can go on meanwhile */
+        rt_mutex_release(&(pipe->lock));
+        result = splice_file_write(out, off_out, ptr, size);
+        rt_mutex_take(&(pipe->lock), RT_WAITING_FOREVER);
+        if (result <= 0)
+            break;
+
+        pipe_consume(pipe, result);
+        total += result;
+        pipe_wakeup(&(pipe->writer_queue), pipe->writer_waiting, POLLOUT);
+
+        /* the file is full */
+        if (result < size)
+            break;
+    }
+
+    rt_mutex_release(&(pipe->lock));
+    rt_mutex_release(&(pipe->read_lock));
+
+    return total ? total : result;
+}
+
+/* move the data in file to pipe, the file is read into pipe buffer directly */
+static int pipe_splice_from(rt_pipe_t *pipe, struct dfs_fd *in, off_t *off_in,
+                            size_t len, int nonblock)
+{
+    int result = 0;
+    rt_size_t total = 0, size;
+    rt_uint8_t *ptr;
+
+    rt_mutex_take(&(pipe->write_lock), RT_WAITING_FOREVER);
+    rt_mutex_take(&(pipe->lock), RT_WAITING_FOREVER);
+
+    while (total < len)
+    {
+        /* only block before the first byte is moved */
+        result = pipe_wait_space(pipe, nonblock || total);
+        if (result < 0)
+            break;
+
+        size = pipe_space_region(pipe, &ptr);
+        if (size > len - total)
+            size = len - total;
+
+        /* the region is owned by writer, the reader can go on meanwhile */
+        rt_mutex_release(&(pipe->lock));
+        result = splice_file_read(in, off_in, ptr, size);
+        rt_mutex_take(&(pipe->lock), RT_WAITING_FOREVER);
+        if (result <= 0)
+            break;
+
+        pipe_produce(pipe, result);
+        total += result;
+        pipe_wakeup(&(pipe->reader_queue), pipe->reader_waiting, POLLIN);
+
+        /* end of file or no more data in device */
+        if (result < size)
+            break;
+    }
+
+    rt_mutex_release(&(pipe->lock));
+    rt_mutex_release(&(pipe->write_lock));
+
+    return total ? total : result;
+}
+
+/**
+ * this function will move data between a pipe and a file or device without
+ * copying it to user buffer. One of the file descriptors must be a pipe.
+ *
+ * @param fd_in the file descriptor to read data from.
+ * @param off_in the offset to read from, which is updated on return. It must
+ *        be NULL for pipe or to use the current file position.
+ * @param fd_out the file descriptor to write data to.
+ * @param off_out the offset to write to, as same as off_in.
+ * @param len the maximal number of bytes to move.
+ * @param flags SPLICE_F_NONBLOCK to not block on pipe.
+ *
+ * @return the number of bytes moved, 0 on end-of-file, -1 on failed.
+ */
+ssize_t splice(int fd_in, off_t *off_in, int fd_out, off_t *off_out,
+               size_t len, unsigned int flags)
+{
+    int result;
+    struct dfs_fd *d_in, *d_out;
+
+    d_in = fd_get(fd_in);
+    if (d_in == RT_NULL)
+    {
+        rt_set_errno(-EBADF);
+        return -1;
+    }
+
+    d_out = fd_get(fd_out);
+    if (d_out == RT_NULL)
+    {
+        fd_put(d_in);
+        rt_set_errno(-EBADF);
+        return -1;
+    }
+
+    if ((d_in->flags & O_ACCMODE) == O_WRONLY || (d_out->flags & O_ACCMODE) == O_RDONLY)
+    {
+        result = -EBADF;
+    }
+    else if (d_in->fops == &pipe_fops && d_in->data == d_out->data)
+    {
+        result = -EINVAL;
+    }
+    else if ((d_in->fops == &pipe_fops && off_in) ||
+             (d_out->fops == &pipe_fops && off_out))
+    {
+        result = -ESPIPE;
+    }
+    else if (d_in->fops == &pipe_fops)
+    {
+        result = pipe_splice_to((rt_pipe_t *)d_in->data, d_out, off_out, len,
+                                (flags & SPLICE_F_NONBLOCK) || (d_in->flags & O_NONBLOCK));
+    }
+    else if (d_out->fops == &pipe_fops)
+    {
+        result = pipe_splice_from((rt_pipe_t *)d_out->data, d_in, off_in, len,
+                                  (flags & SPLICE_F_NONBLOCK) || (d_out->flags & O_NONBLOCK));
+    }
+    else
+    {
+        result = -EINVAL;
+    }
+
+    fd_put(d_out);
+    fd_put(d_in);
+
+    if (result < 0)
+    {
+        rt_set_errno(result);
+        return -1;
+    }
+
+    return result;
+}
+RTM_EXPORT(splice);
 #endif
@@ -56,6 +56,7 @@ void rt_wqueue_wakeup(rt_wqueue_t *queue, void *key)
 {
     rt_base_t level;
     register int need_schedule = 0;
+    int result;
 
     rt_list_t *queue_list;
     struct rt_list_node *node;
@@ -72,7 +73,8 @@ void rt_wqueue_wakeup(rt_wqueue_t *queue, void *key)
         for (node = queue_list->next; node != queue_list; node = node->next)
         {
             entry = rt_list_entry(node, struct rt_wqueue_node, list);
-            if (entry->wakeup(entry, key) == 0)
+            result = entry->wakeup(entry, key);
+            if (result == 0)
             {
                 rt_thread_resume(entry->polling_thread);
                 need_schedule = 1;
@@ -80,6 +82,11 @@ void rt_wqueue_wakeup(rt_wqueue_t *queue, void *key)
                 rt_wqueue_remove(entry);
                 break;
             }
+            else if (result > 0)
+            {
+                /* the node has resumed its own waiters */
+                need_schedule = 1;
+            }
         }
     }
     rt_hw_interrupt_enable(level);
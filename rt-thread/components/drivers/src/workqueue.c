@@ -216,6 +216,10 @@ rt_err_t rt_workqueue_cancel_work_sync(struct rt_workqueue* queue, struct rt_wor
     RT_ASSERT(queue != RT_NULL);
     RT_ASSERT(work != RT_NULL);
 
+    /* the work thread would wait for itself */
+    if (queue->work_thread == rt_thread_self())
+        return -RT_EBUSY;
+
     level = rt_hw_interrupt_disable();
     if (queue->work_current == work) /* it's current work in the queue */
     {
@@ -247,5 +251,582 @@ rt_err_t rt_workqueue_cancel_all_work(struct rt_workqueue* queue)
     return RT_EOK;
 }
 
+#ifdef RT_USING_SYSTEM_WORKQUEUE
+
+#ifndef RT_WORKQUEUE_STACK_SIZE
+#define RT_WORKQUEUE_STACK_SIZE         2048
+#endif
+#ifndef RT_WORKQUEUE_PRIORITY
+#define RT_WORKQUEUE_PRIORITY           (RT_THREAD_PRIORITY_MAX / 2)
+#endif
+#ifndef RT_WORKQUEUE_HIGHPRI_PRIORITY
+#define RT_WORKQUEUE_HIGHPRI_PRIORITY   (RT_THREAD_PRIORITY_MAX / 8)
+#endif
+#ifndef RT_WORKQUEUE_MAX_WORKERS
+#define RT_WORKQUEUE_MAX_WORKERS        4
+#endif
+
+/* a pool without progress for so many ticks is regarded as blocked */
+#define WORK_STALL_TICKS    (RT_TICK_PER_SECOND / 50 + 1)
+/* the extra idle workers exit after so many ticks */
+#define WORK_IDLE_TICKS     (RT_TICK_PER_SECOND * 5)
+
+#ifdef RT_USING_SMP
+#define WORK_CPUS_NR        RT_CPUS_NR
+#else
+#define WORK_CPUS_NR        1
+#endif
+
+struct rt_worker
+{
+    rt_list_t node;                         /* node in all workers of pool */
+    rt_list_t idle_node;                    /* node in idle workers of pool */
+
+    struct rt_work *current;                /* the running work */
+    struct rt_work_pool *pool;
+
+    struct rt_semaphore sem;
+    rt_thread_t thread;
+
+    struct rt_semaphore done;               /* released when current is done */
+    rt_uint16_t nr_waiting;                 /* the waiters of done */
+};
+
+struct rt_work_pool
+{
+    rt_list_t work_list;                    /* pending works */
+    rt_list_t workers;
+    rt_list_t idle_workers;
+
+    rt_uint16_t nr_workers;
+    rt_uint16_t nr_idle;
+
+    int cpu;                                /* bound cpu, -1 for unbound */
+    rt_uint8_t priority;
+
+    rt_uint32_t completed;                  /* number of completed works */
+    rt_uint32_t stall_mark;                 /* completed at stall_tick */
+    rt_tick_t stall_tick;
+    rt_bool_t watching;
+};
+
+static struct rt_work_pool _work_pools[WORK_CPUS_NR];
+static struct rt_work_pool _work_highpri_pool;
+
+/* delayed works sorted by timeout, and the manager thread handles them */
+static rt_list_t _work_delayed_list = RT_LIST_OBJECT_INIT(_work_delayed_list);
+static struct rt_semaphore _work_manager_sem;
+
+static void _work_worker_entry(void *parameter);
+
+static rt_err_t _work_worker_create(struct rt_work_pool *pool)
+{
+    char name[RT_NAME_MAX];
+    rt_base_t level;
+    struct rt_worker *worker;
+
+    worker = (struct rt_worker *)RT_KERNEL_MALLOC(sizeof(struct rt_worker));
+    if (worker == RT_NULL) return -RT_ENOMEM;
+
+    worker->current = RT_NULL;
+    worker->pool = pool;
+    worker->nr_waiting = 0;
+    rt_list_init(&(worker->idle_node));
+
+    if (pool->cpu < 0)
+        rt_snprintf(name, sizeof(name), "kwh/%d", pool->nr_workers);
+    else
+        rt_snprintf(name, sizeof(name), "kw%d/%d", pool->cpu, pool->nr_workers);
+
+    rt_sem_init(&(worker->sem), name, 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&(worker->done), name, 0, RT_IPC_FLAG_FIFO);
+    worker->thread = rt_thread_create(name, _work_worker_entry, worker,
+                                      RT_WORKQUEUE_STACK_SIZE, pool->priority, 10);
+    if (worker->thread == RT_NULL)
+    {
+        rt_sem_detach(&(worker->sem));
+        rt_sem_detach(&(worker->done));
+        RT_KERNEL_FREE(worker);
+        return -RT_ENOMEM;
+    }
+#ifdef RT_USING_SMP
+    if (pool->cpu >= 0)
+        rt_thread_control(worker->thread, RT_THREAD_CTRL_BIND_CPU, (void *)(rt_ubase_t)pool->cpu);
+#endif
+
+    level = rt_hw_interrupt_disable();
+    rt_list_insert_before(&(pool->workers), &(worker->node));
+    pool->nr_workers ++;
+    rt_hw_interrupt_enable(level);
+
+    rt_thread_startup(worker->thread);
+
+    return RT_EOK;
+}
+
+static void _work_worker_entry(void *parameter)
+{
+    rt_base_t level;
+    rt_err_t result;
+    rt_uint16_t waiting;
+    struct rt_work *work;
+    struct rt_worker *worker;
+    struct rt_work_pool *pool;
+
+    worker = (struct rt_worker *)parameter;
+    pool = worker->pool;
+
+    while (1)
+    {
+        level = rt_hw_interrupt_disable();
+        if (rt_list_isempty(&(pool->work_list)))
+        {
+            /* no work to do, become an idle worker */
+            rt_list_insert_after(&(pool->idle_workers), &(worker->idle_node));
+            pool->nr_idle ++;
+            rt_hw_interrupt_enable(level);
+
+            result = rt_sem_take(&(worker->sem), WORK_IDLE_TICKS);
+
+            level = rt_hw_interrupt_disable();
+            if (result != RT_EOK && !rt_list_isempty(&(worker->idle_node)))
+            {
+                /* it's still idle, and the extra worker exits */
+                if (pool->nr_idle > 1)
+                {
+                    rt_list_remove(&(worker->idle_node));
+                    rt_list_remove(&(worker->node));
+                    pool->nr_idle --;
+                    pool->nr_workers --;
+                    rt_hw_interrupt_enable(level);
+
+                    rt_sem_detach(&(worker->sem));
+                    rt_sem_detach(&(worker->done));
+                    RT_KERNEL_FREE(worker);
+                    return;
+                }
+
+                /* keep the last one */
+                rt_list_remove(&(worker->idle_node));
+                pool->nr_idle --;
+            }
+            rt_hw_interrupt_enable(level);
+
+            /* consume the wakeup which races with timeout */
+            if (result != RT_EOK)
+                rt_sem_trytake(&(worker->sem));
+            continue;
+        }
+
+        /* we have work to do with. */
+        work = rt_list_entry(pool->work_list.next, struct rt_work, list);
+        rt_list_remove(&(work->list));
+        work->flags &= ~RT_WORK_STATE_PENDING;
+        worker->current = work;
+        rt_hw_interrupt_enable(level);
+
+        /* do work, the work may be freed in it */
+        work->work_func(work, work->work_data);
+
+        level = rt_hw_interrupt_disable();
+        worker->current = RT_NULL;
+        pool->completed ++;
+        waiting = worker->nr_waiting;
+        worker->nr_waiting = 0;
+        rt_hw_interrupt_enable(level);
+
+        /* wake up the threads waiting for completion of the work */
+        while (waiting --)
+            rt_sem_release(&(worker->done));
+    }
+}
+
+/* get the worker running the work, the interrupt shall be disabled before
+ * invoking */
+static struct rt_worker *_work_running_worker(struct rt_work *work)
+{
+    struct rt_list_node *node;
+    struct rt_worker *worker;
+
+    if (work->pool == RT_NULL) return RT_NULL;
+
+    rt_list_for_each(node, &(work->pool->workers))
+    {
+        worker = rt_list_entry(node, struct rt_worker, node);
+        if (worker->current == work) return worker;
+    }
+
+    return RT_NULL;
+}
+
+#define _work_is_running(work)  (_work_running_worker(work) != RT_NULL)
+
+/*
+ * Put the work to the list of pool, and return the idle worker to wake up, or
+ * RT_NULL if there is no idle worker. The interrupt shall be disabled before
+ * invoking.
+ */
+static struct rt_worker *_work_pool_queue(struct rt_work_pool *pool, struct rt_work *work)
+{
+    struct rt_worker *worker = RT_NULL;
+
+    rt_list_insert_before(&(pool->work_list), &(work->list));
+    work->flags |= RT_WORK_STATE_PENDING;
+
+    if (!rt_list_isempty(&(pool->idle_workers)))
+    {
+        worker = rt_list_entry(pool->idle_workers.next, struct rt_worker, idle_node);
+        rt_list_remove(&(worker->idle_node));
+        pool->nr_idle --;
+    }
+
+    return worker;
+}
+
+static struct rt_work_pool *_work_pool_get(int cpu)
+{
+#ifdef RT_USING_SMP
+    if (cpu < 0) cpu = rt_hw_cpu_id();
+#else
+    cpu = 0;
+#endif
+
+    return &_work_pools[cpu];
+}
+
+static rt_err_t _work_submit(struct rt_work_pool *pool, struct rt_work *work, rt_tick_t ticks)
+{
+    rt_base_t level;
+    rt_bool_t wake_manager = RT_FALSE;
+    struct rt_worker *worker = RT_NULL;
+    struct rt_list_node *node;
+    struct rt_work *iter;
+
+    RT_ASSERT(work != RT_NULL);
+
+    level = rt_hw_interrupt_disable();
+    if (_work_is_running(work))
+    {
+        rt_hw_interrupt_enable(level);
+        return -RT_EBUSY;
+    }
+
+    /* NOTE: the work MUST be initialized firstly */
+    rt_list_remove(&(work->list));
+    work->flags &= ~(RT_WORK_STATE_PENDING | RT_WORK_STATE_DELAYED);
+    work->pool = pool;
+
+    if (ticks == 0)
+    {
+        worker = _work_pool_queue(pool, work);
+        /* all workers are busy, let the manager watch this pool */
+        if (worker == RT_NULL) wake_manager = RT_TRUE;
+    }
+    else
+    {
+        work->timeout = rt_tick_get() + ticks;
+        work->flags |= RT_WORK_STATE_DELAYED;
+
+        /* insert it by timeout order */
+        for (node = _work_delayed_list.next; node != &_work_delayed_list; node = node->next)
+        {
+            iter = rt_list_entry(node, struct rt_work, list);
+            if ((iter->timeout - work->timeout) < RT_TICK_MAX / 2 &&
+                iter->timeout != work->timeout)
+                break;
+        }
+        rt_list_insert_before(node, &(work->list));
+
+        /* the earliest one is changed */
+        if (_work_delayed_list.next == &(work->list)) wake_manager = RT_TRUE;
+    }
+    rt_hw_interrupt_enable(level);
+
+    if (worker != RT_NULL) rt_sem_release(&(worker->sem));
+    if (wake_manager) rt_sem_release(&_work_manager_sem);
+
+    return RT_EOK;
+}
+
+/*
+ * The manager thread moves the expired delayed works to their pools, and adds
+ * worker to the pool which has pending works but no progress for a while,
+ * that is all workers of it are blocked.
+ */
+static void _work_manager_entry(void *parameter)
+{
+    int index;
+    rt_base_t level;
+    rt_tick_t now;
+    rt_int32_t timeout;
+    rt_bool_t stalled;
+    struct rt_work *work;
+    struct rt_worker *worker;
+    struct rt_work_pool *pool;
+
+    while (1)
+    {
+        timeout = RT_WAITING_FOREVER;
+
+        level = rt_hw_interrupt_disable();
+        now = rt_tick_get();
+        while (!rt_list_isempty(&_work_delayed_list))
+        {
+            work = rt_list_entry(_work_delayed_list.next, struct rt_work, list);
+            if ((now - work->timeout) >= RT_TICK_MAX / 2)
+            {
+                timeout = work->timeout - now;
+                break;
+            }
+
+            rt_list_remove(&(work->list));
+            work->flags &= ~RT_WORK_STATE_DELAYED;
+            worker = _work_pool_queue(work->pool, work);
+            if (worker != RT_NULL)
+            {
+                rt_hw_interrupt_enable(level);
+                rt_sem_release(&(worker->sem));
+                level = rt_hw_interrupt_disable();
+                now = rt_tick_get();
+            }
+        }
+        rt_hw_interrupt_enable(level);
+
+        for (index = 0; index <= WORK_CPUS_NR; index ++)
+        {
+            pool = index < WORK_CPUS_NR ? &_work_pools[index] : &_work_highpri_pool;
+
+            stalled = RT_FALSE;
+            level = rt_hw_interrupt_disable();
+            if (rt_list_isempty(&(pool->work_list)) || pool->nr_idle != 0)
+            {
+                pool->watching = RT_FALSE;
+            }
+            else if (!pool->watching || pool->completed != pool->stall_mark)
+            {
+                /* busy, start or restart watching */
+                pool->watching = RT_TRUE;
+                pool->stall_mark = pool->completed;
+                pool->stall_tick = now;
+            }
+            else if (rt_tick_get() - pool->stall_tick >= WORK_STALL_TICKS)
+            {
+                /* no progress, all of workers are blocked */
+                pool->watching = RT_FALSE;
+                stalled = (pool->nr_workers < RT_WORKQUEUE_MAX_WORKERS);
+            }
+
+            if (pool->watching && (timeout < 0 || timeout > WORK_STALL_TICKS))
+                timeout = WORK_STALL_TICKS;
+            rt_hw_interrupt_enable(level);
+
+            if (stalled) _work_worker_create(pool);
+        }
+
+        rt_sem_take(&_work_manager_sem, timeout);
+    }
+}
+
+static rt_err_t _work_pool_init(struct rt_work_pool *pool, int cpu, rt_uint8_t priority)
+{
+    rt_list_init(&(pool->work_list));
+    rt_list_init(&(pool->workers));
+    rt_list_init(&(pool->idle_workers));
+    pool->nr_workers = 0;
+    pool->nr_idle = 0;
+    pool->cpu = cpu;
+    pool->priority = priority;
+    pool->completed = 0;
+    pool->stall_mark = 0;
+    pool->stall_tick = 0;
+    pool->watching = RT_FALSE;
+
+    return _work_worker_create(pool);
+}
+
+/**
+ * This function will initialize the system workqueue, which has one worker
+ * pool per CPU and an unbound high priority pool.
+ *
+ * @return 0 on successful, or -1 on failed.
+ */
+int rt_work_sys_init(void)
+{
+    static rt_bool_t _init_flag = RT_FALSE;
+    rt_thread_t tid;
+    int cpu;
+
+    if (_init_flag) return 0;
+
+    rt_sem_init(&_work_manager_sem, "kwmgr", 0, RT_IPC_FLAG_FIFO);
+    for (cpu = 0; cpu < WORK_CPUS_NR; cpu ++)
+    {
+#ifdef RT_USING_SMP
+        if (_work_pool_init(&_work_pools[cpu], cpu, RT_WORKQUEUE_PRIORITY) != RT_EOK)
+#else
+        if (_work_pool_init(&_work_pools[cpu], -1, RT_WORKQUEUE_PRIORITY) != RT_EOK)
+#endif
+            return -1;
+    }
+    if (_work_pool_init(&_work_highpri_pool, -1, RT_WORKQUEUE_HIGHPRI_PRIORITY) != RT_EOK)
+        return -1;
+
+    tid = rt_thread_create("kwmgr", _work_manager_entry, RT_NULL,
+                           RT_WORKQUEUE_STACK_SIZE, RT_WORKQUEUE_HIGHPRI_PRIORITY, 10);
+    if (tid == RT_NULL) return -1;
+    rt_thread_startup(tid);
+
+    _init_flag = RT_TRUE;
+
+    return 0;
+}
+INIT_PREV_EXPORT(rt_work_sys_init);
+
+/**
+ * This function will submit a work to the pool of current CPU.
+ *
+ * @param work the work
+ *
+ * @return the error code, -RT_EBUSY if the work is running.
+ */
+rt_err_t rt_work_submit(struct rt_work* work)
+{
+    return _work_submit(_work_pool_get(RT_WORK_CPU_ANY), work, 0);
+}
+
+/**
+ * This function will submit a work to the pool of specified CPU.
+ *
+ * @param work the work
+ * @param cpu the CPU, or RT_WORK_CPU_ANY for current CPU
+ *
+ * @return the error code, -RT_EBUSY if the work is running.
+ */
+rt_err_t rt_work_submit_on(struct rt_work* work, int cpu)
+{
+    if (cpu >= WORK_CPUS_NR) return -RT_EINVAL;
+
+    return _work_submit(_work_pool_get(cpu), work, 0);
+}
+
+/**
+ * This function will submit a work to the pool of current CPU after the
+ * specified ticks. Submitting a delayed work again restarts its delay.
+ *
+ * @param work the work
+ * @param ticks the delay ticks
+ *
+ * @return the error code, -RT_EBUSY if the work is running.
+ */
+rt_err_t rt_work_submit_delayed(struct rt_work* work, rt_tick_t ticks)
+{
+    if (ticks >= RT_TICK_MAX / 2) return -RT_EINVAL;
+
+    return _work_submit(_work_pool_get(RT_WORK_CPU_ANY), work, ticks);
+}
+
+/**
+ * This function will submit a work to the pool of specified CPU after the
+ * specified ticks.
+ *
+ * @param work the work
+ * @param cpu the CPU, or RT_WORK_CPU_ANY for current CPU
+ * @param ticks the delay ticks
+ *
+ * @return the error code, -RT_EBUSY if the work is running.
+ */
+rt_err_t rt_work_submit_delayed_on(struct rt_work* work, int cpu, rt_tick_t ticks)
+{
+    if (cpu >= WORK_CPUS_NR) return -RT_EINVAL;
+    if (ticks >= RT_TICK_MAX / 2) return -RT_EINVAL;
+
+    return _work_submit(_work_pool_get(cpu), work, ticks);
+}
+
+/**
+ * This function will submit a work to the unbound high priority pool.
+ *
+ * @param work the work
+ *
+ * @return the error code, -RT_EBUSY if the work is running.
+ */
+rt_err_t rt_work_submit_highpri(struct rt_work* work)
+{
+    return _work_submit(&_work_highpri_pool, work, 0);
+}
+
+/**
+ * This function will cancel a pending or delayed work.
+ *
+ * @param work the work
+ *
+ * @return the error code, -RT_EBUSY if the work is running.
+ */
+rt_err_t rt_work_cancel(struct rt_work* work)
+{
+    rt_base_t level;
+
+    RT_ASSERT(work != RT_NULL);
+
+    level = rt_hw_interrupt_disable();
+    if (_work_is_running(work))
+    {
+        rt_hw_interrupt_enable(level);
+        return -RT_EBUSY;
+    }
+    rt_list_remove(&(work->list));
+    work->flags &= ~(RT_WORK_STATE_PENDING | RT_WORK_STATE_DELAYED);
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+
+/**
+ * This function will cancel a work, and wait for its completion if it's
+ * running. The work submitted again by itself is cancelled too.
+ *
+ * @param work the work
+ *
+ * @return the error code, -RT_EBUSY if it's called by the worker running the
+ *         work, such as in the work function.
+ */
+rt_err_t rt_work_cancel_sync(struct rt_work* work)
+{
+    rt_base_t level;
+    struct rt_worker *worker;
+
+    RT_ASSERT(work != RT_NULL);
+
+    while (1)
+    {
+        level = rt_hw_interrupt_disable();
+        worker = _work_running_worker(work);
+        if (worker == RT_NULL)
+        {
+            rt_list_remove(&(work->list));
+            work->flags &= ~(RT_WORK_STATE_PENDING | RT_WORK_STATE_DELAYED);
+            rt_hw_interrupt_enable(level);
+            break;
+        }
+
+        /* it would wait for itself */
+        if (worker->thread == rt_thread_self())
+        {
+            rt_hw_interrupt_enable(level);
+            return -RT_EBUSY;
+        }
+
+        worker->nr_waiting ++;
+        rt_hw_interrupt_enable(level);
+
+        /* wait for work completion */
+        rt_sem_take(&(worker->done), RT_WAITING_FOREVER);
+    }
+
+    return RT_EOK;
+}
+
+#endif
+
 #endif
 
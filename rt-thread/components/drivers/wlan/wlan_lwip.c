@@ -50,11 +50,12 @@ static void netif_is_ready(struct rt_work *work, void *parameter)
     rt_base_t level;
     struct rt_wlan_buff buff;
     rt_uint32_t ip_addr[4];
+    rt_bool_t again = RT_FALSE;
 
     rt_timer_stop(&lwip_prot->timer);
     if (ip_addr_cmp(&(eth_dev->netif->ip_addr), &ip_addr_zero) != 0)
     {
-        rt_timer_start(&lwip_prot->timer);
+        again = RT_TRUE;
         goto exit;
     }
     rt_memset(&ip_addr, 0, sizeof(ip_addr));
@@ -88,7 +89,7 @@ static void netif_is_ready(struct rt_work *work, void *parameter)
 #endif
     if (rt_wlan_prot_ready(wlan, &buff) != 0)
     {
-        rt_timer_start(&lwip_prot->timer);
+        again = RT_TRUE;
         goto exit;
     }
     rt_memset(str, 0, IP4ADDR_STRLEN_MAX);
@@ -97,31 +98,36 @@ static void netif_is_ready(struct rt_work *work, void *parameter)
     rt_exit_critical();
     LOG_I("Got IP address : %s", str);
 exit:
+    /* clear the work before the timer is restarted, or the next check may be
+     * skipped by timer_callback and the timer is never started again */
     level = rt_hw_interrupt_disable();
     rt_memset(work, 0, sizeof(struct rt_work));
     rt_hw_interrupt_enable(level);
+    if (again)
+        rt_timer_start(&lwip_prot->timer);
 }
 
 static void timer_callback(void *parameter)
 {
-    struct rt_workqueue *workqueue;
     struct rt_wlan_device *wlan = parameter;
     struct lwip_prot_des *lwip_prot = (struct lwip_prot_des *)wlan->prot;
     struct rt_work *work = &lwip_prot->work;
     rt_base_t level;
 
-    workqueue = rt_wlan_get_workqueue();
-    if (workqueue != RT_NULL)
+    level = rt_hw_interrupt_disable();
+    /* the work is pending or running, it's cleared by itself when done */
+    if (work->work_func != RT_NULL)
+    {
+        rt_hw_interrupt_enable(level);
+        return;
+    }
+    rt_work_init(work, netif_is_ready, parameter);
+    rt_hw_interrupt_enable(level);
+    if (rt_wlan_workqueue_submit(work) != RT_EOK)
     {
         level = rt_hw_interrupt_disable();
-        rt_work_init(work, netif_is_ready, parameter);
+        rt_memset(work, 0, sizeof(struct rt_work));
         rt_hw_interrupt_enable(level);
-        if (rt_workqueue_dowork(workqueue, work) != RT_EOK)
-        {
-            level = rt_hw_interrupt_disable();
-            rt_memset(work, 0, sizeof(struct rt_work));
-            rt_hw_interrupt_enable(level);
-        }
     }
 }
 
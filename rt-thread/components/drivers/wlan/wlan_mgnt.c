@@ -430,24 +430,25 @@ exit:
 
 static void rt_wlan_cyclic_check(void *parameter)
 {
-    struct rt_workqueue *workqueue;
     static struct rt_work work;
     rt_base_t level;
 
-    if ((_is_do_connect() == RT_TRUE) && (work.work_func == RT_NULL))
+    if (_is_do_connect() == RT_TRUE)
     {
-        workqueue = rt_wlan_get_workqueue();
-        if (workqueue != RT_NULL)
+        level = rt_hw_interrupt_disable();
+        /* the work is pending or running, it's cleared by itself when done */
+        if (work.work_func != RT_NULL)
+        {
+            rt_hw_interrupt_enable(level);
+            return;
+        }
+        rt_work_init(&work, rt_wlan_auto_connect_run, RT_NULL);
+        rt_hw_interrupt_enable(level);
+        if (rt_wlan_workqueue_submit(&work) != RT_EOK)
         {
             level = rt_hw_interrupt_disable();
-            rt_work_init(&work, rt_wlan_auto_connect_run, RT_NULL);
+            rt_memset(&work, 0, sizeof(struct rt_work));
             rt_hw_interrupt_enable(level);
-            if (rt_workqueue_dowork(workqueue, &work) != RT_EOK)
-            {
-                level = rt_hw_interrupt_disable();
-                rt_memset(&work, 0, sizeof(struct rt_work));
-                rt_hw_interrupt_enable(level);
-            }
         }
     }
 }
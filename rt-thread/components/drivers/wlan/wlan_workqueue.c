@@ -41,6 +41,19 @@ struct rt_workqueue *rt_wlan_get_workqueue(void)
     return wlan_workqueue;
 }
 
+/* the works of WLAN are run one by one in order of submitting, so they are
+ * kept on the queue of a single thread rather than the system workqueue */
+rt_err_t rt_wlan_workqueue_submit(struct rt_work *work)
+{
+    if (wlan_workqueue == RT_NULL)
+    {
+        LOG_E("F:%s L:%d not init wlan work queue", __FUNCTION__, __LINE__);
+        return -RT_ERROR;
+    }
+
+    return rt_workqueue_dowork(wlan_workqueue, work);
+}
+
 rt_err_t rt_wlan_workqueue_dowork(void (*func)(void *parameter), void *parameter)
 {
     struct rt_wlan_work *wlan_work;
@@ -53,12 +66,6 @@ rt_err_t rt_wlan_workqueue_dowork(void (*func)(void *parameter), void *parameter
         return -RT_EINVAL;
     }
 
-    if (wlan_workqueue == RT_NULL)
-    {
-        LOG_E("F:%s L:%d not init wlan work queue", __FUNCTION__, __LINE__);
-        return -RT_ERROR;
-    }
-
     wlan_work = rt_malloc(sizeof(struct rt_wlan_work));
     if (wlan_work == RT_NULL)
     {
@@ -68,7 +75,7 @@ rt_err_t rt_wlan_workqueue_dowork(void (*func)(void *parameter), void *parameter
     wlan_work->fun = func;
     wlan_work->parameter = parameter;
     rt_work_init(&wlan_work->work, rt_wlan_workqueue_fun, wlan_work);
-    err = rt_workqueue_dowork(wlan_workqueue, &wlan_work->work);
+    err = rt_wlan_workqueue_submit(&wlan_work->work);
     if (err != RT_EOK)
     {
         LOG_E("F:%s L:%d do work failed", __FUNCTION__, __LINE__);
@@ -35,6 +35,8 @@ rt_err_t rt_wlan_workqueue_dowork(void (*func)(void *parameter), void *parameter
 
 struct rt_workqueue *rt_wlan_get_workqueue(void);
 
+rt_err_t rt_wlan_workqueue_submit(struct rt_work *work);
+
 #ifdef __cplusplus
 }
 #endif
@@ -33,8 +33,17 @@
 
 #include "posix_aio.h"
 
+#ifdef RT_USING_SYSTEM_WORKQUEUE
+/* the asynchronous I/O works run on the system workqueue of all CPUs */
+#define aio_work_submit(work)       rt_work_submit(work)
+#define aio_work_cancel_sync(work)  rt_work_cancel_sync(work)
+#else
 struct rt_workqueue* aio_queue = NULL;
 
+#define aio_work_submit(work)       rt_workqueue_dowork(aio_queue, work)
+#define aio_work_cancel_sync(work)  rt_workqueue_cancel_work_sync(aio_queue, work)
+#endif
+
 /**
  * The aio_cancel() function shall attempt to cancel one or more asynchronous I/O 
  * requests currently outstanding against file descriptor fildes. The aiocbp 
@@ -64,7 +73,7 @@ int aio_cancel(int fd, struct aiocb *cb)
     if (!cb) return -EINVAL;
     if (cb->aio_fildes != fd) return -EINVAL;
 
-    ret = rt_workqueue_cancel_work_sync(aio_queue, &(cb->aio_work));
+    ret = aio_work_cancel_sync(&(cb->aio_work));
     if (ret == RT_EOK)
     {
         errno = -ECANCELED;
@@ -161,7 +170,7 @@ int aio_fsync(int op, struct aiocb *cb)
     rt_hw_interrupt_enable(level);
 
     rt_work_init(&(cb->aio_work), aio_fync_work, cb);
-    rt_workqueue_dowork(aio_queue, &(cb->aio_work));
+    aio_work_submit(&(cb->aio_work));
 
     return 0;
 }
@@ -250,7 +259,7 @@ int aio_read(struct aiocb *cb)
 
     /* en-queue read work */
     rt_work_init(&(cb->aio_work), aio_read_work, cb);
-    rt_workqueue_dowork(aio_queue, &(cb->aio_work));
+    aio_work_submit(&(cb->aio_work));
 
     return 0;
 }
@@ -392,7 +401,7 @@ int aio_write(struct aiocb *cb)
     rt_hw_interrupt_enable(level);
 
     rt_work_init(&(cb->aio_work), aio_write_work, cb);
-    rt_workqueue_dowork(aio_queue, &(cb->aio_work));
+    aio_work_submit(&(cb->aio_work));
 
     return 0;
 }
@@ -470,8 +479,12 @@ int lio_listio(int mode, struct aiocb * const list[], int nent,
 
 int aio_system_init(void)
 {
+#ifdef RT_USING_SYSTEM_WORKQUEUE
+    rt_work_sys_init();
+#else
     aio_queue = rt_workqueue_create("aio", 2048, RT_THREAD_PRIORITY_MAX/2);
     RT_ASSERT(aio_queue != NULL);
+#endif
 
     return 0;
 }
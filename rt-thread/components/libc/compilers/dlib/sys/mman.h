@@ -65,6 +65,7 @@ extern "C" {
 
 void *mmap (void *start, size_t len, int prot, int flags, int fd, off_t off);
 int munmap (void *start, size_t len);
+int msync (void *start, size_t len, int flags);
 
 #ifdef __cplusplus
 }
@@ -33,10 +33,9 @@ static struct rt_module_symtab *_rt_module_symtab_end   = RT_NULL;
 static void _dlmodule_set_name(struct rt_dlmodule *module, const char *path)
 {
     int size;
-    struct rt_object *object;
+    char name[RT_NAME_MAX + 1];
     const char *first, *end, *ptr;
 
-    object = &(module->parent);
     ptr   = first = (char *)path;
     end   = path + rt_strlen(path);
 
@@ -53,8 +52,11 @@ static void _dlmodule_set_name(struct rt_dlmodule *module, const char *path)
     size = end - first + 1;
     if (size > RT_NAME_MAX) size = RT_NAME_MAX;
 
-    rt_strncpy(object->name, first, size);
-    object->name[size] = '\0';
+    rt_strncpy(name, first, size);
+    name[size] = '\0';
+
+    /* the object is hashed by name */
+    rt_object_set_name(&(module->parent), name);
 }
 
 #define RT_MODULE_ARG_MAX    8
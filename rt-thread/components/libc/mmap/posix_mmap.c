@@ -22,60 +22,365 @@
  * 2017/11/30     Bernard      The first version.
  */
 
+/*
+ * The mapped regions are kept in a list. A region of file which supports
+ * RT_FIOGETADDR (such as romfs in XIP flash) is mapped to the file data in
+ * place if it's read only. Otherwise the region is allocated and read from
+ * file, the region of MAP_SHARED and PROT_WRITE is written back to file by
+ * msync() and munmap().
+ *
+ * The region doesn't hold the file descriptor of mmap(), it may be closed
+ * before unmapping. The file is written back through the descriptor opening
+ * it then, or a private opening of its path.
+ */
+
 #include <stdint.h>
 #include <stdio.h>
 
 #include <rtthread.h>
 #include <dfs_posix.h>
+#include <dfs_pcache.h>
 
 #include <sys/mman.h>
 
+#define MMAP_REGION_ALLOC   0   /* allocated by mmap */
+#define MMAP_REGION_USER    1   /* the memory of addr given by user */
+#define MMAP_REGION_DIRECT  2   /* the file data in place */
+
+struct mmap_region
+{
+    rt_list_t list;
+
+    rt_uint8_t *addr;
+    size_t length;
+    int type;
+
+    char *path;                 /* the file written back */
+    off_t offset;
+    size_t file_length;         /* the length of region backed by file */
+};
+
+static rt_list_t _mmap_regions = RT_LIST_OBJECT_INIT(_mmap_regions);
+static struct rt_mutex _mmap_lock;
+
+/* the region contains the range of memory */
+static struct mmap_region *mmap_region_find(void *addr, size_t length)
+{
+    rt_list_t *node;
+    struct mmap_region *region;
+
+    rt_list_for_each(node, &_mmap_regions)
+    {
+        region = rt_list_entry(node, struct mmap_region, list);
+        if ((rt_uint8_t *)addr >= region->addr &&
+            (rt_uint8_t *)addr + length <= region->addr + region->length)
+            return region;
+    }
+
+    return RT_NULL;
+}
+
+/* the full path of file, which is opened again for writing back */
+static char *mmap_file_path(struct dfs_fd *d)
+{
+    char *path;
+    struct dfs_filesystem *fs = d->fs;
+
+    if ((fs->ops->flags & DFS_FS_FLAG_FULLPATH) ||
+        (fs->path[0] == '/' && fs->path[1] == '\0'))
+        return rt_strdup(d->path);
+
+    path = (char *)rt_malloc(rt_strlen(fs->path) + rt_strlen(d->path) + 1);
+    if (path != RT_NULL)
+    {
+        strcpy(path, fs->path);
+        strcat(path, d->path);
+    }
+
+    return path;
+}
+
+static int mmap_file_read(struct dfs_fd *d, off_t offset, rt_uint8_t *buf, size_t length)
+{
+    size_t total;
+    int result = 0;
+
+    for (total = 0; total < length; total += result)
+    {
+        result = dfs_file_pread(d, buf + total, length - total, offset + total);
+        if (result <= 0)
+            break;
+    }
+
+    return result < 0 ? result : (int)total;
+}
+
+static int mmap_write_back(struct mmap_region *region, size_t offset, size_t length,
+                           rt_bool_t sync)
+{
+    int result;
+    struct dfs_fd *d;
+    struct dfs_fd fd;
+
+    /* the bytes beyond the end of file are not written */
+    if (offset >= region->file_length)
+        return 0;
+    if (length > region->file_length - offset)
+        length = region->file_length - offset;
+
+    /* the file can't be opened twice, use the descriptor opening it */
+    d = fd_find(region->path);
+    if (d == RT_NULL)
+    {
+        /* not a file in fd table */
+        memset(&fd, 0, sizeof(fd));
+        result = dfs_file_open(&fd, region->path, O_WRONLY);
+        if (result == -EBUSY)
+        {
+            /* opened by others meanwhile */
+            d = fd_find(region->path);
+            if (d == RT_NULL)
+                return result;
+        }
+        else if (result < 0)
+        {
+            return result;
+        }
+    }
+
+    result = dfs_file_pwrite(d ? d : &fd, region->addr + offset, length,
+                             region->offset + offset);
+    if (result >= 0 && (size_t)result != length)
+        result = -ENOSPC;
+
+    if (d != RT_NULL)
+    {
+        if (result >= 0 && sync)
+        {
+            result = dfs_file_flush(d);
+            /* the file system writes through */
+            if (result == -ENOSYS)
+                result = 0;
+        }
+        fd_put(d);
+    }
+    else
+    {
+        /* the data is flushed on closing */
+        if (dfs_file_close(&fd) < 0 && result >= 0)
+            result = -EIO;
+    }
+
+    return result < 0 ? result : 0;
+}
+
+static void mmap_region_free(struct mmap_region *region)
+{
+    if (region->type == MMAP_REGION_ALLOC)
+        rt_free(region->addr);
+    rt_free(region->path);
+    rt_free(region);
+}
+
 void *mmap(void *addr, size_t length, int prot, int flags,
     int fd, off_t offset)
 {
-    uint8_t *mem;
+    int result;
+    off_t size;
+    rt_uint8_t *data;
+    struct dfs_fd *d = RT_NULL;
+    struct mmap_region *region;
+
+    if (length == 0 || offset < 0 ||
+        ((flags & MAP_TYPE) != MAP_SHARED && (flags & MAP_TYPE) != MAP_PRIVATE))
+    {
+        errno = EINVAL;
 
-    if (addr)
+        return MAP_FAILED;
+    }
+
+    region = (struct mmap_region *)rt_calloc(1, sizeof(struct mmap_region));
+    if (region == RT_NULL)
     {
-        mem = addr;
+        errno = ENOMEM;
+
+        return MAP_FAILED;
     }
-    else mem = (uint8_t *)malloc(length);
+    region->length = length;
+    region->offset = offset;
 
-    if (mem)
+    if (!(flags & MAP_ANONYMOUS))
     {
-        off_t cur;
-        size_t read_bytes;
+        d = fd_get(fd);
+        if (d == RT_NULL)
+        {
+            rt_free(region);
+            errno = EBADF;
 
-        cur = lseek(fd, 0, SEEK_SET);
+            return MAP_FAILED;
+        }
+        if (d->type != FT_REGULAR || d->fs == RT_NULL)
+        {
+            fd_put(d);
+            rt_free(region);
+            errno = ENODEV;
 
-        lseek(fd, offset, SEEK_SET);
-        read_bytes = read(fd, addr, length);
-        if (read_bytes != length)
+            return MAP_FAILED;
+        }
+        if ((flags & MAP_TYPE) == MAP_SHARED && (prot & PROT_WRITE) &&
+            (d->flags & O_ACCMODE) == O_RDONLY)
         {
-            if (addr == RT_NULL)
+            fd_put(d);
+            rt_free(region);
+            errno = EACCES;
+
+            return MAP_FAILED;
+        }
+
+        /* the size includes the data not written back from page cache */
+        size = DFS_FD_SIZE(d);
+        if (offset < size)
+            region->file_length = size - offset < (off_t)length ? size - offset : length;
+    }
+
+    /* map the read only data of file in place */
+    if (d != RT_NULL && addr == RT_NULL && !(prot & PROT_WRITE) &&
+        region->file_length == length &&
+        dfs_file_ioctl(d, RT_FIOGETADDR, &data) == 0)
+    {
+        region->addr = data + offset;
+        region->type = MMAP_REGION_DIRECT;
+    }
+    else
+    {
+        if (addr != RT_NULL)
+        {
+            region->addr = addr;
+            region->type = MMAP_REGION_USER;
+        }
+        else
+        {
+            region->addr = (rt_uint8_t *)rt_malloc(length);
+            region->type = MMAP_REGION_ALLOC;
+        }
+
+        if (region->addr == RT_NULL)
+        {
+            result = -ENOMEM;
+            goto __failed;
+        }
+
+        result = 0;
+        if (region->file_length > 0)
+        {
+            result = mmap_file_read(d, offset, region->addr, region->file_length);
+            if (result < 0)
+                goto __failed;
+        }
+        /* the bytes beyond the end of file are zero */
+        rt_memset(region->addr + result, 0, length - result);
+        region->file_length = result;
+
+        if ((flags & MAP_TYPE) == MAP_SHARED && (prot & PROT_WRITE) && d != RT_NULL)
+        {
+            region->path = mmap_file_path(d);
+            if (region->path == RT_NULL)
             {
-                /* read failed */
-                free(mem);
-                mem = RT_NULL;
+                result = -ENOMEM;
+                goto __failed;
             }
         }
-        lseek(fd, cur, SEEK_SET);
-
-        return mem;
     }
 
-    errno = ENOMEM;
+    /* the file is found by path to write back */
+    if (d != RT_NULL)
+        fd_put(d);
+
+    rt_mutex_take(&_mmap_lock, RT_WAITING_FOREVER);
+    rt_list_insert_after(&_mmap_regions, &(region->list));
+    rt_mutex_release(&_mmap_lock);
+
+    return region->addr;
+
+__failed:
+    if (d != RT_NULL)
+        fd_put(d);
+    mmap_region_free(region);
+    errno = -result;
 
     return MAP_FAILED;
 }
+RTM_EXPORT(mmap);
 
 int munmap(void *addr, size_t length)
 {
-    if (addr)
+    int result = 0;
+    struct mmap_region *region;
+
+    rt_mutex_take(&_mmap_lock, RT_WAITING_FOREVER);
+    region = mmap_region_find(addr, 0);
+    if (region == RT_NULL || region->addr != addr)
     {
-        free(addr);
-        return 0;
+        rt_mutex_release(&_mmap_lock);
+        errno = EINVAL;
+
+        return -1;
     }
+    rt_list_remove(&(region->list));
+
+    if (region->path != RT_NULL)
+        result = mmap_write_back(region, 0, region->length, RT_FALSE);
+    rt_mutex_release(&_mmap_lock);
+
+    mmap_region_free(region);
+    if (result < 0)
+    {
+        errno = -result;
+
+        return -1;
+    }
+
+    return 0;
+}
+RTM_EXPORT(munmap);
+
+int msync(void *addr, size_t length, int flags)
+{
+    int result = 0;
+    struct mmap_region *region;
+
+    rt_mutex_take(&_mmap_lock, RT_WAITING_FOREVER);
+    region = mmap_region_find(addr, length);
+    if (region == RT_NULL)
+    {
+        rt_mutex_release(&_mmap_lock);
+        errno = ENOMEM;
+
+        return -1;
+    }
+
+    if (region->path != RT_NULL)
+    {
+        result = mmap_write_back(region, (rt_uint8_t *)addr - region->addr, length,
+                                 (flags & MS_SYNC) ? RT_TRUE : RT_FALSE);
+    }
+    rt_mutex_release(&_mmap_lock);
+
+    if (result < 0)
+    {
+        errno = -result;
+
+        return -1;
+    }
+
+    return 0;
+}
+RTM_EXPORT(msync);
+
+int posix_mmap_init(void)
+{
+    rt_mutex_init(&_mmap_lock, "mmap", RT_IPC_FLAG_FIFO);
 
-    return -1;
+    return 0;
 }
+INIT_COMPONENT_EXPORT(posix_mmap_init);
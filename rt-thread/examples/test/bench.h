@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * The common skeleton of benchmarks: the threads are created (and bound to
+ * cpu on SMP), started together, and each of them calls bench_done() when it
+ * finishes. bench_run() returns the ticks elapsed until all of them are done.
+ */
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <rtthread.h>
+
+#define BENCH_PRIORITY          (RT_THREAD_PRIORITY_MAX / 2)
+#define BENCH_THREADS_MAX       8
+
+struct bench
+{
+    struct rt_semaphore done;
+    rt_thread_t threads[BENCH_THREADS_MAX];
+    int count;
+    rt_bool_t failed;
+};
+
+rt_inline void bench_init(struct bench *bench)
+{
+    rt_memset(bench, 0, sizeof(struct bench));
+    rt_sem_init(&(bench->done), "done", 0, RT_IPC_FLAG_FIFO);
+}
+
+rt_inline void bench_detach(struct bench *bench)
+{
+    rt_sem_detach(&(bench->done));
+}
+
+/* create a thread of benchmark, cpu is -1 for not binding */
+rt_inline void bench_thread(struct bench *bench, const char *name,
+                            void (*entry)(void *), void *parameter,
+                            rt_uint32_t stack_size, int cpu)
+{
+    rt_thread_t tid = RT_NULL;
+
+    if (bench->count < BENCH_THREADS_MAX)
+        tid = rt_thread_create(name, entry, parameter, stack_size, BENCH_PRIORITY, 10);
+    if (tid == RT_NULL)
+    {
+        bench->failed = RT_TRUE;
+        return;
+    }
+
+#ifdef RT_USING_SMP
+    if (cpu >= 0)
+        rt_thread_control(tid, RT_THREAD_CTRL_BIND_CPU, (void *)(rt_ubase_t)cpu);
+#endif
+
+    bench->threads[bench->count ++] = tid;
+}
+
+/* it's called by the thread of benchmark at the end */
+rt_inline void bench_done(struct bench *bench)
+{
+    rt_sem_release(&(bench->done));
+}
+
+/* the ticks elapsed since start, at least 1 for computing the rate */
+rt_inline rt_tick_t bench_elapsed(rt_tick_t start)
+{
+    rt_tick_t tick = rt_tick_get() - start;
+
+    return tick ? tick : 1;
+}
+
+/* the count per second */
+rt_inline rt_uint32_t bench_rate(rt_uint64_t count, rt_tick_t tick)
+{
+    return (rt_uint32_t)(count * RT_TICK_PER_SECOND / tick);
+}
+
+/*
+ * start the threads in the reverse order of creating, and wait for them
+ * done. It returns the ticks elapsed, or 0 if any thread is not created.
+ */
+rt_inline rt_tick_t bench_run(struct bench *bench)
+{
+    int index;
+    rt_tick_t tick;
+
+    if (bench->failed)
+    {
+        rt_kprintf("create thread failed\n");
+        for (index = 0; index < bench->count; index ++)
+            rt_thread_delete(bench->threads[index]);
+        bench->count = 0;
+        bench->failed = RT_FALSE;
+
+        return 0;
+    }
+
+    tick = rt_tick_get();
+    for (index = bench->count - 1; index >= 0; index --)
+        rt_thread_startup(bench->threads[index]);
+    for (index = 0; index < bench->count; index ++)
+        rt_sem_take(&(bench->done), RT_WAITING_FOREVER);
+    tick = bench_elapsed(tick);
+    bench->count = 0;
+
+    return tick;
+}
+
+#endif
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Multi-threaded file I/O benchmark.
+ *
+ * Each thread writes a file and reads it back, the files are spread over the
+ * given directories, which can be on different file systems (e.g. ramfs,
+ * romfs and elmfat). For read-only file systems such as romfs, pass the path
+ * of an existing file with 'r:' prefix to read it only.
+ *
+ * msh> fs_mt_test [threads] [size KB] [block] [dir|r:file ...]
+ */
+
+#include <rtthread.h>
+#include <dfs_posix.h>
+#include <stdlib.h>
+#include "bench.h"
+
+#define FS_TEST_STACK_SIZE      2048
+#define FS_TEST_PATHS_MAX       4
+
+struct fs_test_worker
+{
+    char path[64];
+    rt_bool_t read_only;
+
+    rt_uint32_t bytes;
+    rt_tick_t write_tick;
+    rt_tick_t read_tick;
+    int error;
+};
+
+static struct fs_test_worker workers[BENCH_THREADS_MAX];
+static struct bench bench;
+
+static rt_uint32_t test_size;
+static rt_uint32_t test_block;
+
+static void fs_test_entry(void *parameter)
+{
+    int fd, length;
+    rt_uint32_t total;
+    rt_uint8_t *buffer;
+    rt_tick_t tick;
+    struct fs_test_worker *worker = (struct fs_test_worker *)parameter;
+
+    buffer = rt_malloc(test_block);
+    if (buffer == RT_NULL)
+    {
+        worker->error = -ENOMEM;
+        goto __exit;
+    }
+    rt_memset(buffer, 0x5a, test_block);
+
+    if (!worker->read_only)
+    {
+        fd = open(worker->path, O_WRONLY | O_CREAT | O_TRUNC, 0);
+        if (fd < 0)
+        {
+            worker->error = rt_get_errno();
+            goto __exit;
+        }
+
+        tick = rt_tick_get();
+        for (total = 0; total < test_size; total += length)
+        {
+            length = write(fd, buffer, test_block);
+            if (length <= 0)
+            {
+                worker->error = rt_get_errno();
+                break;
+            }
+        }
+        close(fd);
+        worker->write_tick = bench_elapsed(tick);
+        if (worker->error) goto __exit;
+    }
+
+    fd = open(worker->path, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        worker->error = rt_get_errno();
+        goto __exit;
+    }
+
+    tick = rt_tick_get();
+    for (total = 0; total < test_size; total += length)
+    {
+        length = read(fd, buffer, test_block);
+        if (length <= 0)
+            break;
+    }
+    close(fd);
+    worker->read_tick = bench_elapsed(tick);
+    worker->bytes = total;
+
+__exit:
+    if (buffer) rt_free(buffer);
+    bench_done(&bench);
+}
+
+/* KB/s */
+#define fs_test_speed(bytes, tick)  (bench_rate(bytes, tick) / 1024)
+
+int fs_mt_test(int argc, char **argv)
+{
+    int index, threads, paths;
+    const char *path[FS_TEST_PATHS_MAX] = {"/"};
+    rt_uint32_t bytes = 0;
+    rt_tick_t tick;
+
+    threads = 2;
+    test_size = 256 * 1024;
+    test_block = 4096;
+    paths = 1;
+    if (argc > 1) threads = atoi(argv[1]);
+    if (argc > 2) test_size = atoi(argv[2]) * 1024;
+    if (argc > 3) test_block = atoi(argv[3]);
+    for (index = 4; index < argc && index - 4 < FS_TEST_PATHS_MAX; index ++)
+        path[index - 4] = argv[index];
+    if (argc > 4) paths = index - 4;
+
+    if (threads <= 0) threads = 1;
+    if (threads > BENCH_THREADS_MAX) threads = BENCH_THREADS_MAX;
+    if (test_block == 0) test_block = 512;
+
+    bench_init(&bench);
+
+    for (index = 0; index < threads; index ++)
+    {
+        const char *p = path[index % paths];
+        struct fs_test_worker *worker = &workers[index];
+
+        rt_memset(worker, 0, sizeof(struct fs_test_worker));
+        if (p[0] == 'r' && p[1] == ':')
+        {
+            worker->read_only = RT_TRUE;
+            rt_snprintf(worker->path, sizeof(worker->path), "%s", p + 2);
+        }
+        else
+        {
+            rt_snprintf(worker->path, sizeof(worker->path), "%s/fsmt%d.dat",
+                        (p[0] == '/' && p[1] == '\0') ? "" : p, index);
+        }
+
+        bench_thread(&bench, "fsmt", fs_test_entry, worker, FS_TEST_STACK_SIZE, -1);
+    }
+
+    tick = bench_run(&bench);
+    if (tick == 0)
+        goto __exit;
+
+    for (index = 0; index < threads; index ++)
+    {
+        struct fs_test_worker *worker = &workers[index];
+
+        if (worker->error)
+        {
+            rt_kprintf("%-24s error %d\n", worker->path, worker->error);
+            continue;
+        }
+
+        if (worker->read_only)
+            rt_kprintf("%-24s write     -- KB/s, read %6d KB/s\n", worker->path,
+                       fs_test_speed(worker->bytes, worker->read_tick));
+        else
+            rt_kprintf("%-24s write %6d KB/s, read %6d KB/s\n", worker->path,
+                       fs_test_speed(worker->bytes, worker->write_tick),
+                       fs_test_speed(worker->bytes, worker->read_tick));
+
+        bytes += worker->bytes * (worker->read_only ? 1 : 2);
+        if (!worker->read_only)
+            unlink(worker->path);
+    }
+    rt_kprintf("%d threads, block %d, total %d KB/s\n", threads, test_block,
+               fs_test_speed(bytes, tick));
+
+__exit:
+    bench_detach(&bench);
+
+    return 0;
+}
+MSH_CMD_EXPORT(fs_mt_test, multi-threaded file io benchmark: fs_mt_test [threads] [size KB] [block] [dir|r:file ...]);
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Mailbox and message queue batch throughput benchmark.
+ *
+ * A producer thread sends messages to a consumer thread, batch messages in
+ * each call. Batch 1 goes through rt_mb_send_wait/rt_mb_recv and
+ * rt_mq_send/rt_mq_recv, others go through the batch interfaces. On SMP, the
+ * threads can be bound to the same cpu or to different cpus.
+ *
+ * msh> ipc_batch_test [messages] [batch] [cpu0] [cpu1]
+ */
+
+#include <rtthread.h>
+#include <stdlib.h>
+#include "bench.h"
+
+#define IPC_TEST_STACK_SIZE     1024
+#define IPC_TEST_QUEUE_SIZE     64
+#define IPC_TEST_MSG_SIZE       16
+#define IPC_TEST_BATCH_MAX      32
+
+static struct rt_mailbox test_mb;
+static rt_ubase_t test_mb_pool[IPC_TEST_QUEUE_SIZE];
+static struct rt_messagequeue test_mq;
+static rt_uint8_t test_mq_pool[IPC_TEST_QUEUE_SIZE * (IPC_TEST_MSG_SIZE + sizeof(void *))];
+static struct bench bench;
+
+static rt_uint32_t test_messages;
+static rt_size_t test_batch;
+
+static void mb_producer(void *parameter)
+{
+    rt_ubase_t values[IPC_TEST_BATCH_MAX];
+    rt_uint32_t sent = 0;
+    rt_size_t count;
+
+    while (sent < test_messages)
+    {
+        count = test_messages - sent;
+        if (count > test_batch) count = test_batch;
+
+        if (test_batch == 1)
+            rt_mb_send_wait(&test_mb, sent, RT_WAITING_FOREVER);
+        else
+            rt_mb_send_batch(&test_mb, values, &count, RT_WAITING_FOREVER);
+        sent += count;
+    }
+
+    bench_done(&bench);
+}
+
+static void mb_consumer(void *parameter)
+{
+    rt_ubase_t values[IPC_TEST_BATCH_MAX];
+    rt_uint32_t received = 0;
+    rt_size_t count;
+
+    while (received < test_messages)
+    {
+        count = test_batch;
+
+        if (test_batch == 1)
+            rt_mb_recv(&test_mb, values, RT_WAITING_FOREVER);
+        else
+            rt_mb_recv_batch(&test_mb, values, &count, RT_WAITING_FOREVER);
+        received += count;
+    }
+
+    bench_done(&bench);
+}
+
+static void mq_producer(void *parameter)
+{
+    rt_uint8_t buffer[IPC_TEST_BATCH_MAX * IPC_TEST_MSG_SIZE];
+    rt_uint32_t sent = 0;
+    rt_size_t count;
+
+    while (sent < test_messages)
+    {
+        count = test_messages - sent;
+        if (count > test_batch) count = test_batch;
+
+        /* message queue sending never blocks, yield when it's full */
+        if (test_batch == 1)
+        {
+            if (rt_mq_send(&test_mq, buffer, IPC_TEST_MSG_SIZE) != RT_EOK)
+                count = 0;
+        }
+        else
+        {
+            rt_mq_send_batch(&test_mq, buffer, IPC_TEST_MSG_SIZE, &count);
+        }
+
+        if (count == 0)
+            rt_thread_delay(1);
+        sent += count;
+    }
+
+    bench_done(&bench);
+}
+
+static void mq_consumer(void *parameter)
+{
+    rt_uint8_t buffer[IPC_TEST_BATCH_MAX * IPC_TEST_MSG_SIZE];
+    rt_uint32_t received = 0;
+    rt_size_t count;
+
+    while (received < test_messages)
+    {
+        count = test_batch;
+
+        if (test_batch == 1)
+            rt_mq_recv(&test_mq, buffer, IPC_TEST_MSG_SIZE, RT_WAITING_FOREVER);
+        else
+            rt_mq_recv_batch(&test_mq, buffer, IPC_TEST_MSG_SIZE, &count, RT_WAITING_FOREVER);
+        received += count;
+    }
+
+    bench_done(&bench);
+}
+
+static void ipc_test_run(const char *name, void (*producer)(void *),
+                         void (*consumer)(void *), int cpu0, int cpu1)
+{
+    rt_tick_t tick;
+
+    bench_thread(&bench, "prod", producer, RT_NULL, IPC_TEST_STACK_SIZE, cpu0);
+    bench_thread(&bench, "cons", consumer, RT_NULL, IPC_TEST_STACK_SIZE, cpu1);
+    tick = bench_run(&bench);
+    if (tick != 0)
+        rt_kprintf("%s: %d messages, batch %d, %d ticks, %d msgs/s\n", name,
+                   test_messages, test_batch, tick, bench_rate(test_messages, tick));
+}
+
+int ipc_batch_test(int argc, char **argv)
+{
+    int cpu0 = -1, cpu1 = -1;
+
+    test_messages = 100000;
+    test_batch = 8;
+    if (argc > 1) test_messages = atoi(argv[1]);
+    if (argc > 2) test_batch = atoi(argv[2]);
+    if (argc > 3) cpu0 = atoi(argv[3]);
+    if (argc > 4) cpu1 = atoi(argv[4]);
+
+    if (test_batch == 0) test_batch = 1;
+    if (test_batch > IPC_TEST_BATCH_MAX) test_batch = IPC_TEST_BATCH_MAX;
+
+    bench_init(&bench);
+    rt_mb_init(&test_mb, "tmb", test_mb_pool, IPC_TEST_QUEUE_SIZE, RT_IPC_FLAG_FIFO);
+    rt_mq_init(&test_mq, "tmq", test_mq_pool, IPC_TEST_MSG_SIZE,
+               sizeof(test_mq_pool), RT_IPC_FLAG_FIFO);
+
+    ipc_test_run("mailbox", mb_producer, mb_consumer, cpu0, cpu1);
+    ipc_test_run("msgqueue", mq_producer, mq_consumer, cpu0, cpu1);
+
+    rt_mq_detach(&test_mq);
+    rt_mb_detach(&test_mb);
+    bench_detach(&bench);
+
+    return 0;
+}
+MSH_CMD_EXPORT(ipc_batch_test, mailbox and message queue batch benchmark: ipc_batch_test [messages] [batch] [cpu0] [cpu1]);
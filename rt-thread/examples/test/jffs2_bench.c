@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * JFFS2 mount time and write latency benchmark.
+ *
+ * A NOR flash emulated in RAM is formatted and mounted on the given
+ * directory, the files are written and rewritten until garbage collection
+ * is needed, then the file system is mounted again. The flash accesses of
+ * mounting are counted, which show the effect of the erase block summary
+ * (RT_JFFS2_USING_SUMMARY), and the latency of writes shows the effect of
+ * the background GC thread (RT_JFFS2_USING_GCTHREAD).
+ *
+ * msh> jffs2_bench <mount dir> [blocks] [files] [file KB] [rounds]
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <dfs_posix.h>
+#include <dfs_fs.h>
+#include <stdlib.h>
+
+#define JFFS2_BENCH_DEVICE      "jffs2ram"
+#define JFFS2_BENCH_BLOCK_SIZE  (64 * 1024)
+#define JFFS2_BENCH_WRITE_SIZE  1024
+
+struct jffs2_bench_stat
+{
+    rt_uint32_t read_bytes;
+    rt_uint32_t write_bytes;
+    rt_uint32_t erases;
+};
+
+static struct rt_mtd_nor_device ram_nor;
+static rt_uint8_t *ram_nor_buf;
+static struct jffs2_bench_stat bench_stat;
+
+static rt_err_t ram_nor_read_id(struct rt_mtd_nor_device *device)
+{
+    return RT_EOK;
+}
+
+static rt_size_t ram_nor_read(struct rt_mtd_nor_device *device, rt_off_t offset,
+                              rt_uint8_t *data, rt_uint32_t length)
+{
+    rt_memcpy(data, ram_nor_buf + offset, length);
+    bench_stat.read_bytes += length;
+
+    return length;
+}
+
+static rt_size_t ram_nor_write(struct rt_mtd_nor_device *device, rt_off_t offset,
+                               const rt_uint8_t *data, rt_uint32_t length)
+{
+    rt_uint32_t index;
+
+    /* the programming of NOR flash only clears bits */
+    for (index = 0; index < length; index ++)
+        ram_nor_buf[offset + index] &= data[index];
+    bench_stat.write_bytes += length;
+
+    return length;
+}
+
+static rt_err_t ram_nor_erase_block(struct rt_mtd_nor_device *device, rt_off_t offset,
+                                    rt_uint32_t length)
+{
+    rt_memset(ram_nor_buf + offset, 0xff, length);
+    bench_stat.erases ++;
+
+    return RT_EOK;
+}
+
+static const struct rt_mtd_nor_driver_ops ram_nor_ops =
+{
+    ram_nor_read_id,
+    ram_nor_read,
+    ram_nor_write,
+    ram_nor_erase_block,
+};
+
+static int ram_nor_init(rt_uint32_t blocks)
+{
+    if (ram_nor_buf != RT_NULL)
+        rt_free(ram_nor_buf);
+
+    ram_nor_buf = rt_malloc(blocks * JFFS2_BENCH_BLOCK_SIZE);
+    if (ram_nor_buf == RT_NULL)
+        return -ENOMEM;
+    rt_memset(ram_nor_buf, 0xff, blocks * JFFS2_BENCH_BLOCK_SIZE);
+
+    ram_nor.block_size = JFFS2_BENCH_BLOCK_SIZE;
+    ram_nor.block_start = 0;
+    ram_nor.block_end = blocks;
+    if (rt_device_find(JFFS2_BENCH_DEVICE) == RT_NULL)
+    {
+        ram_nor.ops = &ram_nor_ops;
+        if (rt_mtd_nor_register_device(JFFS2_BENCH_DEVICE, &ram_nor) != RT_EOK)
+            return -EIO;
+    }
+
+    return 0;
+}
+
+static int jffs2_bench_mount(const char *path)
+{
+    int result;
+    rt_tick_t tick;
+
+    rt_memset(&bench_stat, 0, sizeof(bench_stat));
+    tick = rt_tick_get();
+    result = dfs_mount(JFFS2_BENCH_DEVICE, path, "jffs2", 0, 0);
+    tick = rt_tick_get() - tick;
+    if (result != 0)
+    {
+        rt_kprintf("mount jffs2 on %s failed %d\n", path, rt_get_errno());
+        return -1;
+    }
+
+    rt_kprintf("mount: %d ticks, read %d KB\n", tick, bench_stat.read_bytes / 1024);
+    return 0;
+}
+
+int jffs2_bench(int argc, char **argv)
+{
+    int fd, index, round, length;
+    rt_uint32_t blocks, files, file_size, rounds, total, writes;
+    rt_tick_t tick, write_tick, max_tick;
+    rt_uint8_t *buffer;
+    char name[64];
+    const char *path;
+
+    if (argc < 2)
+    {
+        rt_kprintf("Usage: jffs2_bench <mount dir> [blocks] [files] [file KB] [rounds]\n");
+        return -1;
+    }
+
+    path = argv[1];
+    blocks = 16;
+    files = 32;
+    file_size = 8 * 1024;
+    rounds = 4;
+    if (argc > 2) blocks = atoi(argv[2]);
+    if (argc > 3) files = atoi(argv[3]);
+    if (argc > 4) file_size = atoi(argv[4]) * 1024;
+    if (argc > 5) rounds = atoi(argv[5]);
+    if (blocks < 8) blocks = 8;
+
+    buffer = rt_malloc(JFFS2_BENCH_WRITE_SIZE);
+    if (buffer == RT_NULL)
+        return -1;
+
+    if (ram_nor_init(blocks) != 0 || jffs2_bench_mount(path) != 0)
+    {
+        rt_free(buffer);
+        return -1;
+    }
+
+    /* rewrite the files, the old data is obsoleted and collected */
+    write_tick = max_tick = 0;
+    writes = 0;
+    rt_memset(&bench_stat, 0, sizeof(bench_stat));
+    for (round = 0; round < rounds; round ++)
+    {
+        for (index = 0; index < files; index ++)
+        {
+            rt_snprintf(name, sizeof(name), "%s/bench%d.dat", path, index);
+            fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0);
+            if (fd < 0)
+            {
+                rt_kprintf("open %s failed %d\n", name, rt_get_errno());
+                goto __exit;
+            }
+
+            rt_memset(buffer, round + index, JFFS2_BENCH_WRITE_SIZE);
+            for (total = 0; total < file_size; total += length)
+            {
+                tick = rt_tick_get();
+                length = write(fd, buffer, JFFS2_BENCH_WRITE_SIZE);
+                tick = rt_tick_get() - tick;
+                if (length <= 0)
+                {
+                    rt_kprintf("write %s failed %d\n", name, rt_get_errno());
+                    close(fd);
+                    goto __exit;
+                }
+
+                write_tick += tick;
+                if (tick > max_tick) max_tick = tick;
+                writes ++;
+            }
+            close(fd);
+        }
+    }
+    rt_kprintf("write: %d writes of %d bytes, %d ticks, max %d ticks, %d erases\n",
+               writes, JFFS2_BENCH_WRITE_SIZE, write_tick, max_tick, bench_stat.erases);
+
+    dfs_unmount(path);
+    jffs2_bench_mount(path);
+
+__exit:
+    dfs_unmount(path);
+    rt_free(buffer);
+
+    return 0;
+}
+MSH_CMD_EXPORT(jffs2_bench, jffs2 mount and write benchmark: jffs2_bench <mount dir> [blocks] [files] [file KB] [rounds]);
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Object finding benchmark.
+ *
+ * It creates a number of semaphore objects and finds each of them by name
+ * many times, with RT_USING_OBJECT_HASH enabled or not.
+ *
+ * msh> object_test [objects] [loops]
+ */
+
+#include <rtthread.h>
+#include <stdlib.h>
+#include "bench.h"
+
+int object_test(int argc, char **argv)
+{
+    int objects = 1000, loops = 10;
+    int index, loop, missed = 0;
+    rt_sem_t *sems;
+    char name[RT_NAME_MAX + 1];
+    rt_tick_t tick;
+
+    if (argc > 1) objects = atoi(argv[1]);
+    if (argc > 2) loops = atoi(argv[2]);
+    if (objects <= 0 || loops <= 0) return -1;
+
+    sems = (rt_sem_t *)rt_calloc(objects, sizeof(rt_sem_t));
+    if (sems == RT_NULL)
+    {
+        rt_kprintf("no memory\n");
+        return -1;
+    }
+
+    for (index = 0; index < objects; index ++)
+    {
+        rt_snprintf(name, sizeof(name), "b%d", index);
+        sems[index] = rt_sem_create(name, 0, RT_IPC_FLAG_FIFO);
+        if (sems[index] == RT_NULL)
+        {
+            rt_kprintf("create object %d failed\n", index);
+            objects = index;
+            break;
+        }
+    }
+
+    tick = rt_tick_get();
+    for (loop = 0; loop < loops; loop ++)
+    {
+        for (index = 0; index < objects; index ++)
+        {
+            rt_snprintf(name, sizeof(name), "b%d", index);
+            if (rt_object_find(name, RT_Object_Class_Semaphore) != (rt_object_t)sems[index])
+                missed ++;
+        }
+    }
+    tick = bench_elapsed(tick);
+
+    rt_kprintf("%d finds in %d objects: %d ticks, %d finds/s, %d missed\n",
+               objects * loops, objects, tick,
+               bench_rate((rt_uint64_t)objects * loops, tick), missed);
+
+    for (index = 0; index < objects; index ++)
+        rt_sem_delete(sems[index]);
+    rt_free(sems);
+
+    return 0;
+}
+MSH_CMD_EXPORT(object_test, object finding benchmark: object_test [objects] [loops]);
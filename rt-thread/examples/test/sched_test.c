@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2006-2018, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Context switch micro-benchmark.
+ *
+ * Two threads ping-pong through a pair of semaphores, so each round trip is
+ * two wakeups and two context switches. On SMP, the threads can be bound to
+ * the same cpu or to different cpus.
+ *
+ * msh> sched_test [rounds] [cpu0] [cpu1]
+ */
+
+#include <rtthread.h>
+#include <stdlib.h>
+#include "bench.h"
+
+#define SCHED_TEST_STACK_SIZE   1024
+
+static struct rt_semaphore ping_sem, pong_sem;
+static struct bench bench;
+static rt_uint32_t test_rounds;
+
+static void ping_entry(void *parameter)
+{
+    rt_uint32_t index;
+
+    for (index = 0; index < test_rounds; index ++)
+    {
+        rt_sem_release(&ping_sem);
+        rt_sem_take(&pong_sem, RT_WAITING_FOREVER);
+    }
+
+    bench_done(&bench);
+}
+
+static void pong_entry(void *parameter)
+{
+    rt_uint32_t index;
+
+    for (index = 0; index < test_rounds; index ++)
+    {
+        rt_sem_take(&ping_sem, RT_WAITING_FOREVER);
+        rt_sem_release(&pong_sem);
+    }
+
+    bench_done(&bench);
+}
+
+int sched_test(int argc, char **argv)
+{
+    rt_tick_t tick;
+    int cpu0 = -1, cpu1 = -1;
+
+    test_rounds = 100000;
+    if (argc > 1) test_rounds = atoi(argv[1]);
+    if (argc > 2) cpu0 = atoi(argv[2]);
+    if (argc > 3) cpu1 = atoi(argv[3]);
+
+    rt_sem_init(&ping_sem, "ping", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&pong_sem, "pong", 0, RT_IPC_FLAG_FIFO);
+    bench_init(&bench);
+
+    bench_thread(&bench, "ping", ping_entry, RT_NULL, SCHED_TEST_STACK_SIZE, cpu0);
+    bench_thread(&bench, "pong", pong_entry, RT_NULL, SCHED_TEST_STACK_SIZE, cpu1);
+    tick = bench_run(&bench);
+    if (tick != 0)
+        rt_kprintf("%d rounds in %d ticks, %d switches/s\n", test_rounds, tick,
+                   bench_rate((rt_uint64_t)test_rounds * 2, tick));
+
+    rt_sem_detach(&ping_sem);
+    rt_sem_detach(&pong_sem);
+    bench_detach(&bench);
+
+    return 0;
+}
+MSH_CMD_EXPORT(sched_test, context switch benchmark: sched_test [rounds] [cpu0] [cpu1]);
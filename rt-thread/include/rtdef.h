@@ -342,6 +342,9 @@ struct rt_object
     void      *module_id;                               /**< id of application module */
 #endif
     rt_list_t  list;                                    /**< list node of kernel object */
+#ifdef RT_USING_OBJECT_HASH
+    struct rt_object *hash_next;                        /**< next object in name hash bucket */
+#endif
 };
 typedef struct rt_object *rt_object_t;                  /**< Type for kernel objects. */
 
@@ -379,6 +382,10 @@ enum rt_object_class_type
     RT_Object_Class_Static = 0x80                       /**< The object is a static object. */
 };
 
+#if defined(RT_USING_OBJECT_HASH) && !defined(RT_OBJECT_HASH_SIZE)
+#define RT_OBJECT_HASH_SIZE             32              /**< hash buckets of each object class */
+#endif
+
 /**
  * The information of the kernel object
  */
@@ -387,6 +394,9 @@ struct rt_object_information
     enum rt_object_class_type type;                     /**< object class type */
     rt_list_t                 object_list;              /**< object list */
     rt_size_t                 object_size;              /**< object size */
+#ifdef RT_USING_OBJECT_HASH
+    struct rt_object         *hash_table[RT_OBJECT_HASH_SIZE]; /**< name hash index */
+#endif
 };
 
 /**
@@ -498,9 +508,48 @@ typedef siginfo_t rt_siginfo_t;
 #define RT_THREAD_CTRL_CHANGE_PRIORITY  0x02                /**< Change thread priority. */
 #define RT_THREAD_CTRL_INFO             0x03                /**< Get thread information. */
 #define RT_THREAD_CTRL_BIND_CPU         0x03                /**< Set thread bind cpu. */
+#define RT_THREAD_CTRL_SET_EDF          0x04                /**< Set thread EDF reservation. */
+
+#ifdef RT_USING_SCHED_EDF
+/* the priority level of EDF band, which is above the idle thread */
+#ifndef RT_SCHED_EDF_PRIORITY
+#define RT_SCHED_EDF_PRIORITY           (RT_THREAD_PRIORITY_MAX - 2)
+#endif
+
+#if RT_SCHED_EDF_PRIORITY >= RT_THREAD_PRIORITY_MAX - 1
+#error "RT_SCHED_EDF_PRIORITY shall be less than RT_THREAD_PRIORITY_MAX - 1"
+#endif
+
+/**
+ * EDF/CBS reservation parameters, all in ticks
+ */
+struct rt_edf_param
+{
+    rt_tick_t runtime;                                  /**< budget granted in each period */
+    rt_tick_t deadline;                                 /**< relative deadline, 0 means period */
+    rt_tick_t period;                                   /**< reservation period */
+};
+#endif
+
+/**
+ * ready bitmap of scheduler
+ */
+struct rt_ready_bitmap
+{
+#if RT_THREAD_PRIORITY_MAX > 32
+    rt_uint32_t priority_group;                         /**< one bit for each word of ready table */
+    rt_uint32_t ready_table[RT_THREAD_PRIORITY_MAX / 32]; /**< one bit for each priority */
+#else
+    rt_uint32_t priority_group;                         /**< one bit for each priority */
+#endif
+};
 
 #ifdef RT_USING_SMP
 
+#ifndef RT_CPU_CACHE_LINE_SZ
+#define RT_CPU_CACHE_LINE_SZ            32                  /**< Cache line size of CPU. */
+#endif
+
 #define RT_CPU_DETACHED                 RT_CPUS_NR          /**< The thread not running on cpu. */
 #define RT_CPU_MASK                     ((1 << RT_CPUS_NR) - 1) /**< All CPUs mask bit. */
 
@@ -520,15 +569,14 @@ struct rt_cpu
     rt_uint8_t  irq_switch_flag;
 
     rt_uint8_t current_priority;
-    rt_list_t priority_table[RT_THREAD_PRIORITY_MAX];
-#if RT_THREAD_PRIORITY_MAX > 32
-    rt_uint32_t priority_group;
-    rt_uint8_t ready_table[32];
-#else
-    rt_uint32_t priority_group;
-#endif
-
     rt_tick_t tick;
+
+    /*
+     * the ready bitmap and ready queue of this cpu start a new cache line,
+     * which is not shared with the data of other cpus.
+     */
+    struct rt_ready_bitmap ready ALIGN(RT_CPU_CACHE_LINE_SZ);
+    rt_list_t priority_table[RT_THREAD_PRIORITY_MAX];
 };
 
 #endif
@@ -548,6 +596,9 @@ struct rt_thread
 #endif
 
     rt_list_t   list;                                   /**< the object list */
+#ifdef RT_USING_OBJECT_HASH
+    struct rt_object *hash_next;                        /**< next object in name hash bucket */
+#endif
     rt_list_t   tlist;                                  /**< the thread list */
 
     /* stack point and entry */
@@ -574,8 +625,8 @@ struct rt_thread
     rt_uint8_t  current_priority;                       /**< current priority */
     rt_uint8_t  init_priority;                          /**< initialized priority */
 #if RT_THREAD_PRIORITY_MAX > 32
-    rt_uint8_t  number;
-    rt_uint8_t  high_mask;
+    rt_uint8_t  number;                                 /**< word index in ready table */
+    rt_uint32_t high_mask;                              /**< bit mask in ready table word */
 #endif
     rt_uint32_t number_mask;
 
@@ -597,6 +648,16 @@ struct rt_thread
     rt_ubase_t  init_tick;                              /**< thread's initialized tick */
     rt_ubase_t  remaining_tick;                         /**< remaining tick */
 
+#ifdef RT_USING_SCHED_EDF
+    rt_tick_t   edf_runtime;                            /**< budget in each period */
+    rt_tick_t   edf_deadline;                           /**< relative deadline */
+    rt_tick_t   edf_period;                             /**< period, 0 for non-EDF thread */
+    rt_tick_t   edf_abs_deadline;                       /**< current absolute deadline */
+    rt_tick_t   edf_budget;                             /**< remaining budget */
+    rt_uint32_t edf_bandwidth;                          /**< admitted bandwidth */
+    rt_uint8_t  edf_inherited;                          /**< out of band by priority inheritance */
+#endif
+
     struct rt_timer thread_timer;                       /**< built-in thread timer */
 
     void (*cleanup)(struct rt_thread *tid);             /**< cleanup function when thread exit */
@@ -890,6 +951,7 @@ enum rt_device_class_type
 #define RT_DEVICE_CTRL_BLK_SYNC         0x11            /**< flush data to block device */
 #define RT_DEVICE_CTRL_BLK_ERASE        0x12            /**< erase block on block device */
 #define RT_DEVICE_CTRL_BLK_AUTOREFRESH  0x13            /**< block device : enter/exit auto refresh mode */
+#define RT_DEVICE_CTRL_BLK_QUEUE        0x14            /**< get request queue of block device */
 #define RT_DEVICE_CTRL_NETIF_GETMAC     0x10            /**< get mac address */
 #define RT_DEVICE_CTRL_MTD_FORMAT       0x10            /**< format a MTD device */
 #define RT_DEVICE_CTRL_RTC_GET_TIME     0x10            /**< get time */
@@ -50,6 +50,9 @@ void rt_object_delete(rt_object_t object);
 rt_bool_t rt_object_is_systemobject(rt_object_t object);
 rt_uint8_t rt_object_get_type(rt_object_t object);
 rt_object_t rt_object_find(const char *name, rt_uint8_t type);
+/* for kernel internal use only, without checking the context */
+rt_object_t _rt_object_find(const char *name, rt_uint8_t type);
+void rt_object_set_name(rt_object_t object, const char *name);
 
 #ifdef RT_USING_HOOK
 void rt_object_attach_sethook(void (*hook)(struct rt_object *object));
@@ -179,6 +182,12 @@ void rt_enter_critical(void);
 void rt_exit_critical(void);
 rt_uint16_t rt_critical_level(void);
 
+#ifdef RT_USING_SCHED_EDF
+rt_err_t rt_schedule_edf_admit(struct rt_thread *thread, struct rt_edf_param *param);
+void rt_schedule_edf_release(struct rt_thread *thread);
+rt_bool_t rt_schedule_edf_tick(struct rt_thread *thread);
+#endif
+
 #ifdef RT_USING_HOOK
 void rt_scheduler_sethook(void (*hook)(rt_thread_t from, rt_thread_t to));
 #endif
@@ -356,6 +365,14 @@ rt_err_t rt_mb_send_wait(rt_mailbox_t mb,
                          rt_ubase_t  value,
                          rt_int32_t   timeout);
 rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeout);
+rt_err_t rt_mb_send_batch(rt_mailbox_t mb,
+                          const rt_ubase_t *values,
+                          rt_size_t  *count,
+                          rt_int32_t  timeout);
+rt_err_t rt_mb_recv_batch(rt_mailbox_t mb,
+                          rt_ubase_t *values,
+                          rt_size_t  *count,
+                          rt_int32_t  timeout);
 rt_err_t rt_mb_control(rt_mailbox_t mb, int cmd, void *arg);
 #endif
 
@@ -382,6 +399,22 @@ rt_err_t rt_mq_recv(rt_mq_t    mq,
                     void      *buffer,
                     rt_size_t  size,
                     rt_int32_t timeout);
+rt_err_t rt_mq_reserve(rt_mq_t mq, void **buffer);
+rt_err_t rt_mq_commit(rt_mq_t mq, void *buffer);
+rt_err_t rt_mq_commit_urgent(rt_mq_t mq, void *buffer);
+rt_err_t rt_mq_recv_ref(rt_mq_t    mq,
+                        void     **buffer,
+                        rt_int32_t timeout);
+rt_err_t rt_mq_release(rt_mq_t mq, void *buffer);
+rt_err_t rt_mq_send_batch(rt_mq_t     mq,
+                          const void *buffer,
+                          rt_size_t   size,
+                          rt_size_t  *count);
+rt_err_t rt_mq_recv_batch(rt_mq_t    mq,
+                          void      *buffer,
+                          rt_size_t  size,
+                          rt_size_t *count,
+                          rt_int32_t timeout);
 rt_err_t rt_mq_control(rt_mq_t mq, int cmd, void *arg);
 #endif
 
@@ -84,14 +84,26 @@ void rt_tick_increase(void)
     /* check time slice */
     thread = rt_thread_self();
 
-    -- thread->remaining_tick;
-    if (thread->remaining_tick == 0)
+#ifdef RT_USING_SCHED_EDF
+    if (thread->edf_period != 0 && thread->current_priority == RT_SCHED_EDF_PRIORITY)
     {
-        /* change to initialized tick */
-        thread->remaining_tick = thread->init_tick;
-
-        /* yield */
-        rt_thread_yield();
+        /* EDF thread consumes its reservation budget instead of time slice,
+         * but not while its priority is inherited out of the band */
+        if (rt_schedule_edf_tick(thread) == RT_TRUE)
+            rt_thread_yield();
+    }
+    else
+#endif
+    {
+        -- thread->remaining_tick;
+        if (thread->remaining_tick == 0)
+        {
+            /* change to initialized tick */
+            thread->remaining_tick = thread->init_tick;
+
+            /* yield */
+            rt_thread_yield();
+        }
     }
 
     /* check timer */
@@ -145,6 +145,28 @@ rt_inline rt_err_t rt_ipc_list_resume(rt_list_t *list)
     return RT_EOK;
 }
 
+/**
+ * This function will resume at most the specified number of threads in the
+ * list of a IPC object. The interrupt shall be disabled before invoking.
+ *
+ * @param list the thread list
+ * @param count the maximal number of threads to resume
+ *
+ * @return the number of resumed threads
+ */
+rt_inline rt_size_t rt_ipc_list_resume_n(rt_list_t *list, rt_size_t count)
+{
+    rt_size_t resumed = 0;
+
+    while (resumed < count && !rt_list_isempty(list))
+    {
+        rt_ipc_list_resume(list);
+        resumed ++;
+    }
+
+    return resumed;
+}
+
 /**
  * This function will resume all suspended threads in a list, including
  * suspend list of IPC object and private list of mailbox etc.
@@ -718,6 +740,10 @@ __again:
                 /* change the owner thread priority of mutex */
                 if (thread->current_priority < mutex->owner->current_priority)
                 {
+#ifdef RT_USING_SCHED_EDF
+                    /* keep the EDF reservation of owner until it's restored */
+                    mutex->owner->edf_inherited = 1;
+#endif
                     /* change the owner thread priority */
                     rt_thread_control(mutex->owner,
                                       RT_THREAD_CTRL_CHANGE_PRIORITY,
@@ -1574,6 +1600,140 @@ rt_err_t rt_mb_send(rt_mailbox_t mb, rt_ubase_t value)
 }
 RTM_EXPORT(rt_mb_send);
 
+/**
+ * This function will send a batch of mails to mailbox object under one
+ * interrupt lock. If the mailbox is full, current thread will be suspended
+ * until there is room for at least one mail or timeout. The suspended
+ * receivers are waked up with one scheduling at the end.
+ *
+ * @param mb the mailbox object
+ * @param values the mails
+ * @param count the number of mails to send, and the number of mails sent
+ *        will be saved in
+ * @param timeout the waiting time
+ *
+ * @return the error code
+ */
+rt_err_t rt_mb_send_batch(rt_mailbox_t mb,
+                          const rt_ubase_t *values,
+                          rt_size_t  *count,
+                          rt_int32_t  timeout)
+{
+    struct rt_thread *thread;
+    register rt_ubase_t temp;
+    rt_uint32_t tick_delta;
+    rt_size_t sent, resumed;
+
+    /* parameter check */
+    RT_ASSERT(mb != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
+    RT_ASSERT(values != RT_NULL);
+    RT_ASSERT(count != RT_NULL);
+
+    if (*count == 0)
+        return RT_EOK;
+
+    /* initialize delta tick */
+    tick_delta = 0;
+    /* get current thread */
+    thread = rt_thread_self();
+
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mb->parent.parent)));
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
+    /* mailbox is full */
+    while (mb->entry == mb->size)
+    {
+        /* reset error number in thread */
+        thread->error = RT_EOK;
+
+        /* no waiting, return timeout */
+        if (timeout == 0)
+        {
+            /* enable interrupt */
+            rt_hw_interrupt_enable(temp);
+
+            *count = 0;
+
+            return -RT_EFULL;
+        }
+
+        RT_DEBUG_IN_THREAD_CONTEXT;
+        /* suspend current thread */
+        rt_ipc_list_suspend(&(mb->suspend_sender_thread),
+                            thread,
+                            mb->parent.parent.flag);
+
+        /* has waiting time, start thread timer */
+        if (timeout > 0)
+        {
+            /* get the start tick of timer */
+            tick_delta = rt_tick_get();
+
+            RT_DEBUG_LOG(RT_DEBUG_IPC, ("mb_send_batch: start timer of thread:%s\n",
+                                        thread->name));
+
+            /* reset the timeout of thread timer and start it */
+            rt_timer_control(&(thread->thread_timer),
+                             RT_TIMER_CTRL_SET_TIME,
+                             &timeout);
+            rt_timer_start(&(thread->thread_timer));
+        }
+
+        /* enable interrupt */
+        rt_hw_interrupt_enable(temp);
+
+        /* re-schedule */
+        rt_schedule();
+
+        /* resume from suspend state */
+        if (thread->error != RT_EOK)
+        {
+            *count = 0;
+
+            /* return error */
+            return thread->error;
+        }
+
+        /* disable interrupt */
+        temp = rt_hw_interrupt_disable();
+
+        /* if it's not waiting forever and then re-calculate timeout tick */
+        if (timeout > 0)
+        {
+            tick_delta = rt_tick_get() - tick_delta;
+            timeout -= tick_delta;
+            if (timeout < 0)
+                timeout = 0;
+        }
+    }
+
+    /* put as many mails as the room */
+    for (sent = 0; sent < *count && mb->entry < mb->size; sent ++)
+    {
+        mb->msg_pool[mb->in_offset] = values[sent];
+        ++ mb->in_offset;
+        if (mb->in_offset >= mb->size)
+            mb->in_offset = 0;
+        mb->entry ++;
+    }
+    *count = sent;
+
+    /* resume suspended threads, one thread for one mail */
+    resumed = rt_ipc_list_resume_n(&(mb->parent.suspend_thread), sent);
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+
+    if (resumed)
+        rt_schedule();
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mb_send_batch);
+
 /**
  * This function will receive a mail from mailbox object, if there is no mail
  * in mailbox object, the thread shall wait for a specified time.
@@ -1711,6 +1871,143 @@ rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_ubase_t *value, rt_int32_t timeout)
 }
 RTM_EXPORT(rt_mb_recv);
 
+/**
+ * This function will receive a batch of mails from mailbox object under one
+ * interrupt lock. If there is no mail in mailbox object, the thread shall
+ * wait until there is at least one mail or timeout. The suspended senders
+ * are waked up with one scheduling at the end.
+ *
+ * @param mb the mailbox object
+ * @param values the received mails will be saved in
+ * @param count the maximal number of mails to receive, and the number of
+ *        mails received will be saved in
+ * @param timeout the waiting time
+ *
+ * @return the error code
+ */
+rt_err_t rt_mb_recv_batch(rt_mailbox_t mb,
+                          rt_ubase_t *values,
+                          rt_size_t  *count,
+                          rt_int32_t  timeout)
+{
+    struct rt_thread *thread;
+    register rt_ubase_t temp;
+    rt_uint32_t tick_delta;
+    rt_size_t received, resumed;
+
+    /* parameter check */
+    RT_ASSERT(mb != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
+    RT_ASSERT(values != RT_NULL);
+    RT_ASSERT(count != RT_NULL);
+
+    if (*count == 0)
+        return RT_EOK;
+
+    /* initialize delta tick */
+    tick_delta = 0;
+    /* get current thread */
+    thread = rt_thread_self();
+
+    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mb->parent.parent)));
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
+    /* mailbox is empty */
+    while (mb->entry == 0)
+    {
+        /* reset error number in thread */
+        thread->error = RT_EOK;
+
+        /* no waiting, return timeout */
+        if (timeout == 0)
+        {
+            /* enable interrupt */
+            rt_hw_interrupt_enable(temp);
+
+            thread->error = -RT_ETIMEOUT;
+            *count = 0;
+
+            return -RT_ETIMEOUT;
+        }
+
+        RT_DEBUG_IN_THREAD_CONTEXT;
+        /* suspend current thread */
+        rt_ipc_list_suspend(&(mb->parent.suspend_thread),
+                            thread,
+                            mb->parent.parent.flag);
+
+        /* has waiting time, start thread timer */
+        if (timeout > 0)
+        {
+            /* get the start tick of timer */
+            tick_delta = rt_tick_get();
+
+            RT_DEBUG_LOG(RT_DEBUG_IPC, ("mb_recv_batch: start timer of thread:%s\n",
+                                        thread->name));
+
+            /* reset the timeout of thread timer and start it */
+            rt_timer_control(&(thread->thread_timer),
+                             RT_TIMER_CTRL_SET_TIME,
+                             &timeout);
+            rt_timer_start(&(thread->thread_timer));
+        }
+
+        /* enable interrupt */
+        rt_hw_interrupt_enable(temp);
+
+        /* re-schedule */
+        rt_schedule();
+
+        /* resume from suspend state */
+        if (thread->error != RT_EOK)
+        {
+            *count = 0;
+
+            /* return error */
+            return thread->error;
+        }
+
+        /* disable interrupt */
+        temp = rt_hw_interrupt_disable();
+
+        /* if it's not waiting forever and then re-calculate timeout tick */
+        if (timeout > 0)
+        {
+            tick_delta = rt_tick_get() - tick_delta;
+            timeout -= tick_delta;
+            if (timeout < 0)
+                timeout = 0;
+        }
+    }
+
+    /* take as many mails as there are */
+    for (received = 0; received < *count && mb->entry > 0; received ++)
+    {
+        values[received] = mb->msg_pool[mb->out_offset];
+        ++ mb->out_offset;
+        if (mb->out_offset >= mb->size)
+            mb->out_offset = 0;
+        mb->entry --;
+    }
+    *count = received;
+
+    /* resume suspended senders, one thread for one free room */
+    resumed = rt_ipc_list_resume_n(&(mb->suspend_sender_thread), received);
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+
+    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mb->parent.parent)));
+
+    if (resumed)
+        rt_schedule();
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mb_recv_batch);
+
 /**
  * This function can get or set some extra attributions of a mailbox object.
  *
@@ -1948,35 +2245,80 @@ rt_err_t rt_mq_delete(rt_mq_t mq)
 RTM_EXPORT(rt_mq_delete);
 #endif
 
-/**
- * This function will send a message to message queue object, if there are
- * threads suspended on message queue object, it will be waked up.
- *
- * @param mq the message queue object
- * @param buffer the message
- * @param size the size of buffer
+/*
+ * This function will link a message to the message queue and wake up the
+ * receiver, the interrupt shall be disabled before invoking.
  *
- * @return the error code
+ * @return RT_TRUE if a suspended thread is resumed.
  */
-rt_err_t rt_mq_send(rt_mq_t mq, void *buffer, rt_size_t size)
+static rt_bool_t _rt_mq_link(rt_mq_t mq, struct rt_mq_message *msg, rt_bool_t urgent)
 {
-    register rt_ubase_t temp;
-    struct rt_mq_message *msg;
+    if (urgent)
+    {
+        /* link msg to the beginning of message queue */
+        msg->next = mq->msg_queue_head;
+        mq->msg_queue_head = msg;
 
-    /* parameter check */
-    RT_ASSERT(mq != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
-    RT_ASSERT(buffer != RT_NULL);
-    RT_ASSERT(size != 0);
+        /* if there is no tail */
+        if (mq->msg_queue_tail == RT_NULL)
+            mq->msg_queue_tail = msg;
+    }
+    else
+    {
+        /* the msg is the new tailer of list, the next shall be NULL */
+        msg->next = RT_NULL;
 
-    /* greater than one message size */
-    if (size > mq->msg_size)
-        return -RT_ERROR;
+        /* link msg to message queue */
+        if (mq->msg_queue_tail != RT_NULL)
+        {
+            /* if the tail exists, */
+            ((struct rt_mq_message *)mq->msg_queue_tail)->next = msg;
+        }
 
-    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
+        /* set new tail */
+        mq->msg_queue_tail = msg;
+        /* if the head is empty, set head */
+        if (mq->msg_queue_head == RT_NULL)
+            mq->msg_queue_head = msg;
+    }
 
-    /* disable interrupt */
-    temp = rt_hw_interrupt_disable();
+    /* increase message entry */
+    mq->entry ++;
+
+    /* resume suspended thread */
+    if (!rt_list_isempty(&mq->parent.suspend_thread))
+    {
+        rt_ipc_list_resume(&(mq->parent.suspend_thread));
+
+        return RT_TRUE;
+    }
+
+    return RT_FALSE;
+}
+
+/**
+ * This function will reserve a free message slot in message queue object. The
+ * slot can be filled in place, then be sent by rt_mq_commit/rt_mq_commit_urgent
+ * or be given back by rt_mq_release.
+ *
+ * @param mq the message queue object
+ * @param buffer the address of message slot will be saved in, which is
+ *        mq->msg_size bytes
+ *
+ * @return the error code, -RT_EFULL if there is no free slot.
+ */
+rt_err_t rt_mq_reserve(rt_mq_t mq, void **buffer)
+{
+    register rt_ubase_t temp;
+    struct rt_mq_message *msg;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
 
     /* get a free list, there must be an empty item */
     msg = (struct rt_mq_message *)mq->msg_queue_free;
@@ -1994,47 +2336,103 @@ rt_err_t rt_mq_send(rt_mq_t mq, void *buffer, rt_size_t size)
     /* enable interrupt */
     rt_hw_interrupt_enable(temp);
 
-    /* the msg is the new tailer of list, the next shall be NULL */
-    msg->next = RT_NULL;
-    /* copy buffer */
-    rt_memcpy(msg + 1, buffer, size);
+    *buffer = msg + 1;
 
-    /* disable interrupt */
-    temp = rt_hw_interrupt_disable();
-    /* link msg to message queue */
-    if (mq->msg_queue_tail != RT_NULL)
-    {
-        /* if the tail exists, */
-        ((struct rt_mq_message *)mq->msg_queue_tail)->next = msg;
-    }
-
-    /* set new tail */
-    mq->msg_queue_tail = msg;
-    /* if the head is empty, set head */
-    if (mq->msg_queue_head == RT_NULL)
-        mq->msg_queue_head = msg;
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mq_reserve);
 
-    /* increase message entry */
-    mq->entry ++;
+static rt_err_t _rt_mq_commit(rt_mq_t mq, void *buffer, rt_bool_t urgent)
+{
+    register rt_ubase_t temp;
+    rt_bool_t resumed;
 
-    /* resume suspended thread */
-    if (!rt_list_isempty(&mq->parent.suspend_thread))
-    {
-        rt_ipc_list_resume(&(mq->parent.suspend_thread));
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
 
-        /* enable interrupt */
-        rt_hw_interrupt_enable(temp);
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
 
-        rt_schedule();
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
 
-        return RT_EOK;
-    }
+    resumed = _rt_mq_link(mq, (struct rt_mq_message *)buffer - 1, urgent);
 
     /* enable interrupt */
     rt_hw_interrupt_enable(temp);
 
+    if (resumed)
+        rt_schedule();
+
     return RT_EOK;
 }
+
+/**
+ * This function will send a message slot, which is reserved by rt_mq_reserve
+ * and filled in place, to message queue object. If there are threads
+ * suspended on message queue object, it will be waked up.
+ *
+ * @param mq the message queue object
+ * @param buffer the message slot
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_commit(rt_mq_t mq, void *buffer)
+{
+    return _rt_mq_commit(mq, buffer, RT_FALSE);
+}
+RTM_EXPORT(rt_mq_commit);
+
+/**
+ * This function will send a reserved message slot as an urgent message, which
+ * means the message will be inserted to the head of message queue.
+ *
+ * @param mq the message queue object
+ * @param buffer the message slot
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_commit_urgent(rt_mq_t mq, void *buffer)
+{
+    return _rt_mq_commit(mq, buffer, RT_TRUE);
+}
+RTM_EXPORT(rt_mq_commit_urgent);
+
+/**
+ * This function will send a message to message queue object, if there are
+ * threads suspended on message queue object, it will be waked up.
+ *
+ * @param mq the message queue object
+ * @param buffer the message
+ * @param size the size of buffer
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_send(rt_mq_t mq, void *buffer, rt_size_t size)
+{
+    void *slot;
+    rt_err_t result;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
+
+    /* greater than one message size */
+    if (size > mq->msg_size)
+        return -RT_ERROR;
+
+    result = rt_mq_reserve(mq, &slot);
+    if (result != RT_EOK)
+        return result;
+
+    /* copy buffer */
+    rt_memcpy(slot, buffer, size);
+
+    return _rt_mq_commit(mq, slot, RT_FALSE);
+}
 RTM_EXPORT(rt_mq_send);
 
 /**
@@ -2049,123 +2447,157 @@ RTM_EXPORT(rt_mq_send);
  * @return the error code
  */
 rt_err_t rt_mq_urgent(rt_mq_t mq, void *buffer, rt_size_t size)
+{
+    void *slot;
+    rt_err_t result;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
+
+    /* greater than one message size */
+    if (size > mq->msg_size)
+        return -RT_ERROR;
+
+    result = rt_mq_reserve(mq, &slot);
+    if (result != RT_EOK)
+        return result;
+
+    /* copy buffer */
+    rt_memcpy(slot, buffer, size);
+
+    return _rt_mq_commit(mq, slot, RT_TRUE);
+}
+RTM_EXPORT(rt_mq_urgent);
+
+/**
+ * This function will send a batch of messages to message queue object. The
+ * free slots are taken and linked under one interrupt lock respectively, and
+ * the suspended receivers are waked up with one scheduling at the end.
+ *
+ * @param mq the message queue object
+ * @param buffer the messages, each one takes size bytes
+ * @param size the size of each message
+ * @param count the number of messages to send, and the number of messages
+ *        sent will be saved in
+ *
+ * @return the error code, -RT_EFULL if no message is sent.
+ */
+rt_err_t rt_mq_send_batch(rt_mq_t     mq,
+                          const void *buffer,
+                          rt_size_t   size,
+                          rt_size_t  *count)
 {
     register rt_ubase_t temp;
-    struct rt_mq_message *msg;
+    struct rt_mq_message *head, *tail, *msg;
+    const rt_uint8_t *ptr;
+    rt_size_t sent, resumed;
 
     /* parameter check */
     RT_ASSERT(mq != RT_NULL);
     RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
     RT_ASSERT(buffer != RT_NULL);
     RT_ASSERT(size != 0);
+    RT_ASSERT(count != RT_NULL);
 
     /* greater than one message size */
     if (size > mq->msg_size)
+    {
+        *count = 0;
+
         return -RT_ERROR;
+    }
+    if (*count == 0)
+        return RT_EOK;
 
     RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
 
     /* disable interrupt */
     temp = rt_hw_interrupt_disable();
 
-    /* get a free list, there must be an empty item */
-    msg = (struct rt_mq_message *)mq->msg_queue_free;
-    /* message queue is full */
-    if (msg == RT_NULL)
+    /* cut a chain of free slots from the free list */
+    head = tail = (struct rt_mq_message *)mq->msg_queue_free;
+    if (head == RT_NULL)
     {
         /* enable interrupt */
         rt_hw_interrupt_enable(temp);
 
+        *count = 0;
+
         return -RT_EFULL;
     }
-    /* move free list pointer */
-    mq->msg_queue_free = msg->next;
+    for (sent = 1; sent < *count && tail->next != RT_NULL; sent ++)
+        tail = tail->next;
+    mq->msg_queue_free = tail->next;
 
     /* enable interrupt */
     rt_hw_interrupt_enable(temp);
 
-    /* copy buffer */
-    rt_memcpy(msg + 1, buffer, size);
+    /* copy messages without lock */
+    ptr = (const rt_uint8_t *)buffer;
+    for (msg = head; ; msg = msg->next)
+    {
+        rt_memcpy(msg + 1, ptr, size);
+        ptr += size;
+
+        if (msg == tail)
+            break;
+    }
+    tail->next = RT_NULL;
 
     /* disable interrupt */
     temp = rt_hw_interrupt_disable();
 
-    /* link msg to the beginning of message queue */
-    msg->next = mq->msg_queue_head;
-    mq->msg_queue_head = msg;
-
-    /* if there is no tail */
-    if (mq->msg_queue_tail == RT_NULL)
-        mq->msg_queue_tail = msg;
+    /* link the chain to message queue */
+    if (mq->msg_queue_tail != RT_NULL)
+        ((struct rt_mq_message *)mq->msg_queue_tail)->next = head;
+    mq->msg_queue_tail = tail;
+    if (mq->msg_queue_head == RT_NULL)
+        mq->msg_queue_head = head;
 
     /* increase message entry */
-    mq->entry ++;
-
-    /* resume suspended thread */
-    if (!rt_list_isempty(&mq->parent.suspend_thread))
-    {
-        rt_ipc_list_resume(&(mq->parent.suspend_thread));
-
-        /* enable interrupt */
-        rt_hw_interrupt_enable(temp);
-
-        rt_schedule();
+    mq->entry += sent;
 
-        return RT_EOK;
-    }
+    /* resume suspended threads, one thread for one message */
+    resumed = rt_ipc_list_resume_n(&(mq->parent.suspend_thread), sent);
 
     /* enable interrupt */
     rt_hw_interrupt_enable(temp);
 
+    *count = sent;
+
+    if (resumed)
+        rt_schedule();
+
     return RT_EOK;
 }
-RTM_EXPORT(rt_mq_urgent);
+RTM_EXPORT(rt_mq_send_batch);
 
-/**
- * This function will receive a message from message queue object, if there is
- * no message in message queue object, the thread shall wait for a specified
- * time.
- *
- * @param mq the message queue object
- * @param buffer the received message will be saved in
- * @param size the size of buffer
- * @param timeout the waiting time
- *
- * @return the error code
+/*
+ * This function will wait until there is a message in message queue object.
+ * The interrupt shall be disabled before invoking, it keeps disabled when
+ * RT_EOK is returned and is enabled on error.
  */
-rt_err_t rt_mq_recv(rt_mq_t    mq,
-                    void      *buffer,
-                    rt_size_t  size,
-                    rt_int32_t timeout)
+static rt_err_t _rt_mq_wait(rt_mq_t mq, rt_ubase_t *level, rt_int32_t timeout)
 {
     struct rt_thread *thread;
-    register rt_ubase_t temp;
-    struct rt_mq_message *msg;
     rt_uint32_t tick_delta;
 
-    /* parameter check */
-    RT_ASSERT(mq != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
-    RT_ASSERT(buffer != RT_NULL);
-    RT_ASSERT(size != 0);
-
-    /* initialize delta tick */
-    tick_delta = 0;
-    /* get current thread */
-    thread = rt_thread_self();
-    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mq->parent.parent)));
-
-    /* disable interrupt */
-    temp = rt_hw_interrupt_disable();
-
     /* for non-blocking call */
     if (mq->entry == 0 && timeout == 0)
     {
-        rt_hw_interrupt_enable(temp);
+        rt_hw_interrupt_enable(*level);
 
         return -RT_ETIMEOUT;
     }
 
+    /* initialize delta tick */
+    tick_delta = 0;
+    /* get current thread */
+    thread = rt_thread_self();
+
     /* message queue is empty */
     while (mq->entry == 0)
     {
@@ -2178,7 +2610,7 @@ rt_err_t rt_mq_recv(rt_mq_t    mq,
         if (timeout == 0)
         {
             /* enable interrupt */
-            rt_hw_interrupt_enable(temp);
+            rt_hw_interrupt_enable(*level);
 
             thread->error = -RT_ETIMEOUT;
 
@@ -2207,7 +2639,7 @@ rt_err_t rt_mq_recv(rt_mq_t    mq,
         }
 
         /* enable interrupt */
-        rt_hw_interrupt_enable(temp);
+        rt_hw_interrupt_enable(*level);
 
         /* re-schedule */
         rt_schedule();
@@ -2220,7 +2652,7 @@ rt_err_t rt_mq_recv(rt_mq_t    mq,
         }
 
         /* disable interrupt */
-        temp = rt_hw_interrupt_disable();
+        *level = rt_hw_interrupt_disable();
 
         /* if it's not waiting forever and then re-calculate timeout tick */
         if (timeout > 0)
@@ -2232,6 +2664,43 @@ rt_err_t rt_mq_recv(rt_mq_t    mq,
         }
     }
 
+    return RT_EOK;
+}
+
+/**
+ * This function will receive a message from message queue object without
+ * copying, if there is no message in message queue object, the thread shall
+ * wait for a specified time. The message slot shall be given back by
+ * rt_mq_release after it's processed.
+ *
+ * @param mq the message queue object
+ * @param buffer the address of received message slot will be saved in
+ * @param timeout the waiting time
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_recv_ref(rt_mq_t    mq,
+                        void     **buffer,
+                        rt_int32_t timeout)
+{
+    rt_ubase_t temp;
+    struct rt_mq_message *msg;
+    rt_err_t result;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+
+    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mq->parent.parent)));
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
+    result = _rt_mq_wait(mq, &temp, timeout);
+    if (result != RT_EOK)
+        return result;
+
     /* get message from queue */
     msg = (struct rt_mq_message *)mq->msg_queue_head;
 
@@ -2247,8 +2716,35 @@ rt_err_t rt_mq_recv(rt_mq_t    mq,
     /* enable interrupt */
     rt_hw_interrupt_enable(temp);
 
-    /* copy message */
-    rt_memcpy(buffer, msg + 1, size > mq->msg_size ? mq->msg_size : size);
+    *buffer = msg + 1;
+
+    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mq->parent.parent)));
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mq_recv_ref);
+
+/**
+ * This function will give back a message slot, which is received by
+ * rt_mq_recv_ref or reserved by rt_mq_reserve, to the free list of message
+ * queue object.
+ *
+ * @param mq the message queue object
+ * @param buffer the message slot
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_release(rt_mq_t mq, void *buffer)
+{
+    register rt_ubase_t temp;
+    struct rt_mq_message *msg;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+
+    msg = (struct rt_mq_message *)buffer - 1;
 
     /* disable interrupt */
     temp = rt_hw_interrupt_disable();
@@ -2258,11 +2754,136 @@ rt_err_t rt_mq_recv(rt_mq_t    mq,
     /* enable interrupt */
     rt_hw_interrupt_enable(temp);
 
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mq_release);
+
+/**
+ * This function will receive a message from message queue object, if there is
+ * no message in message queue object, the thread shall wait for a specified
+ * time.
+ *
+ * @param mq the message queue object
+ * @param buffer the received message will be saved in
+ * @param size the size of buffer
+ * @param timeout the waiting time
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_recv(rt_mq_t    mq,
+                    void      *buffer,
+                    rt_size_t  size,
+                    rt_int32_t timeout)
+{
+    void *slot;
+    rt_err_t result;
+
+    /* parameter check */
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
+
+    result = rt_mq_recv_ref(mq, &slot, timeout);
+    if (result != RT_EOK)
+        return result;
+
+    /* copy message */
+    rt_memcpy(buffer, slot, size > mq->msg_size ? mq->msg_size : size);
+
+    return rt_mq_release(mq, slot);
+}
+RTM_EXPORT(rt_mq_recv);
+
+/**
+ * This function will receive a batch of messages from message queue object.
+ * If there is no message in message queue object, the thread shall wait
+ * until there is at least one message or timeout. The messages are taken
+ * and given back under one interrupt lock respectively.
+ *
+ * @param mq the message queue object
+ * @param buffer the received messages will be saved in, each one takes size
+ *        bytes
+ * @param size the size of each message in buffer
+ * @param count the maximal number of messages to receive, and the number of
+ *        messages received will be saved in
+ * @param timeout the waiting time
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_recv_batch(rt_mq_t    mq,
+                          void      *buffer,
+                          rt_size_t  size,
+                          rt_size_t *count,
+                          rt_int32_t timeout)
+{
+    rt_ubase_t temp;
+    struct rt_mq_message *head, *tail, *msg;
+    rt_uint8_t *ptr;
+    rt_size_t received;
+    rt_err_t result;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mq->parent.parent) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
+    RT_ASSERT(count != RT_NULL);
+
+    if (*count == 0)
+        return RT_EOK;
+
+    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mq->parent.parent)));
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
+    result = _rt_mq_wait(mq, &temp, timeout);
+    if (result != RT_EOK)
+    {
+        *count = 0;
+
+        return result;
+    }
+
+    /* cut a chain of messages from the queue head */
+    head = tail = (struct rt_mq_message *)mq->msg_queue_head;
+    for (received = 1; received < *count && tail->next != RT_NULL; received ++)
+        tail = tail->next;
+    mq->msg_queue_head = tail->next;
+    if (mq->msg_queue_tail == tail)
+        mq->msg_queue_tail = RT_NULL;
+
+    /* decrease message entry */
+    mq->entry -= received;
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+
     RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mq->parent.parent)));
 
+    /* copy messages without lock */
+    ptr = (rt_uint8_t *)buffer;
+    for (msg = head; ; msg = msg->next)
+    {
+        rt_memcpy(ptr, msg + 1, size > mq->msg_size ? mq->msg_size : size);
+        ptr += size;
+
+        if (msg == tail)
+            break;
+    }
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+    /* put the chain to free list */
+    tail->next = (struct rt_mq_message *)mq->msg_queue_free;
+    mq->msg_queue_free = head;
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+
+    *count = received;
+
     return RT_EOK;
 }
-RTM_EXPORT(rt_mq_recv);
+RTM_EXPORT(rt_mq_recv_batch);
 
 /**
  * This function can get or set some extra attributions of a message queue
@@ -191,6 +191,53 @@ void rt_object_put_sethook(void (*hook)(struct rt_object *object))
 /**@}*/
 #endif
 
+#ifdef RT_USING_OBJECT_HASH
+/*
+ * the hash of object name, only the first RT_NAME_MAX characters are used as
+ * rt_strncmp does in object finding.
+ */
+static rt_uint32_t _object_hash(const char *name)
+{
+    rt_uint32_t hash = 5381;
+    int index;
+
+    for (index = 0; index < RT_NAME_MAX && name[index] != '\0'; index ++)
+        hash = (hash << 5) + hash + (rt_uint8_t)name[index];
+
+    return hash & (RT_OBJECT_HASH_SIZE - 1);
+}
+
+/* insert object to the hash index, the interrupt shall be disabled */
+static void _object_hash_insert(struct rt_object_information *information,
+                                struct rt_object *object)
+{
+    struct rt_object **bucket;
+
+    bucket = &(information->hash_table[_object_hash(object->name)]);
+    object->hash_next = *bucket;
+    *bucket = object;
+}
+
+/* remove object from the hash index, the interrupt shall be disabled */
+static void _object_hash_remove(struct rt_object_information *information,
+                                struct rt_object *object)
+{
+    struct rt_object **link;
+
+    for (link = &(information->hash_table[_object_hash(object->name)]);
+         *link != RT_NULL;
+         link = &((*link)->hash_next))
+    {
+        if (*link == object)
+        {
+            *link = object->hash_next;
+            break;
+        }
+    }
+    object->hash_next = RT_NULL;
+}
+#endif
+
 /**
  * @ingroup SystemInit
  *
@@ -267,12 +314,18 @@ void rt_object_init(struct rt_object         *object,
     {
         rt_list_insert_after(&(module->object_list), &(object->list));
         object->module_id = (void *)module;
+#ifdef RT_USING_OBJECT_HASH
+        object->hash_next = RT_NULL;
+#endif
     }
     else
 #endif
     {
         /* insert object into information object list */
         rt_list_insert_after(&(information->object_list), &(object->list));
+#ifdef RT_USING_OBJECT_HASH
+        _object_hash_insert(information, object);
+#endif
     }
 
     /* unlock interrupt */
@@ -288,12 +341,20 @@ void rt_object_init(struct rt_object         *object,
 void rt_object_detach(rt_object_t object)
 {
     register rt_base_t temp;
+#ifdef RT_USING_OBJECT_HASH
+    struct rt_object_information *information;
+#endif
 
     /* object check */
     RT_ASSERT(object != RT_NULL);
 
     RT_OBJECT_HOOK_CALL(rt_object_detach_hook, (object));
 
+#ifdef RT_USING_OBJECT_HASH
+    information = rt_object_get_information((enum rt_object_class_type)
+                                            (object->type & ~RT_Object_Class_Static));
+#endif
+
     /* reset object type */
     object->type = 0;
 
@@ -302,6 +363,10 @@ void rt_object_detach(rt_object_t object)
 
     /* remove from old list */
     rt_list_remove(&(object->list));
+#ifdef RT_USING_OBJECT_HASH
+    if (information != RT_NULL)
+        _object_hash_remove(information, object);
+#endif
 
     /* unlock interrupt */
     rt_hw_interrupt_enable(temp);
@@ -362,12 +427,18 @@ rt_object_t rt_object_allocate(enum rt_object_class_type type, const char *name)
     {
         rt_list_insert_after(&(module->object_list), &(object->list));
         object->module_id = (void *)module;
+#ifdef RT_USING_OBJECT_HASH
+        object->hash_next = RT_NULL;
+#endif
     }
     else
 #endif
     {
         /* insert object into information object list */
         rt_list_insert_after(&(information->object_list), &(object->list));
+#ifdef RT_USING_OBJECT_HASH
+        _object_hash_insert(information, object);
+#endif
     }
 
     /* unlock interrupt */
@@ -385,6 +456,9 @@ rt_object_t rt_object_allocate(enum rt_object_class_type type, const char *name)
 void rt_object_delete(rt_object_t object)
 {
     register rt_base_t temp;
+#ifdef RT_USING_OBJECT_HASH
+    struct rt_object_information *information;
+#endif
 
     /* object check */
     RT_ASSERT(object != RT_NULL);
@@ -392,6 +466,11 @@ void rt_object_delete(rt_object_t object)
 
     RT_OBJECT_HOOK_CALL(rt_object_detach_hook, (object));
 
+#ifdef RT_USING_OBJECT_HASH
+    information = rt_object_get_information((enum rt_object_class_type)
+                                            (object->type & ~RT_Object_Class_Static));
+#endif
+
     /* reset object type */
     object->type = 0;
 
@@ -400,6 +479,10 @@ void rt_object_delete(rt_object_t object)
 
     /* remove from old list */
     rt_list_remove(&(object->list));
+#ifdef RT_USING_OBJECT_HASH
+    if (information != RT_NULL)
+        _object_hash_remove(information, object);
+#endif
 
     /* unlock interrupt */
     rt_hw_interrupt_enable(temp);
@@ -445,58 +528,109 @@ rt_uint8_t rt_object_get_type(rt_object_t object)
     return object->type & ~RT_Object_Class_Static;
 }
 
-/**
- * This function will find specified name object from object
- * container.
- *
- * @param name the specified name of object.
- * @param type the type of object
- *
- * @return the found object or RT_NULL if there is no this object
- * in object container.
- *
- * @note this function shall not be invoked in interrupt status.
- */
-rt_object_t rt_object_find(const char *name, rt_uint8_t type)
+/* find the object by name without checking the context, it's used by
+ * rt_device_find and rt_thread_find, which may be invoked in interrupt. */
+rt_object_t _rt_object_find(const char *name, rt_uint8_t type)
 {
     struct rt_object *object = RT_NULL;
-    struct rt_list_node *node = RT_NULL;
     struct rt_object_information *information = RT_NULL;
+#ifndef RT_USING_OBJECT_HASH
+    struct rt_list_node *node = RT_NULL;
+#endif
 
     /* parameter check */
     if ((name == RT_NULL) || (type > RT_Object_Class_Unknown))
         return RT_NULL;
 
-    /* which is invoke in interrupt status */
-    RT_DEBUG_NOT_IN_INTERRUPT;
+    /* try to find object */
+    information = rt_object_get_information((enum rt_object_class_type)type);
+    RT_ASSERT(information != RT_NULL);
 
-    /* enter critical */
-    rt_enter_critical();
+    /* enter critical, the scheduler may not be started yet */
+    if (rt_thread_self() != RT_NULL)
+        rt_enter_critical();
 
-    /* try to find object */
-    if (information == RT_NULL)
+#ifdef RT_USING_OBJECT_HASH
+    for (object  = information->hash_table[_object_hash(name)];
+         object != RT_NULL;
+         object  = object->hash_next)
     {
-        information = rt_object_get_information((enum rt_object_class_type)type);
-        RT_ASSERT(information != RT_NULL);
+        if (rt_strncmp(object->name, name, RT_NAME_MAX) == 0)
+            break;
     }
+#else
     for (node  = information->object_list.next;
             node != &(information->object_list);
             node  = node->next)
     {
         object = rt_list_entry(node, struct rt_object, list);
         if (rt_strncmp(object->name, name, RT_NAME_MAX) == 0)
-        {
-            /* leave critical */
-            rt_exit_critical();
+            break;
 
-            return object;
-        }
+        object = RT_NULL;
     }
+#endif
 
     /* leave critical */
-    rt_exit_critical();
+    if (rt_thread_self() != RT_NULL)
+        rt_exit_critical();
 
-    return RT_NULL;
+    return object;
+}
+
+/**
+ * This function will find specified name object from object
+ * container.
+ *
+ * @param name the specified name of object.
+ * @param type the type of object
+ *
+ * @return the found object or RT_NULL if there is no this object
+ * in object container.
+ *
+ * @note this function shall not be invoked in interrupt status.
+ */
+rt_object_t rt_object_find(const char *name, rt_uint8_t type)
+{
+    /* which is invoke in interrupt status */
+    RT_DEBUG_NOT_IN_INTERRUPT;
+
+    return _rt_object_find(name, type);
+}
+
+/**
+ * This function will change the name of object, the object is moved to
+ * the hash index of new name.
+ *
+ * @param object the specified object.
+ * @param name the new name of object.
+ */
+void rt_object_set_name(rt_object_t object, const char *name)
+{
+    register rt_base_t temp;
+#ifdef RT_USING_OBJECT_HASH
+    struct rt_object_information *information;
+#endif
+
+    /* object check */
+    RT_ASSERT(object != RT_NULL);
+
+#ifdef RT_USING_OBJECT_HASH
+    information = rt_object_get_information((enum rt_object_class_type)
+                                            (object->type & ~RT_Object_Class_Static));
+#endif
+
+    temp = rt_hw_interrupt_disable();
+#ifdef RT_USING_OBJECT_HASH
+    if (information != RT_NULL)
+        _object_hash_remove(information, object);
+#endif
+    rt_strncpy(object->name, name, RT_NAME_MAX);
+#ifdef RT_USING_OBJECT_HASH
+    if (information != RT_NULL)
+        _object_hash_insert(information, object);
+#endif
+    rt_hw_interrupt_enable(temp);
 }
 
 /**@}*/
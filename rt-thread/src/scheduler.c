@@ -31,10 +31,14 @@ rt_hw_spinlock_t _rt_critical_lock;
 #endif /*RT_USING_SMP*/
 
 rt_list_t rt_thread_priority_table[RT_THREAD_PRIORITY_MAX];
-rt_uint32_t rt_thread_ready_priority_group;
-#if RT_THREAD_PRIORITY_MAX > 32
-/* Maximum priority level, 256 */
-rt_uint8_t rt_thread_ready_table[32];
+#ifdef RT_USING_SMP
+/*
+ * The global ready bitmap is written by all of cpus, it starts a new cache
+ * line so the writing does not invalidate the per-cpu ready bitmaps.
+ */
+struct rt_ready_bitmap rt_thread_ready ALIGN(RT_CPU_CACHE_LINE_SZ);
+#else
+struct rt_ready_bitmap rt_thread_ready;
 #endif
 
 #ifndef RT_USING_SMP
@@ -100,6 +104,107 @@ static void _rt_scheduler_stack_check(struct rt_thread *thread)
 }
 #endif
 
+#ifdef RT_USING_SCHED_EDF
+/* bandwidth is a fixed-point number, EDF_BW_UNIT stands for one full CPU */
+#define EDF_BW_SHIFT                16
+#define EDF_BW_UNIT                 (1UL << EDF_BW_SHIFT)
+
+#ifdef RT_USING_SMP
+/* one bandwidth account for each CPU plus one for the global queue */
+#define EDF_BW_GLOBAL               RT_CPUS_NR
+static rt_uint32_t _edf_bandwidth[RT_CPUS_NR + 1];
+#else
+#define EDF_BW_GLOBAL               0
+static rt_uint32_t _edf_bandwidth[1];
+#endif
+
+rt_inline rt_bool_t _edf_thread(struct rt_thread *thread)
+{
+    return (thread->edf_period != 0 &&
+            thread->current_priority == RT_SCHED_EDF_PRIORITY) ? RT_TRUE : RT_FALSE;
+}
+
+/*
+ * whether the deadline of thread is earlier than the one of other thread.
+ * The thread in EDF band without a reservation has an infinite deadline.
+ */
+rt_inline rt_bool_t _edf_earlier(struct rt_thread *thread, struct rt_thread *other)
+{
+    if (_edf_thread(thread) == RT_FALSE)
+        return RT_FALSE;
+    if (_edf_thread(other) == RT_FALSE)
+        return RT_TRUE;
+
+    return (rt_int32_t)(thread->edf_abs_deadline - other->edf_abs_deadline) < 0 ?
+           RT_TRUE : RT_FALSE;
+}
+
+/*
+ * insert thread to the priority list and keep the list ordered by deadline
+ */
+static void _edf_insert(rt_list_t *list, struct rt_thread *thread)
+{
+    struct rt_list_node *node;
+
+    for (node = list->next; node != list; node = node->next)
+    {
+        if (_edf_earlier(thread, rt_list_entry(node, struct rt_thread, tlist)))
+            break;
+    }
+
+    rt_list_insert_before(node, &(thread->tlist));
+}
+
+/*
+ * CBS wakeup rule: keep the current (budget, deadline) pair only if it does
+ * not exceed the reserved bandwidth, otherwise start a new server period.
+ */
+static void _edf_wakeup(struct rt_thread *thread)
+{
+    rt_tick_t now = rt_tick_get();
+    rt_tick_t laxity;
+
+    laxity = thread->edf_abs_deadline - now;
+    if ((rt_int32_t)laxity <= 0 ||
+        (rt_uint64_t)thread->edf_budget * thread->edf_deadline >
+        (rt_uint64_t)laxity * thread->edf_runtime)
+    {
+        thread->edf_abs_deadline = now + thread->edf_deadline;
+        thread->edf_budget       = thread->edf_runtime;
+    }
+}
+
+rt_inline void _schedule_list_insert(rt_list_t *list, struct rt_thread *thread)
+{
+    if (thread->current_priority == RT_SCHED_EDF_PRIORITY)
+        _edf_insert(list, thread);
+    else
+        rt_list_insert_before(list, &(thread->tlist));
+}
+#else
+#define _schedule_list_insert(list, thread) rt_list_insert_before(list, &((thread)->tlist))
+#endif /*RT_USING_SCHED_EDF*/
+
+/*
+ * whether the running thread should keep the processor against the highest
+ * ready thread
+ */
+rt_inline rt_bool_t _schedule_keep_current(struct rt_thread *current,
+                                           struct rt_thread *ready,
+                                           rt_ubase_t ready_priority)
+{
+    if (current->current_priority < ready_priority)
+        return RT_TRUE;
+
+#ifdef RT_USING_SCHED_EDF
+    if (current->current_priority == ready_priority && _edf_thread(current) &&
+        _edf_earlier(ready, current) == RT_FALSE)
+        return RT_TRUE;
+#endif
+
+    return RT_FALSE;
+}
+
 /*
  * get the highest priority thread in ready queue
  */
@@ -107,40 +212,55 @@ static void _rt_scheduler_stack_check(struct rt_thread *thread)
 static struct rt_thread* _get_highest_priority_thread(rt_ubase_t *highest_prio)
 {
     register struct rt_thread *highest_priority_thread;
-    register rt_ubase_t highest_ready_priority, local_highest_ready_priority;
+    register rt_ubase_t highest_ready_priority;
+    register rt_uint32_t local_mask;
     struct rt_cpu* pcpu = rt_cpu_self();
 
+    /*
+     * the global and local bitmaps are merged, so only one lookup is needed
+     * for each level of bitmap.
+     */
 #if RT_THREAD_PRIORITY_MAX > 32
     register rt_ubase_t number;
 
-    if (rt_thread_ready_priority_group == 0 && pcpu->priority_group == 0)
+    number = __rt_ffs(rt_thread_ready.priority_group | pcpu->ready.priority_group);
+    if (number == 0)
     {
         *highest_prio = pcpu->current_thread->current_priority;
         /* only local IDLE is readly */
         return pcpu->current_thread;
     }
 
-    number = __rt_ffs(rt_thread_ready_priority_group) - 1;
-    highest_ready_priority = (number << 3) + __rt_ffs(rt_thread_ready_table[number]) - 1;
-    number = __rt_ffs(pcpu->priority_group) - 1;
-    local_highest_ready_priority = (number << 3) + __rt_ffs(pcpu->ready_table[number]) - 1;
+    number --;
+    local_mask = pcpu->ready.ready_table[number];
+    highest_ready_priority = __rt_ffs(rt_thread_ready.ready_table[number] | local_mask) - 1;
+    local_mask &= 1UL << highest_ready_priority;
+    highest_ready_priority += number << 5;
 #else
-    highest_ready_priority = __rt_ffs(rt_thread_ready_priority_group) - 1;
-    local_highest_ready_priority = __rt_ffs(pcpu->priority_group) - 1;
+    local_mask = pcpu->ready.priority_group;
+    highest_ready_priority = __rt_ffs(rt_thread_ready.priority_group | local_mask);
+    if (highest_ready_priority == 0)
+    {
+        *highest_prio = pcpu->current_thread->current_priority;
+        /* only local IDLE is readly */
+        return pcpu->current_thread;
+    }
+
+    highest_ready_priority --;
+    local_mask &= 1UL << highest_ready_priority;
 #endif
 
-    /* get highest ready priority thread */
-    if (highest_ready_priority < local_highest_ready_priority)
+    /* get highest ready priority thread, local thread is preferred */
+    *highest_prio = highest_ready_priority;
+    if (local_mask)
     {
-        *highest_prio = highest_ready_priority;
-        highest_priority_thread = rt_list_entry(rt_thread_priority_table[highest_ready_priority].next,
+        highest_priority_thread = rt_list_entry(pcpu->priority_table[highest_ready_priority].next,
                                   struct rt_thread,
                                   tlist);
     }
     else
     {
-        *highest_prio = local_highest_ready_priority;
-        highest_priority_thread = rt_list_entry(pcpu->priority_table[local_highest_ready_priority].next,
+        highest_priority_thread = rt_list_entry(rt_thread_priority_table[highest_ready_priority].next,
                                   struct rt_thread,
                                   tlist);
     }
@@ -156,10 +276,10 @@ static struct rt_thread* _get_highest_priority_thread(rt_ubase_t *highest_prio)
 #if RT_THREAD_PRIORITY_MAX > 32
     register rt_ubase_t number;
 
-    number = __rt_ffs(rt_thread_ready_priority_group) - 1;
-    highest_ready_priority = (number << 3) + __rt_ffs(rt_thread_ready_table[number]) - 1;
+    number = __rt_ffs(rt_thread_ready.priority_group) - 1;
+    highest_ready_priority = (number << 5) + __rt_ffs(rt_thread_ready.ready_table[number]) - 1;
 #else
-    highest_ready_priority = __rt_ffs(rt_thread_ready_priority_group) - 1;
+    highest_ready_priority = __rt_ffs(rt_thread_ready.priority_group) - 1;
 #endif
 
     /* get highest ready priority thread */
@@ -207,21 +327,14 @@ void rt_system_scheduler_init(void)
         pcpu->irq_switch_flag = 0;
         pcpu->current_priority = RT_THREAD_PRIORITY_MAX - 1;
         pcpu->current_thread = RT_NULL;
-        pcpu->priority_group = 0;
 
-#if RT_THREAD_PRIORITY_MAX > 32
-        rt_memset(pcpu->ready_table, 0, sizeof(pcpu->ready_table));
-#endif
+        /* initialize ready bitmap of cpu */
+        rt_memset(&(pcpu->ready), 0, sizeof(pcpu->ready));
     }
 #endif /*RT_USING_SMP*/
 
-    /* initialize ready priority group */
-    rt_thread_ready_priority_group = 0;
-
-#if RT_THREAD_PRIORITY_MAX > 32
-    /* initialize ready table */
-    rt_memset(rt_thread_ready_table, 0, sizeof(rt_thread_ready_table));
-#endif
+    /* initialize ready priority group and ready table */
+    rt_memset(&rt_thread_ready, 0, sizeof(rt_thread_ready));
 
     /* initialize thread defunct */
     rt_list_init(&rt_thread_defunct);
@@ -307,13 +420,13 @@ void rt_schedule(void)
     {
         rt_ubase_t highest_ready_priority;
 
-        if (rt_thread_ready_priority_group != 0 || pcpu->priority_group != 0)
+        if (rt_thread_ready.priority_group != 0 || pcpu->ready.priority_group != 0)
         {
             to_thread = _get_highest_priority_thread(&highest_ready_priority);
             current_thread->oncpu = RT_CPU_DETACHED;
             if ((current_thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_READY)
             {
-                if (current_thread->current_priority < highest_ready_priority)
+                if (_schedule_keep_current(current_thread, to_thread, highest_ready_priority))
                 {
                     to_thread = current_thread;
                 }
@@ -389,7 +502,7 @@ void rt_schedule(void)
     {
         rt_ubase_t highest_ready_priority;
 
-        if (rt_thread_ready_priority_group != 0)
+        if (rt_thread_ready.priority_group != 0)
         {
             int need_insert_from_thread = 0;
 
@@ -397,7 +510,7 @@ void rt_schedule(void)
 
             if ((rt_current_thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_READY)
             {
-                if (rt_current_thread->current_priority < highest_ready_priority)
+                if (_schedule_keep_current(rt_current_thread, to_thread, highest_ready_priority))
                 {
                     to_thread = rt_current_thread;
                 }
@@ -508,13 +621,13 @@ void rt_scheduler_do_irq_switch(void *context)
         /* clear irq switch flag */
         pcpu->irq_switch_flag = 0;
 
-        if (rt_thread_ready_priority_group != 0 || pcpu->priority_group != 0)
+        if (rt_thread_ready.priority_group != 0 || pcpu->ready.priority_group != 0)
         {
             to_thread = _get_highest_priority_thread(&highest_ready_priority);
             current_thread->oncpu = RT_CPU_DETACHED;
             if ((current_thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_READY)
             {
-                if (current_thread->current_priority < highest_ready_priority)
+                if (_schedule_keep_current(current_thread, to_thread, highest_ready_priority))
                 {
                     to_thread = current_thread;
                 }
@@ -571,6 +684,15 @@ void rt_schedule_insert_thread(struct rt_thread *thread)
     /* disable interrupt */
     level = rt_hw_interrupt_disable();
 
+#ifdef RT_USING_SCHED_EDF
+    /* a thread becomes ready again, check its server deadline */
+    if (thread->edf_period != 0 &&
+        (thread->stat & RT_THREAD_STAT_MASK) != RT_THREAD_READY)
+    {
+        _edf_wakeup(thread);
+    }
+#endif
+
     /* change stat */
     thread->stat = RT_THREAD_READY | (thread->stat & ~RT_THREAD_STAT_MASK);
 
@@ -586,12 +708,12 @@ void rt_schedule_insert_thread(struct rt_thread *thread)
     if (bind_cpu == RT_CPUS_NR)
     {
 #if RT_THREAD_PRIORITY_MAX > 32
-        rt_thread_ready_table[thread->number] |= thread->high_mask;
+        rt_thread_ready.ready_table[thread->number] |= thread->high_mask;
 #endif
-        rt_thread_ready_priority_group |= thread->number_mask;
+        rt_thread_ready.priority_group |= thread->number_mask;
 
-        rt_list_insert_before(&(rt_thread_priority_table[thread->current_priority]),
-                              &(thread->tlist));
+        _schedule_list_insert(&(rt_thread_priority_table[thread->current_priority]),
+                              thread);
         cpu_mask = RT_CPU_MASK ^ (1 << cpu_id);
         rt_hw_ipi_send(RT_SCHEDULE_IPI_IRQ, cpu_mask);
     }
@@ -600,12 +722,12 @@ void rt_schedule_insert_thread(struct rt_thread *thread)
         struct rt_cpu *pcpu = rt_cpu_index(bind_cpu);
 
 #if RT_THREAD_PRIORITY_MAX > 32
-        pcpu->ready_table[thread->number] |= thread->high_mask;
+        pcpu->ready.ready_table[thread->number] |= thread->high_mask;
 #endif
-        pcpu->priority_group |= thread->number_mask;
+        pcpu->ready.priority_group |= thread->number_mask;
 
-        rt_list_insert_before(&(rt_cpu_index(bind_cpu)->priority_table[thread->current_priority]),
-                              &(thread->tlist));
+        _schedule_list_insert(&(rt_cpu_index(bind_cpu)->priority_table[thread->current_priority]),
+                              thread);
 
         if (cpu_id != bind_cpu)
         {
@@ -631,6 +753,15 @@ void rt_schedule_insert_thread(struct rt_thread *thread)
     /* disable interrupt */
     temp = rt_hw_interrupt_disable();
 
+#ifdef RT_USING_SCHED_EDF
+    /* a thread becomes ready again, check its server deadline */
+    if (thread->edf_period != 0 &&
+        (thread->stat & RT_THREAD_STAT_MASK) != RT_THREAD_READY)
+    {
+        _edf_wakeup(thread);
+    }
+#endif
+
     /* change stat */
     thread->stat = RT_THREAD_READY | (thread->stat & ~RT_THREAD_STAT_MASK);
 
@@ -640,17 +771,17 @@ void rt_schedule_insert_thread(struct rt_thread *thread)
     }
 
     /* insert thread to ready list */
-    rt_list_insert_before(&(rt_thread_priority_table[thread->current_priority]),
-                          &(thread->tlist));
+    _schedule_list_insert(&(rt_thread_priority_table[thread->current_priority]),
+                          thread);
 
     RT_DEBUG_LOG(RT_DEBUG_SCHEDULER, ("insert thread[%.*s], the priority: %d\n",
                                       RT_NAME_MAX, thread->name, thread->current_priority));
 
     /* set priority mask */
 #if RT_THREAD_PRIORITY_MAX > 32
-    rt_thread_ready_table[thread->number] |= thread->high_mask;
+    rt_thread_ready.ready_table[thread->number] |= thread->high_mask;
 #endif
-    rt_thread_ready_priority_group |= thread->number_mask;
+    rt_thread_ready.priority_group |= thread->number_mask;
 
 __exit:
     /* enable interrupt */
@@ -686,13 +817,13 @@ void rt_schedule_remove_thread(struct rt_thread *thread)
         if (rt_list_isempty(&(rt_thread_priority_table[thread->current_priority])))
         {
 #if RT_THREAD_PRIORITY_MAX > 32
-            rt_thread_ready_table[thread->number] &= ~thread->high_mask;
-            if (rt_thread_ready_table[thread->number] == 0)
+            rt_thread_ready.ready_table[thread->number] &= ~thread->high_mask;
+            if (rt_thread_ready.ready_table[thread->number] == 0)
             {
-                rt_thread_ready_priority_group &= ~thread->number_mask;
+                rt_thread_ready.priority_group &= ~thread->number_mask;
             }
 #else
-            rt_thread_ready_priority_group &= ~thread->number_mask;
+            rt_thread_ready.priority_group &= ~thread->number_mask;
 #endif
         }
     }
@@ -703,13 +834,13 @@ void rt_schedule_remove_thread(struct rt_thread *thread)
         if (rt_list_isempty(&(pcpu->priority_table[thread->current_priority])))
         {
 #if RT_THREAD_PRIORITY_MAX > 32
-            pcpu->ready_table[thread->number] &= ~thread->high_mask;
-            if (rt_thread_ready_table[thread->number] == 0)
+            pcpu->ready.ready_table[thread->number] &= ~thread->high_mask;
+            if (pcpu->ready.ready_table[thread->number] == 0)
             {
-                pcpu->priority_group &= ~thread->number_mask;
+                pcpu->ready.priority_group &= ~thread->number_mask;
             }
 #else
-            pcpu->priority_group &= ~thread->number_mask;
+            pcpu->ready.priority_group &= ~thread->number_mask;
 #endif
         }
     }
@@ -736,13 +867,13 @@ void rt_schedule_remove_thread(struct rt_thread *thread)
     if (rt_list_isempty(&(rt_thread_priority_table[thread->current_priority])))
     {
 #if RT_THREAD_PRIORITY_MAX > 32
-        rt_thread_ready_table[thread->number] &= ~thread->high_mask;
-        if (rt_thread_ready_table[thread->number] == 0)
+        rt_thread_ready.ready_table[thread->number] &= ~thread->high_mask;
+        if (rt_thread_ready.ready_table[thread->number] == 0)
         {
-            rt_thread_ready_priority_group &= ~thread->number_mask;
+            rt_thread_ready.priority_group &= ~thread->number_mask;
         }
 #else
-        rt_thread_ready_priority_group &= ~thread->number_mask;
+        rt_thread_ready.priority_group &= ~thread->number_mask;
 #endif
     }
 
@@ -751,6 +882,185 @@ void rt_schedule_remove_thread(struct rt_thread *thread)
 }
 #endif /*RT_USING_SMP*/
 
+#ifdef RT_USING_SCHED_EDF
+#ifdef RT_USING_SMP
+#define EDF_CPUS_NR                 RT_CPUS_NR
+#else
+#define EDF_CPUS_NR                 1
+#endif
+
+/*
+ * the number of global EDF reservations and the maximal bandwidth of them,
+ * which are updated at admission and release. The maximum is not lowered
+ * until all of them are released, which only makes the admission pessimistic.
+ */
+static rt_uint32_t _edf_global_count = 0;
+static rt_uint32_t _edf_global_max = 0;
+
+/**
+ * This function will set an EDF reservation to a thread which has not been
+ * started yet. The thread is moved to the EDF priority band.
+ *
+ * The admission control makes sure that no CPU is overloaded by the threads
+ * bound to it, and all of reservations pass the Goossens-Funk-Baruah test
+ * of global EDF: U <= m - (m - 1) * Umax.
+ *
+ * @param thread the thread to be set
+ * @param param the reservation parameter
+ *
+ * @return RT_EOK on OK, -RT_EINVAL on bad parameter or thread state,
+ *         -RT_EFULL if the reservation can not be admitted.
+ */
+rt_err_t rt_schedule_edf_admit(struct rt_thread *thread, struct rt_edf_param *param)
+{
+    int index, i;
+    rt_base_t level;
+    rt_tick_t deadline;
+    rt_uint32_t bandwidth, total, max_bandwidth;
+    rt_err_t result = RT_EOK;
+
+    RT_ASSERT(thread != RT_NULL);
+    RT_ASSERT(param != RT_NULL);
+
+    if ((thread->stat & RT_THREAD_STAT_MASK) != RT_THREAD_INIT)
+        return -RT_EINVAL;
+
+    deadline = param->deadline ? param->deadline : param->period;
+    if (param->runtime == 0 || param->runtime > deadline ||
+        deadline > param->period || param->period > RT_TICK_MAX / 2)
+        return -RT_EINVAL;
+
+    /* use density for the constrained deadline reservation */
+    bandwidth = (rt_uint32_t)(((rt_uint64_t)param->runtime << EDF_BW_SHIFT) / deadline);
+
+#ifdef RT_USING_SMP
+    index = thread->bind_cpu;
+#else
+    index = EDF_BW_GLOBAL;
+#endif
+
+    level = rt_hw_interrupt_disable();
+
+    max_bandwidth = _edf_global_max;
+    if (index == EDF_BW_GLOBAL && bandwidth > max_bandwidth)
+        max_bandwidth = bandwidth;
+
+    total = bandwidth;
+    for (i = 0; i < sizeof(_edf_bandwidth) / sizeof(_edf_bandwidth[0]); i ++)
+        total += _edf_bandwidth[i];
+    /* the old reservation of this thread will be replaced */
+    if (thread->edf_period != 0)
+        total -= thread->edf_bandwidth;
+
+    if (total > EDF_CPUS_NR * EDF_BW_UNIT - (EDF_CPUS_NR - 1) * max_bandwidth)
+    {
+        result = -RT_EFULL;
+    }
+    else if (index != EDF_BW_GLOBAL &&
+             _edf_bandwidth[index] + bandwidth -
+             (thread->edf_period ? thread->edf_bandwidth : 0) > EDF_BW_UNIT)
+    {
+        result = -RT_EFULL;
+    }
+    else
+    {
+        if (thread->edf_period != 0)
+            _edf_bandwidth[index] -= thread->edf_bandwidth;
+        _edf_bandwidth[index] += bandwidth;
+
+        if (index == EDF_BW_GLOBAL)
+        {
+            if (thread->edf_period == 0)
+                _edf_global_count ++;
+            _edf_global_max = max_bandwidth;
+        }
+
+        thread->edf_runtime      = param->runtime;
+        thread->edf_deadline     = deadline;
+        thread->edf_period       = param->period;
+        thread->edf_bandwidth    = bandwidth;
+        /* the first wakeup will start a new server period */
+        thread->edf_budget       = 0;
+        thread->edf_abs_deadline = rt_tick_get();
+
+        thread->init_priority    = RT_SCHED_EDF_PRIORITY;
+        thread->current_priority = RT_SCHED_EDF_PRIORITY;
+    }
+
+    rt_hw_interrupt_enable(level);
+
+    return result;
+}
+
+/**
+ * This function will release the EDF reservation of a thread, which is
+ * scheduled by priority and time slice after then.
+ *
+ * @param thread the thread to be released
+ */
+void rt_schedule_edf_release(struct rt_thread *thread)
+{
+    int index;
+    rt_base_t level;
+
+    RT_ASSERT(thread != RT_NULL);
+
+    level = rt_hw_interrupt_disable();
+    if (thread->edf_period != 0)
+    {
+#ifdef RT_USING_SMP
+        index = thread->bind_cpu;
+#else
+        index = EDF_BW_GLOBAL;
+#endif
+        _edf_bandwidth[index] -= thread->edf_bandwidth;
+        if (index == EDF_BW_GLOBAL)
+        {
+            _edf_global_count --;
+            if (_edf_global_count == 0)
+                _edf_global_max = 0;
+        }
+
+        thread->edf_runtime      = 0;
+        thread->edf_deadline     = 0;
+        thread->edf_period       = 0;
+        thread->edf_abs_deadline = 0;
+        thread->edf_budget       = 0;
+        thread->edf_bandwidth    = 0;
+    }
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * This function will consume one tick of the budget of an EDF thread. When the
+ * budget is exhausted, the deadline is postponed by one period and the budget
+ * is recharged, as the constant bandwidth server does.
+ *
+ * @param thread the running thread
+ *
+ * @return RT_TRUE if the budget is exhausted and a scheduling is needed.
+ */
+rt_bool_t rt_schedule_edf_tick(struct rt_thread *thread)
+{
+    rt_base_t level;
+    rt_bool_t exhausted = RT_FALSE;
+
+    level = rt_hw_interrupt_disable();
+    if (thread->edf_budget > 0)
+        thread->edf_budget --;
+
+    if (thread->edf_budget == 0)
+    {
+        thread->edf_abs_deadline += thread->edf_period;
+        thread->edf_budget        = thread->edf_runtime;
+        exhausted = RT_TRUE;
+    }
+    rt_hw_interrupt_enable(level);
+
+    return exhausted;
+}
+#endif /*RT_USING_SCHED_EDF*/
+
 /**
  * This function will lock the thread scheduler.
  */
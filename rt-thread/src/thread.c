@@ -88,6 +88,9 @@ void rt_thread_exit(void)
 
     /* remove from schedule */
     rt_schedule_remove_thread(thread);
+#ifdef RT_USING_SCHED_EDF
+    rt_schedule_edf_release(thread);
+#endif
     /* change stat */
     thread->stat = RT_THREAD_CLOSE;
 
@@ -152,6 +155,17 @@ static rt_err_t _rt_thread_init(struct rt_thread *thread,
     thread->init_tick      = tick;
     thread->remaining_tick = tick;
 
+#ifdef RT_USING_SCHED_EDF
+    /* not an EDF thread */
+    thread->edf_runtime      = 0;
+    thread->edf_deadline     = 0;
+    thread->edf_period       = 0;
+    thread->edf_abs_deadline = 0;
+    thread->edf_budget       = 0;
+    thread->edf_bandwidth    = 0;
+    thread->edf_inherited    = 0;
+#endif
+
     /* error and flags */
     thread->error = RT_EOK;
     thread->stat  = RT_THREAD_INIT;
@@ -287,11 +301,11 @@ rt_err_t rt_thread_startup(rt_thread_t thread)
 
     /* calculate priority attribute */
 #if RT_THREAD_PRIORITY_MAX > 32
-    thread->number      = thread->current_priority >> 3;            /* 5bit */
-    thread->number_mask = 1L << thread->number;
-    thread->high_mask   = 1L << (thread->current_priority & 0x07);  /* 3bit */
+    thread->number      = thread->current_priority >> 5;            /* 3bit */
+    thread->number_mask = 1UL << thread->number;
+    thread->high_mask   = 1UL << (thread->current_priority & 0x1f);  /* 5bit */
 #else
-    thread->number_mask = 1L << thread->current_priority;
+    thread->number_mask = 1UL << thread->current_priority;
 #endif
 
     RT_DEBUG_LOG(RT_DEBUG_THREAD, ("startup a thread:%s with priority:%d\n",
@@ -333,6 +347,11 @@ rt_err_t rt_thread_detach(rt_thread_t thread)
         rt_schedule_remove_thread(thread);
     }
 
+#ifdef RT_USING_SCHED_EDF
+    /* release EDF reservation */
+    rt_schedule_edf_release(thread);
+#endif
+
     /* release thread timer */
     rt_timer_detach(&(thread->thread_timer));
 
@@ -433,6 +452,11 @@ rt_err_t rt_thread_delete(rt_thread_t thread)
         rt_schedule_remove_thread(thread);
     }
 
+#ifdef RT_USING_SCHED_EDF
+    /* release EDF reservation */
+    rt_schedule_edf_release(thread);
+#endif
+
     /* release thread timer */
     rt_timer_detach(&(thread->thread_timer));
 
@@ -545,7 +569,8 @@ RTM_EXPORT(rt_thread_mdelay);
  *  RT_THREAD_CTRL_CHANGE_PRIORITY for changing priority level of thread;
  *  RT_THREAD_CTRL_STARTUP for starting a thread;
  *  RT_THREAD_CTRL_CLOSE for delete a thread;
- *  RT_THREAD_CTRL_BIND_CPU for bind the thread to a CPU.
+ *  RT_THREAD_CTRL_BIND_CPU for bind the thread to a CPU;
+ *  RT_THREAD_CTRL_SET_EDF for setting EDF reservation of a thread.
  * @param arg the argument of control command
  *
  * @return RT_EOK
@@ -564,6 +589,19 @@ rt_err_t rt_thread_control(rt_thread_t thread, int cmd, void *arg)
         /* disable interrupt */
         temp = rt_hw_interrupt_disable();
 
+#ifdef RT_USING_SCHED_EDF
+        if (*(rt_uint8_t *)arg == RT_SCHED_EDF_PRIORITY)
+        {
+            thread->edf_inherited = 0;
+        }
+        else if (thread->edf_period != 0 && !thread->edf_inherited)
+        {
+            /* the thread leaves EDF band, which is not a temporary priority
+             * inheritance, release its reservation */
+            rt_schedule_edf_release(thread);
+        }
+#endif
+
         /* for ready thread, change queue */
         if ((thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_READY)
         {
@@ -575,11 +613,11 @@ rt_err_t rt_thread_control(rt_thread_t thread, int cmd, void *arg)
 
             /* recalculate priority attribute */
 #if RT_THREAD_PRIORITY_MAX > 32
-            thread->number      = thread->current_priority >> 3;            /* 5bit */
+            thread->number      = thread->current_priority >> 5;            /* 3bit */
             thread->number_mask = 1 << thread->number;
-            thread->high_mask   = 1 << (thread->current_priority & 0x07);   /* 3bit */
+            thread->high_mask   = 1UL << (thread->current_priority & 0x1f);  /* 5bit */
 #else
-            thread->number_mask = 1 << thread->current_priority;
+            thread->number_mask = 1UL << thread->current_priority;
 #endif
 
             /* insert thread to schedule queue again */
@@ -591,11 +629,11 @@ rt_err_t rt_thread_control(rt_thread_t thread, int cmd, void *arg)
 
             /* recalculate priority attribute */
 #if RT_THREAD_PRIORITY_MAX > 32
-            thread->number      = thread->current_priority >> 3;            /* 5bit */
+            thread->number      = thread->current_priority >> 5;            /* 3bit */
             thread->number_mask = 1 << thread->number;
-            thread->high_mask   = 1 << (thread->current_priority & 0x07);   /* 3bit */
+            thread->high_mask   = 1UL << (thread->current_priority & 0x1f);  /* 5bit */
 #else
-            thread->number_mask = 1 << thread->current_priority;
+            thread->number_mask = 1UL << thread->current_priority;
 #endif
         }
 
@@ -622,11 +660,25 @@ rt_err_t rt_thread_control(rt_thread_t thread, int cmd, void *arg)
             return RT_ERROR;
         }
 
+#ifdef RT_USING_SCHED_EDF
+        if (thread->edf_period != 0)
+        {
+            /* the reservation is admitted on the bound cpu. */
+            return -RT_EBUSY;
+        }
+#endif
+
         cpu = (rt_uint8_t)(size_t)arg;
         thread->bind_cpu = cpu > RT_CPUS_NR? RT_CPUS_NR : cpu;
         break;
     }
 #endif /*RT_USING_SMP*/
+
+#ifdef RT_USING_SCHED_EDF
+    case RT_THREAD_CTRL_SET_EDF:
+        return rt_schedule_edf_admit(thread, (struct rt_edf_param *)arg);
+#endif /*RT_USING_SCHED_EDF*/
+
     default:
         break;
     }
@@ -769,38 +821,7 @@ RTM_EXPORT(rt_thread_timeout);
  */
 rt_thread_t rt_thread_find(char *name)
 {
-    struct rt_object_information *information;
-    struct rt_object *object;
-    struct rt_list_node *node;
-
-    /* enter critical */
-    if (rt_thread_self() != RT_NULL)
-        rt_enter_critical();
-
-    /* try to find device object */
-    information = rt_object_get_information(RT_Object_Class_Thread);
-    RT_ASSERT(information != RT_NULL);
-    for (node  = information->object_list.next;
-         node != &(information->object_list);
-         node  = node->next)
-    {
-        object = rt_list_entry(node, struct rt_object, list);
-        if (rt_strncmp(object->name, name, RT_NAME_MAX) == 0)
-        {
-            /* leave critical */
-            if (rt_thread_self() != RT_NULL)
-                rt_exit_critical();
-
-            return (rt_thread_t)object;
-        }
-    }
-
-    /* leave critical */
-    if (rt_thread_self() != RT_NULL)
-        rt_exit_critical();
-
-    /* not found */
-    return RT_NULL;
+    return (rt_thread_t)_rt_object_find(name, RT_Object_Class_Thread);
 }
 RTM_EXPORT(rt_thread_find);
 